@@ -46,6 +46,7 @@
 #include "semphr.h"
 #include "event_groups.h"
 #include "queue.h"
+#include "async_log.h"
 
 #define TYPE_A
 
@@ -73,7 +74,6 @@ typedef struct
 	int8_t shared_memory;
 	SemaphoreHandle_t seconds_signal;
 	EventGroupHandle_t supervisor_signals;
-	SemaphoreHandle_t serial_port_mutex;
 	SemaphoreHandle_t shared_memory_mutex;
 	QueueHandle_t mailbox;
 }task_args_t;
@@ -170,29 +170,23 @@ void task_printer(void*args)
 	{
 		xQueueReceive(task_args.mailbox,&received_msg,portMAX_DELAY);
 
-		xSemaphoreTake(task_args.serial_port_mutex,portMAX_DELAY);
+		/* msg points to the constant text of the sending task, which stays
+		 * valid until the log task prints it. */
 		switch(received_msg.id)
 		{
 		case producer_id:
-			PRINTF("\rProducer sent:");
-			PRINTF(received_msg.msg);
-			PRINTF(" |DATA: %i\n",received_msg.data);
+			ASYNC_LOG("\rProducer sent:%s |DATA: %i\n",ASYNC_LOG_STR(received_msg.msg),received_msg.data);
 			break;
 		case consumer_id:
-			PRINTF("\rConsumer sent:");
-			PRINTF(received_msg.msg);
-			PRINTF(" |DATA: %i\n",received_msg.data);
+			ASYNC_LOG("\rConsumer sent:%s |DATA: %i\n",ASYNC_LOG_STR(received_msg.msg),received_msg.data);
 			break;
 		case supervisor_id:
-			PRINTF("\rSupervisor sent:");
-			PRINTF(received_msg.msg);
-			PRINTF(" |DATA: %i\n",received_msg.data);
+			ASYNC_LOG("\rSupervisor sent:%s |DATA: %i\n",ASYNC_LOG_STR(received_msg.msg),received_msg.data);
 			break;
 		default:
-			PRINTF("\rError\n");
+			ASYNC_LOG("\rError\n");
 			break;
 		}
-		xSemaphoreGive(task_args.serial_port_mutex);
 	}
 }
 
@@ -204,9 +198,7 @@ void task_timer(void*args)
 	for(;;)
 	{
 		seconds++;
-		xSemaphoreTake(task_args.serial_port_mutex,portMAX_DELAY);
-		PRINTF("\rTime: %i seconds since reset\n",seconds);
-		xSemaphoreGive(task_args.serial_port_mutex);
+		ASYNC_LOG("\rTime: %i seconds since reset\n",seconds);
 
 		xSemaphoreGive(task_args.seconds_signal);
 
@@ -220,21 +212,26 @@ int main(void)
 	args.supervisor_signals = xEventGroupCreate();
 	args.seconds_signal = xSemaphoreCreateBinary();
 	args.mailbox = xQueueCreate(5,sizeof(msg_t));
-	args.serial_port_mutex = xSemaphoreCreateMutex();
 	args.shared_memory_mutex = xSemaphoreCreateMutex();
 
 	srand(0x15458523);
 
 	BOARD_InitBootPins();
 	BOARD_InitBootClocks();
+	trace_recorder_init();
 	BOARD_InitBootPeripherals();
 	BOARD_InitDebugConsole();
+#if ASYNC_LOG_BENCHMARK
+	async_log_benchmark();
+#endif
 
 	xTaskCreate(task_producer, "producer", PRINTF_MIN_STACK, (void*)&args, PRODUCER_PRIORITY, NULL);
 	xTaskCreate(task_consumer, "consumer", PRINTF_MIN_STACK, (void*)&args, CONSUMER_PRIORITY, NULL);
 	xTaskCreate(task_supervisor, "supervisor", PRINTF_MIN_STACK, (void*)&args, SUPERVISOR_PRIORITY, NULL);
 	xTaskCreate(task_printer, "printer", PRINTF_MIN_STACK, (void*)&args, PRINTER_PRIORITY, NULL);
 	xTaskCreate(task_timer, "timer", PRINTF_MIN_STACK, (void*)&args, TIMER_PRIORITY, NULL);
+	runtime_stats_start();
+	async_log_start();
 	vTaskStartScheduler();
 
 	while(1) {}
@@ -73,10 +73,18 @@
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
-/* Run time and task stats gathering related definitions. */
+/* Run time and task stats gathering related definitions. The run time stats
+(common/runtime_stats.h) are opt-in: build with configGENERATE_RUN_TIME_STATS=1
+to enable them. */
+#ifndef configGENERATE_RUN_TIME_STATS
 #define configGENERATE_RUN_TIME_STATS           0
+#endif
 #define configUSE_TRACE_FACILITY                1
-#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+/* The binary trace recorder (common/trace_recorder.h) is opt-in as well. */
+#ifndef configUSE_TRACE_RECORDER
+#define configUSE_TRACE_RECORDER                0
+#endif
+#define configUSE_STATS_FORMATTING_FUNCTIONS    configGENERATE_RUN_TIME_STATS
 
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
@@ -136,6 +144,17 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 standard names. */
 #define vPortSVCHandler SVC_Handler
 #define xPortPendSVHandler PendSV_Handler
+/* With run time stats SysTick_Handler is the wrapper in common/runtime_stats.c,
+which accounts the tick as ISR time. */
+#if !configGENERATE_RUN_TIME_STATS
 #define xPortSysTickHandler SysTick_Handler
+#endif
+
+/* The binary trace recorder and the run time stats implement the trace hook
+macros, they have to be seen before FreeRTOS.h supplies the empty defaults. */
+#ifndef __ASSEMBLER__
+#include "trace_recorder.h"
+#include "runtime_stats.h"
+#endif
 
 #endif /* FREERTOS_CONFIG_H */
@@ -122,6 +122,37 @@ static usart_handle_t s_ioUsartHandler;
 #include "fsl_swo.h"
 #endif
 
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+#if defined DEBUG_CONSOLE_TRANSFER_NON_BLOCKING
+#error "DEBUG_CONSOLE_TRANSFER_INTERRUPT and DEBUG_CONSOLE_TRANSFER_NON_BLOCKING exclude each other"
+#endif
+#if (!defined DEBUG_CONSOLE_IO_UART) || (!defined FSL_RTOS_FREE_RTOS)
+#error "DEBUG_CONSOLE_TRANSFER_INTERRUPT is supported for the UART device with FreeRTOS"
+#endif
+#if (DEBUG_CONSOLE_TX_RING_LEN & (DEBUG_CONSOLE_TX_RING_LEN - 1U)) != 0U
+#error "DEBUG_CONSOLE_TX_RING_LEN must be a power of two"
+#endif
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stream_buffer.h"
+
+/*! @brief UART transmit ring and receive stream for interrupt transfer. */
+typedef struct _io_uart_ring
+{
+    uart_handle_t handle;             /*!< transactional driver handle, its interrupt drains the ring */
+    IRQn_Type irq;                    /*!< UART RX/TX interrupt */
+    volatile uint32_t txHead;         /*!< free running index past the bytes the driver may send */
+    volatile uint32_t txTail;         /*!< free running index of the next byte to send */
+    volatile uint32_t txReserve;      /*!< free running index past the room writers have taken */
+    volatile uint32_t txWriters;      /*!< writers copying into the room they have taken */
+    volatile uint32_t txSending;      /*!< bytes handed to the driver, 0 when it is idle */
+    volatile uint32_t txDropped;      /*!< bytes lost to the DROP overflow policy */
+    StreamBufferHandle_t rxStream;    /*!< received characters for GETCHAR and SCANF */
+    uint8_t rxChar;                   /*!< target of the one character receive */
+    uint8_t txRing[DEBUG_CONSOLE_TX_RING_LEN]; /*!< transmit ring */
+} io_uart_ring_t;
+#endif /* DEBUG_CONSOLE_TRANSFER_INTERRUPT */
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
@@ -135,6 +166,11 @@ static io_state_t s_debugConsoleIO = {
 #endif /* DEBUG_CONSOLE_TRANSFER_NON_BLOCKING */
 };
 
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+/*! @brief Debug console UART ring for interrupt transfer. */
+static io_uart_ring_t s_ioUartRing;
+#endif /* DEBUG_CONSOLE_TRANSFER_INTERRUPT */
+
 /*******************************************************************************
  * Code
  ******************************************************************************/
@@ -250,6 +286,266 @@ static void USART_Callback(USART_Type *base, usart_handle_t *handle, status_t st
 #endif /* defined DEBUG_CONSOLE_IO_FLEXCOMM) || (defined DEBUG_CONSOLE_IO_VUSART */
 #endif /* DEBUG_CONSOLE_TRANSFER_NON_BLOCKING */
 
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+/* Hands the bytes from tail up to head or the end of the ring to the driver if it is idle.
+ * Called with interrupts disabled or from the UART interrupt. */
+static void IO_UartRingKick(UART_Type *base)
+{
+    uart_transfer_t transfer;
+    uint32_t offset;
+
+    if ((s_ioUartRing.txSending != 0U) || (s_ioUartRing.txTail == s_ioUartRing.txHead))
+    {
+        return;
+    }
+    offset = s_ioUartRing.txTail & (DEBUG_CONSOLE_TX_RING_LEN - 1U);
+    transfer.data = &s_ioUartRing.txRing[offset];
+    transfer.dataSize = MIN(s_ioUartRing.txHead - s_ioUartRing.txTail, DEBUG_CONSOLE_TX_RING_LEN - offset);
+    s_ioUartRing.txSending = transfer.dataSize;
+    UART_TransferSendNonBlocking(base, &s_ioUartRing.handle, &transfer);
+}
+
+static void IO_UartRingReceiveNext(UART_Type *base)
+{
+    uart_transfer_t transfer;
+
+    transfer.data = &s_ioUartRing.rxChar;
+    transfer.dataSize = 1U;
+    UART_TransferReceiveNonBlocking(base, &s_ioUartRing.handle, &transfer, NULL);
+}
+
+static void IO_UartRingCallback(UART_Type *base, uart_handle_t *handle, status_t status, void *userData)
+{
+    BaseType_t woken = pdFALSE;
+
+    switch (status)
+    {
+        case kStatus_UART_TxIdle:
+            /* the chunk is in the transmit FIFO, give its room back and send the rest */
+            s_ioUartRing.txTail += s_ioUartRing.txSending;
+            s_ioUartRing.txSending = 0U;
+            IO_UartRingKick(base);
+            break;
+
+        case kStatus_UART_RxIdle:
+            /* a full stream drops the character */
+            xStreamBufferSendFromISR(s_ioUartRing.rxStream, &s_ioUartRing.rxChar, 1U, &woken);
+            IO_UartRingReceiveNext(base);
+            break;
+
+        case kStatus_UART_FramingError:
+        case kStatus_UART_ParityError:
+            /* the driver stops receiving after an error unless a new receive is started */
+            IO_UartRingReceiveNext(base);
+            break;
+
+        default:
+            break;
+    }
+
+    portYIELD_FROM_ISR(woken);
+}
+
+static bool IO_UartRingCanWait(void)
+{
+    return (__get_IPSR() == 0U) && (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING);
+}
+
+/* Sends what the ring holds by polling, for callers that cannot wait for the interrupt.
+ * Not possible from an interrupt that preempted the UART interrupt, which is then in the
+ * middle of updating the transfer. Returns false as well when the ring cannot be emptied
+ * because a preempted writer is still copying. */
+static bool IO_UartRingSendPolling(UART_Type *base)
+{
+    uint32_t primask;
+    uint32_t offset;
+    uint32_t size;
+
+    if (NVIC_GetActive(s_ioUartRing.irq) != 0U)
+    {
+        return false;
+    }
+
+    primask = DisableGlobalIRQ();
+    if (s_ioUartRing.txSending != 0U)
+    {
+        /* take the transfer in flight over where the interrupt left it */
+        s_ioUartRing.txTail += s_ioUartRing.txSending - s_ioUartRing.handle.txDataSize;
+        s_ioUartRing.txSending = 0U;
+        UART_TransferAbortSend(base, &s_ioUartRing.handle);
+    }
+    while (s_ioUartRing.txTail != s_ioUartRing.txHead)
+    {
+        offset = s_ioUartRing.txTail & (DEBUG_CONSOLE_TX_RING_LEN - 1U);
+        size = MIN(s_ioUartRing.txHead - s_ioUartRing.txTail, DEBUG_CONSOLE_TX_RING_LEN - offset);
+        UART_WriteBlocking(base, &s_ioUartRing.txRing[offset], size);
+        s_ioUartRing.txTail += size;
+    }
+    /* a preempted writer still holds room the ring cannot give back yet */
+    size = s_ioUartRing.txReserve - s_ioUartRing.txHead;
+    EnableGlobalIRQ(primask);
+
+    return (size == 0U);
+}
+
+/* Copies a log into the room taken for it, DEBUG_CONSOLE_TX_RING_CHUNK bytes at a time with
+ * interrupts enabled. The UART may send a piece as soon as no older writer is still copying. */
+static void IO_UartRingCopy(UART_Type *base, uint32_t start, const uint8_t *ch, uint32_t size)
+{
+    uint32_t primask;
+    uint32_t offset;
+    uint32_t piece;
+    uint32_t done = 0U;
+
+    while (done != size)
+    {
+        offset = (start + done) & (DEBUG_CONSOLE_TX_RING_LEN - 1U);
+        piece = MIN(MIN(size - done, DEBUG_CONSOLE_TX_RING_CHUNK), DEBUG_CONSOLE_TX_RING_LEN - offset);
+        memcpy(&s_ioUartRing.txRing[offset], &ch[done], piece);
+        done += piece;
+
+        primask = DisableGlobalIRQ();
+        if (done == size)
+        {
+            s_ioUartRing.txWriters--;
+            if (s_ioUartRing.txWriters == 0U)
+            {
+                s_ioUartRing.txHead = s_ioUartRing.txReserve;
+            }
+        }
+        else if (s_ioUartRing.txWriters == 1U)
+        {
+            /* the other writers are done, everything before this piece is in the ring */
+            s_ioUartRing.txHead = start + done;
+        }
+        else
+        {
+        }
+        IO_UartRingKick(base);
+        EnableGlobalIRQ(primask);
+    }
+}
+
+static status_t IO_UartRingSend(UART_Type *base, uint8_t *ch, size_t size)
+{
+    uint32_t primask;
+    uint32_t start;
+    size_t chunk;
+
+    while (size != 0U)
+    {
+        /* a log longer than the ring is queued in pieces */
+        chunk = MIN(size, DEBUG_CONSOLE_TX_RING_LEN);
+
+        primask = DisableGlobalIRQ();
+        if (DEBUG_CONSOLE_TX_RING_LEN - (s_ioUartRing.txReserve - s_ioUartRing.txTail) >= chunk)
+        {
+            /* taking the room in one go keeps logs whole, the copy runs with interrupts enabled */
+            start = s_ioUartRing.txReserve;
+            s_ioUartRing.txReserve += chunk;
+            s_ioUartRing.txWriters++;
+            EnableGlobalIRQ(primask);
+
+            IO_UartRingCopy(base, start, ch, chunk);
+            ch += chunk;
+            size -= chunk;
+            continue;
+        }
+#if (DEBUG_CONSOLE_TX_OVERFLOW_POLICY == DEBUG_CONSOLE_TX_OVERFLOW_DROP)
+        s_ioUartRing.txDropped += size;
+        EnableGlobalIRQ(primask);
+        return kStatus_Fail;
+#else
+        EnableGlobalIRQ(primask);
+        if (IO_UartRingCanWait())
+        {
+            /* a tick sends baud rate / 10000 bytes */
+            vTaskDelay(1U);
+        }
+        else if (!IO_UartRingSendPolling(base))
+        {
+            primask = DisableGlobalIRQ();
+            s_ioUartRing.txDropped += size;
+            EnableGlobalIRQ(primask);
+            return kStatus_Fail;
+        }
+        else
+        {
+        }
+#endif /* DEBUG_CONSOLE_TX_OVERFLOW_POLICY */
+    }
+
+    return kStatus_Success;
+}
+
+static status_t IO_UartStreamReceive(uint8_t *ch, size_t size)
+{
+    size_t received;
+
+    while (size != 0U)
+    {
+        received = xStreamBufferReceive(s_ioUartRing.rxStream, ch, size, portMAX_DELAY);
+        ch += received;
+        size -= received;
+    }
+
+    return kStatus_Success;
+}
+
+static void IO_UartRingInit(UART_Type *base)
+{
+    static const IRQn_Type s_uartIrqs[] = UART_RX_TX_IRQS;
+
+    s_ioUartRing.txHead = 0U;
+    s_ioUartRing.txTail = 0U;
+    s_ioUartRing.txReserve = 0U;
+    s_ioUartRing.txWriters = 0U;
+    s_ioUartRing.txSending = 0U;
+    s_ioUartRing.txDropped = 0U;
+    s_ioUartRing.irq = s_uartIrqs[UART_GetInstance(base)];
+    if (s_ioUartRing.rxStream == NULL)
+    {
+        s_ioUartRing.rxStream = xStreamBufferCreate(DEBUG_CONSOLE_RX_STREAM_LEN, 1U);
+        assert(s_ioUartRing.rxStream != NULL);
+    }
+    else
+    {
+        xStreamBufferReset(s_ioUartRing.rxStream);
+    }
+
+    /* create handler for interrupt transfer, it also enables the interrupt */
+    UART_TransferCreateHandle(base, &s_ioUartRing.handle, IO_UartRingCallback, NULL);
+    NVIC_SetPriority(s_ioUartRing.irq, DEBUG_CONSOLE_INTERRUPT_PRIORITY);
+    IO_UartRingReceiveNext(base);
+}
+
+static void IO_UartRingDeinit(UART_Type *base)
+{
+    /* send what is left before the UART goes */
+    IO_UartRingSendPolling(base);
+    UART_TransferAbortReceive(base, &s_ioUartRing.handle);
+    DisableIRQ(s_ioUartRing.irq);
+}
+
+static void IO_UartRingFlush(UART_Type *base)
+{
+    if (!IO_UartRingCanWait())
+    {
+        IO_UartRingSendPolling(base);
+        return;
+    }
+    while (s_ioUartRing.txTail != s_ioUartRing.txReserve)
+    {
+        vTaskDelay(1U);
+    }
+}
+
+uint32_t IO_GetDropCount(void)
+{
+    return s_ioUartRing.txDropped;
+}
+#endif /* DEBUG_CONSOLE_TRANSFER_INTERRUPT */
+
 void IO_Init(io_state_t *io, uint32_t baudRate, uint32_t clkSrcFreq, uint8_t *ringBuffer)
 {
     assert(NULL != io);
@@ -278,6 +574,10 @@ void IO_Init(io_state_t *io, uint32_t baudRate, uint32_t clkSrcFreq, uint8_t *ri
             /* start ring buffer */
             UART_TransferStartRingBuffer(s_debugConsoleIO.ioBase, &s_ioUartHandler, ringBuffer,
                                          DEBUG_CONSOLE_RECEIVE_BUFFER_LEN);
+#endif
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+            /* start transmit ring and receive stream */
+            IO_UartRingInit(s_debugConsoleIO.ioBase);
 #endif
         }
         break;
@@ -401,6 +701,10 @@ status_t IO_Deinit(void)
 #ifdef DEBUG_CONSOLE_TRANSFER_NON_BLOCKING
             /* stop ring buffer */
             UART_TransferStopRingBuffer(s_debugConsoleIO.ioBase, &s_ioUartHandler);
+#endif
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+            /* stop transmit ring and receive stream */
+            IO_UartRingDeinit(s_debugConsoleIO.ioBase);
 #endif
             /* Disable UART module. */
             UART_Deinit((UART_Type *)s_debugConsoleIO.ioBase);
@@ -470,6 +774,10 @@ status_t IO_WaitIdle(void)
     {
 #if (defined DEBUG_CONSOLE_IO_UART)
         case DEBUG_CONSOLE_DEVICE_TYPE_UART:
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+            /* wait transmit ring empty */
+            IO_UartRingFlush(s_debugConsoleIO.ioBase);
+#endif
             /* wait transfer complete flag */
             while (!(UART_GetStatusFlags(s_debugConsoleIO.ioBase) & kUART_TransmissionCompleteFlag))
             {
@@ -727,6 +1035,16 @@ status_t IO_Transfer(uint8_t *ch, size_t size, bool tx)
         case DEBUG_CONSOLE_DEVICE_TYPE_UART:
         case DEBUG_CONSOLE_DEVICE_TYPE_IUART:
         {
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+            if (tx)
+            {
+                status = IO_UartRingSend(s_debugConsoleIO.ioBase, ch, size);
+            }
+            else
+            {
+                status = IO_UartStreamReceive(ch, size);
+            }
+#else
             if (tx)
             {
                 UART_WriteBlocking(s_debugConsoleIO.ioBase, ch, size);
@@ -735,6 +1053,7 @@ status_t IO_Transfer(uint8_t *ch, size_t size, bool tx)
             {
                 status = UART_ReadBlocking(s_debugConsoleIO.ioBase, ch, size);
             }
+#endif /* DEBUG_CONSOLE_TRANSFER_INTERRUPT */
         }
         break;
 #endif
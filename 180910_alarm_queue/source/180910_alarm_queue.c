@@ -47,6 +47,9 @@
 #include "event_groups.h"
 #include "queue.h"
 
+#include "async_log.h"
+#include "msg_pool.h"
+
 
 /* TODO: insert other definitions and declarations here. */
 #define PRINTF_MIN_STACK (110)
@@ -54,6 +57,9 @@
 #define EVENT_SECONDS (1<<0)
 #define EVENT_MINUTES (1<<1)
 #define EVENT_HOURS   (1<<2)
+//un bloque por mensaje en el mailbox, por productor y para print_task
+#define MAILBOX_LENGTH (3)
+#define TIME_MSG_BLOCKS (MAILBOX_LENGTH+4)
 
 //#define FIRST60SCOUNTFLAG_STATE_H 1
 
@@ -71,8 +77,8 @@ typedef struct
 	SemaphoreHandle_t minutes_semaphore;
 	SemaphoreHandle_t hours_semaphore;
 	EventGroupHandle_t event_alarm_signal;
-	SemaphoreHandle_t serial_port_mutex;
 	QueueHandle_t mailbox;
+	msg_pool_t *msg_pool;
 }task_args_t;
 
 //estructura para los mensajes en el mailbox
@@ -115,9 +121,9 @@ void seconds_task(void*args)
 		}
 
 		msg.value = seconds;
-		pmsg = pvPortMalloc(sizeof(time_msg_t));
+		pmsg = msg_pool_alloc(task_args.msg_pool,portMAX_DELAY);
 		*pmsg = msg;
-		xQueueSend(task_args.mailbox,&pmsg,portMAX_DELAY);
+		msg_pool_send(task_args.msg_pool,task_args.mailbox,pmsg,portMAX_DELAY);
 
 
 	}
@@ -147,9 +153,9 @@ void minutes_task(void*args)
 		}
 
 		msg.value = minutes;
-		pmsg = pvPortMalloc(sizeof(time_msg_t));
+		pmsg = msg_pool_alloc(task_args.msg_pool,portMAX_DELAY);
 		*pmsg = msg;
-		xQueueSend(task_args.mailbox,&pmsg,portMAX_DELAY);
+		msg_pool_send(task_args.msg_pool,task_args.mailbox,pmsg,portMAX_DELAY);
 	}
 }
 
@@ -176,9 +182,9 @@ void hours_task(void*args)
 		}
 
 		msg.value = hours;
-		pmsg = pvPortMalloc(sizeof(time_msg_t));
+		pmsg = msg_pool_alloc(task_args.msg_pool,portMAX_DELAY);
 		*pmsg = msg;
-		xQueueSend(task_args.mailbox,&pmsg,portMAX_DELAY);
+		msg_pool_send(task_args.msg_pool,task_args.mailbox,pmsg,portMAX_DELAY);
 	}
 }
 
@@ -188,9 +194,7 @@ void alarm_task(void*args)
 	for(;;)
 	{
 		xEventGroupWaitBits(task_args.event_alarm_signal,EVENT_HOURS|EVENT_MINUTES|EVENT_SECONDS, pdTRUE, pdTRUE, portMAX_DELAY);
-		xSemaphoreTake(task_args.serial_port_mutex,portMAX_DELAY);
-		PRINTF("\rALARM\n");
-		xSemaphoreGive(task_args.serial_port_mutex);
+		ASYNC_LOG("\rALARM\n");
 	}
 }
 
@@ -205,8 +209,6 @@ void print_task(void*args)
 	{
 		xQueueReceive(task_args.mailbox,&received_msg,portMAX_DELAY);
 
-		xSemaphoreTake(task_args.serial_port_mutex,portMAX_DELAY);
-
 		switch (received_msg->time_type) {
 		case seconds_type:
 			seconds = received_msg->value;
@@ -218,13 +220,12 @@ void print_task(void*args)
 			hours   = received_msg->value;
 			break;
 		default:
-			PRINTF("\rError\n");
+			ASYNC_LOG("\rError\n");
 			break;
 		}
 
-		PRINTF("\r%2i:%2i:%2i\n", hours, minutes, seconds);
-		vPortFree(received_msg);
-		xSemaphoreGive(task_args.serial_port_mutex);
+		ASYNC_LOG("\r%2i:%2i:%2i\n", hours, minutes, seconds);
+		msg_pool_free(task_args.msg_pool,received_msg);
 	}
 }
 
@@ -232,10 +233,10 @@ int main(void) {
 
 	static task_args_t args;
 	args.event_alarm_signal = xEventGroupCreate();
-	args.mailbox = xQueueCreate(3,sizeof(time_msg_t*));
+	args.mailbox = xQueueCreate(MAILBOX_LENGTH,sizeof(time_msg_t*));
+	args.msg_pool = msg_pool_create(TIME_MSG_BLOCKS,sizeof(time_msg_t));
 	args.minutes_semaphore = xSemaphoreCreateBinary();
 	args.hours_semaphore = xSemaphoreCreateBinary();
-	args.serial_port_mutex = xSemaphoreCreateMutex();
 
   	/* Init board hardware. */
     BOARD_InitBootPins();
@@ -243,6 +244,9 @@ int main(void) {
     BOARD_InitBootPeripherals();
   	/* Init FSL debug console. */
     BOARD_InitDebugConsole();
+#if MSG_POOL_BENCHMARK
+    msg_pool_benchmark();
+#endif
 
     alarm.hour = 0;
     alarm.minute = 1;
@@ -256,6 +260,8 @@ int main(void) {
     xTaskCreate(hours_task,   "hours",   configMINIMAL_STACK_SIZE, (void*)&args, configMAX_PRIORITIES-1, NULL);
     xTaskCreate(alarm_task,   "alarm",   PRINTF_MIN_STACK,         (void*)&args, configMAX_PRIORITIES-4, NULL);
     xTaskCreate(print_task,   "print",   PRINTF_MIN_STACK,         (void*)&args, configMAX_PRIORITIES-4, NULL);
+    runtime_stats_start();
+    async_log_start();
     vTaskStartScheduler();
 
     /* Enter an infinite loop, just incrementing a counter. */
@@ -131,6 +131,17 @@ status_t IO_WaitIdle(void);
 status_t IO_TryReceiveCharacter(uint8_t *ch);
 #endif
 
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+/*!
+ * @brief io get the dropped transmit bytes.
+ *
+ * Call this function to know how much log the DROP overflow policy lost.
+ *
+ * @return number of bytes dropped since IO_Init.
+ */
+uint32_t IO_GetDropCount(void);
+#endif
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
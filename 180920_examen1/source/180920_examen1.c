@@ -47,6 +47,8 @@
 #include "semphr.h"
 #include "event_groups.h"
 #include "queue.h"
+
+#include "async_log.h"
 /* TODO: insert other definitions and declarations here. */
 #define PRINTF_MIN_STACK (110)
 #define GET_ARGS(args,type) *((type*)args)
@@ -60,7 +62,6 @@ typedef struct
 	char buffer[10];
 
 	EventGroupHandle_t t1t2_signals;
-	SemaphoreHandle_t serial_port_mutex;
 	SemaphoreHandle_t shared_memory_mutex;
 	EventBits_t uxBits;
 
@@ -146,21 +147,15 @@ void task_3_receive(void*args)
 
 		if      (  ( task_args.uxBits & EVENT_T1 ) != 0  )
 		{
-			xSemaphoreTake(task_args.serial_port_mutex,portMAX_DELAY);
-			PRINTF(task_args.buffer);
-			xSemaphoreGive(task_args.serial_port_mutex);
+			async_log_puts(task_args.buffer);
 		}
 		else if(  ( task_args.uxBits & EVENT_T2 ) != 0  )
 		{
-			xSemaphoreTake(task_args.serial_port_mutex,portMAX_DELAY);
-			PRINTF(task_args.buffer);
-			xSemaphoreGive(task_args.serial_port_mutex);
+			async_log_puts(task_args.buffer);
 		}
 		else
 		{
-			xSemaphoreTake(task_args.serial_port_mutex,portMAX_DELAY);
-			PRINTF("\rError\n");
-			xSemaphoreGive(task_args.serial_port_mutex);
+			ASYNC_LOG("\rError\n");
 		}
 
 	}
@@ -186,6 +181,7 @@ int main(void) {
     /* Enter an infinite loop, just incrementing a counter. */
 
     xTaskCreate(initial_task, "init_task", configMINIMAL_STACK_SIZE, (void*)&args, configMAX_PRIORITIES, NULL);
+    async_log_start();
     vTaskStartScheduler();
 
 
@@ -46,6 +46,9 @@
 #include "queue.h"
 #include "semphr.h"
 
+#include "async_log.h"
+#include "msg_pool.h"
+
 #define PRINTF_MIN_STACK (110)
 #define GET_ARGS(args,type) *((type*)args)
 
@@ -53,6 +56,10 @@
 #define EVENT_ALARM_MINUTES (1<<1)
 #define EVENT_ALARM_HOURS	(1<<2)
 
+#define TIME_QUEUE_LENGTH (3)
+/* one block per queued message, per producer and for the printer */
+#define TIME_MSG_BLOCKS (TIME_QUEUE_LENGTH+4)
+
 typedef enum{seconds_type, minutes_type, hours_type} time_types_t;
 
 typedef struct
@@ -75,7 +82,7 @@ typedef struct
 	SemaphoreHandle_t minutes60_sem;
 	EventGroupHandle_t alarm_events;
 	QueueHandle_t time_queue;
-	SemaphoreHandle_t uart_mutex;
+	msg_pool_t *time_pool;
 }task_args_t;
 
 void seconds_task(void *arg)
@@ -104,10 +111,10 @@ void seconds_task(void *arg)
 			seconds = 0;
 			xSemaphoreGive(args.seconds60_sem);
 		}
-		msg = pvPortMalloc(sizeof(time_msg_t));
+		msg = msg_pool_alloc(args.time_pool,portMAX_DELAY);
 		msg->time_type = seconds_type;
 		msg->value = seconds;
-		xQueueSend(args.time_queue,&msg,portMAX_DELAY);
+		msg_pool_send(args.time_pool,args.time_queue,msg,portMAX_DELAY);
 	}
 }
 
@@ -132,10 +139,10 @@ void minutes_task(void *arg)
 			xSemaphoreGive(args.minutes60_sem);
 
 		}
-		msg = pvPortMalloc(sizeof(time_msg_t));
+		msg = msg_pool_alloc(args.time_pool,portMAX_DELAY);
 		msg->time_type = minutes_type;
 		msg->value = minutes;
-		xQueueSend(args.time_queue,&msg,portMAX_DELAY);
+		msg_pool_send(args.time_pool,args.time_queue,msg,portMAX_DELAY);
 	}
 }
 
@@ -157,10 +164,10 @@ void hours_task(void *arg)
 		{
 			hours = 0;
 		}
-		msg = pvPortMalloc(sizeof(time_msg_t));
+		msg = msg_pool_alloc(args.time_pool,portMAX_DELAY);
 		msg->time_type = hours_type;
 		msg->value = hours;
-		xQueueSend(args.time_queue,&msg,portMAX_DELAY);
+		msg_pool_send(args.time_pool,args.time_queue,msg,portMAX_DELAY);
 	}
 }
 
@@ -188,12 +195,10 @@ void print_task(void *arg)
 				hours = msg->value;
 				break;
 			}
-			vPortFree(msg);
+			msg_pool_free(args.time_pool,msg);
 		}while(0!=uxQueueMessagesWaiting(args.time_queue));
 
-		xSemaphoreTake(args.uart_mutex,portMAX_DELAY);
-		PRINTF("\r%i:%i:%i\n",hours,minutes,seconds);
-		xSemaphoreGive(args.uart_mutex);
+		ASYNC_LOG("\r%i:%i:%i\n",hours,minutes,seconds);
 	}
 }
 
@@ -205,9 +210,7 @@ void alarm_task(void *arg)
 		xEventGroupWaitBits(args.alarm_events,
 				EVENT_ALARM_HOURS|EVENT_ALARM_MINUTES|EVENT_ALARM_SECONDS,
 				pdTRUE, pdTRUE, portMAX_DELAY);
-		xSemaphoreTake(args.uart_mutex,portMAX_DELAY);
-		PRINTF("\rAlarm reached!!\n");
-		xSemaphoreGive(args.uart_mutex);
+		ASYNC_LOG("\rAlarm reached!!\n");
 	}
 }
 
@@ -220,14 +223,17 @@ int main(void)
 	BOARD_InitBootPeripherals();
 	/* Init FSL debug console. */
 	BOARD_InitDebugConsole();
+#if MSG_POOL_BENCHMARK
+	msg_pool_benchmark();
+#endif
 
 	time_alarm_t alarm = {0,1,30};
 
 	args.minutes60_sem = xSemaphoreCreateBinary();
 	args.seconds60_sem = xSemaphoreCreateBinary();
-	args.time_queue = xQueueCreate(3,sizeof(time_msg_t*));
+	args.time_queue = xQueueCreate(TIME_QUEUE_LENGTH,sizeof(time_msg_t*));
+	args.time_pool = msg_pool_create(TIME_MSG_BLOCKS,sizeof(time_msg_t));
 	args.alarm_events = xEventGroupCreate();
-	args.uart_mutex = xSemaphoreCreateMutex();
 	args.alarm = alarm;
 
 
@@ -236,6 +242,8 @@ int main(void)
 	xTaskCreate(hours_task, "Hours",PRINTF_MIN_STACK,(void *)&args,configMAX_PRIORITIES-1 ,NULL);
 	xTaskCreate(print_task, "Printer",PRINTF_MIN_STACK,(void *)&args,configMAX_PRIORITIES-4 ,NULL);
 	xTaskCreate(alarm_task, "Alarm",PRINTF_MIN_STACK,(void *)&args,configMAX_PRIORITIES-4 ,NULL);
+	runtime_stats_start();
+	async_log_start();
 	vTaskStartScheduler();
 
 	for(;;)
@@ -71,6 +71,54 @@
 #define DEBUG_CONSOLE_TRANSFER_BLOCKING
 #endif /* DEBUG_CONSOLE_TRANSFER_NON_BLOCKING */
 
+/*! @brief If interrupt transfer is needed, please define DEBUG_CONSOLE_TRANSFER_INTERRUPT at project setting.
+* PRINTF then copies the log into a transmit ring and returns, the UART transmit interrupt sends the ring,
+* and received characters reach GETCHAR and SCANF through a FreeRTOS stream buffer.
+* It is supported for the UART device with FreeRTOS and excludes DEBUG_CONSOLE_TRANSFER_NON_BLOCKING.
+* Call DbgConsole_Flush() to wait until the ring is sent, e.g. before a reset.
+*/
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+/*! @brief define the transmit ring length, it must be a power of two.
+* At 115200 baud the UART sends about 11 bytes per millisecond, the ring absorbs the bursts above that.
+*/
+#ifndef DEBUG_CONSOLE_TX_RING_LEN
+#define DEBUG_CONSOLE_TX_RING_LEN (1024U)
+#endif /* DEBUG_CONSOLE_TX_RING_LEN */
+
+/*! @brief define the size of the pieces a log is copied into the transmit ring in.
+* The copy runs with interrupts enabled, the UART starts sending after the first piece.
+*/
+#ifndef DEBUG_CONSOLE_TX_RING_CHUNK
+#define DEBUG_CONSOLE_TX_RING_CHUNK (64U)
+#endif /* DEBUG_CONSOLE_TX_RING_CHUNK */
+
+/*! @brief define the number of received characters kept until GETCHAR or SCANF reads them,
+* characters received while it is full are lost.
+*/
+#ifndef DEBUG_CONSOLE_RX_STREAM_LEN
+#define DEBUG_CONSOLE_RX_STREAM_LEN (64U)
+#endif /* DEBUG_CONSOLE_RX_STREAM_LEN */
+
+/*! @brief transmit ring overflow policy, what a log that does not fit in the ring does.
+* WAIT: a task waits for the interrupt to make room. Code that cannot wait, an interrupt handler or
+*       main() before the scheduler starts, sends the ring by polling like the blocking transfer does.
+* DROP: the log is dropped and counted, see DbgConsole_GetDropCount(), PRINTF never waits.
+*/
+#define DEBUG_CONSOLE_TX_OVERFLOW_WAIT 0
+#define DEBUG_CONSOLE_TX_OVERFLOW_DROP 1
+#ifndef DEBUG_CONSOLE_TX_OVERFLOW_POLICY
+#define DEBUG_CONSOLE_TX_OVERFLOW_POLICY DEBUG_CONSOLE_TX_OVERFLOW_WAIT
+#endif /* DEBUG_CONSOLE_TX_OVERFLOW_POLICY */
+
+/*! @brief NVIC priority of the debug console UART interrupt.
+* The handler uses the FreeRTOS FromISR API, so it must not be more urgent than
+* configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY.
+*/
+#ifndef DEBUG_CONSOLE_INTERRUPT_PRIORITY
+#define DEBUG_CONSOLE_INTERRUPT_PRIORITY (7U)
+#endif /* DEBUG_CONSOLE_INTERRUPT_PRIORITY */
+#endif /* DEBUG_CONSOLE_TRANSFER_INTERRUPT */
+
 /*!@ brief define the MAX log length debug console support , that is when you call printf("log", x);, the log
 * length can not bigger than this value.
 * This macro decide the local log buffer length, the buffer locate at stack, the stack maybe overflow if
@@ -0,0 +1,901 @@
+/*
+ * FreeRTOS Kernel V10.0.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * An implementation of pvPortMalloc() and vPortFree() whose execution time
+ * does not depend on the number of blocks in the heap, using a two-level
+ * segregated fit (TLSF) scheme.
+ *
+ * Free blocks are kept on lists selected by a first level index (the power of
+ * two below the block size) and a second level index (a linear subdivision of
+ * that power of two).  Two bitmaps record which lists are non-empty, so a
+ * large enough free block is found with a couple of bit scans rather than a
+ * list walk.  Adjacent free blocks are combined as soon as a block is freed.
+ *
+ * Blocks of up to configHEAP_ISR_BLOCK_SIZE_MAX bytes that are freed are kept
+ * in a small per-size cache, up to configHEAP_ISR_CACHE_DEPTH blocks per size.
+ * The cache is guarded by the interrupt mask rather than by suspending the
+ * scheduler, so pvPortMallocFromISR() and vPortFreeFromISR() can use it from
+ * interrupts that are permitted to call the FreeRTOS API.  Blocks freed from an
+ * interrupt that do not fit in the cache are handed back to the allocator by
+ * the next pvPortMalloc() or vPortFree() call.
+ *
+ * The heap is a statically allocated array of configTOTAL_HEAP_SIZE bytes.
+ * Set configAPPLICATION_ALLOCATED_HEAP to 1 to let the application provide
+ * ucHeap[] itself, for example to place it in a particular RAM bank.
+ *
+ * See heap_1.c, heap_2.c, heap_3.c, heap_4.c and heap_5.c for alternative
+ * implementations, and the memory management pages of http://www.FreeRTOS.org
+ * for more information.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* Log2 of the number of second level lists per power of two.  More lists
+waste less memory when rounding a request up, but take more RAM for the list
+heads. */
+#ifndef configHEAP_SL_INDEX_COUNT_LOG2
+	#define configHEAP_SL_INDEX_COUNT_LOG2		4
+#endif
+
+/* Blocks must be smaller than 2^configHEAP_FL_INDEX_MAX bytes, which bounds
+configTOTAL_HEAP_SIZE. */
+#ifndef configHEAP_FL_INDEX_MAX
+	#define configHEAP_FL_INDEX_MAX				20
+#endif
+
+/* Largest block, in bytes, kept in the small block cache used by the ISR
+functions. */
+#ifndef configHEAP_ISR_BLOCK_SIZE_MAX
+	#define configHEAP_ISR_BLOCK_SIZE_MAX		64
+#endif
+
+/* Number of freed blocks of each size kept in the small block cache.  Set to 0
+to remove the cache, in which case pvPortMallocFromISR() always fails. */
+#ifndef configHEAP_ISR_CACHE_DEPTH
+	#define configHEAP_ISR_CACHE_DEPTH			4
+#endif
+
+#if portBYTE_ALIGNMENT == 32
+	#define heapALIGNMENT_LOG2	5
+#elif portBYTE_ALIGNMENT == 16
+	#define heapALIGNMENT_LOG2	4
+#elif portBYTE_ALIGNMENT == 8
+	#define heapALIGNMENT_LOG2	3
+#elif portBYTE_ALIGNMENT == 4
+	#define heapALIGNMENT_LOG2	2
+#else
+	#error heap_6.c requires portBYTE_ALIGNMENT to be 4, 8, 16 or 32
+#endif
+
+#if( configHEAP_SL_INDEX_COUNT_LOG2 > 5 )
+	#error configHEAP_SL_INDEX_COUNT_LOG2 must not exceed 5
+#endif
+
+/* Blocks smaller than heapSMALL_BLOCK_SIZE all live in first level list 0,
+split linearly into second level lists of portBYTE_ALIGNMENT bytes each. */
+#define heapSL_INDEX_COUNT		( 1U << configHEAP_SL_INDEX_COUNT_LOG2 )
+#define heapFL_INDEX_SHIFT		( configHEAP_SL_INDEX_COUNT_LOG2 + heapALIGNMENT_LOG2 )
+#define heapFL_INDEX_COUNT		( configHEAP_FL_INDEX_MAX - heapFL_INDEX_SHIFT + 1 )
+#define heapSMALL_BLOCK_SIZE	( ( size_t ) 1 << heapFL_INDEX_SHIFT )
+
+#if( heapFL_INDEX_COUNT > 31 ) || ( heapFL_INDEX_COUNT < 1 )
+	#error configHEAP_FL_INDEX_MAX is out of range
+#endif
+
+/* The block size holds the size of the payload, which is always a multiple of
+portBYTE_ALIGNMENT, so the bottom bit is free to mark free blocks. */
+#define heapBLOCK_FREE_BIT		( ( size_t ) 1 )
+
+/* Allocate the memory for the heap. */
+#if( configAPPLICATION_ALLOCATED_HEAP == 1 )
+	/* The application writer has already defined the array used for the RTOS
+	heap - probably so it can be placed in a special segment or address. */
+	extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+	static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+/* Every block, free or allocated, starts with the physical neighbour pointer
+and the size.  The free list links overlay the start of the payload, so they
+only exist while the block is free, or while it sits in the small block cache
+or on the deferred free list. */
+typedef struct A_BLOCK_HEADER
+{
+	struct A_BLOCK_HEADER *pxPrevPhysBlock;	/*<< The block immediately below this one in memory, NULL for the first block. */
+	size_t xBlockSize;						/*<< The size of the payload, ORed with heapBLOCK_FREE_BIT while on a free list. */
+	struct A_BLOCK_HEADER *pxNextFreeBlock;	/*<< The next block on the same list. */
+	struct A_BLOCK_HEADER *pxPrevFreeBlock;	/*<< The previous block on the same free list. */
+} BlockHeader_t;
+
+/* The size of the part of BlockHeader_t that is always present, rounded up so
+the payload stays correctly aligned. */
+static const size_t xHeapStructSize = ( offsetof( BlockHeader_t, pxNextFreeBlock ) + ( ( size_t ) portBYTE_ALIGNMENT_MASK ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* The end marker is accessed as a whole BlockHeader_t, so it gets a full,
+aligned header's worth of space. */
+static const size_t xHeapEndSize = ( sizeof( BlockHeader_t ) + ( ( size_t ) portBYTE_ALIGNMENT_MASK ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* Payloads must be large enough to hold the free list links. */
+#define heapMINIMUM_BLOCK_SIZE	( ( sizeof( BlockHeader_t ) - offsetof( BlockHeader_t, pxNextFreeBlock ) + ( ( size_t ) portBYTE_ALIGNMENT_MASK ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called automatically to setup the required heap structures the first time
+ * pvPortMalloc() is called.
+ */
+static void prvHeapInit( void );
+
+/*
+ * Compute the list that holds blocks of exactly xSize bytes, used when freeing.
+ */
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+/*
+ * Compute the first list whose blocks are all at least xSize bytes, used when
+ * allocating.
+ */
+static void prvMappingSearch( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+/*
+ * Put a block on, and take a block off, the free lists.
+ */
+static void prvInsertFreeBlock( BlockHeader_t *pxBlock );
+static void prvRemoveFreeBlock( BlockHeader_t *pxBlock, UBaseType_t uxFL, UBaseType_t uxSL );
+
+/*
+ * Take a free block of at least xSize bytes, splitting off what is not needed.
+ * Returns NULL if no free block is large enough.
+ */
+static BlockHeader_t *prvBlockAllocate( size_t xSize );
+
+/*
+ * Return an allocated block to the free lists, combining it with its free
+ * neighbours.
+ */
+static void prvBlockRelease( BlockHeader_t *pxBlock );
+
+/*
+ * Release the blocks that vPortFreeFromISR() could not cache.
+ */
+static void prvDrainDeferredFrees( void );
+
+/*-----------------------------------------------------------*/
+
+/* The free lists and the bitmaps recording which of them are non-empty. */
+static BlockHeader_t *pxFreeLists[ heapFL_INDEX_COUNT ][ heapSL_INDEX_COUNT ];
+static uint32_t ulFLBitmap = 0U;
+static uint32_t ulSLBitmap[ heapFL_INDEX_COUNT ];
+
+/* The zero sized, permanently allocated block at the end of the heap.  NULL
+until the heap has been initialised. */
+static BlockHeader_t *pxEnd = NULL;
+
+/* Blocks freed by vPortFreeFromISR() that could not be cached. */
+static BlockHeader_t *pxDeferredFrees = NULL;
+
+/* Keeps track of the number of free bytes remaining, but says nothing about
+fragmentation.  xCachedBytes counts the bytes held in the small block cache,
+which are available to pvPortMalloc() too. */
+static size_t xFreeBytesRemaining = 0U;
+static size_t xCachedBytes = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+static size_t xNumberOfFreeBlocks = 0U;
+static size_t xNumberOfSuccessfulAllocations = 0U;
+static size_t xNumberOfSuccessfulFrees = 0U;
+
+#if( configHEAP_ISR_CACHE_DEPTH > 0 )
+	#define heapCACHE_CLASS_COUNT	( configHEAP_ISR_BLOCK_SIZE_MAX >> heapALIGNMENT_LOG2 )
+
+	/* One LIFO list of free blocks per multiple of portBYTE_ALIGNMENT. */
+	static BlockHeader_t *pxCache[ heapCACHE_CLASS_COUNT ];
+	static UBaseType_t uxCacheCount[ heapCACHE_CLASS_COUNT ];
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Position of the most significant set bit. */
+static portFORCE_INLINE UBaseType_t prvFLS( size_t xValue )
+{
+	#if defined( __GNUC__ )
+		return ( UBaseType_t ) ( ( sizeof( unsigned long ) * 8U ) - 1U - ( size_t ) __builtin_clzl( ( unsigned long ) xValue ) );
+	#else
+		UBaseType_t uxBit = 0U;
+
+		while( ( xValue >>= 1 ) != 0U )
+		{
+			uxBit++;
+		}
+		return uxBit;
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+/* Position of the least significant set bit. */
+static portFORCE_INLINE UBaseType_t prvFFS( uint32_t ulValue )
+{
+	#if defined( __GNUC__ )
+		return ( UBaseType_t ) __builtin_ctz( ulValue );
+	#else
+		UBaseType_t uxBit = 0U;
+
+		while( ( ulValue & 1U ) == 0U )
+		{
+			ulValue >>= 1;
+			uxBit++;
+		}
+		return uxBit;
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static portFORCE_INLINE size_t prvBlockSize( const BlockHeader_t *pxBlock )
+{
+	return pxBlock->xBlockSize & ~heapBLOCK_FREE_BIT;
+}
+/*-----------------------------------------------------------*/
+
+static portFORCE_INLINE BlockHeader_t *prvNextPhysBlock( const BlockHeader_t *pxBlock )
+{
+	return ( BlockHeader_t * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize + prvBlockSize( pxBlock ) );
+}
+/*-----------------------------------------------------------*/
+
+/* Round a request up to a block payload size, or return 0 if it can never be
+satisfied. */
+static portFORCE_INLINE size_t prvAdjustSize( size_t xWantedSize )
+{
+size_t xSize = 0U;
+
+	if( ( xWantedSize > 0U ) && ( xWantedSize < ( ( size_t ) 1 << configHEAP_FL_INDEX_MAX ) ) )
+	{
+		xSize = ( xWantedSize + ( size_t ) portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+		if( xSize < heapMINIMUM_BLOCK_SIZE )
+		{
+			xSize = heapMINIMUM_BLOCK_SIZE;
+		}
+	}
+
+	return xSize;
+}
+/*-----------------------------------------------------------*/
+
+#if( configHEAP_ISR_CACHE_DEPTH > 0 )
+
+	/* Take a block of exactly xSize bytes from the small block cache.  Safe to
+	call from tasks and from interrupts. */
+	static void *prvCacheGet( size_t xSize )
+	{
+	BlockHeader_t *pxBlock = NULL;
+	UBaseType_t uxClass, uxSavedInterruptStatus;
+
+		if( xSize <= configHEAP_ISR_BLOCK_SIZE_MAX )
+		{
+			uxClass = ( UBaseType_t ) ( xSize >> heapALIGNMENT_LOG2 ) - 1U;
+
+			uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+			{
+				pxBlock = pxCache[ uxClass ];
+				if( pxBlock != NULL )
+				{
+					pxCache[ uxClass ] = pxBlock->pxNextFreeBlock;
+					uxCacheCount[ uxClass ]--;
+					xCachedBytes -= xSize;
+					xNumberOfSuccessfulAllocations++;
+				}
+			}
+			portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+		}
+
+		return ( pxBlock != NULL ) ? ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize ) : NULL;
+	}
+	/*-----------------------------------------------------------*/
+
+	/* Keep an allocated block in the small block cache if it is small enough
+	and its list is not full.  Safe to call from tasks and from interrupts. */
+	static BaseType_t prvCachePut( BlockHeader_t *pxBlock )
+	{
+	BaseType_t xReturn = pdFALSE;
+	size_t xSize = prvBlockSize( pxBlock );
+	UBaseType_t uxClass, uxSavedInterruptStatus;
+
+		if( xSize <= configHEAP_ISR_BLOCK_SIZE_MAX )
+		{
+			uxClass = ( UBaseType_t ) ( xSize >> heapALIGNMENT_LOG2 ) - 1U;
+
+			uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+			{
+				if( uxCacheCount[ uxClass ] < configHEAP_ISR_CACHE_DEPTH )
+				{
+					pxBlock->pxNextFreeBlock = pxCache[ uxClass ];
+					pxCache[ uxClass ] = pxBlock;
+					uxCacheCount[ uxClass ]++;
+					xCachedBytes += xSize;
+					xNumberOfSuccessfulFrees++;
+					xReturn = pdTRUE;
+				}
+			}
+			portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	/* Give every cached block back to the free lists so they can be combined.
+	Called with the scheduler suspended when an allocation would fail. */
+	static void prvCacheFlush( void )
+	{
+	BlockHeader_t *pxBlock;
+	UBaseType_t uxClass, uxSavedInterruptStatus;
+
+		for( uxClass = 0U; uxClass < heapCACHE_CLASS_COUNT; uxClass++ )
+		{
+			uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+			{
+				pxBlock = pxCache[ uxClass ];
+				pxCache[ uxClass ] = NULL;
+				xCachedBytes -= ( size_t ) ( uxClass + 1U ) * ( size_t ) portBYTE_ALIGNMENT * ( size_t ) uxCacheCount[ uxClass ];
+				uxCacheCount[ uxClass ] = 0U;
+			}
+			portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+			while( pxBlock != NULL )
+			{
+				BlockHeader_t *pxNext = pxBlock->pxNextFreeBlock;
+
+				prvBlockRelease( pxBlock );
+				pxBlock = pxNext;
+			}
+		}
+	}
+
+#else
+
+	#define prvCacheGet( xSize )	( ( void * ) NULL )
+	#define prvCachePut( pxBlock )	( pdFALSE )
+	#define prvCacheFlush()
+
+#endif /* configHEAP_ISR_CACHE_DEPTH */
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+BlockHeader_t *pxBlock;
+void *pvReturn = NULL;
+size_t xSize;
+UBaseType_t uxSavedInterruptStatus;
+
+	vTaskSuspendAll();
+	{
+		/* If this is the first call to malloc then the heap will require
+		initialisation to setup the list of free blocks. */
+		if( pxEnd == NULL )
+		{
+			prvHeapInit();
+		}
+		else
+		{
+			prvDrainDeferredFrees();
+		}
+
+		xSize = prvAdjustSize( xWantedSize );
+		if( xSize > 0U )
+		{
+			pvReturn = prvCacheGet( xSize );
+
+			if( pvReturn == NULL )
+			{
+				pxBlock = prvBlockAllocate( xSize );
+
+				if( pxBlock == NULL )
+				{
+					/* Cached blocks may be what stops a larger block being
+					formed. */
+					prvCacheFlush();
+					pxBlock = prvBlockAllocate( xSize );
+				}
+
+				if( pxBlock != NULL )
+				{
+					pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+
+					uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+					{
+						xNumberOfSuccessfulAllocations++;
+					}
+					portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+				}
+			}
+
+			if( ( xFreeBytesRemaining + xCachedBytes ) < xMinimumEverFreeBytesRemaining )
+			{
+				xMinimumEverFreeBytesRemaining = xFreeBytesRemaining + xCachedBytes;
+			}
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+	}
+	#endif
+
+	configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+BlockHeader_t *pxBlock;
+UBaseType_t uxSavedInterruptStatus;
+
+	if( pv != NULL )
+	{
+		pxBlock = ( BlockHeader_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+		/* Check the block is actually allocated. */
+		configASSERT( ( pxBlock->xBlockSize & heapBLOCK_FREE_BIT ) == 0 );
+		configASSERT( ( ( uint8_t * ) pxBlock >= ucHeap ) && ( pxBlock < pxEnd ) );
+
+		vTaskSuspendAll();
+		{
+			prvDrainDeferredFrees();
+			traceFREE( pv, prvBlockSize( pxBlock ) );
+
+			if( prvCachePut( pxBlock ) == pdFALSE )
+			{
+				prvBlockRelease( pxBlock );
+
+				uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+				{
+					xNumberOfSuccessfulFrees++;
+				}
+				portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMallocFromISR( size_t xWantedSize )
+{
+void *pvReturn = NULL;
+size_t xSize;
+
+	/* Before the first pvPortMalloc() there is nothing in the cache. */
+	if( pxEnd != NULL )
+	{
+		xSize = prvAdjustSize( xWantedSize );
+		if( xSize > 0U )
+		{
+			pvReturn = prvCacheGet( xSize );
+		}
+	}
+
+	traceMALLOC( pvReturn, xWantedSize );
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFreeFromISR( void *pv )
+{
+BlockHeader_t *pxBlock;
+UBaseType_t uxSavedInterruptStatus;
+
+	if( pv != NULL )
+	{
+		pxBlock = ( BlockHeader_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+		configASSERT( ( pxBlock->xBlockSize & heapBLOCK_FREE_BIT ) == 0 );
+		configASSERT( ( ( uint8_t * ) pxBlock >= ucHeap ) && ( pxBlock < pxEnd ) );
+		traceFREE( pv, prvBlockSize( pxBlock ) );
+
+		if( prvCachePut( pxBlock ) == pdFALSE )
+		{
+			/* The free lists can only be changed with the scheduler suspended,
+			so leave the block for the next task level call. */
+			uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+			{
+				pxBlock->pxNextFreeBlock = pxDeferredFrees;
+				pxDeferredFrees = pxBlock;
+				xNumberOfSuccessfulFrees++;
+			}
+			portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortHeapFillISRCache( size_t xWantedSize, UBaseType_t uxCount )
+{
+UBaseType_t uxCached = 0U;
+
+	#if( configHEAP_ISR_CACHE_DEPTH > 0 )
+	{
+	BlockHeader_t *pxBlock;
+	size_t xSize = prvAdjustSize( xWantedSize );
+	UBaseType_t uxClass;
+
+		if( ( xSize > 0U ) && ( xSize <= configHEAP_ISR_BLOCK_SIZE_MAX ) )
+		{
+			uxClass = ( UBaseType_t ) ( xSize >> heapALIGNMENT_LOG2 ) - 1U;
+
+			vTaskSuspendAll();
+			{
+				if( pxEnd == NULL )
+				{
+					prvHeapInit();
+				}
+
+				while( ( uxCount > 0U ) && ( uxCacheCount[ uxClass ] < configHEAP_ISR_CACHE_DEPTH ) )
+				{
+					pxBlock = prvBlockAllocate( xSize );
+
+					/* A block that was not split would land in the cache for
+					a larger size. */
+					if( ( pxBlock != NULL ) && ( prvBlockSize( pxBlock ) != xSize ) )
+					{
+						prvBlockRelease( pxBlock );
+						pxBlock = NULL;
+					}
+
+					if( pxBlock == NULL )
+					{
+						break;
+					}
+
+					/* prvCachePut() counts a free that never had a matching
+					allocation, so count one here. */
+					xNumberOfSuccessfulAllocations++;
+					( void ) prvCachePut( pxBlock );
+					uxCount--;
+				}
+
+				uxCached = uxCacheCount[ uxClass ];
+			}
+			( void ) xTaskResumeAll();
+		}
+	}
+	#else
+	{
+		( void ) xWantedSize;
+		( void ) uxCount;
+	}
+	#endif /* configHEAP_ISR_CACHE_DEPTH */
+
+	return uxCached;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining + xCachedBytes;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+BlockHeader_t *pxBlock;
+UBaseType_t uxFL, uxSL;
+size_t xMaxSize = 0U, xMinSize = 0U;
+
+	vTaskSuspendAll();
+	{
+		if( ulFLBitmap != 0U )
+		{
+			/* Only the highest and lowest non-empty lists can hold the largest
+			and smallest blocks. */
+			uxFL = prvFLS( ulFLBitmap );
+			uxSL = prvFLS( ulSLBitmap[ uxFL ] );
+			for( pxBlock = pxFreeLists[ uxFL ][ uxSL ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+			{
+				if( prvBlockSize( pxBlock ) > xMaxSize )
+				{
+					xMaxSize = prvBlockSize( pxBlock );
+				}
+			}
+
+			uxFL = prvFFS( ulFLBitmap );
+			uxSL = prvFFS( ulSLBitmap[ uxFL ] );
+			xMinSize = xMaxSize;
+			for( pxBlock = pxFreeLists[ uxFL ][ uxSL ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+			{
+				if( prvBlockSize( pxBlock ) < xMinSize )
+				{
+					xMinSize = prvBlockSize( pxBlock );
+				}
+			}
+		}
+
+		pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining + xCachedBytes;
+		pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+		pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+		pxHeapStats->xNumberOfFreeBlocks = xNumberOfFreeBlocks;
+		pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+		pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+		pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+UBaseType_t uxFL, uxSL;
+
+	if( xSize < heapSMALL_BLOCK_SIZE )
+	{
+		uxFL = 0U;
+		uxSL = ( UBaseType_t ) ( xSize >> heapALIGNMENT_LOG2 );
+	}
+	else
+	{
+		uxFL = prvFLS( xSize );
+		uxSL = ( UBaseType_t ) ( xSize >> ( uxFL - configHEAP_SL_INDEX_COUNT_LOG2 ) ) ^ heapSL_INDEX_COUNT;
+		uxFL -= ( heapFL_INDEX_SHIFT - 1U );
+	}
+
+	*puxFL = uxFL;
+	*puxSL = uxSL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingSearch( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+	/* Round up to the start of the next list, so every block on the list found
+	is large enough. */
+	if( xSize >= heapSMALL_BLOCK_SIZE )
+	{
+		xSize += ( ( size_t ) 1 << ( prvFLS( xSize ) - configHEAP_SL_INDEX_COUNT_LOG2 ) ) - 1U;
+	}
+
+	prvMappingInsert( xSize, puxFL, puxSL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( BlockHeader_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+size_t xSize = prvBlockSize( pxBlock );
+
+	prvMappingInsert( xSize, &uxFL, &uxSL );
+
+	pxBlock->xBlockSize = xSize | heapBLOCK_FREE_BIT;
+	pxBlock->pxPrevFreeBlock = NULL;
+	pxBlock->pxNextFreeBlock = pxFreeLists[ uxFL ][ uxSL ];
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock;
+	}
+	pxFreeLists[ uxFL ][ uxSL ] = pxBlock;
+
+	ulFLBitmap |= 1UL << uxFL;
+	ulSLBitmap[ uxFL ] |= 1UL << uxSL;
+
+	xFreeBytesRemaining += xSize;
+	xNumberOfFreeBlocks++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( BlockHeader_t *pxBlock, UBaseType_t uxFL, UBaseType_t uxSL )
+{
+size_t xSize = prvBlockSize( pxBlock );
+
+	if( pxBlock->pxPrevFreeBlock != NULL )
+	{
+		pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		pxFreeLists[ uxFL ][ uxSL ] = pxBlock->pxNextFreeBlock;
+		if( pxFreeLists[ uxFL ][ uxSL ] == NULL )
+		{
+			ulSLBitmap[ uxFL ] &= ~( 1UL << uxSL );
+			if( ulSLBitmap[ uxFL ] == 0U )
+			{
+				ulFLBitmap &= ~( 1UL << uxFL );
+			}
+		}
+	}
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+	}
+
+	pxBlock->xBlockSize = xSize;
+
+	xFreeBytesRemaining -= xSize;
+	xNumberOfFreeBlocks--;
+}
+/*-----------------------------------------------------------*/
+
+static BlockHeader_t *prvBlockAllocate( size_t xSize )
+{
+BlockHeader_t *pxBlock = NULL, *pxNewBlock;
+UBaseType_t uxFL, uxSL;
+uint32_t ulMap;
+size_t xRemaining;
+
+	prvMappingSearch( xSize, &uxFL, &uxSL );
+
+	if( uxFL < heapFL_INDEX_COUNT )
+	{
+		/* First look for a list in this power of two, then for the smallest
+		non-empty list in any larger one. */
+		ulMap = ulSLBitmap[ uxFL ] & ( ( uint32_t ) ~0UL << uxSL );
+		if( ulMap == 0U )
+		{
+			ulMap = ulFLBitmap & ( ( uint32_t ) ~0UL << ( uxFL + 1U ) );
+			if( ulMap != 0U )
+			{
+				uxFL = prvFFS( ulMap );
+				ulMap = ulSLBitmap[ uxFL ];
+			}
+		}
+
+		if( ulMap != 0U )
+		{
+			uxSL = prvFFS( ulMap );
+			pxBlock = pxFreeLists[ uxFL ][ uxSL ];
+			prvRemoveFreeBlock( pxBlock, uxFL, uxSL );
+
+			/* If the block is larger than required it can be split into two. */
+			xRemaining = prvBlockSize( pxBlock ) - xSize;
+			if( xRemaining >= ( xHeapStructSize + heapMINIMUM_BLOCK_SIZE ) )
+			{
+				pxNewBlock = ( BlockHeader_t * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize + xSize );
+				pxNewBlock->xBlockSize = xRemaining - xHeapStructSize;
+				pxNewBlock->pxPrevPhysBlock = pxBlock;
+				prvNextPhysBlock( pxNewBlock )->pxPrevPhysBlock = pxNewBlock;
+				pxBlock->xBlockSize = xSize;
+
+				prvInsertFreeBlock( pxNewBlock );
+			}
+		}
+	}
+
+	return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBlockRelease( BlockHeader_t *pxBlock )
+{
+BlockHeader_t *pxNeighbour;
+UBaseType_t uxFL, uxSL;
+
+	/* Combine with the block below if it is free. */
+	pxNeighbour = pxBlock->pxPrevPhysBlock;
+	if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xBlockSize & heapBLOCK_FREE_BIT ) != 0 ) )
+	{
+		prvMappingInsert( prvBlockSize( pxNeighbour ), &uxFL, &uxSL );
+		prvRemoveFreeBlock( pxNeighbour, uxFL, uxSL );
+		pxNeighbour->xBlockSize += xHeapStructSize + pxBlock->xBlockSize;
+		pxBlock = pxNeighbour;
+		prvNextPhysBlock( pxBlock )->pxPrevPhysBlock = pxBlock;
+	}
+
+	/* Combine with the block above if it is free.  pxEnd is never free. */
+	pxNeighbour = prvNextPhysBlock( pxBlock );
+	if( ( pxNeighbour->xBlockSize & heapBLOCK_FREE_BIT ) != 0 )
+	{
+		prvMappingInsert( prvBlockSize( pxNeighbour ), &uxFL, &uxSL );
+		prvRemoveFreeBlock( pxNeighbour, uxFL, uxSL );
+		pxBlock->xBlockSize += xHeapStructSize + pxNeighbour->xBlockSize;
+		prvNextPhysBlock( pxBlock )->pxPrevPhysBlock = pxBlock;
+	}
+
+	prvInsertFreeBlock( pxBlock );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDrainDeferredFrees( void )
+{
+BlockHeader_t *pxBlock, *pxNext;
+UBaseType_t uxSavedInterruptStatus;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		pxBlock = pxDeferredFrees;
+		pxDeferredFrees = NULL;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	while( pxBlock != NULL )
+	{
+		pxNext = pxBlock->pxNextFreeBlock;
+		prvBlockRelease( pxBlock );
+		pxBlock = pxNext;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+BlockHeader_t *pxFirstFreeBlock;
+size_t uxAddress, xTotalHeapSize = configTOTAL_HEAP_SIZE;
+
+	/* Ensure the heap starts on a correctly aligned boundary. */
+	uxAddress = ( size_t ) ucHeap;
+	if( ( uxAddress & ( size_t ) portBYTE_ALIGNMENT_MASK ) != 0 )
+	{
+		uxAddress += ( size_t ) portBYTE_ALIGNMENT_MASK;
+		uxAddress &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+		xTotalHeapSize -= uxAddress - ( size_t ) ucHeap;
+	}
+	xTotalHeapSize &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+	/* One free block covering the heap, followed by a zero sized block that is
+	never freed, so the last real block has no free neighbour above it. */
+	pxFirstFreeBlock = ( BlockHeader_t * ) uxAddress;
+	pxFirstFreeBlock->pxPrevPhysBlock = NULL;
+	pxFirstFreeBlock->xBlockSize = xTotalHeapSize - xHeapStructSize - xHeapEndSize;
+	configASSERT( pxFirstFreeBlock->xBlockSize < ( ( size_t ) 1 << configHEAP_FL_INDEX_MAX ) );
+
+	pxEnd = prvNextPhysBlock( pxFirstFreeBlock );
+	pxEnd->pxPrevPhysBlock = pxFirstFreeBlock;
+	pxEnd->xBlockSize = 0U;
+
+	prvInsertFreeBlock( pxFirstFreeBlock );
+	xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+}
@@ -61,7 +61,7 @@
 
 /* NOTE!!
  * The configFRTOS_MEMORY_SCHEME macro describes the heap scheme using a value
- * 1 - 5 which corresponds to the following schemes:
+ * 1 - 6 which corresponds to the following schemes:
  *
  * heap_1 - the very simplest, does not permit memory to be freed
  * heap_2 - permits memory to be freed, but not does coalescence adjacent free
@@ -71,12 +71,14 @@
  *          absolute address placement option
  * heap_5 - as per heap_4, with the ability to span the heap across
  *          multiple nonOadjacent memory areas
+ * heap_6 - two-level segregated fit, constant time allocation and free, with
+ *          a small block cache usable from interrupts
  */
 #ifndef configFRTOS_MEMORY_SCHEME
 #define configFRTOS_MEMORY_SCHEME 3 /* thread safe malloc */
 #endif
 
-#if ((configFRTOS_MEMORY_SCHEME > 5) || (configFRTOS_MEMORY_SCHEME < 1))
+#if ((configFRTOS_MEMORY_SCHEME > 6) || (configFRTOS_MEMORY_SCHEME < 1))
 #error "Invalid configFRTOS_MEMORY_SCHEME setting!"
 #endif
 
@@ -132,6 +132,38 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+/* Used by heap_6.c. */
+typedef struct xHeapStats
+{
+	size_t xAvailableHeapSpaceInBytes;		/* The total heap size currently available - this is the sum of all the free blocks, not the largest block that can be allocated. */
+	size_t xSizeOfLargestFreeBlockInBytes;	/* The maximum size, in bytes, of all the free blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xSizeOfSmallestFreeBlockInBytes;	/* The minimum size, in bytes, of all the free blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xNumberOfFreeBlocks;				/* The number of free memory blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xMinimumEverFreeBytesRemaining;	/* The minimum amount of total free memory (sum of all free blocks) there has been in the heap since the system booted. */
+	size_t xNumberOfSuccessfulAllocations;	/* The number of calls to pvPortMalloc() that have returned a valid memory block. */
+	size_t xNumberOfSuccessfulFrees;		/* The number of calls to vPortFree() that has successfully freed a block of memory. */
+} HeapStats_t;
+
+/*
+ * Fills pxHeapStats with a snapshot of the heap.  Fragmentation can be judged
+ * by comparing xSizeOfLargestFreeBlockInBytes with xAvailableHeapSpaceInBytes,
+ * and the high-water mark is configTOTAL_HEAP_SIZE less
+ * xMinimumEverFreeBytesRemaining.
+ */
+void vPortGetHeapStats( HeapStats_t *pxHeapStats ) PRIVILEGED_FUNCTION;
+
+/*
+ * Allocate and free small blocks from an interrupt, used by heap_6.c.  Only
+ * blocks held in the allocator's small block cache can be returned by
+ * pvPortMallocFromISR(), which returns NULL when the cache for the requested
+ * size is empty.  uxPortHeapFillISRCache() moves up to uxCount blocks of
+ * xWantedSize bytes into that cache from task context, and returns the number
+ * of blocks now cached for that size.
+ */
+void *pvPortMallocFromISR( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+void vPortFreeFromISR( void *pv ) PRIVILEGED_FUNCTION;
+UBaseType_t uxPortHeapFillISRCache( size_t xWantedSize, UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
 /*
  * Setup the hardware ready for the scheduler to take control.  This generally
  * sets up a tick interrupt and sets timers for the correct tick frequency.
@@ -0,0 +1,386 @@
+/*
+ * Checksum offload of ethernetif (CHECKSUM_BY_HARDWARE) on the ENET model.
+ *
+ * Feeds UDP datagrams to a bound pcb and checks which ones the stack delivers:
+ * good ones, ones without a UDP checksum, ones with a bad UDP or IP header
+ * checksum, fragmented ones with a good and with a bad UDP checksum, and a bad
+ * frame followed by a good one in the same burst. The ENET cannot check
+ * fragments, so the bad fragmented datagram has to be caught in software.
+ * With enhanced descriptors the driver counts the errors the ENET reports,
+ * with legacy descriptors the ENET discards the frames itself.
+ *
+ * Then sends a datagram that fits a frame and one that is fragmented: the
+ * first must leave with its checksum fields cleared for the ENET to fill in,
+ * the second with the UDP checksum computed in software.
+ *
+ *   make -C host chksum_offload_enhanced chksum_offload_legacy
+ *   host/chksum_offload_enhanced
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/udp.h"
+#include "lwip/etharp.h"
+#include "netif/ethernet.h"
+#include "ethernetif.h"
+#include "enet_model.h"
+
+#undef memcpy
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TEST_PORT 7U
+#define TEST_PEER_PORT 40000U
+#define TEST_FRAG_PAYLOAD 2000U
+#define TEST_FRAG_SIZE 1480U /* fragment payload, a multiple of 8 */
+
+#ifdef ENET_ENHANCEDBUFFERDESCRIPTOR_MODE
+#define TEST_ENHANCED 1
+#else
+#define TEST_ENHANCED 0
+#endif
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const uint8_t s_mac[6] = {0x02, 0x12, 0x13, 0x10, 0x15, 0x11};
+static const uint8_t s_peerMac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t s_addrs[8] = {192, 168, 1, 1, 192, 168, 1, 102};
+
+static struct netif s_netif;
+static volatile uint32_t s_delivered;
+static uint32_t s_failures;
+
+/* Datagrams the wire saw, reassembled. */
+static uint8_t s_wire[TEST_FRAG_PAYLOAD + 8U];
+static volatile uint32_t s_wireLen;
+static volatile bool s_wireDone;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static void put16(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static uint32_t get16(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 8) | p[1];
+}
+
+/* UDP checksum over the pseudo header of s_addrs-like addresses, 0 if valid when filled in. */
+static uint16_t udp_chksum(const uint8_t *addrs, const uint8_t *udp, uint32_t udpLen)
+{
+    uint8_t pseudo[12];
+    uint32_t sum;
+
+    memcpy(pseudo, addrs, 8);
+    pseudo[8] = 0U;
+    pseudo[9] = 17U;
+    put16(&pseudo[10], udpLen);
+    /* Adding the complements of two checksums gives the complement of the checksum of both. */
+    sum = (uint16_t)~enet_model_chksum(pseudo, sizeof(pseudo));
+    sum += (uint16_t)~enet_model_chksum(udp, udpLen);
+    sum = (sum & 0xFFFFU) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+/* Builds a UDP datagram, header included, with a valid or bad checksum; 0 leaves it unset. */
+static uint32_t build_udp(uint8_t *udp, uint32_t payload, uint32_t seq, int chksum)
+{
+    uint32_t udpLen = 8U + payload;
+    uint32_t i;
+    uint16_t sum;
+
+    put16(&udp[0], TEST_PEER_PORT);
+    put16(&udp[2], TEST_PORT);
+    put16(&udp[4], udpLen);
+    put16(&udp[6], 0U);
+    for (i = 0U; i < payload; i++)
+    {
+        udp[8U + i] = (uint8_t)(seq + i);
+    }
+    if (chksum != 0)
+    {
+        sum = udp_chksum(s_addrs, udp, udpLen);
+        if (sum == 0U)
+        {
+            sum = 0xFFFFU;
+        }
+        put16(&udp[6], (chksum > 0) ? sum : (uint16_t)(sum ^ 0x0100U));
+    }
+    return udpLen;
+}
+
+/* Wraps a piece of an IP payload into an Ethernet frame. */
+static uint32_t build_frame(uint8_t *frame, uint32_t id, const uint8_t *data, uint32_t length, uint32_t offset,
+                            bool more, bool badHeader)
+{
+    uint8_t *ip = &frame[14];
+    uint16_t sum;
+
+    memcpy(&frame[0], s_mac, 6);
+    memcpy(&frame[6], s_peerMac, 6);
+    put16(&frame[12], 0x0800U);
+
+    memset(ip, 0, 20);
+    ip[0] = 0x45;
+    put16(&ip[2], 20U + length);
+    put16(&ip[4], id);
+    put16(&ip[6], (more ? 0x2000U : 0U) | (offset / 8U));
+    ip[8] = 64;
+    ip[9] = 17;
+    memcpy(&ip[12], s_addrs, sizeof(s_addrs));
+    sum = enet_model_chksum(ip, 20);
+    put16(&ip[10], badHeader ? (uint16_t)(sum ^ 0x0001U) : sum);
+    memcpy(&ip[20], data, length);
+    return 14U + 20U + length;
+}
+
+static void inject(const uint8_t *frame, uint32_t length)
+{
+    if (!enet_model_receive(frame, length))
+    {
+        printf("error: receive ring full\n");
+        s_failures++;
+    }
+}
+
+static void settle(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(20));
+}
+
+static void expect(const char *name, uint32_t delivered, uint32_t ipErrors, uint32_t protoErrors, uint32_t discards)
+{
+    static uint32_t lastDelivered;
+    static enet_model_stats_t last;
+    enet_model_stats_t stats;
+    uint32_t gotIp = 0U;
+    uint32_t gotProto = 0U;
+#if TEST_ENHANCED
+    static ethernetif_checksum_stats_t lastChk;
+    ethernetif_checksum_stats_t chk;
+
+    ethernetif_get_checksum_stats(&s_netif, &chk);
+    gotIp = chk.rxIpHeaderErrors - lastChk.rxIpHeaderErrors;
+    gotProto = chk.rxProtocolErrors - lastChk.rxProtocolErrors;
+    lastChk = chk;
+#endif
+    enet_model_get_stats(&stats);
+
+    printf("%-26s delivered %u, ip header errors %u, protocol errors %u, discarded by the ENET %u\n", name,
+           (unsigned)(s_delivered - lastDelivered), (unsigned)gotIp, (unsigned)gotProto,
+           (unsigned)(stats.rxChecksumDiscards - last.rxChecksumDiscards));
+    if ((s_delivered - lastDelivered != delivered) || (gotIp != ipErrors) || (gotProto != protoErrors) ||
+        (stats.rxChecksumDiscards - last.rxChecksumDiscards != discards))
+    {
+        printf("FAIL: expected delivered %u, ip header errors %u, protocol errors %u, discarded %u\n",
+               (unsigned)delivered, (unsigned)ipErrors, (unsigned)protoErrors, (unsigned)discards);
+        s_failures++;
+    }
+    lastDelivered = s_delivered;
+    last = stats;
+}
+
+static void test_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    s_delivered++;
+    pbuf_free(p);
+}
+
+/* Reassembles the UDP datagram the stack sends from its fragments. */
+static void test_wire(const uint8_t *frame, uint32_t length, void *arg)
+{
+    const uint8_t *ip = &frame[14];
+    uint32_t flags;
+    uint32_t offset;
+    uint32_t plen;
+
+    LWIP_UNUSED_ARG(arg);
+
+    if ((length < 34U) || (get16(&frame[12]) != 0x0800U) || (ip[9] != 17U))
+    {
+        return;
+    }
+    flags = get16(&ip[6]);
+    offset = (flags & 0x1FFFU) * 8U;
+    plen = get16(&ip[2]) - 20U;
+    if ((enet_model_chksum(ip, 20) != 0U) || (offset + plen > sizeof(s_wire)))
+    {
+        printf("error: bad IP header on the wire\n");
+        s_failures++;
+        return;
+    }
+    memcpy(&s_wire[offset], &ip[20], plen);
+    if (!(flags & 0x2000U))
+    {
+        s_wireLen = offset + plen;
+        s_wireDone = true;
+    }
+}
+
+static void test_send(struct udp_pcb *pcb, uint32_t payload, uint32_t expectPreset)
+{
+    static const uint8_t wireAddrs[8] = {192, 168, 1, 102, 192, 168, 1, 1};
+    enet_model_stats_t before, after;
+    struct pbuf *p;
+    ip_addr_t dst;
+    uint32_t i;
+
+    IP_ADDR4(&dst, 192, 168, 1, 1);
+    enet_model_get_stats(&before);
+    s_wireDone = false;
+
+    LOCK_TCPIP_CORE();
+    p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)payload, PBUF_RAM);
+    for (i = 0U; i < payload; i++)
+    {
+        ((uint8_t *)p->payload)[i] = (uint8_t)i;
+    }
+    udp_sendto(pcb, p, &dst, TEST_PEER_PORT);
+    pbuf_free(p);
+    UNLOCK_TCPIP_CORE();
+
+    while (enet_model_transmit() != 0U)
+    {
+    }
+    settle();
+    enet_model_get_stats(&after);
+
+    printf("send %4u bytes: %u frames, %u with checksums filled in by software, UDP checksum %s\n",
+           (unsigned)payload, (unsigned)(after.txFrames - before.txFrames),
+           (unsigned)(after.txChecksumsPreset - before.txChecksumsPreset),
+           (s_wireDone && (s_wireLen == 8U + payload) && (udp_chksum(wireAddrs, s_wire, s_wireLen) == 0U)) ? "valid"
+                                                                                                            : "BAD");
+    if (!s_wireDone || (s_wireLen != 8U + payload) || (udp_chksum(wireAddrs, s_wire, s_wireLen) != 0U) ||
+        (after.txChecksumsPreset - before.txChecksumsPreset != expectPreset))
+    {
+        printf("FAIL: expected a valid datagram and %u frames with preset checksums\n", (unsigned)expectPreset);
+        s_failures++;
+    }
+}
+
+static void test_task(void *arg)
+{
+    static uint8_t frame[ENET_FRAME_MAX_FRAMELEN];
+    static uint8_t frame2[ENET_FRAME_MAX_FRAMELEN];
+    static uint8_t udp[8U + TEST_FRAG_PAYLOAD];
+    ethernetif_config_t config = {
+        .phyAddress = 0,
+        .clockName = kCLOCK_CoreSysClk,
+        .macAddress = {0x02, 0x12, 0x13, 0x10, 0x15, 0x11},
+    };
+    struct eth_addr peerMac = {{0x02, 0x00, 0x00, 0x00, 0x00, 0x01}};
+    ip4_addr_t ipaddr, netmask, gw;
+    struct udp_pcb *pcb;
+    uint32_t udpLen;
+    uint32_t len;
+    uint32_t len2;
+    /* What a bad checksum costs: a driver count with enhanced descriptors, an ENET discard with legacy ones. */
+    const uint32_t ipErr = TEST_ENHANCED ? 1U : 0U;
+    const uint32_t protoErr = TEST_ENHANCED ? 1U : 0U;
+    const uint32_t discard = TEST_ENHANCED ? 0U : 1U;
+
+    LWIP_UNUSED_ARG(arg);
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    tcpip_init(NULL, NULL);
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, &config, ethernetif0_init, tcpip_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    enet_model_set_tx_handler(test_wire, NULL);
+
+    LOCK_TCPIP_CORE();
+    etharp_add_static_entry(&gw, &peerMac);
+    pcb = udp_new();
+    udp_bind(pcb, IP_ADDR_ANY, TEST_PORT);
+    udp_recv(pcb, test_recv, NULL);
+    UNLOCK_TCPIP_CORE();
+    while (enet_model_transmit() != 0U)
+    {
+    }
+    settle();
+    expect("start", 0U, 0U, 0U, 0U);
+
+    udpLen = build_udp(udp, 100U, 1U, 1);
+    inject(frame, build_frame(frame, 1U, udp, udpLen, 0U, false, false));
+    settle();
+    expect("good", 1U, 0U, 0U, 0U);
+
+    udpLen = build_udp(udp, 100U, 2U, 0);
+    inject(frame, build_frame(frame, 2U, udp, udpLen, 0U, false, false));
+    settle();
+    expect("no UDP checksum", 1U, 0U, 0U, 0U);
+
+    udpLen = build_udp(udp, 100U, 3U, -1);
+    inject(frame, build_frame(frame, 3U, udp, udpLen, 0U, false, false));
+    settle();
+    expect("bad UDP checksum", 0U, 0U, protoErr, discard);
+
+    udpLen = build_udp(udp, 100U, 4U, 1);
+    inject(frame, build_frame(frame, 4U, udp, udpLen, 0U, false, true));
+    settle();
+    expect("bad IP header checksum", 0U, ipErr, 0U, discard);
+
+    udpLen = build_udp(udp, TEST_FRAG_PAYLOAD, 5U, 1);
+    inject(frame, build_frame(frame, 5U, udp, TEST_FRAG_SIZE, 0U, true, false));
+    inject(frame, build_frame(frame, 5U, udp + TEST_FRAG_SIZE, udpLen - TEST_FRAG_SIZE, TEST_FRAG_SIZE, false, false));
+    settle();
+    expect("fragmented, good", 1U, 0U, 0U, 0U);
+
+    udpLen = build_udp(udp, TEST_FRAG_PAYLOAD, 6U, -1);
+    inject(frame, build_frame(frame, 6U, udp, TEST_FRAG_SIZE, 0U, true, false));
+    inject(frame, build_frame(frame, 6U, udp + TEST_FRAG_SIZE, udpLen - TEST_FRAG_SIZE, TEST_FRAG_SIZE, false, false));
+    settle();
+    expect("fragmented, bad UDP", 0U, 0U, 0U, 0U);
+
+    /* Both frames are in the ring before the receive interrupt runs. */
+    udpLen = build_udp(udp, 100U, 7U, -1);
+    len = build_frame(frame, 7U, udp, udpLen, 0U, false, false);
+    udpLen = build_udp(udp, 100U, 8U, 1);
+    len2 = build_frame(frame2, 8U, udp, udpLen, 0U, false, false);
+    taskENTER_CRITICAL();
+    inject(frame, len);
+    inject(frame2, len2);
+    taskEXIT_CRITICAL();
+    settle();
+    expect("bad UDP, then good", 1U, 0U, protoErr, discard);
+
+    test_send(pcb, 100U, 0U);
+    test_send(pcb, TEST_FRAG_PAYLOAD, 0U);
+
+    if (s_failures != 0U)
+    {
+        printf("FAIL: %u checks failed\n", (unsigned)s_failures);
+        exit(1);
+    }
+    printf("%s descriptors: all checks passed\n", TEST_ENHANCED ? "enhanced" : "legacy");
+    exit(0);
+}
+
+int main(void)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (sys_thread_new("test", test_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
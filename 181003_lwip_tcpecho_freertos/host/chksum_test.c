@@ -0,0 +1,185 @@
+/*
+ * Checksum routines of the port (lwip/port/chksum.c) against the generic
+ * lwip_standard_chksum() of inet_chksum.c.
+ *
+ * The fuzz part sums random data of random length at every source alignment,
+ * all-ones data up to the largest length (the worst case for carries), and
+ * copies with checksum to every destination alignment. Then it times both
+ * routines, and the copy against memcpy() followed by a sum, for frame sized
+ * lengths at each alignment and prints host nanoseconds per byte.
+ *
+ * Fails if a sum or a copy differs.
+ *
+ *   make -C host chksum_test
+ *   host/chksum_test [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/inet_chksum.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TEST_BUF_SIZE (0x10000 + 16)
+#define TEST_MAX_LEN 1600
+
+/* Built from inet_chksum.c with LWIP_PORT_OPTIMIZED_CHKSUM=0. */
+u16_t lwip_standard_chksum(const void *dataptr, int len);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_iterations = 200000U;
+static uint8_t s_src[TEST_BUF_SIZE];
+static uint8_t s_dst[TEST_BUF_SIZE];
+static uint32_t s_errors;
+
+/* Keeps the timed sums from being optimized away. */
+static volatile u16_t s_sink;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void test_error(const char *what, int len, int srcOff, int dstOff)
+{
+    if (s_errors++ < 10U)
+    {
+        printf("error: %s, length %d, source offset %d, destination offset %d\n", what, len, srcOff, dstOff);
+    }
+}
+
+static void check_one(int len, int srcOff, int dstOff)
+{
+    u16_t expected = lwip_standard_chksum(&s_src[srcOff], len);
+    u16_t sum;
+
+    if (port_chksum(&s_src[srcOff], len) != expected)
+    {
+        test_error("port_chksum differs", len, srcOff, dstOff);
+    }
+    if (len <= 0xFFFF)
+    {
+        memset(s_dst, 0xA5, (size_t)(len + 16));
+        sum = port_chksum_copy(&s_dst[dstOff], &s_src[srcOff], (u16_t)len);
+        if ((sum != expected) || (memcmp(&s_dst[dstOff], &s_src[srcOff], (size_t)len) != 0) ||
+            (s_dst[dstOff + len] != 0xA5U) || ((dstOff > 0) && (s_dst[dstOff - 1] != 0xA5U)))
+        {
+            test_error("port_chksum_copy differs", len, srcOff, dstOff);
+        }
+    }
+}
+
+static void fuzz(void)
+{
+    uint32_t n;
+    int len;
+    int i;
+
+    srand(1);
+    for (n = 0U; n < s_iterations; n++)
+    {
+        len = rand() % (TEST_MAX_LEN + 1);
+        for (i = 0; i < len + 8; i++)
+        {
+            s_src[i] = (uint8_t)rand();
+        }
+        check_one(len, rand() % 8, rand() % 8);
+    }
+
+    memset(s_src, 0xFF, sizeof(s_src));
+    for (len = 0; len <= 0xFFFF; len += (len < 256) ? 1 : 251)
+    {
+        check_one(len, len % 8, (len / 8) % 8);
+    }
+    check_one(0xFFFF, 1, 2);
+}
+
+static double time_sum(u16_t (*sum)(const void *, int), int len, int off, uint32_t rounds)
+{
+    double start = now_ns();
+    uint32_t n;
+
+    for (n = 0U; n < rounds; n++)
+    {
+        s_sink = sum(&s_src[off], len);
+    }
+    return (now_ns() - start) / ((double)rounds * len);
+}
+
+static double time_copy(int len, int off, int separate, uint32_t rounds)
+{
+    double start = now_ns();
+    uint32_t n;
+
+    for (n = 0U; n < rounds; n++)
+    {
+        if (separate)
+        {
+            memcpy(&s_dst[off], &s_src[off], (size_t)len);
+            s_sink = lwip_standard_chksum(&s_dst[off], len);
+        }
+        else
+        {
+            s_sink = port_chksum_copy(&s_dst[off], &s_src[off], (u16_t)len);
+        }
+    }
+    return (now_ns() - start) / ((double)rounds * len);
+}
+
+static void bench(void)
+{
+    static const int lengths[] = {20, 64, 576, 1460};
+    uint32_t rounds;
+    uint32_t i;
+    int off;
+
+    for (i = 0U; i < sizeof(s_src); i++)
+    {
+        s_src[i] = (uint8_t)(i * 7U);
+    }
+
+    printf("%6s %5s %10s %10s %12s %12s   (ns per byte)\n", "length", "align", "standard", "port",
+           "copy+sum", "chksum_copy");
+    for (i = 0U; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+        rounds = 20000000U / (uint32_t)lengths[i];
+        for (off = 0; off < 4; off++)
+        {
+            printf("%6d %5d %10.3f %10.3f %12.3f %12.3f\n", lengths[i], off,
+                   time_sum(lwip_standard_chksum, lengths[i], off, rounds), time_sum(port_chksum, lengths[i], off, rounds),
+                   time_copy(lengths[i], off, 1, rounds), time_copy(lengths[i], off, 0, rounds));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        s_iterations = strtoul(argv[1], NULL, 0);
+    }
+
+    fuzz();
+    printf("%u random buffers and the all-ones lengths up to 65535: %u errors\n", (unsigned)s_iterations,
+           (unsigned)s_errors);
+    if (s_errors != 0U)
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    bench();
+    return 0;
+}
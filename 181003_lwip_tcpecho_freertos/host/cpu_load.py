@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+#
+# Context switch overhead of the run time stats on the host build.
+#
+# Keeps one connection bouncing --size byte blocks through the echo server for
+# --seconds, then asks the statistics server for its report and prints the run
+# time stats part. Its first line has the switch rate and the cost the
+# accounting adds to every switch, as ticks and as a share of the CPU. Running
+# the same load on a build without the stats gives the echo rate to compare.
+#
+#   make -C host DEFS=-DconfigGENERATE_RUN_TIME_STATS=1
+#   host/lwip_tcpecho_freertos &
+#   host/cpu_load.py --seconds 5
+#
+
+import argparse
+import socket
+import time
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--host', default='192.168.1.102')
+    parser.add_argument('--port', type=int, default=50000)
+    parser.add_argument('--stats-port', type=int, default=50001)
+    parser.add_argument('--size', type=int, default=16384)
+    parser.add_argument('--seconds', type=float, default=5.0)
+    parser.add_argument('--timeout', type=float, default=5.0)
+    args = parser.parse_args()
+
+    payload = b'e' * args.size
+    s = socket.create_connection((args.host, args.port), timeout=args.timeout)
+    rounds = 0
+    start = time.monotonic()
+    while time.monotonic() - start < args.seconds:
+        s.sendall(payload)
+        got = 0
+        while got < len(payload):
+            data = s.recv(len(payload) - got)
+            if not data:
+                raise ConnectionResetError('closed before the echo')
+            got += len(data)
+        rounds += 1
+    elapsed = time.monotonic() - start
+
+    # The sampler publishes once per period: ask while the load still runs.
+    u = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    u.settimeout(args.timeout)
+    u.sendto(b'?', (args.host, args.stats_port))
+    report = u.recv(65535).decode(errors='replace')
+    s.close()
+
+    print('echo %.0f kB/s, %.0f round trips/s' % (rounds * args.size / elapsed / 1e3, rounds / elapsed))
+    if 'cpu sample' in report:
+        print('cpu sample' + report.split('cpu sample', 1)[1].rstrip())
+    else:
+        print('no run time stats in the report, build with configGENERATE_RUN_TIME_STATS=1')
+
+
+if __name__ == '__main__':
+    main()
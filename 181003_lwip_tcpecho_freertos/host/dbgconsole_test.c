@@ -0,0 +1,325 @@
+/*
+ * Interrupt driven debug console (DEBUG_CONSOLE_TRANSFER_INTERRUPT of
+ * utilities/fsl_io.c) on a model of the K64F UART0 at 115200 baud (uart/).
+ *
+ * Logs 40 boot lines before the scheduler starts, then lines from the task,
+ * more than the wire can carry as the task only does 2 ms of other work every
+ * three lines. Then a 1000 byte log that an interrupt, itself logging a line,
+ * preempts in the middle of its copy; a log that fills the transmit ring, and
+ * two lines from interrupts behind it, one of them preempting the UART
+ * interrupt; and last SCANF and GETCHAR on received characters. Run it as
+ * dbgconsole_test_wait and dbgconsole_test_drop, which differ in
+ * DEBUG_CONSOLE_TX_OVERFLOW_POLICY alone. Prints the host microseconds per KB
+ * logged that the callers spend, formatting included, and that the transmit
+ * interrupt spends, against the 88.9 ms per KB of the blocking transfer.
+ *
+ * Fails if the wire carries anything but the logs in order, under WAIT all
+ * of them but the one of the interrupt that preempted the UART interrupt,
+ * under DROP whole logs only; if the drop count is not the bytes missing; if
+ * a critical section copies any byte of a log; or if SCANF and GETCHAR do not
+ * return what was received.
+ *
+ *   make -C host dbgconsole_test_wait dbgconsole_test_drop
+ *   host/dbgconsole_test_wait [lines]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fsl_debug_console.h"
+#include "fsl_debug_console_conf.h"
+#include "fsl_io.h"
+#include "uart_model.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TEST_EXPECTED_MAX (1U << 20)
+#define TEST_LOGS_MAX 65536U
+#define TEST_BOOT_LINES 40U
+#define TEST_BIG_LOG 1000U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_lines = 4000U;
+
+/* The logs in the order they were written, each one starting at s_logs[i]. */
+static char s_expected[TEST_EXPECTED_MAX];
+static uint32_t s_logs[TEST_LOGS_MAX + 1U];
+static uint32_t s_logCount;
+/* Bytes of logs that must be dropped, and are not in s_expected. */
+static uint32_t s_mustDrop;
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Host ns of the model: the interrupts and the waits of vTaskDelay(). */
+static double model_ns(void)
+{
+    uart_model_stats_t stats;
+
+    uart_model_get_stats(&stats);
+    return stats.txIsrHostNs + stats.delayHostNs;
+}
+
+static void test_error(const char *what)
+{
+    if (s_errors++ < 10U)
+    {
+        printf("error: %s\n", what);
+    }
+}
+
+static void expect(const char *log, uint32_t length)
+{
+    uint32_t start = s_logs[s_logCount];
+
+    if ((s_logCount == TEST_LOGS_MAX) || (start + length > TEST_EXPECTED_MAX))
+    {
+        printf("FAIL: too many logs\n");
+        exit(1);
+    }
+    memcpy(&s_expected[start], log, length);
+    s_logs[++s_logCount] = start + length;
+}
+
+/* Logs a line with DbgConsole_Printf() and expects it on the wire. Returns the
+ * host ns of the call, less the transmit interrupts and waits it took. */
+static double test_line(const char *format, uint32_t n)
+{
+    char line[DEBUG_CONSOLE_PRINTF_MAX_LOG_LEN];
+    double model = model_ns();
+    double start = now_ns();
+
+    DbgConsole_Printf(format, n, n * 7U);
+    start = now_ns() - start - (model_ns() - model);
+    expect(line, (uint32_t)snprintf(line, sizeof(line), format, n, n * 7U));
+    return start;
+}
+
+static const char s_isrLine[] = "line from an interrupt\r\n";
+static const char s_uartIsrLine[] = "line from an interrupt preempting the UART interrupt\r\n";
+
+static void isr_line(void)
+{
+    DbgConsole_Printf(s_isrLine);
+}
+
+static void uart_isr_line(void)
+{
+    DbgConsole_Printf(s_uartIsrLine);
+}
+
+static void test_boot(void)
+{
+    uart_model_stats_t stats;
+    uint32_t i;
+
+    for (i = 0U; i < TEST_BOOT_LINES; i++)
+    {
+        test_line("boot line %u before the scheduler, %x\r\n", i);
+    }
+    uart_model_get_stats(&stats);
+    printf("boot:       %u lines before the scheduler, %.1f ms spent polling the UART\n", (unsigned)TEST_BOOT_LINES,
+           stats.pollingNs / 1e6);
+}
+
+static void test_task(void)
+{
+    uart_model_stats_t before;
+    uart_model_stats_t after;
+    double caller = 0.0;
+    double sim;
+    uint32_t logged = s_logs[s_logCount];
+    uint32_t sent;
+    uint32_t total;
+    uint32_t i;
+
+    uart_model_set_scheduler(true);
+    uart_model_masked_max = 0U;
+    uart_model_get_stats(&before);
+    uart_model_output(&sent);
+    sim = uart_model_now();
+    for (i = 0U; i < s_lines; i++)
+    {
+        caller += test_line("task line %u of the producer, value %x\r\n", i);
+        if (i % 3U == 2U)
+        {
+            /* the task does other work */
+            uart_model_advance(2e6);
+        }
+    }
+    uart_model_get_stats(&after);
+    logged = s_logs[s_logCount] - logged;
+    uart_model_output(&total);
+    sent = total - sent;
+    sim = uart_model_now() - sim;
+
+    printf("task:       %u lines, %u bytes in %.0f ms, %u ticks waiting for room, %.1f us per KB logged in the callers\n",
+           (unsigned)s_lines, (unsigned)logged, sim / 1e6, (unsigned)(after.delayTicks - before.delayTicks),
+           caller / 1e3 / (logged / 1024.0));
+    printf("interrupt:  %.1f us per KB sent, %u interrupts of %.1f bytes each\n",
+           (after.txIsrHostNs - before.txIsrHostNs) / 1e3 / (sent / 1024.0),
+           (unsigned)(after.txIsrCalls - before.txIsrCalls), (double)sent / (after.txIsrCalls - before.txIsrCalls));
+    printf("blocking:   %.1f ms per KB on the wire\n", 1024.0 * 1e4 / 115200.0);
+    if (uart_model_masked_max != 0U)
+    {
+        printf("error: %u bytes copied with interrupts disabled\n", (unsigned)uart_model_masked_max);
+        s_errors++;
+    }
+}
+
+/* A big log preempted in the middle of its copy by an interrupt that logs a line. */
+static void test_preempted(void)
+{
+    static uint8_t big[TEST_BIG_LOG];
+
+    DbgConsole_Flush();
+    memset(big, 'b', sizeof(big));
+    big[sizeof(big) - 2U] = '\r';
+    big[sizeof(big) - 1U] = '\n';
+    uart_model_masked_max = 0U;
+    uart_model_preempt(isr_line);
+    IO_Transfer(big, sizeof(big), true);
+    /* the big log took its room before the interrupt came */
+    expect((const char *)big, sizeof(big));
+    expect(s_isrLine, sizeof(s_isrLine) - 1U);
+    printf("preempted:  %u byte log, at most %u bytes copied with interrupts disabled\n", (unsigned)sizeof(big),
+           (unsigned)uart_model_masked_max);
+    if (uart_model_masked_max != 0U)
+    {
+        test_error("a critical section copied log bytes");
+    }
+}
+
+/* A log filling the transmit ring, then lines from interrupts that find no room. */
+static void test_full_ring(void)
+{
+    static uint8_t big[DEBUG_CONSOLE_TX_RING_LEN];
+
+    DbgConsole_Flush();
+    memset(big, 'f', sizeof(big));
+    big[sizeof(big) - 2U] = '\r';
+    big[sizeof(big) - 1U] = '\n';
+    IO_Transfer(big, sizeof(big), true);
+    expect((const char *)big, sizeof(big));
+
+    /* cannot poll in the middle of the UART interrupt, drops */
+    uart_model_interrupt(uart_isr_line, true);
+    s_mustDrop += sizeof(s_uartIsrLine) - 1U;
+    /* polls the ring out under WAIT, drops under DROP */
+    uart_model_interrupt(isr_line, false);
+    expect(s_isrLine, sizeof(s_isrLine) - 1U);
+}
+
+/* The wire must carry the expected logs in order, dropped ones left out whole. */
+static void test_output(void)
+{
+    const uint8_t *out;
+    uint32_t length;
+    uint32_t at = 0U;
+    uint32_t skipped = 0U;
+    uint32_t dropped = 0U;
+    uint32_t i;
+
+    DbgConsole_Flush();
+    out = uart_model_output(&length);
+    for (i = 0U; i < s_logCount; i++)
+    {
+        uint32_t size = s_logs[i + 1U] - s_logs[i];
+
+        if ((length - at >= size) && (memcmp(&out[at], &s_expected[s_logs[i]], size) == 0))
+        {
+            at += size;
+        }
+        else
+        {
+            skipped += size;
+            dropped++;
+        }
+    }
+    printf("output:     %u bytes sent, %u of %u logs dropped, %u bytes counted dropped\n", (unsigned)length,
+           (unsigned)dropped, (unsigned)s_logCount,
+           (unsigned)DbgConsole_GetDropCount());
+    if (at != length)
+    {
+        printf("error: byte %u of the output is not part of a whole log\n", (unsigned)at);
+        s_errors++;
+    }
+#if (DEBUG_CONSOLE_TX_OVERFLOW_POLICY == DEBUG_CONSOLE_TX_OVERFLOW_WAIT)
+    if (skipped != 0U)
+    {
+        printf("error: %u bytes lost under WAIT\n", (unsigned)skipped);
+        s_errors++;
+    }
+#endif
+    if (DbgConsole_GetDropCount() != skipped + s_mustDrop)
+    {
+        printf("error: %u bytes counted dropped, %u missing\n", (unsigned)DbgConsole_GetDropCount(),
+               (unsigned)(skipped + s_mustDrop));
+        s_errors++;
+    }
+}
+
+static void test_receive(void)
+{
+    int value = 0;
+    int ch;
+
+    uart_model_receive('4');
+    uart_model_receive('2');
+    uart_model_receive('\r');
+    DbgConsole_Scanf("%d", &value);
+    uart_model_receive('z');
+    ch = DbgConsole_Getchar();
+    printf("receive:    SCANF read %d, GETCHAR %c\n", value, ch);
+    if ((value != 42) || (ch != 'z'))
+    {
+        test_error("SCANF or GETCHAR returned what was not received");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_lines = strtoul(argv[1], NULL, 0);
+    }
+    if ((s_lines == 0U) || (s_lines > TEST_LOGS_MAX - 64U))
+    {
+        fprintf(stderr, "usage: %s [lines], at most %u\n", argv[0], (unsigned)(TEST_LOGS_MAX - 64U));
+        return 2;
+    }
+
+    printf("overflow policy %s, %u byte transmit ring\n",
+           (DEBUG_CONSOLE_TX_OVERFLOW_POLICY == DEBUG_CONSOLE_TX_OVERFLOW_WAIT) ? "WAIT" : "DROP",
+           (unsigned)DEBUG_CONSOLE_TX_RING_LEN);
+    DbgConsole_Init(UART0_BASE, 115200U, DEBUG_CONSOLE_DEVICE_TYPE_UART, 0U);
+    test_boot();
+    test_task();
+    test_preempted();
+    test_full_ring();
+    test_output();
+    test_receive();
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        return 1;
+    }
+    return 0;
+}
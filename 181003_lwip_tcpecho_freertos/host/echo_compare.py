@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+#
+# Raw API echo server against the netconn one (EXAMPLE_TCPECHO_RAW).
+#
+# Starts each server build in turn. One connection bounces --size byte blocks
+# through it for --seconds while the statistics server samples the run time
+# stats; the busy share of the CPU (all but the idle task) and the counter
+# rate give the counter ticks spent per echoed byte, which on the target are
+# CPU cycles. The CPU time the host process used is reported as well. Then
+# --rounds messages of --msg bytes go back and forth one at a time for the
+# round trip latency.
+#
+#   make -C host tcpecho_netconn tcpecho_raw
+#   host/echo_compare.py --seconds 5
+#
+
+import argparse
+import os
+import re
+import socket
+import subprocess
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+CLK_TCK = os.sysconf('SC_CLK_TCK')
+
+
+def connect(args):
+    deadline = time.monotonic() + 10
+    while True:
+        try:
+            s = socket.create_connection((args.host, args.port), timeout=args.timeout)
+            s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            return s
+        except OSError:
+            if time.monotonic() > deadline:
+                raise
+            time.sleep(0.2)
+
+
+def cpu_seconds(pid):
+    with open('/proc/%d/stat' % pid) as f:
+        fields = f.read().rsplit(')', 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / CLK_TCK
+
+
+def echo(s, payload):
+    s.sendall(payload)
+    got = b''
+    while len(got) < len(payload):
+        data = s.recv(len(payload) - len(got))
+        if not data:
+            raise ConnectionResetError('closed before the echo')
+        got += data
+    if got != payload:
+        raise ValueError('echo differs from the message')
+
+
+def run(args, server):
+    proc = subprocess.Popen([server], stdout=subprocess.DEVNULL)
+    try:
+        s = connect(args)
+        payload = bytes(range(256)) * (args.size // 256) + bytes(args.size % 256)
+
+        rounds = 0
+        cpu = cpu_seconds(proc.pid)
+        start = time.monotonic()
+        while time.monotonic() - start < args.seconds:
+            echo(s, payload)
+            rounds += 1
+        elapsed = time.monotonic() - start
+        cpu = cpu_seconds(proc.pid) - cpu
+
+        # The sampler publishes once per period: ask while the load still runs.
+        u = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        u.settimeout(args.timeout)
+        u.sendto(b'?', (args.host, args.stats_port))
+        report = u.recv(65535).decode(errors='replace')
+
+        message = b'm' * args.msg
+        latencies = []
+        for _ in range(args.rounds):
+            t = time.monotonic()
+            echo(s, message)
+            latencies.append(time.monotonic() - t)
+        s.close()
+    finally:
+        proc.terminate()
+        proc.wait()
+        time.sleep(0.5)
+
+    rate = rounds * args.size / elapsed
+    hz = re.search(r'at (\d+) Hz', report)
+    idle = re.search(r'^IDLE\s+(\d+\.\d+)%', report, re.M)
+    if hz is None or idle is None:
+        raise RuntimeError('no run time stats in the report, build with configGENERATE_RUN_TIME_STATS=1')
+    busy = int(hz.group(1)) * (100.0 - float(idle.group(1))) / 100.0
+    latencies.sort()
+    return (rate, rate / busy, rate * elapsed / cpu / 1e6,
+            latencies[len(latencies) // 2] * 1e6, latencies[len(latencies) * 99 // 100] * 1e6)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--servers', default='netconn=%s,raw=%s' % (os.path.join(HERE, 'tcpecho_netconn'),
+                                                                     os.path.join(HERE, 'tcpecho_raw')),
+                        help='comma separated name=binary pairs')
+    parser.add_argument('--host', default='192.168.1.102')
+    parser.add_argument('--port', type=int, default=50000)
+    parser.add_argument('--stats-port', type=int, default=50001)
+    parser.add_argument('--size', type=int, default=16384)
+    parser.add_argument('--seconds', type=float, default=5.0)
+    parser.add_argument('--msg', type=int, default=64)
+    parser.add_argument('--rounds', type=int, default=2000)
+    parser.add_argument('--timeout', type=float, default=5.0)
+    args = parser.parse_args()
+
+    print('%-8s %10s %12s %14s %10s %10s' % ('server', 'echo kB/s', 'B/busy tick', 'B/host cpu us',
+                                               'p50 us', 'p99 us'))
+    for pair in args.servers.split(','):
+        name, server = pair.split('=', 1)
+        rate, per_tick, per_us, p50, p99 = run(args, server)
+        print('%-8s %10.0f %12.3f %14.1f %10.0f %10.0f' % (name, rate / 1e3, per_tick, per_us, p50, p99))
+
+
+if __name__ == '__main__':
+    main()
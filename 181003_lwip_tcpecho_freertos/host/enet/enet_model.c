@@ -0,0 +1,632 @@
+/*
+ * ENET model of the host build, see enet_model.h. The driver functions follow
+ * drivers/fsl_enet.c for a single ring, without PTP and cache maintenance.
+ */
+
+#include "fsl_enet.h"
+#include "enet_model.h"
+
+#include "task.h"
+
+/* Device side copies are DMA, not CPU work: they bypass the counting macro. */
+#define dma_copy(dst, src, size) (memcpy)((dst), (src), (size))
+
+#define ETHTYPE_IPV4 0x0800U
+#define IP_PROTO_ICMP 1U
+#define IP_PROTO_TCP 6U
+#define IP_PROTO_UDP 17U
+
+ENET_Type enet_model_regs;
+uint64_t enet_model_copied;
+
+static struct
+{
+    enet_handle_t *handle;
+    uint32_t rxBdNumber;
+    uint32_t txBdNumber;
+    uint32_t rxDma; /* next receive descriptor the DMA writes */
+    uint32_t txDma; /* next transmit descriptor the DMA sends */
+    uint8_t rxAccel;
+    uint8_t txAccel;
+    enet_model_tx_handler_t txHandler;
+    void *txArg;
+    enet_model_stats_t stats;
+} s_enet;
+
+/*******************************************************************************
+ * Checksums
+ ******************************************************************************/
+static uint32_t chksum_add(uint32_t sum, const uint8_t *data, uint32_t length)
+{
+    uint32_t i;
+
+    for (i = 0U; i + 1U < length; i += 2U)
+    {
+        sum += ((uint32_t)data[i] << 8) | data[i + 1U];
+    }
+    if (length & 1U)
+    {
+        sum += (uint32_t)data[length - 1U] << 8;
+    }
+    return sum;
+}
+
+static uint16_t chksum_fold(uint32_t sum)
+{
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFFU) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+uint16_t enet_model_chksum(const void *data, uint32_t length)
+{
+    return chksum_fold(chksum_add(0U, (const uint8_t *)data, length));
+}
+
+/* Offset of the checksum field in the protocol header, 0 if there is none. */
+static uint32_t proto_chksum_offset(uint8_t proto)
+{
+    switch (proto)
+    {
+        case IP_PROTO_ICMP:
+            return 2U;
+        case IP_PROTO_TCP:
+            return 16U;
+        case IP_PROTO_UDP:
+            return 6U;
+        default:
+            return 0U;
+    }
+}
+
+/* Checksum of the protocol header and payload, with the pseudo header for TCP and UDP. */
+static uint16_t proto_chksum(const uint8_t *ip, uint32_t ihl, uint32_t length)
+{
+    uint32_t sum = 0U;
+
+    if (ip[9] != IP_PROTO_ICMP)
+    {
+        sum = chksum_add(sum, &ip[12], 8U);
+        sum += ip[9];
+        sum += length;
+    }
+    return chksum_fold(chksum_add(sum, &ip[ihl], length));
+}
+
+/*
+ * Parses an IPv4 frame. Returns false for other frames; *proto is left 0 for
+ * fragments and protocols the ENET does not checksum.
+ */
+static bool parse_ipv4(uint8_t *frame, uint32_t length, uint8_t **ip, uint32_t *ihl, uint32_t *plen, uint8_t *proto)
+{
+    uint32_t total;
+
+    if ((length < 14U + 20U) || ((((uint32_t)frame[12] << 8) | frame[13]) != ETHTYPE_IPV4))
+    {
+        return false;
+    }
+    *ip = &frame[14];
+    *ihl = ((*ip)[0] & 0x0FU) * 4U;
+    total = ((uint32_t)(*ip)[2] << 8) | (*ip)[3];
+    if ((*ihl < 20U) || (total < *ihl) || (14U + total > length))
+    {
+        return false;
+    }
+    *plen = total - *ihl;
+    *proto = 0U;
+    if (((((uint32_t)(*ip)[6] << 8) | (*ip)[7]) & 0x3FFFU) == 0U)
+    {
+        /* More fragments clear and offset 0: the whole datagram is here. */
+        if ((proto_chksum_offset((*ip)[9]) != 0U) && (*plen >= proto_chksum_offset((*ip)[9]) + 2U))
+        {
+            *proto = (*ip)[9];
+        }
+    }
+    return true;
+}
+
+/* Receive checksum status as the enhanced descriptor reports it. */
+static uint16_t rx_chksum_status(uint8_t *frame, uint32_t length)
+{
+    uint8_t *ip;
+    uint32_t ihl;
+    uint32_t plen;
+    uint8_t proto;
+    uint16_t status = 0U;
+
+    if (!parse_ipv4(frame, length, &ip, &ihl, &plen, &proto))
+    {
+        return 0U;
+    }
+    if (enet_model_chksum(ip, ihl) != 0U)
+    {
+        status |= 0x20U; /* IPHEADCHECKSUM */
+    }
+    /* A UDP checksum of 0 means none was sent. */
+    if ((proto != 0U) && !((proto == IP_PROTO_UDP) && (ip[ihl + 6U] == 0U) && (ip[ihl + 7U] == 0U)))
+    {
+        if (proto_chksum(ip, ihl, plen) != 0U)
+        {
+            status |= 0x10U; /* PROTOCOLCHECKSUM */
+        }
+    }
+    return status;
+}
+
+static void tx_insert_chksums(uint8_t *frame, uint32_t length)
+{
+    uint8_t *ip;
+    uint32_t ihl;
+    uint32_t plen;
+    uint8_t proto;
+    uint16_t sum;
+    bool preset = false;
+
+    if (!parse_ipv4(frame, length, &ip, &ihl, &plen, &proto))
+    {
+        return;
+    }
+    if (s_enet.txAccel & kENET_TxAccelIpCheckEnabled)
+    {
+        preset = (ip[10] != 0U) || (ip[11] != 0U);
+        ip[10] = 0U;
+        ip[11] = 0U;
+        sum = enet_model_chksum(ip, ihl);
+        ip[10] = (uint8_t)(sum >> 8);
+        ip[11] = (uint8_t)sum;
+    }
+    if ((s_enet.txAccel & kENET_TxAccelProtoCheckEnabled) && (proto != 0U))
+    {
+        uint8_t *field = &ip[ihl + proto_chksum_offset(proto)];
+
+        preset = preset || (field[0] != 0U) || (field[1] != 0U);
+        field[0] = 0U;
+        field[1] = 0U;
+        sum = proto_chksum(ip, ihl, plen);
+        if ((proto == IP_PROTO_UDP) && (sum == 0U))
+        {
+            sum = 0xFFFFU;
+        }
+        field[0] = (uint8_t)(sum >> 8);
+        field[1] = (uint8_t)sum;
+    }
+    if (preset)
+    {
+        s_enet.stats.txChecksumsPreset++;
+    }
+}
+
+/*******************************************************************************
+ * Interrupts
+ ******************************************************************************/
+static void enet_model_irq(enet_event_t event, uint32_t mask)
+{
+    enet_handle_t *handle = s_enet.handle;
+
+    while (mask & ENET->EIR)
+    {
+        ENET->EIR &= ~mask;
+        if (handle->callback)
+        {
+            handle->callback(ENET, handle, event, handle->userData);
+        }
+    }
+}
+
+static void enet_model_rx_irq(void)
+{
+    enet_model_irq(kENET_RxEvent, kENET_RxFrameInterrupt | kENET_RxBufferInterrupt);
+}
+
+static void enet_model_tx_irq(void)
+{
+    enet_model_irq(kENET_TxEvent, kENET_TxFrameInterrupt | kENET_TxBufferInterrupt);
+}
+
+/* Raises an interrupt, taken at once unless the caller masked interrupts. */
+static void enet_model_raise(UBaseType_t line, uint32_t mask)
+{
+    taskENTER_CRITICAL();
+    ENET->EIR |= mask;
+    taskEXIT_CRITICAL();
+    vPortGenerateSimulatedInterrupt(line);
+    portYIELD();
+}
+
+/*******************************************************************************
+ * Driver
+ ******************************************************************************/
+void ENET_GetDefaultConfig(enet_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->miiSpeed = kENET_MiiSpeed100M;
+    config->miiDuplex = kENET_MiiFullDuplex;
+    config->ringNum = 1U;
+    config->rxMaxFrameLen = ENET_FRAME_MAX_FRAMELEN;
+}
+
+void ENET_Init(ENET_Type *base,
+               enet_handle_t *handle,
+               const enet_config_t *config,
+               const enet_buffer_config_t *bufferConfig,
+               uint8_t *macAddr,
+               uint32_t srcClock_Hz)
+{
+    volatile enet_rx_bd_struct_t *rxBd = bufferConfig->rxBdStartAddrAlign;
+    volatile enet_tx_bd_struct_t *txBd = bufferConfig->txBdStartAddrAlign;
+    uint32_t i;
+
+    (void)macAddr;
+    (void)srcClock_Hz;
+
+    memset(handle, 0, sizeof(*handle));
+    memset(base, 0, sizeof(*base));
+    memset(&s_enet.stats, 0, sizeof(s_enet.stats));
+
+    for (i = 0U; i < bufferConfig->rxBdNumber; i++)
+    {
+        rxBd[i].buffer = bufferConfig->rxBufferAlign + i * bufferConfig->rxBuffSizeAlign;
+        rxBd[i].length = 0U;
+        rxBd[i].control = ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK;
+        if (i == bufferConfig->rxBdNumber - 1U)
+        {
+            rxBd[i].control |= ENET_BUFFDESCRIPTOR_RX_WRAP_MASK;
+        }
+    }
+    for (i = 0U; i < bufferConfig->txBdNumber; i++)
+    {
+        txBd[i].buffer = bufferConfig->txBufferAlign + i * bufferConfig->txBuffSizeAlign;
+        txBd[i].length = 0U;
+        txBd[i].control = 0U;
+        if (i == bufferConfig->txBdNumber - 1U)
+        {
+            txBd[i].control |= ENET_BUFFDESCRIPTOR_TX_WRAP_MASK;
+        }
+    }
+
+    handle->rxBdBase[0] = rxBd;
+    handle->rxBdCurrent[0] = rxBd;
+    handle->txBdBase[0] = txBd;
+    handle->txBdCurrent[0] = txBd;
+    handle->rxBuffSizeAlign[0] = bufferConfig->rxBuffSizeAlign;
+    handle->txBuffSizeAlign[0] = bufferConfig->txBuffSizeAlign;
+    handle->ringNum = config->ringNum;
+
+    s_enet.handle = handle;
+    s_enet.rxBdNumber = bufferConfig->rxBdNumber;
+    s_enet.txBdNumber = bufferConfig->txBdNumber;
+    s_enet.rxDma = 0U;
+    s_enet.txDma = 0U;
+    s_enet.rxAccel = config->rxAccelerConfig;
+    s_enet.txAccel = config->txAccelerConfig;
+
+    vPortSetInterruptHandler(ENET_MODEL_RX_IRQ_LINE, enet_model_rx_irq);
+    vPortSetInterruptHandler(ENET_MODEL_TX_IRQ_LINE, enet_model_tx_irq);
+}
+
+void ENET_SetCallback(enet_handle_t *handle, enet_callback_t callback, void *userData)
+{
+    handle->callback = callback;
+    handle->userData = userData;
+}
+
+void ENET_AddMulticastGroup(ENET_Type *base, uint8_t *address)
+{
+    (void)base;
+    (void)address;
+}
+
+void ENET_LeaveMulticastGroup(ENET_Type *base, uint8_t *address)
+{
+    (void)base;
+    (void)address;
+}
+
+status_t ENET_GetRxFrameSize(enet_handle_t *handle, uint32_t *length)
+{
+    uint16_t validLastMask = ENET_BUFFDESCRIPTOR_RX_LAST_MASK | ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK;
+    volatile enet_rx_bd_struct_t *curBuffDescrip = handle->rxBdCurrent[0];
+
+    *length = 0;
+
+    if (curBuffDescrip->control & ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK)
+    {
+        return kStatus_ENET_RxFrameEmpty;
+    }
+
+    do
+    {
+        if ((!(curBuffDescrip->control & ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK)) && (!curBuffDescrip->length))
+        {
+            return kStatus_ENET_RxFrameError;
+        }
+
+        if ((curBuffDescrip->control & validLastMask) == ENET_BUFFDESCRIPTOR_RX_LAST_MASK)
+        {
+            if (curBuffDescrip->control & ENET_BUFFDESCRIPTOR_RX_ERR_MASK)
+            {
+                return kStatus_ENET_RxFrameError;
+            }
+            *length = curBuffDescrip->length;
+            return kStatus_Success;
+        }
+        if (curBuffDescrip->control & ENET_BUFFDESCRIPTOR_RX_WRAP_MASK)
+        {
+            curBuffDescrip = handle->rxBdBase[0];
+        }
+        else
+        {
+            curBuffDescrip++;
+        }
+
+    } while (curBuffDescrip != handle->rxBdCurrent[0]);
+
+    return kStatus_ENET_RxFrameEmpty;
+}
+
+static void ENET_UpdateReadBuffers(ENET_Type *base, enet_handle_t *handle)
+{
+    handle->rxBdCurrent[0]->control &= ENET_BUFFDESCRIPTOR_RX_WRAP_MASK;
+    handle->rxBdCurrent[0]->control |= ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK;
+
+    if (handle->rxBdCurrent[0]->control & ENET_BUFFDESCRIPTOR_RX_WRAP_MASK)
+    {
+        handle->rxBdCurrent[0] = handle->rxBdBase[0];
+    }
+    else
+    {
+        handle->rxBdCurrent[0]++;
+    }
+
+    base->RDAR = ENET_RDAR_RDAR_MASK;
+}
+
+status_t ENET_ReadFrame(ENET_Type *base, enet_handle_t *handle, uint8_t *data, uint32_t length)
+{
+    uint32_t len = 0;
+    uint32_t offset = 0;
+    uint16_t control;
+    bool isLastBuff = false;
+    volatile enet_rx_bd_struct_t *curBuffDescrip = handle->rxBdCurrent[0];
+
+    if (!data)
+    {
+        do
+        {
+            control = handle->rxBdCurrent[0]->control;
+            ENET_UpdateReadBuffers(base, handle);
+
+            if (control & ENET_BUFFDESCRIPTOR_RX_LAST_MASK)
+            {
+                break;
+            }
+
+        } while (handle->rxBdCurrent[0] != curBuffDescrip);
+
+        return kStatus_Success;
+    }
+
+    while (!isLastBuff)
+    {
+        if (curBuffDescrip->control & ENET_BUFFDESCRIPTOR_RX_LAST_MASK)
+        {
+            isLastBuff = true;
+            if (length == curBuffDescrip->length)
+            {
+                len = curBuffDescrip->length - offset;
+                memcpy(data + offset, curBuffDescrip->buffer, len);
+                ENET_UpdateReadBuffers(base, handle);
+                return kStatus_Success;
+            }
+            else
+            {
+                ENET_UpdateReadBuffers(base, handle);
+            }
+        }
+        else
+        {
+            if (offset >= length)
+            {
+                break;
+            }
+
+            memcpy(data + offset, curBuffDescrip->buffer, handle->rxBuffSizeAlign[0]);
+            offset += handle->rxBuffSizeAlign[0];
+            ENET_UpdateReadBuffers(base, handle);
+        }
+
+        curBuffDescrip = handle->rxBdCurrent[0];
+    }
+
+    return kStatus_ENET_RxFrameFail;
+}
+
+status_t ENET_SendFrame(ENET_Type *base, enet_handle_t *handle, const uint8_t *data, uint32_t length)
+{
+    volatile enet_tx_bd_struct_t *curBuffDescrip;
+    uint32_t len = 0;
+    uint32_t sizeleft = 0;
+
+    if (length > ENET_FRAME_MAX_FRAMELEN)
+    {
+        return kStatus_ENET_TxFrameOverLen;
+    }
+
+    curBuffDescrip = handle->txBdCurrent[0];
+    if (curBuffDescrip->control & ENET_BUFFDESCRIPTOR_TX_READY_MASK)
+    {
+        return kStatus_ENET_TxFrameBusy;
+    }
+
+    do
+    {
+        if (curBuffDescrip->control & ENET_BUFFDESCRIPTOR_TX_WRAP_MASK)
+        {
+            handle->txBdCurrent[0] = handle->txBdBase[0];
+        }
+        else
+        {
+            handle->txBdCurrent[0]++;
+        }
+        sizeleft = length - len;
+        if (sizeleft > handle->txBuffSizeAlign[0])
+        {
+            memcpy(curBuffDescrip->buffer, data + len, handle->txBuffSizeAlign[0]);
+            curBuffDescrip->length = handle->txBuffSizeAlign[0];
+            len += handle->txBuffSizeAlign[0];
+            curBuffDescrip->control &= ~ENET_BUFFDESCRIPTOR_TX_LAST_MASK;
+            curBuffDescrip->control |= ENET_BUFFDESCRIPTOR_TX_READY_MASK;
+            base->TDAR = ENET_TDAR_TDAR_MASK;
+        }
+        else
+        {
+            memcpy(curBuffDescrip->buffer, data + len, sizeleft);
+            curBuffDescrip->length = sizeleft;
+            curBuffDescrip->control |= ENET_BUFFDESCRIPTOR_TX_READY_MASK | ENET_BUFFDESCRIPTOR_TX_LAST_MASK;
+            base->TDAR = ENET_TDAR_TDAR_MASK;
+            return kStatus_Success;
+        }
+
+        curBuffDescrip = handle->txBdCurrent[0];
+
+    } while (!(curBuffDescrip->control & ENET_BUFFDESCRIPTOR_TX_READY_MASK));
+
+    return kStatus_ENET_TxFrameBusy;
+}
+
+/*******************************************************************************
+ * Device side
+ ******************************************************************************/
+bool enet_model_receive(const uint8_t *frame, uint32_t length)
+{
+    volatile enet_rx_bd_struct_t *base = s_enet.handle->rxBdBase[0];
+    uint32_t size = s_enet.handle->rxBuffSizeAlign[0];
+    uint32_t count = (length + size - 1U) / size;
+    uint32_t idx;
+    uint32_t i;
+    uint32_t offset = 0U;
+    uint16_t status;
+
+    for (i = 0U, idx = s_enet.rxDma; i < count; i++, idx = (idx + 1U) % s_enet.rxBdNumber)
+    {
+        if (!(base[idx].control & ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK))
+        {
+            s_enet.stats.rxOverruns++;
+            return false;
+        }
+    }
+
+    /* The accelerator only reads the frame. */
+    status = rx_chksum_status((uint8_t *)frame, length);
+#ifndef ENET_ENHANCEDBUFFERDESCRIPTOR_MODE
+    if (((status & 0x20U) && (s_enet.rxAccel & kENET_RxAccelIpCheckEnabled)) ||
+        ((status & 0x10U) && (s_enet.rxAccel & kENET_RxAccelProtoCheckEnabled)))
+    {
+        s_enet.stats.rxChecksumDiscards++;
+        return true;
+    }
+#endif
+
+    for (i = 0U; i < count; i++)
+    {
+        volatile enet_rx_bd_struct_t *bd = &base[s_enet.rxDma];
+        uint32_t chunk = (length - offset > size) ? size : (length - offset);
+        uint16_t control = bd->control & ENET_BUFFDESCRIPTOR_RX_WRAP_MASK;
+
+        dma_copy(bd->buffer, frame + offset, chunk);
+        offset += chunk;
+#ifdef ENET_ENHANCEDBUFFERDESCRIPTOR_MODE
+        bd->controlExtend0 = status;
+        bd->controlExtend1 = 0U;
+#endif
+        if (i == count - 1U)
+        {
+            bd->length = (uint16_t)length;
+            control |= ENET_BUFFDESCRIPTOR_RX_LAST_MASK;
+        }
+        else
+        {
+            bd->length = (uint16_t)size;
+        }
+        bd->control = control;
+        s_enet.rxDma = (s_enet.rxDma + 1U) % s_enet.rxBdNumber;
+    }
+    s_enet.stats.rxFrames++;
+
+    enet_model_raise(ENET_MODEL_RX_IRQ_LINE, kENET_RxFrameInterrupt);
+    return true;
+}
+
+uint32_t enet_model_rx_free(void)
+{
+    volatile enet_rx_bd_struct_t *base = s_enet.handle->rxBdBase[0];
+    uint32_t i;
+    uint32_t count = 0U;
+
+    for (i = 0U; i < s_enet.rxBdNumber; i++)
+    {
+        if (base[i].control & ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t enet_model_transmit(void)
+{
+    static uint8_t frame[ENET_FRAME_MAX_FRAMELEN];
+    volatile enet_tx_bd_struct_t *base = s_enet.handle->txBdBase[0];
+    uint32_t sent = 0U;
+
+    while (base[s_enet.txDma].control & ENET_BUFFDESCRIPTOR_TX_READY_MASK)
+    {
+        uint32_t length = 0U;
+        bool last = false;
+
+        while (!last)
+        {
+            volatile enet_tx_bd_struct_t *bd = &base[s_enet.txDma];
+
+            configASSERT(bd->control & ENET_BUFFDESCRIPTOR_TX_READY_MASK);
+            configASSERT(length + bd->length <= sizeof(frame));
+            dma_copy(&frame[length], bd->buffer, bd->length);
+            length += bd->length;
+            last = (bd->control & ENET_BUFFDESCRIPTOR_TX_LAST_MASK) != 0U;
+            bd->control &= ~ENET_BUFFDESCRIPTOR_TX_READY_MASK;
+            s_enet.txDma = (s_enet.txDma + 1U) % s_enet.txBdNumber;
+            s_enet.stats.txDescriptors++;
+        }
+
+        if (s_enet.txAccel & (kENET_TxAccelIpCheckEnabled | kENET_TxAccelProtoCheckEnabled))
+        {
+            tx_insert_chksums(frame, length);
+        }
+        s_enet.stats.txFrames++;
+        s_enet.stats.txBytes += length;
+        sent++;
+        if (s_enet.txHandler != NULL)
+        {
+            s_enet.txHandler(frame, length, s_enet.txArg);
+        }
+    }
+
+    if (sent != 0U)
+    {
+        enet_model_raise(ENET_MODEL_TX_IRQ_LINE, kENET_TxFrameInterrupt);
+    }
+    return sent;
+}
+
+void enet_model_set_tx_handler(enet_model_tx_handler_t handler, void *arg)
+{
+    s_enet.txHandler = handler;
+    s_enet.txArg = arg;
+}
+
+void enet_model_get_stats(enet_model_stats_t *stats)
+{
+    *stats = s_enet.stats;
+}
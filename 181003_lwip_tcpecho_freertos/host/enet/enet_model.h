@@ -0,0 +1,73 @@
+/*
+ * Device side of the ENET model behind host/enet/fsl_enet.h.
+ *
+ * The model plays the ENET DMA: enet_model_receive() writes a frame into the
+ * receive descriptors the driver left empty, enet_model_transmit() sends the
+ * frames the driver marked ready. Both raise the matching interrupt, whose
+ * handler calls the driver callback as ENET_ReceiveIRQHandler() and
+ * ENET_TransmitIRQHandler() do. The model runs on the simulated CPU: call it
+ * from a task, never from a host thread.
+ *
+ * With the checksum accelerators configured, the model verifies received
+ * IPv4/TCP/UDP/ICMP checksums and inserts transmitted ones as the ENET does:
+ * it leaves IP fragments alone, reports errors in the enhanced descriptor or
+ * discards the frame with legacy descriptors.
+ */
+
+#ifndef ENET_MODEL_H
+#define ENET_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Simulated interrupt lines of the ENET, see portmacro.h. */
+#define ENET_MODEL_RX_IRQ_LINE 1U
+#define ENET_MODEL_TX_IRQ_LINE 2U
+
+/* Counters of the device side. */
+typedef struct enet_model_stats
+{
+    uint32_t rxFrames;           /* frames written to the receive descriptors */
+    uint32_t rxOverruns;         /* frames dropped because no descriptor was empty */
+    uint32_t rxChecksumDiscards; /* frames the receive accelerator discarded */
+    uint32_t txFrames;           /* frames sent */
+    uint32_t txDescriptors;      /* descriptors the sent frames used */
+    uint32_t txChecksumsPreset;  /* sent frames the accelerator found with a checksum already filled in */
+    uint64_t txBytes;
+} enet_model_stats_t;
+
+/* Called for every sent frame, with the frame gathered from its descriptors. */
+typedef void (*enet_model_tx_handler_t)(const uint8_t *frame, uint32_t length, void *arg);
+
+/*!
+ * @brief Receives a frame.
+ *
+ * Writes the frame into the empty receive descriptors and raises the receive
+ * interrupt.
+ *
+ * @return false if the frame was dropped because the ring is full.
+ */
+bool enet_model_receive(const uint8_t *frame, uint32_t length);
+
+/*! @brief Returns the number of receive descriptors the driver has given back to the DMA. */
+uint32_t enet_model_rx_free(void);
+
+/*!
+ * @brief Sends the frames the driver queued.
+ *
+ * Passes every ready frame to the transmit handler, gives its descriptors
+ * back to the driver and raises the transmit interrupt.
+ *
+ * @return the number of frames sent.
+ */
+uint32_t enet_model_transmit(void);
+
+/*! @brief Sets the handler sent frames are passed to, NULL to discard them. */
+void enet_model_set_tx_handler(enet_model_tx_handler_t handler, void *arg);
+
+void enet_model_get_stats(enet_model_stats_t *stats);
+
+/*! @brief Internet checksum of a buffer, in network order, independent from lwIP's. */
+uint16_t enet_model_chksum(const void *data, uint32_t length);
+
+#endif /* ENET_MODEL_H */
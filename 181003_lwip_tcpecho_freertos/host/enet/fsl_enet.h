@@ -0,0 +1,319 @@
+/*
+ * ENET driver of the host build: the K64F SDK driver API that ethernetif.c
+ * uses, on top of a model of the ENET DMA (enet_model.c) instead of the
+ * registers. Descriptors, buffers and the driver calls behave as in
+ * drivers/fsl_enet.c; the device side of the model moves frames between the
+ * descriptor rings and the benchmark, see enet_model.h.
+ *
+ * The memcpy() calls of the driver and of the files that include this header
+ * are counted in enet_model_copied, so a benchmark can tell the bytes the
+ * receive and transmit paths copy per frame.
+ */
+
+#ifndef _FSL_ENET_H_
+#define _FSL_ENET_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+ * fsl_common.h and device header subset
+ ******************************************************************************/
+typedef int32_t status_t;
+
+#define MAKE_STATUS(group, code) ((((group)*100) + (code)))
+#define kStatusGroup_Generic 0
+#define kStatusGroup_ENET 40
+
+enum _generic_status
+{
+    kStatus_Success = MAKE_STATUS(kStatusGroup_Generic, 0),
+    kStatus_Fail = MAKE_STATUS(kStatusGroup_Generic, 1),
+};
+
+#define SDK_ALIGN(var, alignbytes) var __attribute__((aligned(alignbytes)))
+#define SDK_SIZEALIGN(var, alignbytes) (((var) + ((alignbytes)-1)) & (~((alignbytes)-1)))
+#define AT_NONCACHEABLE_SECTION_ALIGN(var, alignbytes) SDK_ALIGN(var, alignbytes)
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+typedef enum IRQn
+{
+    ENET_1588_Timer_IRQn = 82,
+    ENET_Transmit_IRQn = 83,
+    ENET_Receive_IRQn = 84,
+    ENET_Error_IRQn = 85,
+} IRQn_Type;
+
+#define NVIC_SetPriority(irq, priority) ((void)(irq), (void)(priority))
+
+/* The ENET callback runs on a simulated interrupt line (portmacro.h). */
+#define __get_IPSR() ((uint32_t)xPortIsInsideInterrupt())
+#define __DSB() __sync_synchronize()
+
+typedef enum _clock_name
+{
+    kCLOCK_CoreSysClk,
+} clock_name_t;
+
+#define CLOCK_GetFreq(name) ((void)(name), 120000000U)
+
+typedef struct
+{
+    volatile uint32_t EIR;
+    volatile uint32_t EIMR;
+    volatile uint32_t RDAR;
+    volatile uint32_t TDAR;
+} ENET_Type;
+
+extern ENET_Type enet_model_regs;
+
+#define ENET (&enet_model_regs)
+#define ENET_BASE_PTRS { ENET }
+#define ENET_Transmit_IRQS { ENET_Transmit_IRQn }
+#define ENET_Receive_IRQS { ENET_Receive_IRQn }
+#define ENET_Error_IRQS { ENET_Error_IRQn }
+#define ENET_1588_Timer_IRQS { ENET_1588_Timer_IRQn }
+
+#define ENET_RDAR_RDAR_MASK (0x1000000U)
+#define ENET_TDAR_TDAR_MASK (0x1000000U)
+
+#define FSL_FEATURE_SOC_ENET_COUNT (1)
+#define FSL_FEATURE_ENET_QUEUE (1)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define LINK_SPEED_OF_YOUR_NETIF_IN_BPS 100000000
+
+/*! @brief Defines the control and status region of the receive buffer descriptor. */
+#define ENET_BUFFDESCRIPTOR_RX_EMPTY_MASK 0x8000U
+#define ENET_BUFFDESCRIPTOR_RX_SOFTOWNER1_MASK 0x4000U
+#define ENET_BUFFDESCRIPTOR_RX_WRAP_MASK 0x2000U
+#define ENET_BUFFDESCRIPTOR_RX_SOFTOWNER2_Mask 0x1000U
+#define ENET_BUFFDESCRIPTOR_RX_LAST_MASK 0x0800U
+#define ENET_BUFFDESCRIPTOR_RX_MISS_MASK 0x0100U
+#define ENET_BUFFDESCRIPTOR_RX_BROADCAST_MASK 0x0080U
+#define ENET_BUFFDESCRIPTOR_RX_MULTICAST_MASK 0x0040U
+#define ENET_BUFFDESCRIPTOR_RX_LENVLIOLATE_MASK 0x0020U
+#define ENET_BUFFDESCRIPTOR_RX_NOOCTET_MASK 0x0010U
+#define ENET_BUFFDESCRIPTOR_RX_CRC_MASK 0x0004U
+#define ENET_BUFFDESCRIPTOR_RX_OVERRUN_MASK 0x0002U
+#define ENET_BUFFDESCRIPTOR_RX_TRUNC_MASK 0x0001U
+
+/*! @brief Defines the control and status region of the transmit buffer descriptor. */
+#define ENET_BUFFDESCRIPTOR_TX_READY_MASK 0x8000U
+#define ENET_BUFFDESCRIPTOR_TX_SOFTOWENER1_MASK 0x4000U
+#define ENET_BUFFDESCRIPTOR_TX_WRAP_MASK 0x2000U
+#define ENET_BUFFDESCRIPTOR_TX_SOFTOWENER2_MASK 0x1000U
+#define ENET_BUFFDESCRIPTOR_TX_LAST_MASK 0x0800U
+#define ENET_BUFFDESCRIPTOR_TX_TRANMITCRC_MASK 0x0400U
+
+#ifdef ENET_ENHANCEDBUFFERDESCRIPTOR_MODE
+/* Extended control regions for enhanced buffer descriptors. */
+#define ENET_BUFFDESCRIPTOR_RX_IPV4_MASK 0x0001U
+#define ENET_BUFFDESCRIPTOR_RX_IPV6_MASK 0x0002U
+#define ENET_BUFFDESCRIPTOR_RX_VLAN_MASK 0x0004U
+#define ENET_BUFFDESCRIPTOR_RX_PROTOCOLCHECKSUM_MASK 0x0010U
+#define ENET_BUFFDESCRIPTOR_RX_IPHEADCHECKSUM_MASK 0x0020U
+#define ENET_BUFFDESCRIPTOR_RX_INTERRUPT_MASK 0x0080U
+#define ENET_BUFFDESCRIPTOR_RX_EXT_ERR_MASK 0x0010U
+#endif /* ENET_ENHANCEDBUFFERDESCRIPTOR_MODE */
+
+#define ENET_BUFFDESCRIPTOR_RX_ERR_MASK                                        \
+    (ENET_BUFFDESCRIPTOR_RX_TRUNC_MASK | ENET_BUFFDESCRIPTOR_RX_OVERRUN_MASK | \
+     ENET_BUFFDESCRIPTOR_RX_LENVLIOLATE_MASK | ENET_BUFFDESCRIPTOR_RX_NOOCTET_MASK | ENET_BUFFDESCRIPTOR_RX_CRC_MASK)
+
+#define ENET_FRAME_MAX_FRAMELEN 1518U /*!< Default maximum Ethernet frame size. */
+#define ENET_BUFF_ALIGNMENT 16U       /*!< Ethernet buffer alignment. */
+
+/*! @brief Defines the status return codes for transaction. */
+enum _enet_status
+{
+    kStatus_ENET_RxFrameError = MAKE_STATUS(kStatusGroup_ENET, 0U), /*!< A frame received but data error happen. */
+    kStatus_ENET_RxFrameFail = MAKE_STATUS(kStatusGroup_ENET, 1U),  /*!< Failed to receive a frame. */
+    kStatus_ENET_RxFrameEmpty = MAKE_STATUS(kStatusGroup_ENET, 2U), /*!< No frame arrive. */
+    kStatus_ENET_TxFrameOverLen = MAKE_STATUS(kStatusGroup_ENET, 3U), /*!< Tx frame over length. */
+    kStatus_ENET_TxFrameBusy = MAKE_STATUS(kStatusGroup_ENET, 4U),  /*!< Tx buffer descriptors are under process. */
+    kStatus_ENET_TxFrameFail = MAKE_STATUS(kStatusGroup_ENET, 5U)   /*!< Transmit frame fail. */
+};
+
+/*! @brief Defines the MII speed. */
+typedef enum _enet_mii_speed
+{
+    kENET_MiiSpeed10M = 0U,  /*!< Speed 10 Mbps. */
+    kENET_MiiSpeed100M = 1U, /*!< Speed 100 Mbps. */
+} enet_mii_speed_t;
+
+/*! @brief Defines the MII duplex. */
+typedef enum _enet_mii_duplex
+{
+    kENET_MiiHalfDuplex = 0U, /*!< Half duplex mode. */
+    kENET_MiiFullDuplex       /*!< Full duplex mode. */
+} enet_mii_duplex_t;
+
+/*! @brief Defines the interrupt sources. */
+typedef enum _enet_interrupt_enable
+{
+    kENET_TxFrameInterrupt = 0x8000000U,  /*!< TX FRAME interrupt source */
+    kENET_TxBufferInterrupt = 0x4000000U, /*!< TX BUFFER interrupt source */
+    kENET_RxFrameInterrupt = 0x2000000U,  /*!< RX FRAME interrupt source */
+    kENET_RxBufferInterrupt = 0x1000000U, /*!< RX BUFFER interrupt source */
+} enet_interrupt_enable_t;
+
+/*! @brief Defines the common interrupt event for callback use. */
+typedef enum _enet_event
+{
+    kENET_RxEvent,     /*!< Receive event. */
+    kENET_TxEvent,     /*!< Transmit event. */
+    kENET_ErrEvent,    /*!< Error event: BABR/BABT/EBERR/LC/RL/UN/PLR . */
+    kENET_WakeUpEvent, /*!< Wake up from sleep mode event. */
+} enet_event_t;
+
+/*! @brief Defines the transmit accelerator configuration. */
+typedef enum _enet_tx_accelerator
+{
+    kENET_TxAccelIsShift16Enabled = 0x01U,  /*!< Transmit FIFO shift-16. */
+    kENET_TxAccelIpCheckEnabled = 0x08U,    /*!< Insert IP header checksum. */
+    kENET_TxAccelProtoCheckEnabled = 0x10U, /*!< Insert protocol checksum. */
+} enet_tx_accelerator_t;
+
+/*! @brief Defines the receive accelerator configuration. */
+typedef enum _enet_rx_accelerator
+{
+    kENET_RxAccelPadRemoveEnabled = 0x01U,  /*!< Padding removal for short IP frames. */
+    kENET_RxAccelIpCheckEnabled = 0x02U,    /*!< Discard with wrong IP header checksum. */
+    kENET_RxAccelProtoCheckEnabled = 0x04U, /*!< Discard with wrong protocol checksum. */
+    kENET_RxAccelMacCheckEnabled = 0x40U,   /*!< Discard with Mac layer errors. */
+    kENET_RxAccelisShift16Enabled = 0x80U   /*!< Receive FIFO shift-16. */
+} enet_rx_accelerator_t;
+
+/*! @brief Defines the receive buffer descriptor structure for the little endian system.*/
+typedef struct _enet_rx_bd_struct
+{
+    uint16_t length;  /*!< Buffer descriptor data length. */
+    uint16_t control; /*!< Buffer descriptor control and status. */
+    uint8_t *buffer;  /*!< Data buffer pointer. */
+#ifdef ENET_ENHANCEDBUFFERDESCRIPTOR_MODE
+    uint16_t controlExtend0;  /*!< Extend buffer descriptor control0. */
+    uint16_t controlExtend1;  /*!< Extend buffer descriptor control1. */
+    uint16_t payloadCheckSum; /*!< Internal payload checksum. */
+    uint8_t headerLength;     /*!< Header length. */
+    uint8_t protocolTyte;     /*!< Protocol type. */
+    uint16_t reserved0;
+    uint16_t controlExtend2; /*!< Extend buffer descriptor control2. */
+    uint32_t timestamp;      /*!< Timestamp. */
+#endif                       /* ENET_ENHANCEDBUFFERDESCRIPTOR_MODE */
+} enet_rx_bd_struct_t;
+
+/*! @brief Defines the enhanced transmit buffer descriptor structure for the little endian system. */
+typedef struct _enet_tx_bd_struct
+{
+    uint16_t length;  /*!< Buffer descriptor data length. */
+    uint16_t control; /*!< Buffer descriptor control and status. */
+    uint8_t *buffer;  /*!< Data buffer pointer. */
+#ifdef ENET_ENHANCEDBUFFERDESCRIPTOR_MODE
+    uint16_t controlExtend0; /*!< Extend buffer descriptor control0. */
+    uint16_t controlExtend1; /*!< Extend buffer descriptor control1. */
+    uint16_t reserved0;
+    uint16_t controlExtend2; /*!< Extend buffer descriptor control2. */
+    uint32_t timestamp;      /*!< Timestamp. */
+#endif                       /* ENET_ENHANCEDBUFFERDESCRIPTOR_MODE */
+} enet_tx_bd_struct_t;
+
+/*! @brief Defines the receive buffer descriptor configuration structure. */
+typedef struct _enet_buffer_config
+{
+    uint16_t rxBdNumber;                            /*!< Receive buffer descriptor number. */
+    uint16_t txBdNumber;                            /*!< Transmit buffer descriptor number. */
+    uint32_t rxBuffSizeAlign;                       /*!< Aligned receive data buffer size. */
+    uint32_t txBuffSizeAlign;                       /*!< Aligned transmit data buffer size. */
+    volatile enet_rx_bd_struct_t *rxBdStartAddrAlign; /*!< Aligned receive buffer descriptor start address. */
+    volatile enet_tx_bd_struct_t *txBdStartAddrAlign; /*!< Aligned transmit buffer descriptor start address. */
+    uint8_t *rxBufferAlign;                         /*!< Receive data buffer start address. */
+    uint8_t *txBufferAlign;                         /*!< Transmit data buffer start address. */
+} enet_buffer_config_t;
+
+/*! @brief Defines the basic configuration structure for the ENET device. */
+typedef struct _enet_config
+{
+    uint32_t macSpecialConfig;    /*!< Mac special configuration. */
+    uint32_t interrupt;           /*!< Mac interrupt source. */
+    uint16_t rxMaxFrameLen;       /*!< Receive maximum frame length. */
+    enet_mii_speed_t miiSpeed;    /*!< MII speed. */
+    enet_mii_duplex_t miiDuplex;  /*!< MII duplex. */
+    uint8_t rxAccelerConfig;      /*!< Receive accelerator. */
+    uint8_t txAccelerConfig;      /*!< Transmit accelerator. */
+    uint8_t ringNum;              /*!< Number of used rings. */
+} enet_config_t;
+
+typedef struct _enet_handle enet_handle_t;
+
+/*! @brief ENET callback function. */
+typedef void (*enet_callback_t)(ENET_Type *base, enet_handle_t *handle, enet_event_t event, void *userData);
+
+/*! @brief Defines the ENET handler structure. */
+struct _enet_handle
+{
+    volatile enet_rx_bd_struct_t *rxBdBase[FSL_FEATURE_ENET_QUEUE];    /*!< Receive buffer descriptor base address pointer. */
+    volatile enet_rx_bd_struct_t *rxBdCurrent[FSL_FEATURE_ENET_QUEUE]; /*!< The current available receive buffer descriptor pointer. */
+    volatile enet_tx_bd_struct_t *txBdBase[FSL_FEATURE_ENET_QUEUE];    /*!< Transmit buffer descriptor base address pointer. */
+    volatile enet_tx_bd_struct_t *txBdCurrent[FSL_FEATURE_ENET_QUEUE]; /*!< The current available transmit buffer descriptor pointer. */
+    uint32_t rxBuffSizeAlign[FSL_FEATURE_ENET_QUEUE];                  /*!< Receive buffer size alignment. */
+    uint32_t txBuffSizeAlign[FSL_FEATURE_ENET_QUEUE];                  /*!< Transmit buffer size alignment. */
+    uint8_t ringNum;                                                   /*!< Number of used rings. */
+    enet_callback_t callback;                                          /*!< Callback function. */
+    void *userData;                                                    /*!< Callback function parameter.*/
+};
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void ENET_GetDefaultConfig(enet_config_t *config);
+void ENET_Init(ENET_Type *base,
+               enet_handle_t *handle,
+               const enet_config_t *config,
+               const enet_buffer_config_t *bufferConfig,
+               uint8_t *macAddr,
+               uint32_t srcClock_Hz);
+void ENET_SetCallback(enet_handle_t *handle, enet_callback_t callback, void *userData);
+void ENET_AddMulticastGroup(ENET_Type *base, uint8_t *address);
+void ENET_LeaveMulticastGroup(ENET_Type *base, uint8_t *address);
+status_t ENET_GetRxFrameSize(enet_handle_t *handle, uint32_t *length);
+status_t ENET_ReadFrame(ENET_Type *base, enet_handle_t *handle, uint8_t *data, uint32_t length);
+status_t ENET_SendFrame(ENET_Type *base, enet_handle_t *handle, const uint8_t *data, uint32_t length);
+
+static inline void ENET_ActiveRead(ENET_Type *base)
+{
+    base->RDAR = ENET_RDAR_RDAR_MASK;
+}
+
+/* Bytes copied by memcpy() in the driver and in the files including this header. */
+extern uint64_t enet_model_copied;
+
+static inline void *enet_model_memcpy(void *dst, const void *src, size_t size)
+{
+    enet_model_copied += size;
+    return (memcpy)(dst, src, size);
+}
+
+#define memcpy(dst, src, size) enet_model_memcpy((dst), (src), (size))
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _FSL_ENET_H_ */
@@ -0,0 +1,290 @@
+/*
+ * Receive path of ethernetif on the ENET model: copy against zero-copy
+ * (ETHERNETIF_RX_ZERO_COPY).
+ *
+ * Feeds UDP frames to the receive descriptors in bursts, the way frames
+ * arriving back to back fill the ring, and counts the frames the stack hands
+ * to a UDP pcb. Prints the frames per second of the host and the bytes the
+ * driver and ethernetif copied per frame. With a hold count the pcb keeps that
+ * many frames before freeing the oldest, like an application that falls behind:
+ * once the spare buffers run out, zero-copy falls back to copying. Holding
+ * more frames than the pbuf pool and the spare buffers have room for stalls
+ * the receive ring.
+ *
+ * The batch builds (ETHERNETIF_RX_BATCH) raise ENET_RXBD_NUM to 32, so a
+ * default burst fills the batches they post to the tcpip thread.
+ *
+ * Fails if a frame is lost or damaged, or if the zero-copy build copies while
+ * it still has spare buffers.
+ *
+ *   make -C host enet_rx_bench_copy enet_rx_bench_zc enet_rx_bench_batch8
+ *   host/enet_rx_bench_zc [frames [payload [burst [hold]]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/udp.h"
+#include "netif/ethernet.h"
+#include "ethernetif.h"
+#include "enet_model.h"
+
+/* Only the copies of the driver and of ethernetif are counted. */
+#undef memcpy
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_PORT 7U
+#define BENCH_HOLD_MAX 64U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const uint8_t s_mac[6] = {0x02, 0x12, 0x13, 0x10, 0x15, 0x11};
+static const uint8_t s_peerMac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t s_addrs[8] = {192, 168, 1, 1, 192, 168, 1, 102};
+
+static uint32_t s_frames = 200000U;
+static uint32_t s_payload = 1472U;
+static uint32_t s_burst = ENET_RXBD_NUM;
+static uint32_t s_hold = 0U;
+
+static volatile uint32_t s_received;
+static volatile uint32_t s_damaged;
+static struct pbuf *s_held[BENCH_HOLD_MAX];
+static uint32_t s_heldNext;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/* Builds the UDP/IPv4 frame with sequence number seq, returns its length. */
+static uint32_t build_frame(uint8_t *frame, uint32_t seq)
+{
+    uint8_t *ip = &frame[14];
+    uint8_t *udp = &ip[20];
+    uint32_t udpLen = 8U + s_payload;
+    uint32_t ipLen = 20U + udpLen;
+    uint32_t sum;
+    uint32_t i;
+    uint16_t check;
+
+    memcpy(&frame[0], s_mac, 6);
+    memcpy(&frame[6], s_peerMac, 6);
+    frame[12] = 0x08;
+    frame[13] = 0x00;
+
+    memset(ip, 0, 20);
+    ip[0] = 0x45;
+    ip[2] = (uint8_t)(ipLen >> 8);
+    ip[3] = (uint8_t)ipLen;
+    ip[4] = (uint8_t)(seq >> 8);
+    ip[5] = (uint8_t)seq;
+    ip[8] = 64;
+    ip[9] = 17;
+    memcpy(&ip[12], s_addrs, sizeof(s_addrs));
+    check = enet_model_chksum(ip, 20);
+    ip[10] = (uint8_t)(check >> 8);
+    ip[11] = (uint8_t)check;
+
+    udp[0] = (uint8_t)(40000U >> 8);
+    udp[1] = (uint8_t)40000U;
+    udp[2] = 0;
+    udp[3] = BENCH_PORT;
+    udp[4] = (uint8_t)(udpLen >> 8);
+    udp[5] = (uint8_t)udpLen;
+    udp[6] = 0;
+    udp[7] = 0;
+    for (i = 0; i < s_payload; i++)
+    {
+        udp[8 + i] = (uint8_t)(seq + i);
+    }
+
+    /* Pseudo header: the address pair, the protocol and the UDP length. */
+    sum = 0U;
+    for (i = 12; i < 20; i += 2)
+    {
+        sum += ((uint32_t)ip[i] << 8) | ip[i + 1];
+    }
+    sum += 17U + udpLen;
+    for (i = 0; i + 1 < udpLen; i += 2)
+    {
+        sum += ((uint32_t)udp[i] << 8) | udp[i + 1];
+    }
+    if (udpLen & 1U)
+    {
+        sum += (uint32_t)udp[udpLen - 1] << 8;
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFFU) + (sum >> 16);
+    }
+    check = (uint16_t)~sum;
+    if (check == 0U)
+    {
+        check = 0xFFFFU;
+    }
+    udp[6] = (uint8_t)(check >> 8);
+    udp[7] = (uint8_t)check;
+
+    return 14U + ipLen;
+}
+
+static void bench_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    uint8_t first;
+    uint8_t last;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    /* The payload of a frame starts with its sequence number and counts up. */
+    if ((p->tot_len != s_payload) || (pbuf_copy_partial(p, &first, 1, 0) != 1) ||
+        (pbuf_copy_partial(p, &last, 1, s_payload - 1U) != 1) || ((uint8_t)(last - first) != (uint8_t)(s_payload - 1U)))
+    {
+        s_damaged++;
+    }
+    s_received++;
+
+    if (s_hold == 0U)
+    {
+        pbuf_free(p);
+        return;
+    }
+    if (s_held[s_heldNext] != NULL)
+    {
+        pbuf_free(s_held[s_heldNext]);
+    }
+    s_held[s_heldNext] = p;
+    s_heldNext = (s_heldNext + 1U) % s_hold;
+}
+
+static void bench_task(void *arg)
+{
+    static struct netif netif;
+    static uint8_t frame[ENET_FRAME_MAX_FRAMELEN];
+    ethernetif_config_t config = {
+        .phyAddress = 0,
+        .clockName = kCLOCK_CoreSysClk,
+        .macAddress = {0x02, 0x12, 0x13, 0x10, 0x15, 0x11},
+    };
+    ip4_addr_t ipaddr, netmask, gw;
+    struct udp_pcb *pcb;
+    enet_model_stats_t stats;
+    struct timespec start, end;
+    uint32_t sent = 0U;
+    uint32_t length;
+    uint32_t i;
+    uint64_t copied;
+    double seconds;
+
+    LWIP_UNUSED_ARG(arg);
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    tcpip_init(NULL, NULL);
+    netif_add(&netif, &ipaddr, &netmask, &gw, &config, ethernetif0_init, tcpip_input);
+    netif_set_default(&netif);
+    netif_set_up(&netif);
+
+    LOCK_TCPIP_CORE();
+    pcb = udp_new();
+    udp_bind(pcb, IP_ADDR_ANY, BENCH_PORT);
+    udp_recv(pcb, bench_recv, NULL);
+    UNLOCK_TCPIP_CORE();
+
+    enet_model_copied = 0U;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (sent < s_frames)
+    {
+        /* A burst arrives while the receive interrupt is pending. */
+        taskENTER_CRITICAL();
+        for (i = 0U; (i < s_burst) && (sent < s_frames); i++)
+        {
+            length = build_frame(frame, sent);
+            if (!enet_model_receive(frame, length))
+            {
+                break;
+            }
+            sent++;
+        }
+        taskEXIT_CRITICAL();
+
+        /* The tcpip thread outranks this task: it is idle again here. */
+        taskYIELD();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    copied = enet_model_copied;
+
+    LOCK_TCPIP_CORE();
+    for (i = 0U; i < BENCH_HOLD_MAX; i++)
+    {
+        if (s_held[i] != NULL)
+        {
+            pbuf_free(s_held[i]);
+            s_held[i] = NULL;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    enet_model_get_stats(&stats);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%s, batch %u: %u frames of %u bytes, burst %u, hold %u: %.0f frames/s, %.1f bytes copied per frame\n",
+           ETHERNETIF_RX_ZERO_COPY ? "zero-copy" : "copy", (unsigned)ETHERNETIF_RX_BATCH, (unsigned)sent,
+           (unsigned)(s_payload + 42U), (unsigned)s_burst, (unsigned)s_hold, sent / seconds, (double)copied / sent);
+    printf("received %u, damaged %u, ring overruns %u\n", (unsigned)s_received, (unsigned)s_damaged,
+           (unsigned)stats.rxOverruns);
+
+    if ((s_received != s_frames) || (s_damaged != 0U))
+    {
+        printf("FAIL: frames lost or damaged\n");
+        exit(1);
+    }
+    if (ETHERNETIF_RX_ZERO_COPY && (s_hold == 0U) && (copied != 0U))
+    {
+        printf("FAIL: zero-copy build copied with spare buffers left\n");
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_frames = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        s_payload = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3)
+    {
+        s_burst = strtoul(argv[3], NULL, 0);
+    }
+    if (argc > 4)
+    {
+        s_hold = strtoul(argv[4], NULL, 0);
+    }
+    if ((s_frames == 0U) || (s_payload == 0U) || (s_payload > 1472U) || (s_burst == 0U) || (s_hold > BENCH_HOLD_MAX))
+    {
+        fprintf(stderr, "usage: %s [frames [payload 1..1472 [burst [hold 0..%u]]]]\n", argv[0], BENCH_HOLD_MAX);
+        return 2;
+    }
+
+    if (sys_thread_new("bench", bench_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
@@ -0,0 +1,359 @@
+/*
+ * Transmit path of ethernetif on the ENET model: copy against scatter-gather
+ * (ETHERNETIF_TX_SCATTER_GATHER).
+ *
+ * A task sends UDP datagrams as fast as the descriptor ring takes them; the
+ * wire, a lower priority task, only runs once the sender has to wait for
+ * descriptors. The payload is
+ *   ram    a PBUF_RAM pbuf with room for the headers: one buffer per frame,
+ *   ref    an application buffer in a custom PBUF_REF pbuf behind the header
+ *          pbuf: two buffers per frame,
+ *   split  four PBUF_REF pieces: five buffers, more than the ring has.
+ * Prints the frames per second of the host, the bytes the driver and ethernetif
+ * copied per frame and the descriptors per frame. The scatter-gather build
+ * flattens split frames with pbuf_copy_partial(), which the copy count does not
+ * see: they show as one descriptor per frame.
+ *
+ * Fails if a frame is lost, damaged or sent out of order, if a ref payload is
+ * released before the wire sent it or out of order, or if the scatter-gather
+ * build copies a frame that fits the ring.
+ *
+ *   make -C host enet_tx_bench_copy enet_tx_bench_sg
+ *   host/enet_tx_bench_sg [ram|ref|split [frames [payload]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/udp.h"
+#include "lwip/etharp.h"
+#include "netif/ethernet.h"
+#include "ethernetif.h"
+#include "enet_model.h"
+
+/* Only the copies of the driver and of ethernetif are counted. */
+#undef memcpy
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_PORT 9U
+#define BENCH_SLOTS 16U
+#define BENCH_PAYLOAD_MAX 1472U
+#define BENCH_SPLIT 4U
+
+typedef enum
+{
+    kBenchRam,
+    kBenchRef,
+    kBenchSplit,
+} bench_mode_t;
+
+/* Application buffer of one datagram. */
+typedef struct bench_slot
+{
+    struct pbuf_custom p; /* must be the first member */
+    uint32_t seq;
+    volatile bool busy;
+    uint8_t data[BENCH_PAYLOAD_MAX];
+} bench_slot_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static const char *const s_modeNames[] = {"ram", "ref", "split"};
+
+static bench_mode_t s_mode = kBenchRef;
+static uint32_t s_frames = 200000U;
+static uint32_t s_payload = 1472U;
+
+static bench_slot_t s_slots[BENCH_SLOTS];
+static volatile uint32_t s_wired;    /* frames the wire sent */
+static volatile uint32_t s_released; /* ref payloads released */
+static volatile uint32_t s_errors;
+static volatile bool s_done;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static void fill_payload(uint8_t *data, uint32_t seq)
+{
+    uint32_t i;
+
+    data[0] = (uint8_t)(seq >> 24);
+    data[1] = (uint8_t)(seq >> 16);
+    data[2] = (uint8_t)(seq >> 8);
+    data[3] = (uint8_t)seq;
+    for (i = 4U; i < s_payload; i++)
+    {
+        data[i] = (uint8_t)(seq + i);
+    }
+}
+
+static void bench_error(const char *what, uint32_t seq)
+{
+    if (s_errors++ < 10U)
+    {
+        printf("error: %s, frame %u\n", what, (unsigned)seq);
+    }
+}
+
+/* Custom pbuf free function of the ref payloads. */
+static void slot_release(struct pbuf *p)
+{
+    bench_slot_t *slot = (bench_slot_t *)p;
+
+    if (slot->seq != s_released)
+    {
+        bench_error("payload released out of order", slot->seq);
+    }
+    if (ETHERNETIF_TX_SCATTER_GATHER && (slot->seq >= s_wired))
+    {
+        bench_error("payload released before it was sent", slot->seq);
+    }
+    s_released++;
+    slot->busy = false;
+}
+
+/* Checks a datagram on the wire: sequence, payload and checksums. */
+static void wire_frame(const uint8_t *frame, uint32_t length, void *arg)
+{
+    const uint8_t *ip = &frame[14];
+    const uint8_t *udp = &ip[20];
+    const uint8_t *data = &udp[8];
+    uint8_t expected[BENCH_PAYLOAD_MAX];
+    uint8_t pseudo[12];
+    uint32_t udpLen = 8U + s_payload;
+    uint32_t seq = s_wired;
+
+    LWIP_UNUSED_ARG(arg);
+
+    /* The gratuitous ARP of netif_set_up() goes out first. */
+    if ((frame[12] != 0x08U) || (frame[13] != 0x00U))
+    {
+        return;
+    }
+
+    fill_payload(expected, seq);
+    if ((length != 14U + 20U + udpLen) || (ip[9] != 17U) || (memcmp(data, expected, s_payload) != 0))
+    {
+        bench_error("frame damaged or out of order", seq);
+    }
+    else
+    {
+        uint32_t sum;
+
+        memcpy(&pseudo[0], &ip[12], 8);
+        pseudo[8] = 0U;
+        pseudo[9] = 17U;
+        pseudo[10] = (uint8_t)(udpLen >> 8);
+        pseudo[11] = (uint8_t)udpLen;
+        /* Summing the two checksums' complements gives the checksum of both. */
+        sum = (uint16_t)~enet_model_chksum(pseudo, sizeof(pseudo));
+        sum += (uint16_t)~enet_model_chksum(udp, udpLen);
+        sum = (sum & 0xFFFFU) + (sum >> 16);
+        if ((enet_model_chksum(ip, 20) != 0U) || ((uint16_t)~sum != 0U))
+        {
+            bench_error("bad checksum", seq);
+        }
+    }
+    s_wired++;
+}
+
+static struct pbuf *make_payload(uint32_t seq)
+{
+    bench_slot_t *slot = &s_slots[seq % BENCH_SLOTS];
+    struct pbuf *p;
+    struct pbuf *piece;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t i;
+
+    switch (s_mode)
+    {
+        case kBenchRam:
+            p = pbuf_alloc(PBUF_TRANSPORT, s_payload, PBUF_RAM);
+            if (p != NULL)
+            {
+                fill_payload(p->payload, seq);
+            }
+            return p;
+
+        case kBenchRef:
+            if (slot->busy)
+            {
+                bench_error("payload still held", slot->seq);
+                return NULL;
+            }
+            fill_payload(slot->data, seq);
+            slot->seq = seq;
+            slot->busy = true;
+            slot->p.custom_free_function = slot_release;
+            return pbuf_alloced_custom(PBUF_RAW, s_payload, PBUF_REF, &slot->p, slot->data, s_payload);
+
+        default:
+            fill_payload(slot->data, seq);
+            p = NULL;
+            for (i = 0U, offset = 0U; i < BENCH_SPLIT; i++, offset += size)
+            {
+                size = (i == BENCH_SPLIT - 1U) ? (s_payload - offset) : (s_payload / BENCH_SPLIT);
+                piece = pbuf_alloc(PBUF_RAW, size, PBUF_REF);
+                if (piece == NULL)
+                {
+                    break;
+                }
+                piece->payload = &slot->data[offset];
+                if (p == NULL)
+                {
+                    p = piece;
+                }
+                else
+                {
+                    pbuf_cat(p, piece);
+                }
+            }
+            return p;
+    }
+}
+
+static void wire_task(void *arg)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    while (!s_done)
+    {
+        enet_model_transmit();
+        taskYIELD();
+    }
+    vTaskDelete(NULL);
+}
+
+static void bench_task(void *arg)
+{
+    static struct netif netif;
+    ethernetif_config_t config = {
+        .phyAddress = 0,
+        .clockName = kCLOCK_CoreSysClk,
+        .macAddress = {0x02, 0x12, 0x13, 0x10, 0x15, 0x11},
+    };
+    struct eth_addr peerMac = {{0x02, 0x00, 0x00, 0x00, 0x00, 0x01}};
+    ip4_addr_t ipaddr, netmask, gw, peer;
+    ip_addr_t dst;
+    struct udp_pcb *pcb;
+    struct pbuf *p;
+    struct timespec start, end;
+    uint32_t seq;
+    enet_model_stats_t stats;
+    uint64_t copied;
+    double seconds;
+    err_t err;
+
+    LWIP_UNUSED_ARG(arg);
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+    IP4_ADDR(&peer, 192, 168, 1, 1);
+    ip_addr_copy_from_ip4(dst, peer);
+
+    tcpip_init(NULL, NULL);
+    netif_add(&netif, &ipaddr, &netmask, &gw, &config, ethernetif0_init, tcpip_input);
+    netif_set_default(&netif);
+    netif_set_up(&netif);
+    enet_model_set_tx_handler(wire_frame, NULL);
+
+    LOCK_TCPIP_CORE();
+    etharp_add_static_entry(&peer, &peerMac);
+    pcb = udp_new();
+    udp_bind(pcb, IP_ADDR_ANY, BENCH_PORT);
+    UNLOCK_TCPIP_CORE();
+
+    if (sys_thread_new("wire", wire_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO - 1) == NULL)
+    {
+        exit(1);
+    }
+
+    enet_model_copied = 0U;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (seq = 0U; seq < s_frames; seq++)
+    {
+        LOCK_TCPIP_CORE();
+        p = make_payload(seq);
+        err = ERR_MEM;
+        if (p != NULL)
+        {
+            err = udp_sendto(pcb, p, &dst, BENCH_PORT);
+            pbuf_free(p);
+        }
+        UNLOCK_TCPIP_CORE();
+        if (err != ERR_OK)
+        {
+            bench_error("send failed", seq);
+            break;
+        }
+    }
+    while ((s_wired < seq) || ((s_mode == kBenchRef) && (s_released < seq)))
+    {
+        vTaskDelay(1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    copied = enet_model_copied;
+    s_done = true;
+    enet_model_get_stats(&stats);
+
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%s %s: %u frames of %u bytes: %.0f frames/s, %.1f bytes copied and %.2f descriptors per frame\n",
+           ETHERNETIF_TX_SCATTER_GATHER ? "scatter-gather" : "copy", s_modeNames[s_mode], (unsigned)seq,
+           (unsigned)(s_payload + 42U), seq / seconds, (double)copied / seq,
+           (double)stats.txDescriptors / stats.txFrames);
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        exit(1);
+    }
+    if (ETHERNETIF_TX_SCATTER_GATHER && (s_mode != kBenchSplit) && (copied != 0U))
+    {
+        printf("FAIL: scatter-gather build copied a frame that fits the ring\n");
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t i;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        for (i = 0U; (i < ARRAY_SIZE(s_modeNames)) && (strcmp(argv[1], s_modeNames[i]) != 0); i++)
+        {
+        }
+        s_mode = (bench_mode_t)i;
+    }
+    if (argc > 2)
+    {
+        s_frames = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3)
+    {
+        s_payload = strtoul(argv[3], NULL, 0);
+    }
+    if ((s_mode > kBenchSplit) || (s_frames == 0U) || (s_payload < 4U * BENCH_SPLIT) || (s_payload > BENCH_PAYLOAD_MAX))
+    {
+        fprintf(stderr, "usage: %s [ram|ref|split [frames [payload 16..%u]]]\n", argv[0], BENCH_PAYLOAD_MAX);
+        return 2;
+    }
+
+    if (sys_thread_new("bench", bench_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
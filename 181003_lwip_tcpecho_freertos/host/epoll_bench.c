@@ -0,0 +1,291 @@
+/*
+ * Waiting on many sockets: lwip_select() against the lwip_epoll_wait() of
+ * LWIP_SOCKET_EPOLL.
+ *
+ * Binds 4 to 64 UDP sockets and watches all of them for reading, with one
+ * fd_set for lwip_select() and with one epoll instance. Each round a sender
+ * socket sends a datagram to a random one of them through the loopback of
+ * the host build, the bench task waits until a socket is readable and reads
+ * the datagram from it. Prints the host nanoseconds per round and spent in
+ * the wait call alone.
+ *
+ * Fails if the wait reports a socket other than the one sent to, a datagram
+ * carries the wrong round, or a socket is still readable after the rounds.
+ *
+ *   make -C host epoll_bench
+ *   host/epoll_bench [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/sockets.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_SOCKETS_MAX 64U
+#define BENCH_PORT_BASE 10000U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_rounds = 20000U;
+
+static struct netif s_netif;
+static int s_socks[BENCH_SOCKETS_MAX];
+static int s_sender;
+static struct sockaddr_in s_addr;
+static uint32_t s_rng = 1U;
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t bench_rand(uint32_t n)
+{
+    s_rng = s_rng * 1103515245U + 12345U;
+    return (s_rng >> 8) % n;
+}
+
+static void bench_error(const char *what, uint32_t round)
+{
+    if (s_errors++ < 10U)
+    {
+        printf("error: %s in round %u\n", what, (unsigned)round);
+    }
+}
+
+static err_t bench_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(p);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    return ERR_OK;
+}
+
+static err_t bench_netif_init(struct netif *netif)
+{
+    netif->output = bench_output;
+    netif->mtu = 1500;
+    return ERR_OK;
+}
+
+/* Sends round to socket i, returns its descriptor. */
+static int bench_send(uint32_t i, uint32_t round)
+{
+    s_addr.sin_port = PP_HTONS(BENCH_PORT_BASE + i);
+    if (lwip_sendto(s_sender, &round, sizeof(round), 0, (struct sockaddr *)&s_addr, sizeof(s_addr)) !=
+        (int)sizeof(round))
+    {
+        bench_error("sendto failed", round);
+    }
+    return s_socks[i];
+}
+
+static void bench_recv(int fd, int expected, uint32_t round)
+{
+    uint32_t data = 0U;
+
+    if (fd != expected)
+    {
+        bench_error("the wait reported another socket", round);
+        fd = expected;
+    }
+    if ((lwip_recv(fd, &data, sizeof(data), 0) != (int)sizeof(data)) || (data != round))
+    {
+        bench_error("the datagram is not the one sent", round);
+    }
+}
+
+/* Returns the ns per round; *wait gets the ns spent in lwip_select(). */
+static double bench_select(uint32_t count, double *wait)
+{
+    fd_set readset;
+    double start;
+    double t;
+    uint32_t round;
+    uint32_t i;
+    int expected;
+    int maxfd = 0;
+    int fd;
+
+    *wait = 0.0;
+    for (i = 0U; i < count; i++)
+    {
+        maxfd = LWIP_MAX(maxfd, s_socks[i]);
+    }
+    start = now_ns();
+    for (round = 0U; round < s_rounds; round++)
+    {
+        expected = bench_send(bench_rand(count), round);
+        FD_ZERO(&readset);
+        for (i = 0U; i < count; i++)
+        {
+            FD_SET(s_socks[i], &readset);
+        }
+        t = now_ns();
+        if (lwip_select(maxfd + 1, &readset, NULL, NULL, NULL) != 1)
+        {
+            bench_error("select did not report one socket", round);
+        }
+        *wait += now_ns() - t;
+        for (fd = expected, i = 0U; i < count; i++)
+        {
+            if (FD_ISSET(s_socks[i], &readset))
+            {
+                fd = s_socks[i];
+                break;
+            }
+        }
+        bench_recv(fd, expected, round);
+    }
+    *wait /= s_rounds;
+    return (now_ns() - start) / s_rounds;
+}
+
+/* Returns the ns per round; *wait gets the ns spent in lwip_epoll_wait(). */
+static double bench_epoll(uint32_t count, double *wait)
+{
+    struct epoll_event event;
+    struct epoll_event events[4];
+    double start;
+    double t;
+    uint32_t round;
+    uint32_t i;
+    int expected;
+    int epfd;
+    int n;
+
+    *wait = 0.0;
+    epfd = lwip_epoll_create(1);
+    if (epfd < 0)
+    {
+        printf("FAIL: no epoll instance\n");
+        exit(1);
+    }
+    for (i = 0U; i < count; i++)
+    {
+        event.events = EPOLLIN;
+        event.data.fd = s_socks[i];
+        if (lwip_epoll_ctl(epfd, EPOLL_CTL_ADD, s_socks[i], &event) != 0)
+        {
+            printf("FAIL: no epoll registration for socket %u\n", (unsigned)i);
+            exit(1);
+        }
+    }
+    start = now_ns();
+    for (round = 0U; round < s_rounds; round++)
+    {
+        expected = bench_send(bench_rand(count), round);
+        t = now_ns();
+        n = lwip_epoll_wait(epfd, events, 4, -1);
+        *wait += now_ns() - t;
+        if (n != 1)
+        {
+            bench_error("epoll_wait did not report one socket", round);
+        }
+        bench_recv((n > 0) ? events[0].data.fd : expected, expected, round);
+    }
+    *wait /= s_rounds;
+    t = (now_ns() - start) / s_rounds;
+
+    if (lwip_epoll_wait(epfd, events, 4, 0) != 0)
+    {
+        bench_error("a socket is still readable", round);
+    }
+    lwip_close(epfd);
+    return t;
+}
+
+static void bench_task(void *arg)
+{
+    static const uint32_t counts[] = {4U, 8U, 16U, 32U, BENCH_SOCKETS_MAX};
+    ip4_addr_t ipaddr, netmask, gw;
+    struct sockaddr_in local;
+    double selectNs, selectWait;
+    double epollNs, epollWait;
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(arg);
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    tcpip_init(NULL, NULL);
+    LOCK_TCPIP_CORE();
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, NULL, bench_netif_init, tcpip_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+    UNLOCK_TCPIP_CORE();
+
+    memset(&s_addr, 0, sizeof(s_addr));
+    s_addr.sin_len = sizeof(s_addr);
+    s_addr.sin_family = AF_INET;
+    inet_addr_from_ip4addr(&s_addr.sin_addr, &ipaddr);
+    local = s_addr;
+    for (i = 0U; i < BENCH_SOCKETS_MAX; i++)
+    {
+        s_socks[i] = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+        local.sin_port = PP_HTONS(BENCH_PORT_BASE + i);
+        if ((s_socks[i] < 0) || (lwip_bind(s_socks[i], (struct sockaddr *)&local, sizeof(local)) != 0))
+        {
+            printf("FAIL: no socket %u\n", (unsigned)i);
+            exit(1);
+        }
+    }
+    s_sender = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+
+    printf("%u rounds, ns per round and in the wait call\n", (unsigned)s_rounds);
+    printf("%8s %10s %10s %10s %10s\n", "sockets", "select", "wait", "epoll", "wait");
+    for (i = 0U; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        selectNs = bench_select(counts[i], &selectWait);
+        epollNs = bench_epoll(counts[i], &epollWait);
+        printf("%8u %10.0f %10.0f %10.0f %10.0f\n", (unsigned)counts[i], selectNs, selectWait, epollNs, epollWait);
+    }
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_rounds = strtoul(argv[1], NULL, 0);
+    }
+    if (s_rounds == 0U)
+    {
+        fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+        return 2;
+    }
+
+    if (sys_thread_new("bench", bench_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
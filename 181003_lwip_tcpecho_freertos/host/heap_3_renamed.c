@@ -0,0 +1,9 @@
+/*
+ * heap_3 under other names, so heap_bench.c can run it next to the heap_6 of
+ * the build.
+ */
+
+#define pvPortMalloc heap3_pvPortMalloc
+#define vPortFree heap3_vPortFree
+
+#include "../amazon-freertos/FreeRTOS/portable/heap_3.c"
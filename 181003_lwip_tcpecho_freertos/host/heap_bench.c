@@ -0,0 +1,533 @@
+/*
+ * Replay of RTOS heap allocation traces on heap_6 (the heap of the build)
+ * and on heap_3 (newlib malloc, glibc here, under vTaskSuspendAll()).
+ *
+ * A trace is a file written by heap_trace.h, or "random": the slot mix of
+ * small and large blocks that heap_6 was first stressed with. Each heap runs
+ * the trace twice; every call of the second pass is timed and its latency
+ * percentiles printed, together with
+ *   peak req   the most bytes the trace had allocated at once,
+ *   peak used  the most bytes the heap had taken for them, headers and
+ *              rounding included (heap_6: configTOTAL_HEAP_SIZE less the free
+ *              bytes, counted from what it held before the trace; heap_3: the
+ *              chunk sizes of the live blocks),
+ *   free       the free bytes of heap_6 at that peak,
+ *   largest    the largest free block of heap_6 at that peak, which against
+ *              "free" shows how fragmented the heap is.
+ * heap_3 grows its arena from the system as it needs to and keeps freed
+ * chunks in per-thread caches, so it has no fixed pool to measure these on.
+ *
+ * Fails if a block is corrupted, if heap_6 refuses a block, or if heap_6
+ * cannot give out (about) its largest starting block again once the trace is
+ * over. Blocks of up to configHEAP_ISR_BLOCK_SIZE_MAX bytes that the trace frees
+ * stay in the ISR cache of heap_6 until an allocation fails without them, so
+ * "largest" may be below "free" even when nothing else is live.
+ *
+ *   make -C host heap_bench
+ *   host/heap_bench [-n operations] [trace|random ...]
+ *
+ * With no trace the recorded heap_traces/tcpecho.trace (beside the binary) and
+ * random are run.
+ * New traces come from tcpecho_heap_trace, the echo server built with the
+ * recorder, under load:
+ *
+ *   make -C host tcpecho_heap_trace
+ *   HEAP_TRACE=tcpecho.trace host/tcpecho_heap_trace &
+ *   host/tcpecho_churn.py --connections 2000 --concurrency 4
+ *   host/tcp_bulk.py --seconds 5
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_RANDOM_SLOTS 200U
+
+typedef struct
+{
+    uint32_t slot;
+    uint32_t size; /* 0 for a free */
+} bench_event_t;
+
+typedef struct
+{
+    const char *name;
+    void *(*malloc_fn)(size_t size);
+    void (*free_fn)(void *pv);
+    /* Bytes the heap has taken for live blocks, and the free bytes beside them. */
+    void (*usage)(size_t *used, size_t *free, size_t *largest);
+    /* Counts a block in or out of the usage, where the heap does not itself. */
+    void (*account)(void *pv, int live);
+} bench_heap_t;
+
+/* heap_3_renamed.c */
+void *heap3_pvPortMalloc(size_t xWantedSize);
+void heap3_vPortFree(void *pv);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_operations = 1000000U;
+static char **s_traces;
+static int s_traceCount;
+/* heap_traces/tcpecho.trace next to the binary. */
+static char s_defaultTrace[4096];
+
+static bench_event_t *s_events;
+static uint32_t s_eventCount;
+static uint32_t s_eventMax;
+static uint32_t s_slotCount;
+
+static void **s_blocks;
+static uint32_t *s_mallocNs;
+static uint32_t *s_freeNs;
+static double s_timerNs;
+static uint32_t s_errors;
+
+static size_t s_heap3Used;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *bench_alloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (p == NULL)
+    {
+        printf("FAIL: out of host memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void heap6_usage(size_t *used, size_t *free, size_t *largest)
+{
+    HeapStats_t stats;
+
+    vPortGetHeapStats(&stats);
+    *used    = configTOTAL_HEAP_SIZE - stats.xAvailableHeapSpaceInBytes;
+    *free    = stats.xAvailableHeapSpaceInBytes;
+    *largest = stats.xSizeOfLargestFreeBlockInBytes;
+}
+
+static void heap3_usage(size_t *used, size_t *free, size_t *largest)
+{
+    *used    = s_heap3Used;
+    *free    = 0U;
+    *largest = 0U;
+}
+
+static void heap3_account(void *pv, int live)
+{
+    /* A glibc chunk is the usable size and its size word. */
+    size_t size = malloc_usable_size(pv) + sizeof(size_t);
+
+    s_heap3Used = live ? (s_heap3Used + size) : (s_heap3Used - size);
+}
+
+static void add_event(uint32_t slot, uint32_t size)
+{
+    if (s_eventCount == s_eventMax)
+    {
+        s_eventMax = (s_eventMax != 0U) ? (2U * s_eventMax) : 65536U;
+        s_events   = realloc(s_events, s_eventMax * sizeof(s_events[0]));
+        if (s_events == NULL)
+        {
+            printf("FAIL: out of host memory\n");
+            exit(1);
+        }
+    }
+    s_events[s_eventCount].slot = slot;
+    s_events[s_eventCount].size = size;
+    s_eventCount++;
+}
+
+static void make_random(void)
+{
+    uint32_t sizes[BENCH_RANDOM_SLOTS] = {0};
+    uint32_t n;
+    uint32_t i;
+
+    srand(3);
+    for (n = 0U; n < s_operations; n++)
+    {
+        i = (uint32_t)rand() % BENCH_RANDOM_SLOTS;
+        if (sizes[i] != 0U)
+        {
+            add_event(i, 0U);
+            sizes[i] = 0U;
+        }
+        else
+        {
+            sizes[i] = ((rand() % 4) == 0) ? (uint32_t)(rand() % 2000 + 1) : (uint32_t)(rand() % 80 + 1);
+            add_event(i, sizes[i]);
+        }
+    }
+    s_slotCount = BENCH_RANDOM_SLOTS;
+}
+
+/* Turns the addresses of a trace into slots, reusing the slots of freed blocks. */
+static int load_trace(const char *name)
+{
+    FILE *f = fopen(name, "r");
+    uintptr_t *keys;
+    uint32_t *slots;
+    uint32_t *freeSlots;
+    uint32_t freeCount = 0U;
+    uint32_t mask      = (1U << 20) - 1U;
+    uint32_t h;
+    uint32_t j;
+    uint32_t home;
+    char op;
+    void *addr;
+    size_t size;
+
+    if (f == NULL)
+    {
+        perror(name);
+        return -1;
+    }
+    keys      = calloc(mask + 1U, sizeof(keys[0]));
+    slots     = bench_alloc((mask + 1U) * sizeof(slots[0]));
+    freeSlots = bench_alloc((mask + 1U) * sizeof(freeSlots[0]));
+    if (keys == NULL)
+    {
+        printf("FAIL: out of host memory\n");
+        exit(1);
+    }
+
+    while (fscanf(f, " %c %p", &op, &addr) == 2)
+    {
+        size = 0U;
+        if ((op == 'm') && (fscanf(f, "%zu", &size) != 1))
+        {
+            break;
+        }
+        for (h = (uint32_t)((uintptr_t)addr >> 3) & mask; (keys[h] != 0U) && (keys[h] != (uintptr_t)addr);
+             h = (h + 1U) & mask)
+        {
+        }
+        if (op == 'm')
+        {
+            if (keys[h] != 0U)
+            {
+                printf("error: %s allocates %p twice\n", name, addr);
+                s_errors++;
+                continue;
+            }
+            keys[h]  = (uintptr_t)addr;
+            slots[h] = (freeCount != 0U) ? freeSlots[--freeCount] : s_slotCount++;
+            add_event(slots[h], (uint32_t)((size != 0U) ? size : 1U));
+        }
+        else if (keys[h] != 0U)
+        {
+            add_event(slots[h], 0U);
+            freeSlots[freeCount++] = slots[h];
+            /* Backward shift deletion keeps the probe chains whole. */
+            for (j = (h + 1U) & mask; keys[j] != 0U; j = (j + 1U) & mask)
+            {
+                home = (uint32_t)(keys[j] >> 3) & mask;
+                if (((j - home) & mask) >= ((j - h) & mask))
+                {
+                    keys[h]  = keys[j];
+                    slots[h] = slots[j];
+                    h        = j;
+                }
+            }
+            keys[h] = 0U;
+        }
+        /* A free of a block allocated before the recording started is dropped. */
+    }
+    fclose(f);
+    free(keys);
+    free(slots);
+    free(freeSlots);
+    return 0;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint32_t pct(const uint32_t *sorted, uint32_t count, double p)
+{
+    uint32_t i = (uint32_t)(count * p / 100.0);
+
+    return (count == 0U) ? 0U : sorted[(i < count) ? i : (count - 1U)];
+}
+
+static uint32_t elapsed(double start, double end)
+{
+    double ns = end - start - s_timerNs;
+
+    return (ns > 0.0) ? (uint32_t)ns : 0U;
+}
+
+static void replay(const bench_heap_t *heap, int report)
+{
+    uint32_t *sizes = calloc(s_slotCount, sizeof(sizes[0]));
+    uint32_t mallocs = 0U;
+    uint32_t frees   = 0U;
+    uint32_t failed  = 0U;
+    size_t requested = 0U;
+    size_t peakRequested = 0U;
+    size_t baseUsed;
+    size_t peakUsed = 0U;
+    size_t peakFree = 0U;
+    size_t peakLargest = 0U;
+    size_t used;
+    size_t free_;
+    size_t largest;
+    const bench_event_t *e;
+    uint8_t *p;
+    double start;
+    uint32_t n;
+    uint32_t k;
+
+    if (sizes == NULL)
+    {
+        printf("FAIL: out of host memory\n");
+        exit(1);
+    }
+    memset(s_blocks, 0, s_slotCount * sizeof(s_blocks[0]));
+    heap->usage(&baseUsed, &free_, &largest);
+
+    for (n = 0U; n < s_eventCount; n++)
+    {
+        e = &s_events[n];
+        if (e->size != 0U)
+        {
+            start              = now_ns();
+            s_blocks[e->slot]  = heap->malloc_fn(e->size);
+            s_mallocNs[mallocs++] = elapsed(start, now_ns());
+            if (s_blocks[e->slot] == NULL)
+            {
+                failed++;
+                continue;
+            }
+            sizes[e->slot] = e->size;
+            if (heap->account != NULL)
+            {
+                heap->account(s_blocks[e->slot], 1);
+            }
+            memset(s_blocks[e->slot], (int)(e->slot & 0xFFU), e->size);
+            requested += e->size;
+            if (requested > peakRequested)
+            {
+                peakRequested = requested;
+            }
+            heap->usage(&used, &free_, &largest);
+            if (used - baseUsed > peakUsed)
+            {
+                peakUsed    = used - baseUsed;
+                peakFree    = free_;
+                peakLargest = largest;
+            }
+        }
+        else if (s_blocks[e->slot] != NULL)
+        {
+            p = s_blocks[e->slot];
+            for (k = 0U; k < sizes[e->slot]; k++)
+            {
+                if (p[k] != (uint8_t)e->slot)
+                {
+                    if (s_errors++ < 10U)
+                    {
+                        printf("error: %s: block of slot %u corrupted at byte %u\n", heap->name, (unsigned)e->slot,
+                               (unsigned)k);
+                    }
+                    break;
+                }
+            }
+            requested -= sizes[e->slot];
+            if (heap->account != NULL)
+            {
+                heap->account(p, 0);
+            }
+            start = now_ns();
+            heap->free_fn(p);
+            s_freeNs[frees++] = elapsed(start, now_ns());
+            s_blocks[e->slot] = NULL;
+        }
+    }
+    for (n = 0U; n < s_slotCount; n++)
+    {
+        if ((s_blocks[n] != NULL) && (heap->account != NULL))
+        {
+            heap->account(s_blocks[n], 0);
+        }
+        heap->free_fn(s_blocks[n]);
+    }
+    free(sizes);
+    if (!report)
+    {
+        return;
+    }
+
+    qsort(s_mallocNs, mallocs, sizeof(s_mallocNs[0]), cmp_u32);
+    qsort(s_freeNs, frees, sizeof(s_freeNs[0]), cmp_u32);
+    printf("%-7s %6u %6u %6u %7u  %6u %6u %6u %7u  %9zu %9zu", heap->name,
+           (unsigned)pct(s_mallocNs, mallocs, 50), (unsigned)pct(s_mallocNs, mallocs, 99),
+           (unsigned)pct(s_mallocNs, mallocs, 99.9), (unsigned)pct(s_mallocNs, mallocs, 100),
+           (unsigned)pct(s_freeNs, frees, 50), (unsigned)pct(s_freeNs, frees, 99), (unsigned)pct(s_freeNs, frees, 99.9),
+           (unsigned)pct(s_freeNs, frees, 100), peakRequested, peakUsed);
+    if (peakLargest != 0U)
+    {
+        printf(" %9zu %9zu", peakFree, peakLargest);
+    }
+    else
+    {
+        printf(" %9s %9s", "-", "-");
+    }
+    if (failed != 0U)
+    {
+        printf("  %u failed", (unsigned)failed);
+        s_errors++;
+    }
+    printf("\n");
+}
+
+static void run(const char *name)
+{
+    static const bench_heap_t heaps[] = {
+        {"heap_6", pvPortMalloc, vPortFree, heap6_usage, NULL},
+        {"heap_3", heap3_pvPortMalloc, heap3_vPortFree, heap3_usage, heap3_account},
+    };
+    HeapStats_t before;
+    void *p;
+    uint32_t allocs = 0U;
+    uint32_t n;
+    uint32_t i;
+
+    s_eventCount = 0U;
+    s_slotCount  = 0U;
+    if (strcmp(name, "random") == 0)
+    {
+        make_random();
+    }
+    else if (load_trace(name) != 0)
+    {
+        s_errors++;
+        return;
+    }
+    for (n = 0U; n < s_eventCount; n++)
+    {
+        allocs += (s_events[n].size != 0U);
+    }
+
+    s_blocks   = bench_alloc((s_slotCount + 1U) * sizeof(s_blocks[0]));
+    s_mallocNs = bench_alloc((allocs + 1U) * sizeof(s_mallocNs[0]));
+    s_freeNs   = bench_alloc((s_eventCount - allocs + 1U) * sizeof(s_freeNs[0]));
+
+    printf("\n%s: %u allocations, %u frees, at most %u blocks\n", name, (unsigned)allocs,
+           (unsigned)(s_eventCount - allocs), (unsigned)s_slotCount);
+    printf("%-7s %6s %6s %6s %7s  %6s %6s %6s %7s  %9s %9s %9s %9s\n", "", "malloc", "p99", "p99.9", "max", "free",
+           "p99", "p99.9", "max", "peak req", "peak used", "free", "largest");
+
+    vPortGetHeapStats(&before);
+    for (i = 0U; i < sizeof(heaps) / sizeof(heaps[0]); i++)
+    {
+        /* The first pass faults the pages of the heap in, which a target does not. */
+        replay(&heaps[i], 0);
+        replay(&heaps[i], 1);
+    }
+    /* The search rounds a size up to the next size class, up to a sixteenth
+    of it with the default configHEAP_SL_INDEX_COUNT_LOG2, and the block size
+    counts the header. */
+    p = pvPortMalloc(before.xSizeOfLargestFreeBlockInBytes - (before.xSizeOfLargestFreeBlockInBytes / 16U) - 64U);
+    if (p == NULL)
+    {
+        printf("error: heap_6 has no block of %zu bytes after the trace\n", before.xSizeOfLargestFreeBlockInBytes);
+        s_errors++;
+    }
+    vPortFree(p);
+
+    free(s_blocks);
+    free(s_mallocNs);
+    free(s_freeNs);
+}
+
+static void bench_task(void *arg)
+{
+    static char *defaults[] = {s_defaultTrace, "random"};
+    double start;
+    int i;
+
+    (void)arg;
+
+    /* The cost of reading the clock, taken off every latency. */
+    start = now_ns();
+    for (i = 0; i < 100000; i++)
+    {
+        (void)now_ns();
+    }
+    s_timerNs = (now_ns() - start) / 100000.0;
+
+    printf("ns per call, less %.0f ns of clock reading; bytes\n", s_timerNs);
+    if (s_traceCount == 0)
+    {
+        s_traces     = defaults;
+        s_traceCount = sizeof(defaults) / sizeof(defaults[0]);
+    }
+    for (i = 0; i < s_traceCount; i++)
+    {
+        run(s_traces[i]);
+    }
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    int i = 1;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if ((argc > 2) && (strcmp(argv[1], "-n") == 0))
+    {
+        s_operations = strtoul(argv[2], NULL, 0);
+        i            = 3;
+    }
+    if (s_operations == 0U)
+    {
+        fprintf(stderr, "usage: %s [-n operations] [trace|random ...]\n", argv[0]);
+        return 2;
+    }
+    s_traces     = &argv[i];
+    s_traceCount = argc - i;
+    snprintf(s_defaultTrace, sizeof(s_defaultTrace), "%.*sheap_traces/tcpecho.trace",
+             (strrchr(argv[0], '/') != NULL) ? (int)(strrchr(argv[0], '/') - argv[0] + 1) : 0, argv[0]);
+
+    if (xTaskCreate(bench_task, "bench", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
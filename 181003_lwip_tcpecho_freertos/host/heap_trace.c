@@ -0,0 +1,48 @@
+/*
+ * Recorder of heap_trace.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "heap_trace.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static FILE *s_trace;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static FILE *heap_trace_file(void)
+{
+    const char *name;
+
+    if (s_trace == NULL)
+    {
+        name = getenv("HEAP_TRACE");
+        s_trace = fopen((name != NULL) ? name : "heap.trace", "w");
+        if (s_trace == NULL)
+        {
+            perror("heap trace");
+            exit(1);
+        }
+        /* The servers end on a signal: keep the file whole up to there. */
+        setvbuf(s_trace, NULL, _IOLBF, 0);
+    }
+    return s_trace;
+}
+
+void heap_trace_malloc(void *pv, size_t size)
+{
+    if (pv != NULL)
+    {
+        fprintf(heap_trace_file(), "m %p %zu\n", pv, size);
+    }
+}
+
+void heap_trace_free(void *pv)
+{
+    fprintf(heap_trace_file(), "f %p\n", pv);
+}
@@ -0,0 +1,23 @@
+/*
+ * Allocation trace of the RTOS heap for heap_bench.c.
+ *
+ * Force included into a build (DEFS="-include heap_trace.h" plus heap_trace.c
+ * in the sources), it takes the traceMALLOC() and traceFREE() hooks of the
+ * heap and appends one line per call to the file named by $HEAP_TRACE
+ * (heap.trace by default):
+ *   m <address> <size>   a successful allocation of size bytes,
+ *   f <address>          a free.
+ */
+
+#ifndef HEAP_TRACE_H
+#define HEAP_TRACE_H
+
+#include <stddef.h>
+
+void heap_trace_malloc(void *pv, size_t size);
+void heap_trace_free(void *pv);
+
+#define traceMALLOC(pvAddress, uiSize) heap_trace_malloc((pvAddress), (uiSize))
+#define traceFREE(pvAddress, uiSize) heap_trace_free(pvAddress)
+
+#endif /* HEAP_TRACE_H */
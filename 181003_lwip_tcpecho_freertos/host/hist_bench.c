@@ -0,0 +1,284 @@
+/*
+ * Cost of the hot path latency histograms of LWIP_STATS_HIST.
+ *
+ * Times one histogram sample (two LWIP_STATS_CYCLES() reads and
+ * stats_hist_add()) in a loop, then sends a TCP stream through the sockets
+ * and the loopback of the host build, from the bench task to a receiver
+ * task, and prints the host MB/s. Run it as hist_bench_off and
+ * hist_bench_on, which differ in LWIP_STATS_HIST alone, and compare; the
+ * histogram build also prints how many samples the streams took.
+ *
+ * Fails if the stream arrives corrupted or short, and in the histogram build
+ * if a histogram of the tcpip thread or of TCP took no samples or its buckets
+ * do not add up to its count.
+ *
+ *   make -C host hist_bench_off hist_bench_on
+ *   host/hist_bench_on [megabytes [runs]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/sockets.h"
+#include "lwip/stats.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_PORT 7000U
+#define BENCH_CHUNK TCP_MSS
+#define BENCH_PATTERN 251U
+#define BENCH_SAMPLES 1000000U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_megabytes = 4U;
+static uint32_t s_runs = 3U;
+
+static struct netif s_netif;
+static struct sockaddr_in s_addr;
+static sys_sem_t s_done;
+static volatile uint32_t s_rxBytes;
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static err_t bench_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(p);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    return ERR_OK;
+}
+
+static err_t bench_netif_init(struct netif *netif)
+{
+    netif->output = bench_output;
+    netif->mtu = 1500;
+    return ERR_OK;
+}
+
+/* Receives streams until the bench ends, checks the bytes of each. */
+static void receiver_task(void *arg)
+{
+    static u8_t buf[4 * BENCH_CHUNK];
+    int listener = (int)(intptr_t)arg;
+    int conn;
+    int n;
+    int i;
+
+    for (;;)
+    {
+        conn = lwip_accept(listener, NULL, NULL);
+        s_rxBytes = 0U;
+        while ((n = lwip_recv(conn, buf, sizeof(buf), 0)) > 0)
+        {
+            for (i = 0; i < n; i++)
+            {
+                if ((buf[i] != (u8_t)((s_rxBytes + (uint32_t)i) % BENCH_PATTERN)) && (s_errors++ < 10U))
+                {
+                    printf("error: byte %u of the stream is corrupted\n", (unsigned)(s_rxBytes + (uint32_t)i));
+                }
+            }
+            s_rxBytes += (uint32_t)n;
+        }
+        lwip_close(conn);
+        sys_sem_signal(&s_done);
+    }
+}
+
+/* Returns the MB/s of one stream. */
+static double bench_stream(void)
+{
+    static u8_t buf[BENCH_CHUNK + BENCH_PATTERN];
+    uint32_t total = s_megabytes * 1000000U;
+    uint32_t sent;
+    uint32_t i;
+    double start;
+    int s;
+    int n;
+
+    for (i = 0U; i < sizeof(buf); i++)
+    {
+        buf[i] = (u8_t)(i % BENCH_PATTERN);
+    }
+    s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    if ((s < 0) || (lwip_connect(s, (struct sockaddr *)&s_addr, sizeof(s_addr)) != 0))
+    {
+        printf("FAIL: no connection\n");
+        exit(1);
+    }
+    start = now_ns();
+    for (sent = 0U; sent < total; sent += (uint32_t)n)
+    {
+        n = lwip_send(s, &buf[sent % BENCH_PATTERN], LWIP_MIN(BENCH_CHUNK, total - sent), 0);
+        if (n <= 0)
+        {
+            printf("FAIL: send returned %d\n", n);
+            exit(1);
+        }
+    }
+    lwip_close(s);
+    sys_arch_sem_wait(&s_done, 0);
+    start = now_ns() - start;
+    if ((s_rxBytes != total) && (s_errors++ < 10U))
+    {
+        printf("error: %u of %u bytes arrived\n", (unsigned)s_rxBytes, (unsigned)total);
+    }
+    return total / start * 1e3;
+}
+
+#if LWIP_STATS_HIST
+/* Returns the samples taken, checks every histogram. */
+static uint32_t hist_check(void)
+{
+    struct stats_hist hist;
+    uint32_t samples = 0U;
+    uint32_t sum;
+    int id;
+    int i;
+
+    for (id = 0; id < STATS_HIST_MAX; id++)
+    {
+        stats_hist_get((enum stats_hist_id)id, &hist);
+        for (sum = 0U, i = 0; i < STATS_HIST_BUCKETS; i++)
+        {
+            sum += hist.bucket[i];
+        }
+        printf("%12s %10u samples, max %u ns\n", stats_hist_name((enum stats_hist_id)id), (unsigned)hist.count,
+               (unsigned)hist.max);
+        /* The loopback bypasses the driver, which feeds the netif histogram. */
+        if ((id != STATS_HIST_NETIF_INPUT) && (hist.count == 0U) && (s_errors++ < 10U))
+        {
+            printf("error: no samples in %s\n", stats_hist_name((enum stats_hist_id)id));
+        }
+        if ((sum != hist.count) && (s_errors++ < 10U))
+        {
+            printf("error: the buckets of %s add up to %u of %u\n", stats_hist_name((enum stats_hist_id)id),
+                   (unsigned)sum, (unsigned)hist.count);
+        }
+        samples += hist.count;
+    }
+    return samples;
+}
+#endif /* LWIP_STATS_HIST */
+
+static void bench_task(void *arg)
+{
+    ip4_addr_t ipaddr, netmask, gw;
+    double mbps;
+    double best = 0.0;
+    uint32_t i;
+    int listener;
+
+    LWIP_UNUSED_ARG(arg);
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    tcpip_init(NULL, NULL);
+    LOCK_TCPIP_CORE();
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, NULL, bench_netif_init, tcpip_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+    UNLOCK_TCPIP_CORE();
+
+#if LWIP_STATS_HIST
+    {
+        struct stats_hist scratch;
+        STATS_HIST_DECL(t);
+        double start;
+
+        memset(&scratch, 0, sizeof(scratch));
+        start = now_ns();
+        for (i = 0U; i < BENCH_SAMPLES; i++)
+        {
+            STATS_HIST_START(t);
+            stats_hist_add(&scratch, LWIP_STATS_CYCLES() - t);
+        }
+        printf("one sample: %.1f ns (stats_init() measured %u ns)\n", (now_ns() - start) / BENCH_SAMPLES,
+               (unsigned)lwip_stats.hist_overhead);
+    }
+#endif /* LWIP_STATS_HIST */
+
+    memset(&s_addr, 0, sizeof(s_addr));
+    s_addr.sin_len = sizeof(s_addr);
+    s_addr.sin_family = AF_INET;
+    s_addr.sin_port = PP_HTONS(BENCH_PORT);
+    inet_addr_from_ip4addr(&s_addr.sin_addr, &ipaddr);
+    listener = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    if ((listener < 0) || (lwip_bind(listener, (struct sockaddr *)&s_addr, sizeof(s_addr)) != 0) ||
+        (lwip_listen(listener, 1) != 0) || (sys_sem_new(&s_done, 0) != ERR_OK) ||
+        (sys_thread_new("receiver", receiver_task, (void *)(intptr_t)listener, DEFAULT_THREAD_STACKSIZE,
+                        DEFAULT_THREAD_PRIO) == NULL))
+    {
+        printf("FAIL: no receiver\n");
+        exit(1);
+    }
+
+    printf("%u MB per stream, histograms %s\n", (unsigned)s_megabytes, LWIP_STATS_HIST ? "on" : "off");
+#if LWIP_STATS_HIST
+    stats_hist_reset();
+#endif
+    for (i = 0U; i < s_runs; i++)
+    {
+        mbps = bench_stream();
+        best = LWIP_MAX(best, mbps);
+        printf("run %u: %.1f MB/s\n", (unsigned)i + 1U, mbps);
+    }
+    printf("best: %.1f MB/s\n", best);
+#if LWIP_STATS_HIST
+    i = hist_check();
+    printf("%u samples, %.0f per MB\n", (unsigned)i, (double)i / (s_megabytes * s_runs));
+#endif
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_megabytes = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        s_runs = strtoul(argv[2], NULL, 0);
+    }
+    if ((s_megabytes == 0U) || (s_megabytes > 4000U) || (s_runs == 0U))
+    {
+        fprintf(stderr, "usage: %s [megabytes [runs]]\n", argv[0]);
+        return 2;
+    }
+
+    if (sys_thread_new("bench", bench_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
@@ -0,0 +1,283 @@
+/*
+ * Mailbox backends of sys_arch: FreeRTOS queue against the lock-free ring of
+ * LWIP_SYS_MBOX_SPSC.
+ *
+ * Runs every case on a sys_mbox_new() and on a sys_mbox_new_spsc() mailbox:
+ *   pair      one task posts a message and fetches it back, no task switch,
+ *   pingpong  two tasks bounce a message over two mailboxes, one switch per
+ *             post,
+ *   stream    a higher priority producer posts into a full mailbox and blocks
+ *             until the consumer makes room, as the tcpip thread feeds a
+ *             netconn recvmbox,
+ *   isr       an interrupt posts bursts that fill the mailbox, as a receive
+ *             interrupt would, and a task drains them.
+ * Prints the host nanoseconds per message or round trip.
+ *
+ * Fails if a message is lost, duplicated or delivered out of order.
+ *
+ *   make -C host mbox_bench
+ *   host/mbox_bench [messages]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_MBOX_SIZE 32
+#define BENCH_IRQ_LINE 3U
+
+typedef err_t (*mbox_new_t)(sys_mbox_t *mbox, int size);
+
+/* Message numbers travel as the message pointers, starting at 1. */
+#define BENCH_MSG(n) ((void *)(uintptr_t)(n))
+#define BENCH_SEQ(msg) ((uint32_t)(uintptr_t)(msg))
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_messages = 200000U;
+
+static sys_mbox_t s_mbox[2];
+static sys_sem_t s_done;
+static volatile uint32_t s_posted;
+static volatile uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check_seq(void *msg, uint32_t expected)
+{
+    if ((BENCH_SEQ(msg) != expected) && (s_errors++ < 10U))
+    {
+        printf("error: message %u where %u was due\n", (unsigned)BENCH_SEQ(msg), (unsigned)expected);
+    }
+}
+
+static void bench_new(mbox_new_t mbox_new, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (mbox_new(&s_mbox[i], BENCH_MBOX_SIZE) != ERR_OK)
+        {
+            printf("FAIL: no memory for the mailboxes\n");
+            exit(1);
+        }
+    }
+}
+
+static void bench_free(int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        sys_mbox_free(&s_mbox[i]);
+    }
+}
+
+static double bench_pair(void)
+{
+    void *msg;
+    uint32_t n;
+    double start;
+
+    start = now_ns();
+    for (n = 1U; n <= s_messages; n++)
+    {
+        if (sys_mbox_trypost(&s_mbox[0], BENCH_MSG(n)) != ERR_OK)
+        {
+            s_errors++;
+        }
+        msg = NULL;
+        sys_arch_mbox_tryfetch(&s_mbox[0], &msg);
+        check_seq(msg, n);
+    }
+    return (now_ns() - start) / s_messages;
+}
+
+static void pong_task(void *arg)
+{
+    void *msg;
+    uint32_t n;
+
+    LWIP_UNUSED_ARG(arg);
+
+    for (n = 1U; n <= s_messages; n++)
+    {
+        sys_arch_mbox_fetch(&s_mbox[0], &msg, 0);
+        check_seq(msg, n);
+        sys_mbox_post(&s_mbox[1], msg);
+    }
+    sys_sem_signal(&s_done);
+    vTaskDelete(NULL);
+}
+
+static double bench_pingpong(void)
+{
+    void *msg;
+    uint32_t n;
+    double start;
+
+    sys_thread_new("pong", pong_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
+    start = now_ns();
+    for (n = 1U; n <= s_messages; n++)
+    {
+        sys_mbox_post(&s_mbox[0], BENCH_MSG(n));
+        sys_arch_mbox_fetch(&s_mbox[1], &msg, 0);
+        check_seq(msg, n);
+    }
+    sys_arch_sem_wait(&s_done, 0);
+    return (now_ns() - start) / s_messages;
+}
+
+static void producer_task(void *arg)
+{
+    uint32_t n;
+
+    LWIP_UNUSED_ARG(arg);
+
+    for (n = 1U; n <= s_messages; n++)
+    {
+        sys_mbox_post(&s_mbox[0], BENCH_MSG(n));
+    }
+    sys_sem_signal(&s_done);
+    vTaskDelete(NULL);
+}
+
+static double bench_stream(void)
+{
+    void *msg;
+    uint32_t n;
+    double start;
+
+    start = now_ns();
+    sys_thread_new("producer", producer_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO + 1);
+    for (n = 1U; n <= s_messages; n++)
+    {
+        sys_arch_mbox_fetch(&s_mbox[0], &msg, 0);
+        check_seq(msg, n);
+    }
+    sys_arch_sem_wait(&s_done, 0);
+    return (now_ns() - start) / s_messages;
+}
+
+static void bench_isr(void)
+{
+    while ((s_posted < s_messages) && (sys_mbox_trypost(&s_mbox[0], BENCH_MSG(s_posted + 1U)) == ERR_OK))
+    {
+        s_posted++;
+    }
+}
+
+static double bench_irq(void)
+{
+    void *msg;
+    uint32_t n;
+    double start;
+
+    s_posted = 0U;
+    start = now_ns();
+    for (n = 1U; n <= s_messages; n++)
+    {
+        if (n > s_posted)
+        {
+            vPortGenerateSimulatedInterrupt(BENCH_IRQ_LINE);
+        }
+        sys_arch_mbox_fetch(&s_mbox[0], &msg, 0);
+        check_seq(msg, n);
+    }
+    return (now_ns() - start) / s_messages;
+}
+
+static void bench_task(void *arg)
+{
+    static const struct
+    {
+        const char *name;
+        mbox_new_t mbox_new;
+    } backends[] = {
+        {"queue", sys_mbox_new},
+        {"ring", sys_mbox_new_spsc},
+    };
+    double ns[4][2];
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(arg);
+
+    sys_sem_new(&s_done, 0);
+    vPortSetInterruptHandler(BENCH_IRQ_LINE, bench_isr);
+
+    for (i = 0U; i < 2U; i++)
+    {
+        bench_new(backends[i].mbox_new, 1);
+        ns[0][i] = bench_pair();
+        bench_free(1);
+
+        bench_new(backends[i].mbox_new, 2);
+        ns[1][i] = bench_pingpong();
+        bench_free(2);
+
+        bench_new(backends[i].mbox_new, 1);
+        ns[2][i] = bench_stream();
+        bench_free(1);
+
+        bench_new(backends[i].mbox_new, 1);
+        ns[3][i] = bench_irq();
+        bench_free(1);
+    }
+
+    printf("%u messages, mailboxes of %d, ns per message (pingpong: per round trip)\n", (unsigned)s_messages,
+           BENCH_MBOX_SIZE);
+    printf("%-9s %8s %8s\n", "", backends[0].name, backends[1].name);
+    printf("%-9s %8.0f %8.0f\n", "pair", ns[0][0], ns[0][1]);
+    printf("%-9s %8.0f %8.0f\n", "pingpong", ns[1][0], ns[1][1]);
+    printf("%-9s %8.0f %8.0f\n", "stream", ns[2][0], ns[2][1]);
+    printf("%-9s %8.0f %8.0f\n", "isr", ns[3][0], ns[3][1]);
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_messages = strtoul(argv[1], NULL, 0);
+    }
+    if (s_messages == 0U)
+    {
+        fprintf(stderr, "usage: %s [messages]\n", argv[0]);
+        return 2;
+    }
+
+    if (sys_thread_new("bench", bench_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
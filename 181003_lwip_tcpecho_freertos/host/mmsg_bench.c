@@ -0,0 +1,264 @@
+/*
+ * Datagrams per second through the sockets: one lwip_sendto() and
+ * lwip_recvfrom() per datagram against lwip_sendmmsg() and lwip_recvmmsg().
+ *
+ * A sender and a receiver UDP socket talk through the loopback of the host
+ * build. Each round sends a burst of datagrams, of 16 bytes up to a full
+ * Ethernet payload, and reads them all back, either one call per datagram or
+ * one lwip_sendmmsg() for the burst and lwip_recvmmsg() until it is drained.
+ * Prints the host datagrams per second of both and how many times faster
+ * the batched calls are.
+ *
+ * Fails if a datagram is lost, reordered, truncated or corrupted.
+ *
+ *   make -C host mmsg_bench
+ *   host/mmsg_bench [datagrams [burst]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/sockets.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_PORT 7000U
+/* A burst must fit in the recvmbox of the receiver. */
+#define BENCH_BURST_MAX DEFAULT_UDP_RECVMBOX_SIZE
+#define BENCH_SIZE_MAX 1472U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_datagrams = 100000U;
+static uint32_t s_burst = LWIP_SOCKET_MMSG_BATCH;
+
+static struct netif s_netif;
+static int s_tx;
+static int s_rx;
+static struct sockaddr_in s_addr;
+static u8_t s_txBuf[BENCH_BURST_MAX][BENCH_SIZE_MAX];
+static u8_t s_rxBuf[BENCH_BURST_MAX][BENCH_SIZE_MAX];
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static err_t bench_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(p);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    return ERR_OK;
+}
+
+static err_t bench_netif_init(struct netif *netif)
+{
+    netif->output = bench_output;
+    netif->mtu = 1500;
+    return ERR_OK;
+}
+
+/* Datagram seq starts with its number, the rest follows from it. */
+static void bench_fill(u8_t *buf, uint32_t seq, uint32_t size)
+{
+    uint32_t i;
+
+    memcpy(buf, &seq, sizeof(seq));
+    for (i = sizeof(seq); i < size; i++)
+    {
+        buf[i] = (u8_t)(seq + i);
+    }
+}
+
+static void bench_check(const u8_t *buf, int len, uint32_t seq, uint32_t size)
+{
+    uint32_t got;
+
+    memcpy(&got, buf, sizeof(got));
+    if ((len != (int)size) || (got != seq) || (memcmp(buf + sizeof(seq), s_txBuf[seq % s_burst] + sizeof(seq),
+                                                      size - sizeof(seq)) != 0))
+    {
+        if (s_errors++ < 10U)
+        {
+            printf("error: datagram %u of %u bytes came as %d bytes of datagram %u\n", (unsigned)seq,
+                   (unsigned)size, len, (unsigned)got);
+        }
+    }
+}
+
+/* Returns the datagrams per second. */
+static double bench_run(uint32_t size, int batched)
+{
+    static struct mmsghdr txMsgs[BENCH_BURST_MAX];
+    static struct mmsghdr rxMsgs[BENCH_BURST_MAX];
+    static struct iovec txIov[BENCH_BURST_MAX];
+    static struct iovec rxIov[BENCH_BURST_MAX];
+    double start;
+    uint32_t seq = 0U;
+    uint32_t i;
+    uint32_t got;
+    int n;
+
+    memset(txMsgs, 0, sizeof(txMsgs));
+    memset(rxMsgs, 0, sizeof(rxMsgs));
+    for (i = 0U; i < s_burst; i++)
+    {
+        txIov[i].iov_base = s_txBuf[i];
+        txIov[i].iov_len = size;
+        txMsgs[i].msg_hdr.msg_name = &s_addr;
+        txMsgs[i].msg_hdr.msg_namelen = sizeof(s_addr);
+        txMsgs[i].msg_hdr.msg_iov = &txIov[i];
+        txMsgs[i].msg_hdr.msg_iovlen = 1;
+        rxIov[i].iov_base = s_rxBuf[i];
+        rxIov[i].iov_len = BENCH_SIZE_MAX;
+        rxMsgs[i].msg_hdr.msg_iov = &rxIov[i];
+        rxMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    start = now_ns();
+    while (seq < s_datagrams)
+    {
+        for (i = 0U; i < s_burst; i++)
+        {
+            bench_fill(s_txBuf[i], seq + i, size);
+        }
+
+        if (batched)
+        {
+            if (lwip_sendmmsg(s_tx, txMsgs, s_burst, 0) != (int)s_burst)
+            {
+                printf("FAIL: sendmmsg did not send the burst\n");
+                exit(1);
+            }
+            for (got = 0U; got < s_burst; got += (uint32_t)n)
+            {
+                n = lwip_recvmmsg(s_rx, rxMsgs, s_burst - got, 0);
+                if (n <= 0)
+                {
+                    printf("FAIL: recvmmsg returned %d\n", n);
+                    exit(1);
+                }
+                for (i = 0U; i < (uint32_t)n; i++)
+                {
+                    if ((rxMsgs[i].msg_hdr.msg_flags & MSG_TRUNC) && (s_errors++ < 10U))
+                    {
+                        printf("error: datagram %u truncated\n", (unsigned)(seq + got + i));
+                    }
+                    bench_check(s_rxBuf[i], (int)rxMsgs[i].msg_len, seq + got + i, size);
+                }
+            }
+        }
+        else
+        {
+            for (i = 0U; i < s_burst; i++)
+            {
+                if (lwip_sendto(s_tx, s_txBuf[i], size, 0, (struct sockaddr *)&s_addr, sizeof(s_addr)) != (int)size)
+                {
+                    printf("FAIL: sendto failed\n");
+                    exit(1);
+                }
+            }
+            for (i = 0U; i < s_burst; i++)
+            {
+                n = lwip_recvfrom(s_rx, s_rxBuf[0], BENCH_SIZE_MAX, 0, NULL, NULL);
+                bench_check(s_rxBuf[0], n, seq + i, size);
+            }
+        }
+        seq += s_burst;
+    }
+    return seq * 1e9 / (now_ns() - start);
+}
+
+static void bench_task(void *arg)
+{
+    static const uint32_t sizes[] = {16U, 128U, 512U, BENCH_SIZE_MAX};
+    ip4_addr_t ipaddr, netmask, gw;
+    double single;
+    double batched;
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(arg);
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    tcpip_init(NULL, NULL);
+    LOCK_TCPIP_CORE();
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, NULL, bench_netif_init, tcpip_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+    UNLOCK_TCPIP_CORE();
+
+    memset(&s_addr, 0, sizeof(s_addr));
+    s_addr.sin_len = sizeof(s_addr);
+    s_addr.sin_family = AF_INET;
+    s_addr.sin_port = PP_HTONS(BENCH_PORT);
+    inet_addr_from_ip4addr(&s_addr.sin_addr, &ipaddr);
+    s_tx = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    s_rx = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    if ((s_tx < 0) || (s_rx < 0) || (lwip_bind(s_rx, (struct sockaddr *)&s_addr, sizeof(s_addr)) != 0))
+    {
+        printf("FAIL: no sockets\n");
+        exit(1);
+    }
+
+    printf("%u datagrams in bursts of %u, %u per netconn_sendv()\n", (unsigned)s_datagrams, (unsigned)s_burst,
+           (unsigned)LWIP_SOCKET_MMSG_BATCH);
+    printf("%6s %12s %12s %8s\n", "bytes", "single/s", "mmsg/s", "speedup");
+    for (i = 0U; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        single = bench_run(sizes[i], 0);
+        batched = bench_run(sizes[i], 1);
+        printf("%6u %12.0f %12.0f %7.2fx\n", (unsigned)sizes[i], single, batched, batched / single);
+    }
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_datagrams = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        s_burst = strtoul(argv[2], NULL, 0);
+    }
+    if ((s_datagrams == 0U) || (s_burst == 0U) || (s_burst > BENCH_BURST_MAX))
+    {
+        fprintf(stderr, "usage: %s [datagrams [burst]], burst 1 to %u\n", argv[0], (unsigned)BENCH_BURST_MAX);
+        return 2;
+    }
+
+    if (sys_thread_new("bench", bench_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
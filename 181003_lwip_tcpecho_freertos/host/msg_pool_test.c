@@ -0,0 +1,547 @@
+/*
+ * Fixed-block message pool (common/msg_pool.c) under load, and against the
+ * heap for the same messages.
+ *
+ * First, before the scheduler starts, four host threads allocate and free
+ * the 3 blocks of a pool with msg_pool_alloc_from_isr() and
+ * msg_pool_free_from_isr() as fast as they can, for 800000 blocks in all;
+ * the host preempts them anywhere, and on a host with more than one CPU they
+ * run at once, so their compare and swaps really contend. Then, under the
+ * scheduler, four producer tasks send 800000 messages in all through a pool
+ * of 6 blocks and a queue of 3 to a consumer task, the producers waiting for
+ * blocks as the alarm apps do, while an interrupt raised after every message
+ * takes and gives back a block of its own. Then the same messages without
+ * the interrupt, from the pool, from heap_6 (pvPortMalloc() of the build)
+ * and from heap_3 (glibc malloc under vTaskSuspendAll()). Last, a wait for a
+ * block that times out and a msg_pool_send() to a full queue. Prints the
+ * host nanoseconds per block or message, the pool statistics and the longest
+ * wait of a producer for a block, then msg_pool_benchmark() of the target
+ * build.
+ *
+ * Fails if a block is handed out twice, a message is corrupted, lost or out
+ * of order for its producer, the statistics do not add up, the timed wait
+ * does not time out in its ticks, or a failed send does not give its block
+ * back.
+ *
+ *   make -C host msg_pool_test
+ *   host/msg_pool_test [messages]
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "msg_pool.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TEST_PRODUCERS 4U
+#define TEST_THREADS 4U
+#define TEST_THREAD_BLOCKS 3U
+#define TEST_BLOCKS 6U
+#define TEST_QUEUE_LEN 3U
+#define TEST_TIMEOUT_TICKS 50U
+#define TEST_IRQ_LINE 3U
+#define TEST_STACK_SIZE (configMINIMAL_STACK_SIZE * 4U)
+#define TEST_PRIO (tskIDLE_PRIORITY + 2U)
+
+typedef enum
+{
+    TEST_POOL,
+    TEST_HEAP_6,
+    TEST_HEAP_3,
+} test_alloc_t;
+
+typedef struct
+{
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t check;
+} test_msg_t;
+
+/* A pool, its blocks found by taking them all, and who holds each. */
+typedef struct
+{
+    msg_pool_t *pool;
+    uint8_t *first;
+    uint32_t stride;
+    uint32_t blocks;
+    volatile uint32_t owner[TEST_BLOCKS];
+} test_pool_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+void *heap3_pvPortMalloc(size_t xWantedSize);
+void heap3_vPortFree(void *pv);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_messages = 800000U;
+
+static test_pool_t s_threadPool;
+static test_pool_t s_taskPool;
+static QueueHandle_t s_queue;
+static SemaphoreHandle_t s_done;
+static test_alloc_t s_alloc;
+static volatile bool s_irq;
+static volatile uint32_t s_irqBlocks;
+static volatile uint32_t s_irqMisses;
+static volatile uint32_t s_threadMisses;
+static volatile uint32_t s_errors;
+static double s_longestWait;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void test_error(const char *what, uint32_t n)
+{
+    if (__atomic_fetch_add(&s_errors, 1U, __ATOMIC_RELAXED) < 10U)
+    {
+        printf("error: %s (%u)\n", what, (unsigned)n);
+    }
+}
+
+/* Creates a pool and finds its blocks: exactly blocks of them, one stride apart. */
+static void test_pool_create(test_pool_t *tp, uint32_t blocks)
+{
+    struct msg_pool_stats stats;
+    void *taken[TEST_BLOCKS];
+    uint32_t i;
+
+    tp->pool = msg_pool_create((uint16_t)blocks, sizeof(test_msg_t));
+    if (tp->pool == NULL)
+    {
+        printf("FAIL: no pool\n");
+        exit(1);
+    }
+    msg_pool_get_stats(tp->pool, &stats);
+    tp->stride = stats.block_size;
+    tp->blocks = blocks;
+    tp->first = NULL;
+    for (i = 0U; i < blocks; i++)
+    {
+        taken[i] = msg_pool_alloc_from_isr(tp->pool);
+        if ((taken[i] == NULL) || ((uintptr_t)taken[i] % portBYTE_ALIGNMENT != 0U))
+        {
+            test_error("a block missing or misaligned", i);
+            exit(1);
+        }
+        if ((tp->first == NULL) || ((uint8_t *)taken[i] < tp->first))
+        {
+            tp->first = taken[i];
+        }
+    }
+    if (msg_pool_alloc_from_isr(tp->pool) != NULL)
+    {
+        test_error("a block more than the pool holds", blocks);
+    }
+    for (i = 0U; i < blocks; i++)
+    {
+        msg_pool_free_from_isr(tp->pool, taken[i], NULL);
+    }
+    msg_pool_get_stats(tp->pool, &stats);
+    if ((stats.used != 0U) || (stats.max_used != blocks) || (stats.failed != 1U))
+    {
+        test_error("the statistics of a new pool", stats.used);
+    }
+}
+
+/* Marks a block taken; it must not have been. */
+static void test_take(test_pool_t *tp, void *block)
+{
+    uint32_t index = (uint32_t)((uint8_t *)block - tp->first) / tp->stride;
+
+    if ((index >= tp->blocks) || ((uint8_t *)block != tp->first + index * tp->stride))
+    {
+        test_error("a block outside the pool", index);
+    }
+    else if (__atomic_exchange_n(&tp->owner[index], 1U, __ATOMIC_SEQ_CST) != 0U)
+    {
+        test_error("a block handed out twice", index);
+    }
+    else
+    {
+    }
+}
+
+static void test_give(test_pool_t *tp, void *block)
+{
+    uint32_t index = (uint32_t)((uint8_t *)block - tp->first) / tp->stride;
+
+    if (index < tp->blocks)
+    {
+        __atomic_store_n(&tp->owner[index], 0U, __ATOMIC_SEQ_CST);
+    }
+}
+
+static void test_fill(test_msg_t *msg, uint32_t producer, uint32_t seq)
+{
+    msg->producer = producer;
+    msg->seq = seq;
+    msg->check = ~(producer ^ seq);
+}
+
+static bool test_intact(const test_msg_t *msg)
+{
+    return msg->check == ~(msg->producer ^ msg->seq);
+}
+
+/*******************************************************************************
+ * Host threads
+ ******************************************************************************/
+static void *test_thread(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    uint32_t count = s_messages / TEST_THREADS;
+    test_msg_t *msg;
+    uint32_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        while ((msg = msg_pool_alloc_from_isr(s_threadPool.pool)) == NULL)
+        {
+            __atomic_fetch_add(&s_threadMisses, 1U, __ATOMIC_RELAXED);
+        }
+        test_take(&s_threadPool, msg);
+        test_fill(msg, id, i);
+        if ((msg->producer != id) || (msg->seq != i) || !test_intact(msg))
+        {
+            test_error("a block written by another thread while held", id);
+        }
+        test_give(&s_threadPool, msg);
+        msg_pool_free_from_isr(s_threadPool.pool, msg, NULL);
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    struct msg_pool_stats stats;
+    pthread_t threads[TEST_THREADS];
+    double start;
+    uint32_t i;
+
+    test_pool_create(&s_threadPool, TEST_THREAD_BLOCKS);
+    start = now_ns();
+    for (i = 0U; i < TEST_THREADS; i++)
+    {
+        if (pthread_create(&threads[i], NULL, test_thread, (void *)(uintptr_t)i) != 0)
+        {
+            printf("FAIL: no thread\n");
+            exit(1);
+        }
+    }
+    for (i = 0U; i < TEST_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    start = now_ns() - start;
+
+    msg_pool_get_stats(s_threadPool.pool, &stats);
+    printf("threads:    %u threads, %u blocks, %.1f ns per alloc+free, %u found the pool empty\n",
+           (unsigned)TEST_THREADS, (unsigned)TEST_THREAD_BLOCKS, start / (s_messages / TEST_THREADS * TEST_THREADS),
+           (unsigned)s_threadMisses);
+    if ((stats.used != 0U) || (stats.failed != 1U + s_threadMisses))
+    {
+        printf("error: %u blocks used and %u failed after the threads, %u expected failed\n", (unsigned)stats.used,
+               (unsigned)stats.failed, (unsigned)(1U + s_threadMisses));
+        s_errors++;
+    }
+}
+
+/*******************************************************************************
+ * Tasks
+ ******************************************************************************/
+static void *test_alloc(void)
+{
+    switch (s_alloc)
+    {
+        case TEST_POOL:
+            return msg_pool_alloc(s_taskPool.pool, portMAX_DELAY);
+        case TEST_HEAP_6:
+            return pvPortMalloc(sizeof(test_msg_t));
+        default:
+            return heap3_pvPortMalloc(sizeof(test_msg_t));
+    }
+}
+
+static void test_free(void *msg)
+{
+    switch (s_alloc)
+    {
+        case TEST_POOL:
+            test_give(&s_taskPool, msg);
+            msg_pool_free(s_taskPool.pool, msg);
+            break;
+        case TEST_HEAP_6:
+            vPortFree(msg);
+            break;
+        default:
+            heap3_vPortFree(msg);
+            break;
+    }
+}
+
+/* Takes a block of its own and gives it back. */
+static void test_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    test_msg_t *msg = msg_pool_alloc_from_isr(s_taskPool.pool);
+
+    if (msg == NULL)
+    {
+        s_irqMisses++;
+        return;
+    }
+    test_take(&s_taskPool, msg);
+    test_fill(msg, TEST_PRODUCERS, s_irqBlocks++);
+    test_give(&s_taskPool, msg);
+    msg_pool_free_from_isr(s_taskPool.pool, msg, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void producer_task(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    uint32_t count = s_messages / TEST_PRODUCERS;
+    test_msg_t *msg;
+    uint32_t seq;
+    double start;
+
+    for (seq = 0U; seq < count; seq++)
+    {
+        start = now_ns();
+        msg = test_alloc();
+        start = now_ns() - start;
+        if (start > s_longestWait)
+        {
+            s_longestWait = start;
+        }
+        if (msg == NULL)
+        {
+            printf("FAIL: no block for a message\n");
+            exit(1);
+        }
+        if (s_alloc == TEST_POOL)
+        {
+            test_take(&s_taskPool, msg);
+        }
+        test_fill(msg, id, seq);
+        if (s_alloc == TEST_POOL)
+        {
+            (void)msg_pool_send(s_taskPool.pool, s_queue, msg, portMAX_DELAY);
+        }
+        else
+        {
+            (void)xQueueSend(s_queue, &msg, portMAX_DELAY);
+        }
+        if (s_irq)
+        {
+            vPortGenerateSimulatedInterrupt(TEST_IRQ_LINE);
+        }
+    }
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+static void consumer_task(void *arg)
+{
+    uint32_t next[TEST_PRODUCERS] = {0U};
+    uint32_t count = s_messages / TEST_PRODUCERS * TEST_PRODUCERS;
+    test_msg_t *msg;
+    uint32_t i;
+
+    (void)arg;
+    for (i = 0U; i < count; i++)
+    {
+        (void)xQueueReceive(s_queue, &msg, portMAX_DELAY);
+        if (!test_intact(msg) || (msg->producer >= TEST_PRODUCERS))
+        {
+            test_error("a corrupted message", i);
+        }
+        else if (msg->seq != next[msg->producer])
+        {
+            test_error("a message lost or out of order", msg->seq);
+            next[msg->producer] = msg->seq + 1U;
+        }
+        else
+        {
+            next[msg->producer]++;
+        }
+        test_free(msg);
+    }
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+/* Returns the ns per message of producers and consumer. */
+static double test_run(test_alloc_t alloc, bool irq)
+{
+    double start;
+    uint32_t i;
+
+    s_alloc = alloc;
+    s_irq = irq;
+    start = now_ns();
+    for (i = 0U; i < TEST_PRODUCERS; i++)
+    {
+        if (xTaskCreate(producer_task, "producer", TEST_STACK_SIZE, (void *)(uintptr_t)i, TEST_PRIO, NULL) != pdPASS)
+        {
+            printf("FAIL: no producer\n");
+            exit(1);
+        }
+    }
+    if (xTaskCreate(consumer_task, "consumer", TEST_STACK_SIZE, NULL, TEST_PRIO, NULL) != pdPASS)
+    {
+        printf("FAIL: no consumer\n");
+        exit(1);
+    }
+    for (i = 0U; i < TEST_PRODUCERS + 1U; i++)
+    {
+        xSemaphoreTake(s_done, portMAX_DELAY);
+    }
+    return (now_ns() - start) / (s_messages / TEST_PRODUCERS * TEST_PRODUCERS);
+}
+
+static void test_timeout(void)
+{
+    void *taken[TEST_BLOCKS];
+    struct msg_pool_stats before;
+    struct msg_pool_stats after;
+    TickType_t start;
+    void *block;
+    uint32_t i;
+
+    msg_pool_get_stats(s_taskPool.pool, &before);
+    for (i = 0U; i < TEST_BLOCKS; i++)
+    {
+        taken[i] = msg_pool_alloc(s_taskPool.pool, 0U);
+    }
+    start = xTaskGetTickCount();
+    block = msg_pool_alloc(s_taskPool.pool, TEST_TIMEOUT_TICKS);
+    start = xTaskGetTickCount() - start;
+    printf("timeout:    a %u tick wait on an empty pool returned %s after %u ticks\n", (unsigned)TEST_TIMEOUT_TICKS,
+           (block == NULL) ? "NULL" : "a block", (unsigned)start);
+    if ((block != NULL) || (start < TEST_TIMEOUT_TICKS) || (start > TEST_TIMEOUT_TICKS + 1U))
+    {
+        test_error("the timed wait", start);
+    }
+
+    /* A send that fails gives the block back. */
+    for (i = 0U; i < TEST_QUEUE_LEN; i++)
+    {
+        (void)msg_pool_send(s_taskPool.pool, s_queue, taken[i], 0U);
+    }
+    if (msg_pool_send(s_taskPool.pool, s_queue, taken[TEST_QUEUE_LEN], 0U) != pdFAIL)
+    {
+        test_error("a send to a full queue", TEST_QUEUE_LEN);
+    }
+    msg_pool_get_stats(s_taskPool.pool, &after);
+    if (after.used != TEST_BLOCKS - 1U)
+    {
+        test_error("blocks used after a failed send", after.used);
+    }
+    for (i = 0U; i < TEST_QUEUE_LEN; i++)
+    {
+        (void)xQueueReceive(s_queue, &block, 0U);
+        msg_pool_free(s_taskPool.pool, block);
+    }
+    for (i = TEST_QUEUE_LEN + 1U; i < TEST_BLOCKS; i++)
+    {
+        msg_pool_free(s_taskPool.pool, taken[i]);
+    }
+    msg_pool_get_stats(s_taskPool.pool, &after);
+    if ((after.used != 0U) || (after.failed != before.failed + 1U) || (after.waits != before.waits + 1U))
+    {
+        test_error("the statistics after the timed wait", after.failed - before.failed);
+    }
+}
+
+static void test_task(void *arg)
+{
+    struct msg_pool_stats stats;
+    double ns[4];
+
+    (void)arg;
+    s_queue = xQueueCreate(TEST_QUEUE_LEN, sizeof(void *));
+    s_done = xSemaphoreCreateCounting(TEST_PRODUCERS + 1U, 0U);
+    if ((s_queue == NULL) || (s_done == NULL))
+    {
+        printf("FAIL: no queue\n");
+        exit(1);
+    }
+    test_pool_create(&s_taskPool, TEST_BLOCKS);
+    vPortSetInterruptHandler(TEST_IRQ_LINE, test_isr);
+
+    ns[0] = test_run(TEST_POOL, true);
+    msg_pool_get_stats(s_taskPool.pool, &stats);
+    printf("tasks:      %u producers, %u blocks, queue of %u, %u messages\n", (unsigned)TEST_PRODUCERS,
+           (unsigned)TEST_BLOCKS, (unsigned)TEST_QUEUE_LEN, (unsigned)(s_messages / TEST_PRODUCERS * TEST_PRODUCERS));
+    printf("interrupt:  %u blocks taken, %u found the pool empty\n", (unsigned)s_irqBlocks, (unsigned)s_irqMisses);
+    printf("pool:       %u used, %u at most, %u waits, %u failed, the longest wait for a block %.1f ms\n",
+           (unsigned)stats.used, (unsigned)stats.max_used, (unsigned)stats.waits, (unsigned)stats.failed,
+           s_longestWait / 1e6);
+    if ((stats.used != 0U) || (stats.failed != 1U + s_irqMisses))
+    {
+        printf("error: %u failed, the interrupt missed %u\n", (unsigned)stats.failed, (unsigned)s_irqMisses);
+        s_errors++;
+    }
+
+    ns[1] = test_run(TEST_POOL, false);
+    ns[2] = test_run(TEST_HEAP_6, false);
+    ns[3] = test_run(TEST_HEAP_3, false);
+    printf("ns per message: pool with the interrupt %.0f, pool %.0f, heap_6 %.0f, heap_3 %.0f\n", ns[0], ns[1],
+           ns[2], ns[3]);
+
+    test_timeout();
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_messages = strtoul(argv[1], NULL, 0);
+    }
+    if (s_messages < TEST_PRODUCERS)
+    {
+        fprintf(stderr, "usage: %s [messages], at least %u\n", argv[0], (unsigned)TEST_PRODUCERS);
+        return 2;
+    }
+
+    test_threads();
+    msg_pool_benchmark();
+
+    if (xTaskCreate(test_task, "test", TEST_STACK_SIZE, NULL, TEST_PRIO + 1U, NULL) != pdPASS)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
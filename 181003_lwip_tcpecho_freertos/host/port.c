@@ -0,0 +1,399 @@
+/*
+ * FreeRTOS port for running the firmware as a Linux process, used by the host
+ * build (see Makefile).
+ *
+ * Every task runs on a POSIX thread of its own, but only the thread of the
+ * task in pxCurrentTCB is ever let run: a context switch wakes the thread of
+ * the next task and parks the current one. The kernel therefore sees a single
+ * CPU, as on the target.
+ *
+ * Interrupts are simulated. Host threads - the tick thread below and device
+ * threads such as the TAP reader of tapif.c - only raise an interrupt line.
+ * The handlers then run on the thread of the running task, as soon as that
+ * task has interrupts enabled: at the end of a critical section, on a yield,
+ * or while the idle task waits for work. Running them on the host thread
+ * instead would let them overlap kernel code that only suspends the
+ * scheduler, which a real interrupt never does. The cost is that a task that
+ * spins without calling the kernel holds off interrupts until it does.
+ *
+ * Since a task is only switched out inside the kernel, tasks may call the C
+ * library freely, but they must not block in the host OS: the blocked thread
+ * would stall the whole simulated CPU.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*-----------------------------------------------------------*/
+
+typedef struct xTHREAD
+{
+	pthread_cond_t xCond;			/* Signalled when the task is switched in or deleted. */
+	BaseType_t xRunning;
+	BaseType_t xExit;
+	TaskFunction_t pxCode;
+	void *pvParameters;
+} Thread_t;
+
+/* Guards the switch handover and the pending interrupts. */
+static pthread_mutex_t xPortMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Signalled when an interrupt is raised, the idle task sleeps on it. */
+static pthread_cond_t xInterruptCond = PTHREAD_COND_INITIALIZER;
+
+/* Signalled by vPortEndScheduler(). */
+static pthread_cond_t xEndCond = PTHREAD_COND_INITIALIZER;
+static BaseType_t xSchedulerEnded = pdFALSE;
+
+/* Raised and not yet handled, written by host threads under xPortMutex. */
+static uint32_t ulPendingTicks = 0;
+static uint32_t ulPendingLines = 0;
+
+static PortInterruptHandler_t pxInterruptHandlers[ portMAX_INTERRUPTS ];
+
+/* State of the simulated CPU. Only the thread that runs - the running task,
+or main() before the scheduler starts - reads or writes it. */
+static BaseType_t xSchedulerRunning = pdFALSE;
+static UBaseType_t uxCriticalNesting = 0;
+static BaseType_t xInterruptsMasked = pdFALSE;
+static BaseType_t xInsideInterrupt = pdFALSE;
+static BaseType_t xSwitchPending = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static Thread_t *prvGetThread( TaskHandle_t xTask )
+{
+	/* pxTopOfStack is the first member of the TCB. */
+	return ( Thread_t * ) **( StackType_t ** ) xTask;
+}
+/*-----------------------------------------------------------*/
+
+/* Parks the calling thread until its task is switched in. The thread of a
+deleted task ends here. */
+static void prvWaitToRun( Thread_t *pxThread )
+{
+BaseType_t xExit;
+
+	pthread_mutex_lock( &xPortMutex );
+	while( ( pxThread->xRunning == pdFALSE ) && ( pxThread->xExit == pdFALSE ) )
+	{
+		pthread_cond_wait( &pxThread->xCond, &xPortMutex );
+	}
+	xExit = pxThread->xExit;
+	pthread_mutex_unlock( &xPortMutex );
+
+	if( xExit != pdFALSE )
+	{
+		pthread_cond_destroy( &pxThread->xCond );
+		free( pxThread );
+		pthread_exit( NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchContext( void )
+{
+Thread_t *pxCurrent = prvGetThread( xTaskGetCurrentTaskHandle() );
+Thread_t *pxNext;
+
+	xSwitchPending = pdFALSE;
+	xInterruptsMasked = pdTRUE;
+	vTaskSwitchContext();
+	pxNext = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+	if( pxNext != pxCurrent )
+	{
+		pthread_mutex_lock( &xPortMutex );
+		pxCurrent->xRunning = pdFALSE;
+		pxNext->xRunning = pdTRUE;
+		pthread_cond_signal( &pxNext->xCond );
+		pthread_mutex_unlock( &xPortMutex );
+
+		prvWaitToRun( pxCurrent );
+	}
+	xInterruptsMasked = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/* Takes the raised interrupts and the pended context switch, called whenever
+the running task has interrupts enabled. */
+static void prvServiceInterrupts( void )
+{
+uint32_t ulTicks, ulLines;
+UBaseType_t uxLine;
+
+	if( ( xSchedulerRunning == pdFALSE ) || ( xInsideInterrupt != pdFALSE ) || ( xInterruptsMasked != pdFALSE ) )
+	{
+		return;
+	}
+
+	for( ;; )
+	{
+		if( ( __atomic_load_n( &ulPendingTicks, __ATOMIC_RELAXED ) | __atomic_load_n( &ulPendingLines, __ATOMIC_RELAXED ) ) != 0UL )
+		{
+			pthread_mutex_lock( &xPortMutex );
+			ulTicks = ulPendingTicks;
+			ulLines = ulPendingLines;
+			ulPendingTicks = 0;
+			ulPendingLines = 0;
+			pthread_mutex_unlock( &xPortMutex );
+
+			xInterruptsMasked = pdTRUE;
+			xInsideInterrupt = pdTRUE;
+			for( ; ulTicks > 0UL; ulTicks-- )
+			{
+				if( xTaskIncrementTick() != pdFALSE )
+				{
+					xSwitchPending = pdTRUE;
+				}
+			}
+			for( uxLine = 0; ulLines != 0UL; uxLine++, ulLines >>= 1 )
+			{
+				if( ( ( ulLines & 1UL ) != 0UL ) && ( pxInterruptHandlers[ uxLine ] != NULL ) )
+				{
+					pxInterruptHandlers[ uxLine ]();
+				}
+			}
+			xInsideInterrupt = pdFALSE;
+			xInterruptsMasked = pdFALSE;
+		}
+		else if( xSwitchPending != pdFALSE )
+		{
+			prvSwitchContext();
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void *prvThreadMain( void *pvParameters )
+{
+Thread_t *pxThread = ( Thread_t * ) pvParameters;
+
+	prvWaitToRun( pxThread );
+
+	/* A task starts with interrupts enabled. */
+	uxCriticalNesting = 0;
+	xInterruptsMasked = pdFALSE;
+	prvServiceInterrupts();
+
+	pxThread->pxCode( pxThread->pvParameters );
+
+	/* A task must not return from its function. */
+	configASSERT( pdFALSE );
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvTickThread( void *pvParameters )
+{
+struct timespec xNext;
+
+	( void ) pvParameters;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNext );
+	for( ;; )
+	{
+		xNext.tv_nsec += 1000000000L / configTICK_RATE_HZ;
+		if( xNext.tv_nsec >= 1000000000L )
+		{
+			xNext.tv_nsec -= 1000000000L;
+			xNext.tv_sec++;
+		}
+		while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xNext, NULL ) == EINTR )
+		{
+		}
+
+		/* Ticks the process missed while it was descheduled are all
+		delivered, so the tick count keeps up with the host clock. */
+		pthread_mutex_lock( &xPortMutex );
+		ulPendingTicks++;
+		pthread_cond_signal( &xInterruptCond );
+		pthread_mutex_unlock( &xPortMutex );
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+Thread_t *pxThread = ( Thread_t * ) calloc( 1, sizeof( Thread_t ) );
+pthread_attr_t xAttr;
+pthread_t xThread;
+
+	configASSERT( pxThread != NULL );
+	pxThread->pxCode = pxCode;
+	pxThread->pvParameters = pvParameters;
+	pthread_cond_init( &pxThread->xCond, NULL );
+
+	/* The task stack is not used, the thread runs on a stack of its own. */
+	pthread_attr_init( &xAttr );
+	pthread_attr_setdetachstate( &xAttr, PTHREAD_CREATE_DETACHED );
+	if( pthread_create( &xThread, &xAttr, prvThreadMain, pxThread ) != 0 )
+	{
+		configASSERT( pdFALSE );
+	}
+	pthread_attr_destroy( &xAttr );
+
+	*pxTopOfStack = ( StackType_t ) pxThread;
+	return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+pthread_t xTickThread;
+Thread_t *pxFirst = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+	uxCriticalNesting = 0;
+	xSchedulerRunning = pdTRUE;
+
+	if( pthread_create( &xTickThread, NULL, prvTickThread, NULL ) != 0 )
+	{
+		return pdFALSE;
+	}
+
+	/* Start the first task; main() only waits from now on. */
+	pthread_mutex_lock( &xPortMutex );
+	pxFirst->xRunning = pdTRUE;
+	pthread_cond_signal( &pxFirst->xCond );
+	while( xSchedulerEnded == pdFALSE )
+	{
+		pthread_cond_wait( &xEndCond, &xPortMutex );
+	}
+	pthread_mutex_unlock( &xPortMutex );
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+	pthread_mutex_lock( &xPortMutex );
+	xSchedulerEnded = pdTRUE;
+	pthread_cond_signal( &xEndCond );
+	pthread_mutex_unlock( &xPortMutex );
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpThread( void *pvThread )
+{
+Thread_t *pxThread = ( Thread_t * ) pvThread;
+
+	/* The thread is parked in prvWaitToRun() and frees itself. */
+	pthread_mutex_lock( &xPortMutex );
+	pxThread->xExit = pdTRUE;
+	pthread_cond_signal( &pxThread->xCond );
+	pthread_mutex_unlock( &xPortMutex );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+	/* Like PendSV: the switch happens once interrupts are enabled. */
+	xSwitchPending = pdTRUE;
+	prvServiceInterrupts();
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	xInterruptsMasked = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	xInterruptsMasked = pdFALSE;
+	prvServiceInterrupts();
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+BaseType_t xWasMasked = xInterruptsMasked;
+
+	xInterruptsMasked = pdTRUE;
+	return ( UBaseType_t ) xWasMasked;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxMask )
+{
+	xInterruptsMasked = ( BaseType_t ) uxMask;
+	prvServiceInterrupts();
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	vPortDisableInterrupts();
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	configASSERT( uxCriticalNesting );
+	uxCriticalNesting--;
+	if( uxCriticalNesting == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortIsInsideInterrupt( void )
+{
+	return xInsideInterrupt;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetInterruptHandler( UBaseType_t uxLine, PortInterruptHandler_t pxHandler )
+{
+	configASSERT( uxLine < portMAX_INTERRUPTS );
+	pxInterruptHandlers[ uxLine ] = pxHandler;
+}
+/*-----------------------------------------------------------*/
+
+void vPortGenerateSimulatedInterrupt( UBaseType_t uxLine )
+{
+	configASSERT( uxLine < portMAX_INTERRUPTS );
+	pthread_mutex_lock( &xPortMutex );
+	ulPendingLines |= 1UL << uxLine;
+	pthread_cond_signal( &xInterruptCond );
+	pthread_mutex_unlock( &xPortMutex );
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+	/* The idle task sleeps like a WFI until a host thread raises an
+	interrupt, rather than spinning a host CPU. */
+	pthread_mutex_lock( &xPortMutex );
+	while( ( ulPendingTicks | ulPendingLines ) == 0UL )
+	{
+		pthread_cond_wait( &xInterruptCond, &xPortMutex );
+	}
+	pthread_mutex_unlock( &xPortMutex );
+
+	prvServiceInterrupts();
+}
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFile, unsigned long ulLine )
+{
+	fprintf( stderr, "ASSERT: %s:%lu\n", pcFile, ulLine );
+	abort();
+}
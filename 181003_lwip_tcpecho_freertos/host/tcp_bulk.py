@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+#
+# Bulk-transfer benchmark for the host build at emulated round-trip times.
+#
+# For every RTT the server is started with TAPIF_DELAY_MS set to it, so every
+# frame it sends is held back that long. One connection then streams data
+# through the echo server for --seconds while the echo is read back and
+# checked. Reports the echo throughput and the largest receive window the
+# stack advertised, as seen by the Linux side in ss -ti.
+#
+#   make -C host DEFS=-DTCP_HIGH_THROUGHPUT=1
+#   host/tcp_bulk.py --rtt 2,10,40,100
+#
+
+import argparse
+import os
+import re
+import socket
+import subprocess
+import threading
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def connect(args):
+    deadline = time.monotonic() + 10
+    while True:
+        try:
+            return socket.create_connection((args.host, args.port), timeout=args.timeout)
+        except OSError:
+            if time.monotonic() > deadline:
+                raise
+            time.sleep(0.2)
+
+
+def peer_window(args, sock):
+    out = subprocess.run(['ss', '-tin', 'dst', '%s:%d' % (args.host, args.port),
+                          'src', ':%d' % sock.getsockname()[1]],
+                         capture_output=True, text=True).stdout
+    m = re.search(r'snd_wnd:(\d+)', out)
+    return int(m.group(1)) if m else 0
+
+
+def run(args, rtt):
+    env = dict(os.environ, TAPIF_DELAY_MS=str(rtt))
+    server = subprocess.Popen([args.server], env=env, stdout=subprocess.DEVNULL)
+    try:
+        sock = connect(args)
+        pattern = bytes(range(256)) * 256
+        expect = pattern * 2
+        sent = [0]
+        received = 0
+        errors = 0
+        stop = threading.Event()
+
+        def writer():
+            while not stop.is_set():
+                try:
+                    sock.sendall(pattern)
+                except OSError:
+                    return
+                sent[0] += len(pattern)
+
+        t = threading.Thread(target=writer, daemon=True)
+        start = time.monotonic()
+        t.start()
+        window = 0
+        next_sample = start
+        while time.monotonic() - start < args.seconds:
+            data = sock.recv(len(pattern))
+            if not data:
+                break
+            offset = received % len(pattern)
+            if data != expect[offset:offset + len(data)]:
+                errors += 1
+            received += len(data)
+            if time.monotonic() >= next_sample:
+                window = max(window, peer_window(args, sock))
+                next_sample += 0.1
+        elapsed = time.monotonic() - start
+        stop.set()
+        sock.close()
+        return received / elapsed / 1e3, window, errors
+    finally:
+        server.terminate()
+        server.wait()
+        time.sleep(0.5)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--server', default=os.path.join(HERE, 'lwip_tcpecho_freertos'))
+    parser.add_argument('--host', default='192.168.1.102')
+    parser.add_argument('--port', type=int, default=50000)
+    parser.add_argument('--rtt', default='2,10,40,100', help='comma separated RTTs in ms')
+    parser.add_argument('--seconds', type=float, default=10.0)
+    parser.add_argument('--timeout', type=float, default=5.0)
+    args = parser.parse_args()
+
+    print('%8s %12s %14s %7s' % ('RTT ms', 'echo kB/s', 'max window B', 'errors'))
+    for rtt in [int(r) for r in args.rtt.split(',')]:
+        rate, window, errors = run(args, rtt)
+        print('%8d %12.0f %14d %7d' % (rtt, rate, window, errors))
+
+
+if __name__ == '__main__':
+    main()
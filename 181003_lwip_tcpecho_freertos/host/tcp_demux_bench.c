@@ -0,0 +1,289 @@
+/*
+ * Demultiplexing of tcp_input(): linear PCB lists against the hash tables of
+ * LWIP_TCP_PCB_HASH.
+ *
+ * Registers 10, 100 and 1000 established PCBs on one local port, as a server
+ * with that many clients, behind a listener on the same port. Segments of one
+ * byte from the clients, in random order, go into ip4_input() on a netif
+ * whose output drops the ACKs, so every segment takes the whole receive path:
+ * the IP and TCP checksums, the PCB lookup, tcp_receive(), the recv callback
+ * and an ACK for every second segment. Prints the host segments per second
+ * and nanoseconds per segment at each PCB count.
+ *
+ * Fails if a segment reaches a PCB other than its own or none at all.
+ *
+ *   make -C host tcp_demux_bench_list tcp_demux_bench_hash tcp_demux_bench_hash1024
+ *   host/tcp_demux_bench_hash [segments]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/tcp.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/ip.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_PORT 50000U
+#define BENCH_PCBS_MAX 1000U
+#define BENCH_SEGMENT_LEN (IP_HLEN + TCP_HLEN + 1U)
+
+/* One client connection. */
+typedef struct
+{
+    struct tcp_pcb *pcb;
+    ip4_addr_t addr;
+    u16_t port;
+    u32_t seqno; /* next sequence number the client sends */
+} bench_conn_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_segments = 1000000U;
+
+static struct netif s_netif;
+static bench_conn_t s_conns[BENCH_PCBS_MAX];
+static uint32_t s_expected;
+static uint32_t s_received;
+static uint32_t s_acks;
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static err_t bench_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(p);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    s_acks++;
+    return ERR_OK;
+}
+
+static err_t bench_netif_init(struct netif *netif)
+{
+    netif->output = bench_output;
+    netif->mtu = 1500;
+    return ERR_OK;
+}
+
+static err_t bench_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL)
+    {
+        s_errors++;
+        return ERR_OK;
+    }
+    if (((uint32_t)(uintptr_t)arg != s_expected) && (s_errors++ < 10U))
+    {
+        printf("error: segment of connection %u reached connection %u\n", (unsigned)s_expected,
+               (unsigned)(uintptr_t)arg);
+    }
+    s_received++;
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static void open_conns(uint32_t count)
+{
+    bench_conn_t *conn;
+    uint32_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        conn = &s_conns[i];
+        /* Clients at .2 to .101, below the address of the netif. */
+        IP4_ADDR(&conn->addr, 192, 168, 1, 2U + (i % 100U));
+        conn->port = (u16_t)(1024U + i);
+        conn->seqno = 1000U * i;
+
+        conn->pcb = tcp_new();
+        if (conn->pcb == NULL)
+        {
+            printf("FAIL: no PCB for connection %u, raise MEMP_NUM_TCP_PCB\n", (unsigned)i);
+            exit(1);
+        }
+        /* Established as if the handshake had just completed. */
+        ip_addr_copy_from_ip4(conn->pcb->local_ip, *netif_ip4_addr(&s_netif));
+        ip_addr_copy_from_ip4(conn->pcb->remote_ip, conn->addr);
+        conn->pcb->local_port = BENCH_PORT;
+        conn->pcb->remote_port = conn->port;
+        conn->pcb->rcv_nxt = conn->seqno;
+        conn->pcb->state = ESTABLISHED;
+        tcp_arg(conn->pcb, (void *)(uintptr_t)i);
+        tcp_recv(conn->pcb, bench_recv);
+        TCP_REG_ACTIVE(conn->pcb);
+    }
+}
+
+static void close_conns(uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        tcp_abort(s_conns[i].pcb);
+    }
+}
+
+static struct pbuf *make_segment(bench_conn_t *conn)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, BENCH_SEGMENT_LEN, PBUF_RAM);
+    struct ip_hdr *iphdr;
+    struct tcp_hdr *tcphdr;
+    ip_addr_t src;
+    ip_addr_t dst;
+
+    if (p == NULL)
+    {
+        return NULL;
+    }
+    iphdr = (struct ip_hdr *)p->payload;
+    memset(iphdr, 0, IP_HLEN);
+    IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+    IPH_LEN_SET(iphdr, lwip_htons(BENCH_SEGMENT_LEN));
+    IPH_TTL_SET(iphdr, 64);
+    IPH_PROTO_SET(iphdr, IP_PROTO_TCP);
+    ip4_addr_copy(iphdr->src, conn->addr);
+    ip4_addr_copy(iphdr->dest, *netif_ip4_addr(&s_netif));
+    IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+
+    tcphdr = (struct tcp_hdr *)((uint8_t *)p->payload + IP_HLEN);
+    tcphdr->src = lwip_htons(conn->port);
+    tcphdr->dest = lwip_htons(BENCH_PORT);
+    tcphdr->seqno = lwip_htonl(conn->seqno);
+    tcphdr->ackno = lwip_htonl(conn->pcb->snd_nxt);
+    TCPH_HDRLEN_FLAGS_SET(tcphdr, TCP_HLEN / 4, TCP_ACK | TCP_PSH);
+    tcphdr->wnd = lwip_htons(TCP_WND);
+    tcphdr->chksum = 0;
+    tcphdr->urgp = 0;
+    ((uint8_t *)tcphdr)[TCP_HLEN] = 'x';
+
+    ip_addr_copy_from_ip4(src, iphdr->src);
+    ip_addr_copy_from_ip4(dst, iphdr->dest);
+    pbuf_header(p, -(s16_t)IP_HLEN);
+    tcphdr->chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, TCP_HLEN + 1U, &src, &dst);
+    pbuf_header(p, IP_HLEN);
+    conn->seqno++;
+    return p;
+}
+
+static double bench_run(uint32_t count)
+{
+    struct pbuf *p;
+    uint32_t rng = 1U;
+    uint32_t n;
+    double start;
+
+    open_conns(count);
+    s_received = 0U;
+
+    start = now_ns();
+    for (n = 0U; n < s_segments; n++)
+    {
+        rng = rng * 1103515245U + 12345U;
+        s_expected = (rng >> 8) % count;
+        p = make_segment(&s_conns[s_expected]);
+        if (p == NULL)
+        {
+            printf("FAIL: out of pbufs\n");
+            exit(1);
+        }
+        ip4_input(p, &s_netif);
+        if ((s_received != n + 1U) && (s_errors++ < 10U))
+        {
+            printf("error: segment %u of connection %u was not delivered\n", (unsigned)n, (unsigned)s_expected);
+            s_received = n + 1U;
+        }
+    }
+    start = now_ns() - start;
+
+    close_conns(count);
+    return start / s_segments;
+}
+
+static void bench_task(void *arg)
+{
+    static const uint32_t counts[] = {10U, 100U, BENCH_PCBS_MAX};
+    ip4_addr_t ipaddr, netmask, gw;
+    struct tcp_pcb *listener;
+    double ns;
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(arg);
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    tcpip_init(NULL, NULL);
+    LOCK_TCPIP_CORE();
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, NULL, bench_netif_init, ip4_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+    listener = tcp_new();
+    tcp_bind(listener, IP_ADDR_ANY, BENCH_PORT);
+    listener = tcp_listen(listener);
+
+    printf("%u segments of 1 byte, %s, %u buckets\n", (unsigned)s_segments,
+           LWIP_TCP_PCB_HASH ? "hash tables" : "linear lists", LWIP_TCP_PCB_HASH ? (unsigned)TCP_PCB_HASH_SIZE : 0U);
+    printf("%6s %12s %10s\n", "pcbs", "segments/s", "ns/seg");
+    for (i = 0U; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        ns = bench_run(counts[i]);
+        printf("%6u %12.0f %10.0f\n", (unsigned)counts[i], 1e9 / ns, ns);
+    }
+    UNLOCK_TCPIP_CORE();
+
+    if ((s_errors != 0U) || (s_acks == 0U))
+    {
+        printf("FAIL: %u errors, %u ACKs sent\n", (unsigned)s_errors, (unsigned)s_acks);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_segments = strtoul(argv[1], NULL, 0);
+    }
+    if (s_segments == 0U)
+    {
+        fprintf(stderr, "usage: %s [segments]\n", argv[0]);
+        return 2;
+    }
+
+    if (sys_thread_new("bench", bench_task, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
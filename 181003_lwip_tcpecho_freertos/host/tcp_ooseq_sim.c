@@ -0,0 +1,387 @@
+/*
+ * Bulk TCP transfers over a link that loses and reorders segments, to compare
+ * the out-of-sequence queue bounds of lwipopts.h (TCP_OOSEQ_MAX_PBUFS,
+ * TCP_OOSEQ_GLOBAL_MAX_PBUFS, TCP_OOSEQ_EVICT_PBUFS) with an unbounded queue
+ * and with no queue at all.
+ *
+ * Runs the bare metal lwIP core (USE_RTOS=0) on a simulated millisecond
+ * clock. Six flows share one netif, whose output holds every frame back for
+ * 5 ms, or 7 ms for the reordered ones, so that the next frames overtake
+ * them, and drops some at the loss rate. Frames reach the stack again in
+ * pbufs of the 9-entry PBUF_POOL, as from the ENET driver; a frame that finds
+ * the pool empty is dropped and counted. For each loss and reorder rate the
+ * transfers run over a few random seeds, and the mean goodput, the frames
+ * dropped for want of a pbuf and the most pbufs held out of sequence are
+ * printed.
+ *
+ * Fails if the data arrives corrupted or if nothing arrives on the clean link.
+ *
+ *   make -C host tcp_ooseq_sim_off tcp_ooseq_sim_unbounded tcp_ooseq_sim_bounded
+ *   host/tcp_ooseq_sim_bounded [seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/ip.h"
+#include "lwip/timeouts.h"
+#include "lwip/priv/tcp_priv.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SIM_PORT 50000U
+#define SIM_FLOWS 6U
+#define SIM_LINK_FRAMES 1024U
+#define SIM_FRAME_MAX 1536U
+#define SIM_DELAY_MS 5U
+#define SIM_REORDER_MS 2U
+#define SIM_SEEDS 6U
+#define SIM_PATTERN 251U
+
+/* One frame on the link. */
+typedef struct
+{
+    u32_t due;
+    u16_t len;
+    u8_t data[SIM_FRAME_MAX];
+} sim_frame_t;
+
+/* One bulk transfer. */
+typedef struct
+{
+    struct tcp_pcb *client;
+    struct tcp_pcb *server;
+    uint32_t txBytes;
+    uint32_t rxBytes;
+} sim_flow_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_seconds = 20U;
+
+static u32_t s_now;
+static struct netif s_netif;
+static sim_frame_t s_link[SIM_LINK_FRAMES];
+static uint32_t s_linkFrames;
+static double s_loss;
+static double s_reorder;
+static uint32_t s_noPbuf;
+static uint32_t s_ooseqMax;
+
+static sim_flow_t s_flows[SIM_FLOWS];
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/* What the bare metal core needs of the port. */
+u32_t sys_now(void)
+{
+    return s_now;
+}
+
+sys_prot_t sys_arch_protect(void)
+{
+    return 0;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+    LWIP_UNUSED_ARG(pval);
+}
+
+void sys_assert(char *msg)
+{
+    printf("FAIL: assertion \"%s\"\n", msg);
+    exit(1);
+}
+
+static double sim_random(void)
+{
+    return (double)rand() / RAND_MAX;
+}
+
+static err_t sim_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    sim_frame_t *frame;
+
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    if ((sim_random() < s_loss) || (s_linkFrames == SIM_LINK_FRAMES) || (p->tot_len > SIM_FRAME_MAX))
+    {
+        return ERR_OK;
+    }
+    frame = &s_link[s_linkFrames++];
+    frame->due = s_now + SIM_DELAY_MS + ((sim_random() < s_reorder) ? SIM_REORDER_MS : 0U);
+    frame->len = pbuf_copy_partial(p, frame->data, p->tot_len, 0);
+    return ERR_OK;
+}
+
+static err_t sim_netif_init(struct netif *netif)
+{
+    netif->output = sim_output;
+    netif->mtu = 1500;
+    return ERR_OK;
+}
+
+/* Delivers the frames that are due, or drops all of them. */
+static void link_run(int drop)
+{
+    sim_frame_t *frame;
+    struct pbuf *p;
+    uint32_t kept = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < s_linkFrames; i++)
+    {
+        frame = &s_link[i];
+        if (!drop && ((s32_t)(frame->due - s_now) > 0))
+        {
+            if (kept != i)
+            {
+                s_link[kept] = *frame;
+            }
+            kept++;
+        }
+        else if (!drop)
+        {
+            p = pbuf_alloc(PBUF_RAW, frame->len, PBUF_POOL);
+            if (p == NULL)
+            {
+                s_noPbuf++;
+                continue;
+            }
+            pbuf_take(p, frame->data, frame->len);
+            if (s_netif.input(p, &s_netif) != ERR_OK)
+            {
+                pbuf_free(p);
+            }
+        }
+    }
+    s_linkFrames = kept;
+}
+
+static err_t server_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    sim_flow_t *flow = (sim_flow_t *)arg;
+    struct pbuf *q;
+    uint16_t i;
+
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL)
+    {
+        return ERR_OK;
+    }
+    for (q = p; q != NULL; q = q->next)
+    {
+        for (i = 0U; i < q->len; i++)
+        {
+            if ((((u8_t *)q->payload)[i] != (u8_t)(flow->rxBytes % SIM_PATTERN)) && (s_errors++ < 10U))
+            {
+                printf("error: byte %u of flow %u is corrupted\n", (unsigned)flow->rxBytes,
+                       (unsigned)(flow - s_flows));
+            }
+            flow->rxBytes++;
+        }
+    }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+/* A PCB that lwIP freed must not be aborted at the end of the run. */
+static void server_err(void *arg, err_t err)
+{
+    LWIP_UNUSED_ARG(err);
+
+    ((sim_flow_t *)arg)->server = NULL;
+}
+
+static void client_err(void *arg, err_t err)
+{
+    LWIP_UNUSED_ARG(err);
+
+    ((sim_flow_t *)arg)->client = NULL;
+}
+
+static err_t server_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    for (i = 0U; i < SIM_FLOWS; i++)
+    {
+        if ((s_flows[i].client != NULL) && (s_flows[i].client->local_port == pcb->remote_port))
+        {
+            s_flows[i].server = pcb;
+            tcp_arg(pcb, &s_flows[i]);
+            tcp_err(pcb, server_err);
+        }
+    }
+    tcp_recv(pcb, server_recv);
+    return ERR_OK;
+}
+
+static void client_fill(struct tcp_pcb *pcb, sim_flow_t *flow)
+{
+    static u8_t buf[TCP_MSS];
+    uint16_t i;
+
+    while (tcp_sndbuf(pcb) >= TCP_MSS)
+    {
+        for (i = 0U; i < TCP_MSS; i++)
+        {
+            buf[i] = (u8_t)((flow->txBytes + i) % SIM_PATTERN);
+        }
+        if (tcp_write(pcb, buf, TCP_MSS, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        {
+            break;
+        }
+        flow->txBytes += TCP_MSS;
+    }
+    tcp_output(pcb);
+}
+
+static err_t client_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    LWIP_UNUSED_ARG(len);
+
+    client_fill(pcb, (sim_flow_t *)arg);
+    return ERR_OK;
+}
+
+static err_t client_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(err);
+
+    client_fill(pcb, (sim_flow_t *)arg);
+    return ERR_OK;
+}
+
+/* One run of all flows: the bytes that arrived in order. */
+static uint32_t sim_run(double loss, double reorder, unsigned int seed)
+{
+    uint32_t bytes = 0U;
+    uint32_t i;
+    u32_t end;
+
+    srand(seed);
+    s_loss = loss;
+    s_reorder = reorder;
+    memset(s_flows, 0, sizeof(s_flows));
+
+    for (i = 0U; i < SIM_FLOWS; i++)
+    {
+        s_flows[i].client = tcp_new();
+        tcp_arg(s_flows[i].client, &s_flows[i]);
+        tcp_sent(s_flows[i].client, client_sent);
+        tcp_err(s_flows[i].client, client_err);
+        tcp_connect(s_flows[i].client, &s_netif.ip_addr, SIM_PORT, client_connected);
+    }
+    for (end = s_now + s_seconds * 1000U; s_now != end; s_now++)
+    {
+        link_run(0);
+        sys_check_timeouts();
+#if TCP_QUEUE_OOSEQ
+        if (tcp_ooseq_usage(NULL) > s_ooseqMax)
+        {
+            s_ooseqMax = tcp_ooseq_usage(NULL);
+        }
+#endif /* TCP_QUEUE_OOSEQ */
+    }
+
+    for (i = 0U; i < SIM_FLOWS; i++)
+    {
+        if (s_flows[i].client != NULL)
+        {
+            tcp_abort(s_flows[i].client);
+        }
+        if (s_flows[i].server != NULL)
+        {
+            tcp_abort(s_flows[i].server);
+        }
+        bytes += s_flows[i].rxBytes;
+    }
+    link_run(1);
+    return bytes;
+}
+
+int main(int argc, char **argv)
+{
+    static const double rates[][2] = {{0.0, 0.0}, {0.0, 0.05}, {0.01, 0.05}, {0.02, 0.10}};
+    ip4_addr_t ipaddr, netmask, gw;
+    struct tcp_pcb *listener;
+    double bytes;
+    uint32_t i;
+    uint32_t seed;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_seconds = strtoul(argv[1], NULL, 0);
+    }
+    if (s_seconds == 0U)
+    {
+        fprintf(stderr, "usage: %s [seconds]\n", argv[0]);
+        return 2;
+    }
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    lwip_init();
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, NULL, sim_netif_init, ip_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+    listener = tcp_new();
+    tcp_bind(listener, IP_ADDR_ANY, SIM_PORT);
+    listener = tcp_listen(listener);
+    tcp_accept(listener, server_accept);
+
+#if !TCP_QUEUE_OOSEQ
+    printf("%u flows, %u s per run, %u seeds, no ooseq queue\n", (unsigned)SIM_FLOWS, (unsigned)s_seconds,
+           (unsigned)SIM_SEEDS);
+#else
+    printf("%u flows, %u s per run, %u seeds, ooseq pbufs %u per pcb, %u in all, evict %u\n", (unsigned)SIM_FLOWS,
+           (unsigned)s_seconds, (unsigned)SIM_SEEDS, (unsigned)TCP_OOSEQ_MAX_PBUFS,
+           (unsigned)TCP_OOSEQ_GLOBAL_MAX_PBUFS, (unsigned)TCP_OOSEQ_EVICT_PBUFS);
+#endif /* !TCP_QUEUE_OOSEQ */
+    printf("%6s %8s %14s %10s %12s\n", "loss", "reorder", "goodput kB/s", "no pbuf", "ooseq max");
+    for (i = 0U; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        bytes = 0.0;
+        s_noPbuf = 0U;
+        s_ooseqMax = 0U;
+        for (seed = 1U; seed <= SIM_SEEDS; seed++)
+        {
+            bytes += sim_run(rates[i][0], rates[i][1], seed);
+        }
+        bytes /= SIM_SEEDS;
+        printf("%5.1f%% %7.1f%% %14.1f %10u %12u\n", rates[i][0] * 100.0, rates[i][1] * 100.0,
+               bytes / 1000.0 / s_seconds, (unsigned)(s_noPbuf / SIM_SEEDS), (unsigned)s_ooseqMax);
+        if ((i == 0U) && (bytes == 0.0) && (s_errors++ < 10U))
+        {
+            printf("error: nothing arrived on the clean link\n");
+        }
+    }
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,318 @@
+/*
+ * Goodput of one bulk TCP transfer over a lossy link, with and without
+ * LWIP_TCP_SACK.
+ *
+ * Runs the bare metal lwIP core (USE_RTOS=0) with the TCP_HIGH_THROUGHPUT
+ * profile on a simulated millisecond clock. Client and server share one
+ * netif, whose output holds every frame back for the one-way delay and drops
+ * it at the given loss rate, both for data and for ACKs; frames reach the
+ * stack again in PBUF_POOL pbufs, as from a driver. The client keeps the send
+ * buffer full. For each loss rate the transfer runs for the given time over a
+ * few random seeds, and the mean goodput is printed.
+ *
+ * Fails if the data arrives corrupted, if SACK is not negotiated when enabled,
+ * or if nothing arrives on the loss-free link.
+ *
+ *   make -C host tcp_sack_sim0 tcp_sack_sim1
+ *   host/tcp_sack_sim1 [seconds [delay_ms]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/ip.h"
+#include "lwip/timeouts.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define SIM_PORT 50000U
+#define SIM_LINK_FRAMES 1024U
+#define SIM_SEEDS 8U
+#define SIM_PATTERN 251U
+
+/* One frame on the link. */
+typedef struct
+{
+    u32_t due;
+    u16_t len;
+    u8_t *data;
+} sim_frame_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_seconds = 30U;
+static u32_t s_delay = 20U;
+
+static u32_t s_now;
+static struct netif s_netif;
+static sim_frame_t s_link[SIM_LINK_FRAMES];
+static uint32_t s_linkHead;
+static uint32_t s_linkTail;
+static double s_loss;
+
+static struct tcp_pcb *s_client;
+static struct tcp_pcb *s_server;
+static uint32_t s_txBytes;
+static uint32_t s_rxBytes;
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/* What the bare metal core needs of the port. */
+u32_t sys_now(void)
+{
+    return s_now;
+}
+
+sys_prot_t sys_arch_protect(void)
+{
+    return 0;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+    LWIP_UNUSED_ARG(pval);
+}
+
+void sys_assert(char *msg)
+{
+    printf("FAIL: assertion \"%s\"\n", msg);
+    exit(1);
+}
+
+static err_t sim_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    sim_frame_t *frame;
+
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    if (((double)rand() / RAND_MAX < s_loss) || (((s_linkTail + 1U) % SIM_LINK_FRAMES) == s_linkHead))
+    {
+        return ERR_OK;
+    }
+    frame = &s_link[s_linkTail];
+    frame->data = malloc(p->tot_len);
+    if (frame->data == NULL)
+    {
+        return ERR_MEM;
+    }
+    frame->len = p->tot_len;
+    frame->due = s_now + s_delay;
+    pbuf_copy_partial(p, frame->data, p->tot_len, 0);
+    s_linkTail = (s_linkTail + 1U) % SIM_LINK_FRAMES;
+    return ERR_OK;
+}
+
+static err_t sim_netif_init(struct netif *netif)
+{
+    netif->output = sim_output;
+    netif->mtu = 1500;
+    return ERR_OK;
+}
+
+/* Delivers the frames that are due, or all of them to the bin. */
+static void link_run(int drop)
+{
+    sim_frame_t *frame;
+    struct pbuf *p;
+
+    while ((s_linkHead != s_linkTail) && (drop || ((s32_t)(s_link[s_linkHead].due - s_now) <= 0)))
+    {
+        frame = &s_link[s_linkHead];
+        s_linkHead = (s_linkHead + 1U) % SIM_LINK_FRAMES;
+        p = drop ? NULL : pbuf_alloc(PBUF_RAW, frame->len, PBUF_POOL);
+        if (p != NULL)
+        {
+            pbuf_take(p, frame->data, frame->len);
+            if (s_netif.input(p, &s_netif) != ERR_OK)
+            {
+                pbuf_free(p);
+            }
+        }
+        free(frame->data);
+    }
+}
+
+static err_t server_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    struct pbuf *q;
+    uint16_t i;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL)
+    {
+        return ERR_OK;
+    }
+    for (q = p; q != NULL; q = q->next)
+    {
+        for (i = 0U; i < q->len; i++)
+        {
+            if ((((u8_t *)q->payload)[i] != (u8_t)(s_rxBytes % SIM_PATTERN)) && (s_errors++ < 10U))
+            {
+                printf("error: byte %u of the stream is corrupted\n", (unsigned)s_rxBytes);
+            }
+            s_rxBytes++;
+        }
+    }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static err_t server_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    s_server = pcb;
+    tcp_recv(pcb, server_recv);
+    return ERR_OK;
+}
+
+static void client_fill(struct tcp_pcb *pcb)
+{
+    static u8_t buf[TCP_MSS];
+    uint16_t i;
+
+    while (tcp_sndbuf(pcb) >= TCP_MSS)
+    {
+        for (i = 0U; i < TCP_MSS; i++)
+        {
+            buf[i] = (u8_t)((s_txBytes + i) % SIM_PATTERN);
+        }
+        if (tcp_write(pcb, buf, TCP_MSS, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        {
+            break;
+        }
+        s_txBytes += TCP_MSS;
+    }
+    tcp_output(pcb);
+}
+
+static err_t client_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(len);
+
+    client_fill(pcb);
+    return ERR_OK;
+}
+
+static err_t client_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+#if LWIP_TCP_SACK
+    if (((pcb->flags & TF_SACK) == 0) && (s_errors++ < 10U))
+    {
+        printf("error: SACK not negotiated\n");
+    }
+#endif /* LWIP_TCP_SACK */
+    client_fill(pcb);
+    return ERR_OK;
+}
+
+/* One transfer: the bytes that arrived in order. */
+static uint32_t sim_run(double loss, unsigned int seed)
+{
+    u32_t end;
+
+    srand(seed);
+    s_loss = loss;
+    s_txBytes = 0U;
+    s_rxBytes = 0U;
+    s_server = NULL;
+
+    s_client = tcp_new();
+    tcp_sent(s_client, client_sent);
+    tcp_connect(s_client, &s_netif.ip_addr, SIM_PORT, client_connected);
+    for (end = s_now + s_seconds * 1000U; s_now != end; s_now++)
+    {
+        link_run(0);
+        sys_check_timeouts();
+    }
+
+    tcp_abort(s_client);
+    if (s_server != NULL)
+    {
+        tcp_abort(s_server);
+    }
+    link_run(1);
+    return s_rxBytes;
+}
+
+int main(int argc, char **argv)
+{
+    static const double losses[] = {0.0, 0.005, 0.01, 0.02, 0.05};
+    ip4_addr_t ipaddr, netmask, gw;
+    struct tcp_pcb *listener;
+    double bytes;
+    uint32_t i;
+    uint32_t seed;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_seconds = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        s_delay = strtoul(argv[2], NULL, 0);
+    }
+    if (s_seconds == 0U)
+    {
+        fprintf(stderr, "usage: %s [seconds [delay_ms]]\n", argv[0]);
+        return 2;
+    }
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    lwip_init();
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, NULL, sim_netif_init, ip_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+    listener = tcp_new();
+    tcp_bind(listener, IP_ADDR_ANY, SIM_PORT);
+    listener = tcp_listen(listener);
+    tcp_accept(listener, server_accept);
+
+    printf("%u s per run, %u ms each way, %u seeds, SACK %s\n", (unsigned)s_seconds, (unsigned)s_delay,
+           (unsigned)SIM_SEEDS, LWIP_TCP_SACK ? "on" : "off");
+    printf("%6s %14s\n", "loss", "goodput kB/s");
+    for (i = 0U; i < sizeof(losses) / sizeof(losses[0]); i++)
+    {
+        bytes = 0.0;
+        for (seed = 1U; seed <= SIM_SEEDS; seed++)
+        {
+            bytes += sim_run(losses[i], seed);
+        }
+        bytes /= SIM_SEEDS;
+        printf("%5.1f%% %14.1f\n", losses[i] * 100.0, bytes / 1000.0 / s_seconds);
+        if ((i == 0U) && (bytes == 0.0) && (s_errors++ < 10U))
+        {
+            printf("error: nothing arrived on the loss-free link\n");
+        }
+    }
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,409 @@
+/*
+ * Cost of tcp_write() with TCP_WRITE_FLAG_COPY against tcp_write_zc() for one
+ * bulk TCP transfer, at write sizes from 64 B to 64 KB.
+ *
+ * Runs the bare metal lwIP core (USE_RTOS=0) with the TCP_HIGH_THROUGHPUT
+ * profile on a simulated millisecond clock. Client and server share one
+ * netif, whose output holds every frame back for 1 ms. The client keeps
+ * writing from a ring of buffers for 2 simulated seconds; with zero-copy, a
+ * buffer is reused only after its completion callback, which first fills it
+ * with garbage, so that a stack still reading it would corrupt the stream.
+ * Prints the host nanoseconds per byte spent in the write calls, and in the
+ * whole run, for both paths at each size.
+ *
+ * Fails if the data arrives corrupted, or if a zero-copy buffer is not
+ * completed exactly once by the end of its connection.
+ *
+ *   make -C host tcp_zc_bench
+ *   host/tcp_zc_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/ip.h"
+#include "lwip/timeouts.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define BENCH_PORT 50000U
+#define BENCH_LINK_FRAMES 4096U
+#define BENCH_MS 2000U
+#define BENCH_BUFS_MAX 1024U
+#define BENCH_PATTERN 251U
+#define BENCH_GARBAGE 0xEEU
+
+/* One frame on the link. */
+typedef struct
+{
+    u32_t due;
+    struct pbuf *p;
+} bench_frame_t;
+
+/* One buffer of the sender. */
+typedef struct
+{
+    u8_t *mem;
+    u32_t off;
+    int busy;
+    uint32_t uses;
+    uint32_t completions;
+    struct tcp_zc zc;
+} bench_buf_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static u32_t s_now;
+static struct netif s_netif;
+static bench_frame_t s_link[BENCH_LINK_FRAMES];
+static uint32_t s_linkHead;
+static uint32_t s_linkTail;
+
+static struct tcp_pcb *s_client;
+static struct tcp_pcb *s_server;
+static bench_buf_t s_bufs[BENCH_BUFS_MAX];
+static uint32_t s_bufCount;
+static int s_current;
+static uint32_t s_size;
+static int s_zeroCopy;
+static uint64_t s_txBytes;
+static uint64_t s_rxBytes;
+static double s_writeNs;
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/* What the bare metal core needs of the port. */
+u32_t sys_now(void)
+{
+    return s_now;
+}
+
+sys_prot_t sys_arch_protect(void)
+{
+    return 0;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+    LWIP_UNUSED_ARG(pval);
+}
+
+void sys_assert(char *msg)
+{
+    printf("FAIL: assertion \"%s\"\n", msg);
+    exit(1);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static err_t bench_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    struct pbuf *copy;
+
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    if (((s_linkTail + 1U) % BENCH_LINK_FRAMES) == s_linkHead)
+    {
+        return ERR_OK;
+    }
+    copy = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
+    if (copy == NULL)
+    {
+        return ERR_MEM;
+    }
+    pbuf_copy(copy, p);
+    s_link[s_linkTail].due = s_now + 1U;
+    s_link[s_linkTail].p = copy;
+    s_linkTail = (s_linkTail + 1U) % BENCH_LINK_FRAMES;
+    return ERR_OK;
+}
+
+static err_t bench_netif_init(struct netif *netif)
+{
+    netif->output = bench_output;
+    netif->mtu = 1500;
+    return ERR_OK;
+}
+
+/* Delivers the frames that are due, or drops all of them. */
+static void link_run(int drop)
+{
+    struct pbuf *p;
+
+    while ((s_linkHead != s_linkTail) && (drop || ((s32_t)(s_link[s_linkHead].due - s_now) <= 0)))
+    {
+        p = s_link[s_linkHead].p;
+        s_linkHead = (s_linkHead + 1U) % BENCH_LINK_FRAMES;
+        if (drop || (s_netif.input(p, &s_netif) != ERR_OK))
+        {
+            pbuf_free(p);
+        }
+    }
+}
+
+static err_t server_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    struct pbuf *q;
+    uint16_t i;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL)
+    {
+        return ERR_OK;
+    }
+    for (q = p; q != NULL; q = q->next)
+    {
+        for (i = 0U; i < q->len; i++)
+        {
+            if ((((u8_t *)q->payload)[i] != (u8_t)((s_rxBytes + i) % BENCH_PATTERN)) && (s_errors++ < 10U))
+            {
+                printf("error: byte %llu is corrupted, %u B %s writes\n", (unsigned long long)(s_rxBytes + i),
+                       (unsigned)s_size, s_zeroCopy ? "zero-copy" : "copied");
+            }
+        }
+        s_rxBytes += q->len;
+    }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static err_t server_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    s_server = pcb;
+    tcp_recv(pcb, server_recv);
+    return ERR_OK;
+}
+
+static void buf_done(void *arg)
+{
+    bench_buf_t *buf = &s_bufs[(uintptr_t)arg];
+
+    /* The stack must not read it any more. */
+    memset(buf->mem, BENCH_GARBAGE, s_size);
+    buf->busy = 0;
+    buf->completions++;
+}
+
+static void client_fill(struct tcp_pcb *pcb)
+{
+    bench_buf_t *buf;
+    uint32_t i;
+    u32_t len;
+    err_t err;
+    double start;
+
+    for (;;)
+    {
+        if (s_current < 0)
+        {
+            for (i = 0U; (i < s_bufCount) && s_bufs[i].busy; i++)
+            {
+            }
+            if (i == s_bufCount)
+            {
+                break;
+            }
+            s_current = (int)i;
+            buf = &s_bufs[i];
+            for (i = 0U; i < s_size; i++)
+            {
+                buf->mem[i] = (u8_t)((s_txBytes + i) % BENCH_PATTERN);
+            }
+            buf->off = 0U;
+            if (s_zeroCopy)
+            {
+                buf->busy = 1;
+                buf->uses++;
+                tcp_zc_init(&buf->zc, buf_done, (void *)(uintptr_t)s_current);
+            }
+        }
+        buf = &s_bufs[s_current];
+
+        len = LWIP_MIN(LWIP_MIN(s_size - buf->off, 0xFFFFU), tcp_sndbuf(pcb));
+        if (len == 0U)
+        {
+            break;
+        }
+        start = now_ns();
+        if (s_zeroCopy)
+        {
+            err = tcp_write_zc(pcb, buf->mem + buf->off, (u16_t)len, TCP_WRITE_FLAG_MORE, &buf->zc);
+        }
+        else
+        {
+            err = tcp_write(pcb, buf->mem + buf->off, (u16_t)len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+        }
+        s_writeNs += now_ns() - start;
+        if (err != ERR_OK)
+        {
+            break;
+        }
+        buf->off += len;
+        if (buf->off == s_size)
+        {
+            s_txBytes += s_size;
+            if (s_zeroCopy)
+            {
+                tcp_zc_release(&buf->zc);
+            }
+            s_current = -1;
+        }
+    }
+    tcp_output(pcb);
+}
+
+static err_t client_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(len);
+
+    client_fill(pcb);
+    return ERR_OK;
+}
+
+static err_t client_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    client_fill(pcb);
+    return ERR_OK;
+}
+
+/* One transfer; returns the host nanoseconds of the whole run. */
+static double bench_run(uint32_t size, int zeroCopy)
+{
+    bench_buf_t *buf;
+    uint32_t i;
+    u32_t end;
+    double start;
+
+    s_size = size;
+    s_zeroCopy = zeroCopy;
+    s_txBytes = 0U;
+    s_rxBytes = 0U;
+    s_writeNs = 0.0;
+    s_current = -1;
+    s_server = NULL;
+    /* Enough buffers to cover the send buffer twice over. */
+    s_bufCount = LWIP_MIN(2U * TCP_SND_BUF / size + 2U, BENCH_BUFS_MAX);
+    for (i = 0U; i < s_bufCount; i++)
+    {
+        s_bufs[i].mem = malloc(size);
+        s_bufs[i].busy = 0;
+        s_bufs[i].uses = 0U;
+        s_bufs[i].completions = 0U;
+        if (s_bufs[i].mem == NULL)
+        {
+            printf("FAIL: out of memory\n");
+            exit(1);
+        }
+    }
+
+    start = now_ns();
+    s_client = tcp_new();
+    tcp_nagle_disable(s_client);
+    tcp_sent(s_client, client_sent);
+    tcp_connect(s_client, &s_netif.ip_addr, BENCH_PORT, client_connected);
+    for (end = s_now + BENCH_MS; s_now != end; s_now++)
+    {
+        link_run(0);
+        sys_check_timeouts();
+    }
+    start = now_ns() - start;
+
+    /* Aborting completes what is still queued; the link gives back the rest. */
+    tcp_abort(s_client);
+    if (s_server != NULL)
+    {
+        tcp_abort(s_server);
+    }
+    link_run(1);
+
+    if (zeroCopy && (s_current >= 0))
+    {
+        /* written in part only: never released */
+        tcp_zc_release(&s_bufs[s_current].zc);
+    }
+    for (i = 0U; i < s_bufCount; i++)
+    {
+        buf = &s_bufs[i];
+        if ((buf->completions != buf->uses) && (s_errors++ < 10U))
+        {
+            printf("error: %u B buffer %u was completed %u times for %u uses\n", (unsigned)size, (unsigned)i,
+                   (unsigned)buf->completions, (unsigned)buf->uses);
+        }
+        free(buf->mem);
+    }
+    return start;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t sizes[] = {64U, 256U, 512U, TCP_MSS, 4096U, 16384U, 65536U};
+    ip4_addr_t ipaddr, netmask, gw;
+    struct tcp_pcb *listener;
+    double copyNs;
+    double copyWriteNs;
+    double zcNs;
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(argc);
+    LWIP_UNUSED_ARG(argv);
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    lwip_init();
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, NULL, bench_netif_init, ip_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+    listener = tcp_new();
+    tcp_bind(listener, IP_ADDR_ANY, BENCH_PORT);
+    listener = tcp_listen(listener);
+    tcp_accept(listener, server_accept);
+
+    printf("%u ms of one bulk transfer per run, 1 ms each way, ns per byte\n", (unsigned)BENCH_MS);
+    printf("%8s %10s %10s %10s %10s %10s %10s\n", "write", "copy MB", "write", "run", "zc MB", "write", "run");
+    for (i = 0U; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        copyNs = bench_run(sizes[i], 0) / (double)s_rxBytes;
+        copyWriteNs = s_writeNs / (double)s_txBytes;
+        printf("%8u %10.1f %10.2f %10.2f", (unsigned)sizes[i], s_rxBytes / 1e6, copyWriteNs, copyNs);
+        zcNs = bench_run(sizes[i], 1) / (double)s_rxBytes;
+        printf(" %10.1f %10.2f %10.2f\n", s_rxBytes / 1e6, s_writeNs / (double)s_txBytes, zcNs);
+    }
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+#
+# Connection churn benchmark for the tcpecho server of the host build.
+#
+# Opens --connections connections, --concurrency at a time. Each one sends
+# --size bytes, waits for the echo, holds the connection for --hold ms and
+# closes it. Reports the connection rate and the connect-to-first-echo
+# latency, which bounds the accept-to-first-byte latency of the server.
+#
+#   make -C host DEFS=-DTCPECHO_WORKER_POOL_SIZE=4
+#   host/lwip_tcpecho_freertos &
+#   host/tcpecho_churn.py --connections 2000 --concurrency 8
+#
+
+import argparse
+import socket
+import threading
+import time
+
+
+def client(args, latencies, failures, lock, remaining):
+    payload = b'e' * args.size
+    while True:
+        with lock:
+            if remaining[0] == 0:
+                return
+            remaining[0] -= 1
+        start = time.monotonic()
+        try:
+            s = socket.create_connection((args.host, args.port), timeout=args.timeout)
+            s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            s.sendall(payload)
+            got = 0
+            while got < len(payload):
+                data = s.recv(len(payload) - got)
+                if not data:
+                    raise ConnectionResetError('closed before the echo')
+                if got == 0:
+                    latency = time.monotonic() - start
+                got += len(data)
+            if args.hold:
+                time.sleep(args.hold / 1000.0)
+            s.close()
+            with lock:
+                latencies.append(latency)
+        except OSError as e:
+            with lock:
+                failures[type(e).__name__] = failures.get(type(e).__name__, 0) + 1
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--host', default='192.168.1.102')
+    parser.add_argument('--port', type=int, default=50000)
+    parser.add_argument('--connections', type=int, default=1000)
+    parser.add_argument('--concurrency', type=int, default=4)
+    parser.add_argument('--size', type=int, default=64)
+    parser.add_argument('--hold', type=float, default=0.0, help='ms to keep each connection open')
+    parser.add_argument('--timeout', type=float, default=5.0)
+    args = parser.parse_args()
+
+    latencies, failures, lock = [], {}, threading.Lock()
+    remaining = [args.connections]
+    threads = [threading.Thread(target=client, args=(args, latencies, failures, lock, remaining))
+               for _ in range(args.concurrency)]
+    start = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - start
+
+    latencies.sort()
+    print('connections %d  concurrency %d  served %d  failed %s' %
+          (args.connections, args.concurrency, len(latencies), failures or 0))
+    print('rate %.0f conn/s' % (len(latencies) / elapsed))
+    if latencies:
+        print('first echo ms  p50 %.2f  p99 %.2f  max %.2f' %
+              (percentile(latencies, 50) * 1e3, percentile(latencies, 99) * 1e3, latencies[-1] * 1e3))
+
+
+if __name__ == '__main__':
+    main()
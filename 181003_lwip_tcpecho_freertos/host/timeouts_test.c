@@ -0,0 +1,416 @@
+/*
+ * lwIP timeouts (lwip/src/core/timeouts.c) against a reference model, and
+ * the cost of many armed timeouts: delta list against the timing wheel of
+ * LWIP_TIMERS_WHEEL.
+ *
+ * The test starts, cancels and lets expire random timeouts, from 0 ms to
+ * beyond the range of the wheel, on a clock that wraps during the run. After
+ * every advance of the clock the model lists what is due, by due time and
+ * then by start order, and sys_check_timeouts() must run exactly those, in
+ * that order; sys_timeouts_sleeptime() must not sleep past the next one.
+ * Fixed cases cover a handler that restarts itself with 0 ms, which runs
+ * again in the same call, and sys_restart_timeouts(), whose skipped time
+ * does not count.
+ *
+ * The bench arms 100 to 5000 timeouts, then restarts random ones
+ * (sys_untimeout() and sys_timeout(), as a connection timer is) and lets
+ * them all expire, and prints the host nanoseconds per restart and per
+ * expiry.
+ *
+ * Fails if a timeout runs early, late, twice, out of order or not at all.
+ *
+ *   make -C host timeouts_test_list timeouts_test_wheel timeouts_test_wheel1024
+ *   host/timeouts_test_wheel [iterations]
+ */
+
+/* sys_check_timeouts() and sys_timeouts_sleeptime() are static with NO_SYS=0. */
+#include "../lwip/src/core/timeouts.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TEST_TIMEOUTS 4000U
+#define TEST_FIRED_MAX 100000U
+
+/* One timeout of the model. */
+typedef struct
+{
+    int armed;
+    u32_t due;
+    u32_t seq;
+} test_timeout_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_iterations = 200000U;
+
+static u32_t s_now;
+#if LWIP_TIMERS_WHEEL
+static test_timeout_t s_model[TEST_TIMEOUTS];
+static u32_t s_modelSeq;
+static uint32_t s_expected[TEST_FIRED_MAX];
+#endif /* LWIP_TIMERS_WHEEL */
+static uint32_t s_fired[TEST_FIRED_MAX];
+static uint32_t s_firedCount;
+static uint32_t s_restarts;
+static uint32_t s_errors;
+
+sys_mutex_t lock_tcpip_core;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+/* What timeouts.c needs of the rest of the stack and of the port. */
+u32_t sys_now(void)
+{
+    return s_now;
+}
+
+void *memp_malloc(memp_t type)
+{
+    LWIP_UNUSED_ARG(type);
+    return malloc(sizeof(struct sys_timeo));
+}
+
+void memp_free(memp_t type, void *mem)
+{
+    LWIP_UNUSED_ARG(type);
+    free(mem);
+}
+
+void sys_mutex_lock(sys_mutex_t *mutex)
+{
+    LWIP_UNUSED_ARG(mutex);
+}
+
+void sys_mutex_unlock(sys_mutex_t *mutex)
+{
+    LWIP_UNUSED_ARG(mutex);
+}
+
+u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
+{
+    LWIP_UNUSED_ARG(mbox);
+    LWIP_UNUSED_ARG(msg);
+    LWIP_UNUSED_ARG(timeout);
+    return 0;
+}
+
+struct tcp_pcb *tcp_active_pcbs;
+struct tcp_pcb *tcp_tw_pcbs;
+
+void tcp_tmr(void)
+{
+}
+
+void ip_reass_tmr(void)
+{
+}
+
+void etharp_tmr(void)
+{
+}
+
+void dhcp_coarse_tmr(void)
+{
+}
+
+void dhcp_fine_tmr(void)
+{
+}
+
+void sys_assert(char *msg)
+{
+    printf("FAIL: assertion \"%s\"\n", msg);
+    exit(1);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void test_error(const char *what, uint32_t iteration)
+{
+    if (s_errors++ < 10U)
+    {
+        printf("error: %s at iteration %u\n", what, (unsigned)iteration);
+    }
+}
+
+static void fired(void *arg)
+{
+    if (s_firedCount < TEST_FIRED_MAX)
+    {
+        s_fired[s_firedCount] = (uint32_t)(uintptr_t)arg;
+    }
+    s_firedCount++;
+}
+
+static void restart_self(void *arg)
+{
+    fired(arg);
+    if (++s_restarts < 5U)
+    {
+        sys_timeout(0, restart_self, arg);
+    }
+}
+
+static void test_fixed(void)
+{
+    s_now = 5U;
+    sys_restart_timeouts();
+    s_restarts = 0U;
+    s_firedCount = 0U;
+    sys_timeout(10, restart_self, NULL);
+    s_now = 15U;
+    sys_check_timeouts();
+    if (s_firedCount != 5U)
+    {
+        test_error("a 0 ms restart from a handler did not run in the same call", 0U);
+    }
+
+    /* The time up to sys_restart_timeouts() is skipped. */
+    s_restarts = 0U;
+    s_firedCount = 0U;
+    sys_timeout(1, restart_self, NULL);
+    s_now = 1000U;
+    sys_restart_timeouts();
+    sys_check_timeouts();
+    if (s_firedCount != 0U)
+    {
+        test_error("a timeout ran on time skipped by sys_restart_timeouts()", 0U);
+    }
+    s_now = 1001U;
+    sys_check_timeouts();
+    if (s_firedCount != 5U)
+    {
+        test_error("a timeout did not run after sys_restart_timeouts()", 0U);
+    }
+}
+
+#if LWIP_TIMERS_WHEEL
+/* A second handler: sys_untimeout() matches on the handler as well. */
+static void fired2(void *arg)
+{
+    fired(arg);
+}
+
+static u32_t random_msecs(void)
+{
+    if ((rand() % 500) == 0)
+    {
+        /* beyond the 2^25 ms of the wheel */
+        return 40000000U;
+    }
+    switch (rand() % 6)
+    {
+        case 0:
+        case 1:
+            return (u32_t)(rand() % 5);
+        case 2:
+            return (u32_t)(rand() % 100000);
+        default:
+            return (u32_t)(rand() % 3000);
+    }
+}
+
+/* Takes the due timeouts out of the model, first due and first started first. */
+static uint32_t model_expire(void)
+{
+    uint32_t count = 0U;
+    int best;
+    uint32_t i;
+
+    for (;;)
+    {
+        best = -1;
+        for (i = 0U; i < TEST_TIMEOUTS; i++)
+        {
+            if (s_model[i].armed && ((s32_t)(s_model[i].due - s_now) <= 0) &&
+                ((best < 0) || ((s32_t)(s_model[i].due - s_model[best].due) < 0) ||
+                 ((s_model[i].due == s_model[best].due) && ((s32_t)(s_model[i].seq - s_model[best].seq) < 0))))
+            {
+                best = (int)i;
+            }
+        }
+        if (best < 0)
+        {
+            return count;
+        }
+        s_model[best].armed = 0;
+        if (count < TEST_FIRED_MAX)
+        {
+            s_expected[count] = (uint32_t)best;
+        }
+        count++;
+    }
+}
+
+static void test_model(void)
+{
+    uint32_t nextId = 0U;
+    uint32_t expected;
+    uint32_t it;
+    uint32_t id;
+    uint32_t i;
+    u32_t msecs;
+    u32_t sleep;
+    int next;
+
+    srand(1);
+    /* The clock wraps a few seconds in. */
+    s_now = 0xFFFFF000U;
+    sys_restart_timeouts();
+    for (it = 0U; it < s_iterations; it++)
+    {
+        switch (rand() % 10)
+        {
+            case 0:
+            case 1:
+            case 2:
+            case 3:
+            case 4:
+                msecs = random_msecs();
+                id = nextId++ % TEST_TIMEOUTS;
+                if (!s_model[id].armed)
+                {
+                    s_model[id].armed = 1;
+                    s_model[id].due = s_now + msecs;
+                    s_model[id].seq = s_modelSeq++;
+                    sys_timeout(msecs, (id & 1U) ? fired : fired2, (void *)(uintptr_t)id);
+                }
+                break;
+            case 5:
+                id = (uint32_t)rand() % TEST_TIMEOUTS;
+                if (s_model[id].armed)
+                {
+                    s_model[id].armed = 0;
+                    sys_untimeout((id & 1U) ? fired : fired2, (void *)(uintptr_t)id);
+                }
+                break;
+            default:
+                s_now += ((rand() % 3) == 0) ? (u32_t)(rand() % 5000) : (u32_t)(rand() % 50);
+                expected = model_expire();
+                s_firedCount = 0U;
+                sys_check_timeouts();
+                if (s_firedCount != expected)
+                {
+                    test_error("a different number of timeouts ran", it);
+                }
+                for (i = 0U; (i < expected) && (i < s_firedCount) && (i < TEST_FIRED_MAX); i++)
+                {
+                    if (s_fired[i] != s_expected[i])
+                    {
+                        test_error("timeouts ran out of order", it);
+                        break;
+                    }
+                }
+
+                sleep = sys_timeouts_sleeptime();
+                next = -1;
+                for (i = 0U; i < TEST_TIMEOUTS; i++)
+                {
+                    if (s_model[i].armed && ((next < 0) || ((s32_t)(s_model[i].due - s_model[next].due) < 0)))
+                    {
+                        next = (int)i;
+                    }
+                }
+                if ((next >= 0) ? (sleep > s_model[next].due - s_now) : (sleep != 0xFFFFFFFFU))
+                {
+                    test_error("sys_timeouts_sleeptime() sleeps past the next timeout", it);
+                }
+                break;
+        }
+    }
+
+    /* Leave nothing armed for the bench. */
+    for (i = 0U; i < TEST_TIMEOUTS; i++)
+    {
+        if (s_model[i].armed)
+        {
+            s_model[i].armed = 0;
+            sys_untimeout((i & 1U) ? fired : fired2, (void *)(uintptr_t)i);
+        }
+    }
+}
+#endif /* LWIP_TIMERS_WHEEL */
+
+static void bench(void)
+{
+    static const uint32_t counts[] = {100U, 1000U, 5000U};
+    uint32_t rounds = 200000U;
+    uint32_t c;
+    uint32_t i;
+    uint32_t id;
+    double restart;
+    double expire;
+
+    printf("%s, %u hash buckets, ns per call\n", LWIP_TIMERS_WHEEL ? "timing wheel" : "delta list",
+           LWIP_TIMERS_WHEEL ? (unsigned)TIMERS_WHEEL_HASH_SIZE : 0U);
+    printf("%8s %10s %10s\n", "armed", "restart", "expiry");
+    for (c = 0U; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        srand(2);
+        for (i = 0U; i < counts[c]; i++)
+        {
+            sys_timeout(1U + (u32_t)(rand() % 60000), fired, (void *)(uintptr_t)i);
+        }
+
+        restart = now_ns();
+        for (i = 0U; i < rounds; i++)
+        {
+            id = (uint32_t)rand() % counts[c];
+            sys_untimeout(fired, (void *)(uintptr_t)id);
+            sys_timeout(1U + (u32_t)(rand() % 60000), fired, (void *)(uintptr_t)id);
+        }
+        restart = (now_ns() - restart) / rounds;
+
+        s_firedCount = 0U;
+        s_now += 60001U;
+        expire = now_ns();
+        sys_check_timeouts();
+        expire = (now_ns() - expire) / counts[c];
+        if (s_firedCount != counts[c])
+        {
+            test_error("the bench timeouts did not all run", 0U);
+        }
+        printf("%8u %10.0f %10.0f\n", (unsigned)counts[c], restart, expire);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_iterations = strtoul(argv[1], NULL, 0);
+    }
+
+    test_fixed();
+#if LWIP_TIMERS_WHEEL
+    test_model();
+    printf("%u iterations against the model: %u errors\n", (unsigned)s_iterations, (unsigned)s_errors);
+#else
+    /* The delta list counts from the last expiry rather than from sys_now(),
+       and files a timeout started between checks by msecs alone: it runs them
+       out of the order of the model, so only the fixed cases apply to it. */
+    printf("fixed cases: %u errors\n", (unsigned)s_errors);
+#endif
+    if (s_errors != 0U)
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    bench();
+    return (s_errors != 0U) ? 1 : 0;
+}
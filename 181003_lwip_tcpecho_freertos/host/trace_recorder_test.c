@@ -0,0 +1,271 @@
+/*
+ * Trace recorder (common/trace_recorder.c) written from two contexts at once.
+ *
+ * A task and an interrupt share the ring of the target with nothing but the
+ * atomic slot reservation between them. Here the task is the main thread,
+ * recording events as fast as it can, and the interrupt a signal handler
+ * that a 20 us interval timer runs in the middle of it and that records a few
+ * events each time; then two threads record at once, which on a host with
+ * more than one CPU contend for the slots for real. Each context numbers its
+ * own events. The ring holds all of them, and afterwards every slot must hold
+ * one whole event, each context's events must all be there once and in the
+ * order it recorded them, and their timestamps must not go back. The
+ * overwrite part records past the end of the ring and checks that the ring
+ * holds the newest events. Prints the host nanoseconds per event of one
+ * thread alone and of two at once.
+ *
+ * Fails if an event is lost, duplicated, torn, out of order or out of time.
+ *
+ *   make -C host trace_recorder_test
+ *   host/trace_recorder_test [events]
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "FreeRTOSConfig.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define TEST_EVENTS_MAX (TRACE_RECORDER_EVENTS / 2U - 64U)
+#define TEST_IRQ_EVENTS 4U
+#define TEST_IRQ_US 20
+
+/* One recording thread: the event type it records and how many. */
+typedef struct
+{
+    uint8_t type;
+    uint32_t events;
+    double ns;
+} test_thread_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_events = 200000U;
+
+static volatile int s_go;
+static volatile uint32_t s_irqEvents;
+static uint32_t s_errors;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void test_error(const char *what, uint32_t slot)
+{
+    if (s_errors++ < 10U)
+    {
+        printf("error: %s at slot %u\n", what, (unsigned)slot);
+    }
+}
+
+static void *record_thread(void *arg)
+{
+    test_thread_t *thread = arg;
+    double start;
+    uint32_t i;
+
+    while (!s_go)
+    {
+    }
+    start = now_ns();
+    for (i = 0U; i < thread->events; i++)
+    {
+        trace_record(thread->type, (uint16_t)i);
+    }
+    thread->ns = (now_ns() - start) / thread->events;
+    return NULL;
+}
+
+static void irq_handler(int sig)
+{
+    uint32_t i;
+
+    (void)sig;
+    for (i = 0U; (i < TEST_IRQ_EVENTS) && (s_irqEvents < TEST_EVENTS_MAX); i++)
+    {
+        trace_record(TRACE_EV_QUEUE_SEND_FROM_ISR, (uint16_t)s_irqEvents++);
+    }
+}
+
+/* Checks the events of one context in slots first to last of the ring. */
+static void check_thread(uint8_t type, uint32_t first, uint32_t last, uint16_t seq, uint32_t expected)
+{
+    struct trace_event *ev;
+    uint32_t found = 0U;
+    uint32_t ts = 0U;
+    uint32_t slot;
+
+    for (slot = first; slot != last; slot++)
+    {
+        ev = &trace_recorder.ring[slot & (TRACE_RECORDER_EVENTS - 1U)];
+        if (ev->type != type)
+        {
+            continue;
+        }
+        if (ev->obj != seq)
+        {
+            test_error("an event out of order, lost or duplicated", slot);
+            seq = ev->obj;
+        }
+        if ((found != 0U) && ((int32_t)(ev->ts - ts) < 0))
+        {
+            test_error("a timestamp going back", slot);
+        }
+        ts = ev->ts;
+        seq++;
+        found++;
+    }
+    if (found != expected)
+    {
+        printf("error: %u of %u events of type %u in the ring\n", (unsigned)found, (unsigned)expected,
+               (unsigned)type);
+        s_errors++;
+    }
+}
+
+/* Every slot up to the index holds one whole event of either type. */
+static void check_slots(uint32_t expected)
+{
+    uint32_t slot;
+
+    if (trace_recorder.index != expected)
+    {
+        printf("error: %u events recorded of %u\n", (unsigned)trace_recorder.index, (unsigned)expected);
+        s_errors++;
+    }
+    for (slot = 0U; slot != trace_recorder.index; slot++)
+    {
+        if ((trace_recorder.ring[slot].type != TRACE_EV_QUEUE_SEND) &&
+            (trace_recorder.ring[slot].type != TRACE_EV_QUEUE_SEND_FROM_ISR))
+        {
+            test_error("a slot without a whole event", slot);
+        }
+    }
+}
+
+static void test_interrupt(void)
+{
+    struct itimerval timer;
+    struct sigaction sa;
+    uint32_t i;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = irq_handler;
+    sigaction(SIGALRM, &sa, NULL);
+    memset(&timer, 0, sizeof(timer));
+    timer.it_interval.tv_usec = TEST_IRQ_US;
+    timer.it_value.tv_usec = TEST_IRQ_US;
+
+    trace_recorder_clear();
+    s_irqEvents = 0U;
+    setitimer(ITIMER_REAL, &timer, NULL);
+    for (i = 0U; i < s_events; i++)
+    {
+        trace_record(TRACE_EV_QUEUE_SEND, (uint16_t)i);
+    }
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_REAL, &timer, NULL);
+    printf("interrupt:   %u events in %u interrupts\n", (unsigned)s_irqEvents,
+           (unsigned)((s_irqEvents + TEST_IRQ_EVENTS - 1U) / TEST_IRQ_EVENTS));
+
+    check_slots(s_events + s_irqEvents);
+    check_thread(TRACE_EV_QUEUE_SEND, 0U, trace_recorder.index, 0U, s_events);
+    check_thread(TRACE_EV_QUEUE_SEND_FROM_ISR, 0U, trace_recorder.index, 0U, s_irqEvents);
+}
+
+static void test_two_threads(void)
+{
+    test_thread_t threads[2] = {{TRACE_EV_QUEUE_SEND, 0U, 0.0}, {TRACE_EV_QUEUE_SEND_FROM_ISR, 0U, 0.0}};
+    pthread_t ids[2];
+    int i;
+
+    /* One thread alone, for the cost of an uncontended event. */
+    trace_recorder_clear();
+    threads[0].events = s_events;
+    s_go = 1;
+    record_thread(&threads[0]);
+    printf("one thread:  %.1f ns per event\n", threads[0].ns);
+
+    trace_recorder_clear();
+    s_go = 0;
+    for (i = 0; i < 2; i++)
+    {
+        threads[i].events = s_events;
+        if (pthread_create(&ids[i], NULL, record_thread, &threads[i]) != 0)
+        {
+            printf("FAIL: no thread\n");
+            exit(1);
+        }
+    }
+    s_go = 1;
+    for (i = 0; i < 2; i++)
+    {
+        pthread_join(ids[i], NULL);
+    }
+    printf("two threads: %.1f and %.1f ns per event\n", threads[0].ns, threads[1].ns);
+
+    check_slots(2U * s_events);
+    for (i = 0; i < 2; i++)
+    {
+        check_thread(threads[i].type, 0U, trace_recorder.index, 0U, s_events);
+    }
+}
+
+static void test_overwrite(void)
+{
+    uint32_t total = 3U * TRACE_RECORDER_EVENTS + 17U;
+    uint32_t i;
+
+    trace_recorder_clear();
+    for (i = 0U; i < total; i++)
+    {
+        trace_record(TRACE_EV_QUEUE_RECEIVE, (uint16_t)i);
+    }
+    /* The oldest event left is total - TRACE_RECORDER_EVENTS. */
+    check_thread(TRACE_EV_QUEUE_RECEIVE, total - TRACE_RECORDER_EVENTS, total,
+                 (uint16_t)(total - TRACE_RECORDER_EVENTS), TRACE_RECORDER_EVENTS);
+}
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (argc > 1)
+    {
+        s_events = strtoul(argv[1], NULL, 0);
+    }
+    if ((s_events == 0U) || (s_events > TEST_EVENTS_MAX))
+    {
+        fprintf(stderr, "usage: %s [events], at most %u\n", argv[0], (unsigned)TEST_EVENTS_MAX);
+        return 2;
+    }
+
+    trace_recorder_init();
+    printf("%u events per thread, %u slots, init measured %u ns per event\n", (unsigned)s_events,
+           (unsigned)TRACE_RECORDER_EVENTS, (unsigned)trace_recorder.cycles_per_event);
+    test_interrupt();
+    test_two_threads();
+    test_overwrite();
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        return 1;
+    }
+    return 0;
+}
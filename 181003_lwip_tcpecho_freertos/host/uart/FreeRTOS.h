@@ -0,0 +1,43 @@
+/*
+ * FreeRTOS of the debug console test: the kernel calls the debug console
+ * makes, on the simulated CPU of uart_model.c. There is one task, the test;
+ * vTaskDelay() lets the simulated time run on while the UART sends, and the
+ * stream buffer is a plain ring that the UART receive interrupt fills.
+ * task.h, semphr.h and stream_buffer.h all come here.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+typedef struct uart_model_stream *StreamBufferHandle_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portYIELD_FROM_ISR(x) ((void)(x))
+#define configTICK_RATE_HZ ((TickType_t)1000)
+
+#define taskSCHEDULER_SUSPENDED ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING ((BaseType_t)2)
+
+void vTaskDelay(const TickType_t xTicksToDelay);
+BaseType_t xTaskGetSchedulerState(void);
+
+StreamBufferHandle_t xStreamBufferCreate(size_t xBufferSizeBytes, size_t xTriggerLevelBytes);
+BaseType_t xStreamBufferReset(StreamBufferHandle_t xStreamBuffer);
+size_t xStreamBufferSendFromISR(StreamBufferHandle_t xStreamBuffer,
+                                const void *pvTxData,
+                                size_t xDataLengthBytes,
+                                BaseType_t *const pxHigherPriorityTaskWoken);
+size_t xStreamBufferReceive(StreamBufferHandle_t xStreamBuffer,
+                            void *pvRxData,
+                            size_t xBufferLengthBytes,
+                            TickType_t xTicksToWait);
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,119 @@
+/*
+ * fsl_common.h of the debug console test: the SDK and device header subset
+ * that utilities/fsl_io.c and the rest of the debug console use, with the
+ * interrupt mask, IPSR and NVIC of a simulated CPU (uart_model.c) in place of
+ * the Cortex-M core.
+ *
+ * The memcpy() calls of the files that include this header are counted in
+ * uart_model_masked while interrupts are disabled, so a test can tell how
+ * many bytes a critical section copies. An interrupt armed with
+ * uart_model_preempt() runs right after the next memcpy() made with
+ * interrupts enabled, as if it had come in the middle of the copy.
+ */
+
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * fsl_common.h subset
+ ******************************************************************************/
+typedef int32_t status_t;
+
+#define MAKE_STATUS(group, code) ((((group)*100) + (code)))
+#define kStatusGroup_Generic 0
+#define kStatusGroup_UART 10
+
+enum _generic_status
+{
+    kStatus_Success = MAKE_STATUS(kStatusGroup_Generic, 0),
+    kStatus_Fail = MAKE_STATUS(kStatusGroup_Generic, 1),
+    kStatus_ReadOnly = MAKE_STATUS(kStatusGroup_Generic, 2),
+    kStatus_OutOfRange = MAKE_STATUS(kStatusGroup_Generic, 3),
+    kStatus_InvalidArgument = MAKE_STATUS(kStatusGroup_Generic, 4),
+};
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define DEBUG_CONSOLE_DEVICE_TYPE_NONE 0U
+#define DEBUG_CONSOLE_DEVICE_TYPE_LPSCI 1U
+#define DEBUG_CONSOLE_DEVICE_TYPE_UART 2U
+#define DEBUG_CONSOLE_DEVICE_TYPE_LPUART 3U
+#define DEBUG_CONSOLE_DEVICE_TYPE_USBCDC 4U
+#define DEBUG_CONSOLE_DEVICE_TYPE_FLEXCOMM 5U
+#define DEBUG_CONSOLE_DEVICE_TYPE_IUART 6U
+#define DEBUG_CONSOLE_DEVICE_TYPE_VUSART 7U
+#define DEBUG_CONSOLE_DEVICE_TYPE_SWO 8U
+
+/*******************************************************************************
+ * MK64F12.h subset
+ ******************************************************************************/
+#define FSL_FEATURE_SOC_UART_COUNT (6)
+
+typedef enum IRQn
+{
+    UART0_RX_TX_IRQn = 31,
+    UART1_RX_TX_IRQn = 33,
+    UART2_RX_TX_IRQn = 35,
+    UART3_RX_TX_IRQn = 37,
+    UART4_RX_TX_IRQn = 66,
+    UART5_RX_TX_IRQn = 68,
+} IRQn_Type;
+
+#define UART0_BASE (0x4006A000u)
+#define UART1_BASE (0x4006B000u)
+#define UART2_BASE (0x4006C000u)
+#define UART3_BASE (0x4006D000u)
+#define UART4_BASE (0x400EA000u)
+#define UART5_BASE (0x400EB000u)
+#define UART_BASE_ADDRS {UART0_BASE, UART1_BASE, UART2_BASE, UART3_BASE, UART4_BASE, UART5_BASE}
+#define UART_RX_TX_IRQS \
+    {UART0_RX_TX_IRQn, UART1_RX_TX_IRQn, UART2_RX_TX_IRQn, UART3_RX_TX_IRQn, UART4_RX_TX_IRQn, UART5_RX_TX_IRQn}
+
+/*******************************************************************************
+ * Simulated CPU, see uart_model.c
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+uint32_t DisableGlobalIRQ(void);
+/* Re-enabling interrupts takes a pending UART interrupt at once, as on the target. */
+void EnableGlobalIRQ(uint32_t primask);
+uint32_t __get_IPSR(void);
+uint32_t NVIC_GetActive(IRQn_Type irq);
+void DisableIRQ(IRQn_Type irq);
+
+#define NVIC_SetPriority(irq, priority) ((void)(irq), (void)(priority))
+
+/* Bytes copied by memcpy() in the current, or the longest, critical section. */
+extern uint32_t uart_model_masked;
+extern uint32_t uart_model_masked_max;
+
+void uart_model_copied(size_t size);
+
+static inline void *uart_model_memcpy(void *dst, const void *src, size_t size)
+{
+    (memcpy)(dst, src, size);
+    uart_model_copied(size);
+    return dst;
+}
+
+#define memcpy(dst, src, size) uart_model_memcpy((dst), (src), (size))
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _FSL_COMMON_H_ */
@@ -0,0 +1,119 @@
+/*
+ * UART driver of the debug console test: the K64F SDK driver API that
+ * utilities/fsl_io.c uses, on top of a model of the UART (uart_model.c)
+ * instead of the registers. The handle and the transactional calls behave as
+ * in drivers/fsl_uart.c; the device side of the model shifts bytes out of the
+ * transmit FIFO at the baud rate and receives characters for the test, see
+ * uart_model.h.
+ */
+
+#ifndef _FSL_UART_H_
+#define _FSL_UART_H_
+
+#include "fsl_common.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/* Never dereferenced, UART0 and friends are the addresses of MK64F12.h. */
+typedef struct
+{
+    uint8_t D;
+} UART_Type;
+
+#define UART0 ((UART_Type *)UART0_BASE)
+
+#define FSL_FEATURE_UART_FIFO_SIZEn(x) (8)
+
+enum _uart_status
+{
+    kStatus_UART_TxBusy = MAKE_STATUS(kStatusGroup_UART, 0),
+    kStatus_UART_RxBusy = MAKE_STATUS(kStatusGroup_UART, 1),
+    kStatus_UART_TxIdle = MAKE_STATUS(kStatusGroup_UART, 2),
+    kStatus_UART_RxIdle = MAKE_STATUS(kStatusGroup_UART, 3),
+    kStatus_UART_RxHardwareOverrun = MAKE_STATUS(kStatusGroup_UART, 9),
+    kStatus_UART_NoiseError = MAKE_STATUS(kStatusGroup_UART, 10),
+    kStatus_UART_FramingError = MAKE_STATUS(kStatusGroup_UART, 11),
+    kStatus_UART_ParityError = MAKE_STATUS(kStatusGroup_UART, 12),
+};
+
+enum _uart_flags
+{
+    kUART_TxDataRegEmptyFlag = (1U << 7),
+    kUART_TransmissionCompleteFlag = (1U << 6),
+};
+
+typedef struct _uart_config
+{
+    uint32_t baudRate_Bps;
+    uint8_t txFifoWatermark;
+    uint8_t rxFifoWatermark;
+    bool enableTx;
+    bool enableRx;
+} uart_config_t;
+
+typedef struct _uart_transfer
+{
+    uint8_t *data;
+    size_t dataSize;
+} uart_transfer_t;
+
+typedef struct _uart_handle uart_handle_t;
+
+typedef void (*uart_transfer_callback_t)(UART_Type *base, uart_handle_t *handle, status_t status, void *userData);
+
+struct _uart_handle
+{
+    uint8_t *volatile txData;
+    volatile size_t txDataSize;
+    size_t txDataSizeAll;
+    uint8_t *volatile rxData;
+    volatile size_t rxDataSize;
+    size_t rxDataSizeAll;
+
+    uint8_t *rxRingBuffer;
+    size_t rxRingBufferSize;
+    volatile uint16_t rxRingBufferHead;
+    volatile uint16_t rxRingBufferTail;
+
+    uart_transfer_callback_t callback;
+    void *userData;
+
+    volatile uint8_t txState;
+    volatile uint8_t rxState;
+};
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void UART_GetDefaultConfig(uart_config_t *config);
+status_t UART_Init(UART_Type *base, const uart_config_t *config, uint32_t srcClock_Hz);
+void UART_Deinit(UART_Type *base);
+uint32_t UART_GetInstance(UART_Type *base);
+void UART_EnableTx(UART_Type *base, bool enable);
+void UART_EnableRx(UART_Type *base, bool enable);
+uint32_t UART_GetStatusFlags(UART_Type *base);
+void UART_WriteBlocking(UART_Type *base, const uint8_t *data, size_t length);
+status_t UART_ReadBlocking(UART_Type *base, uint8_t *data, size_t length);
+
+void UART_TransferCreateHandle(UART_Type *base,
+                               uart_handle_t *handle,
+                               uart_transfer_callback_t callback,
+                               void *userData);
+status_t UART_TransferSendNonBlocking(UART_Type *base, uart_handle_t *handle, uart_transfer_t *xfer);
+status_t UART_TransferReceiveNonBlocking(UART_Type *base,
+                                         uart_handle_t *handle,
+                                         uart_transfer_t *xfer,
+                                         size_t *receivedBytes);
+void UART_TransferAbortSend(UART_Type *base, uart_handle_t *handle);
+void UART_TransferAbortReceive(UART_Type *base, uart_handle_t *handle);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _FSL_UART_H_ */
@@ -0,0 +1,2 @@
+/* See FreeRTOS.h. */
+#include "FreeRTOS.h"
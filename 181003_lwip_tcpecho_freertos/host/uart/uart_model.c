@@ -0,0 +1,556 @@
+/*
+ * UART model of the debug console test, see uart_model.h. The driver
+ * functions follow drivers/fsl_uart.c for the calls the debug console makes,
+ * with the FIFO, the transmit interrupt and the CPU simulated.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fsl_uart.h"
+#include "uart_model.h"
+
+#include "FreeRTOS.h"
+
+#define UART_MODEL_OUTPUT_MAX (1U << 20)
+/* IPSR of the UART interrupt and of the interrupts the test runs. */
+#define UART_MODEL_UART_IPSR (16U + (uint32_t)UART0_RX_TX_IRQn)
+#define UART_MODEL_OTHER_IPSR (16U + 1U)
+
+/* The driver's transfer states. */
+enum
+{
+    kUART_TxIdle,
+    kUART_TxBusy,
+    kUART_RxIdle,
+    kUART_RxBusy,
+};
+
+struct uart_model_stream
+{
+    uint8_t *data;
+    size_t size;
+    size_t head;
+    size_t tail;
+};
+
+uint32_t uart_model_masked;
+uint32_t uart_model_masked_max;
+
+static struct
+{
+    uart_handle_t *handle;
+    UART_Type *base;
+    double byteNs;
+    double now;
+    double shiftEnd;  /* when the shift register is done with its byte */
+    uint32_t fifo;    /* bytes waiting in the transmit FIFO */
+    bool shifting;
+    bool irqEnabled;
+    bool tie;         /* transmit data register empty interrupt enabled */
+    bool masked;      /* PRIMASK */
+    bool uartActive;  /* the UART interrupt is active in the NVIC */
+    uint32_t ipsr;
+    bool running;
+    void (*preempt)(void);
+    uart_model_stats_t stats;
+} s_uart = {.byteNs = 1e10 / 115200};
+
+static uint8_t s_output[UART_MODEL_OUTPUT_MAX];
+static uint32_t s_outputLength;
+
+/*******************************************************************************
+ * Device
+ ******************************************************************************/
+static double host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void uart_push(uint8_t c)
+{
+    if (s_outputLength == UART_MODEL_OUTPUT_MAX)
+    {
+        printf("FAIL: more than %u bytes sent\n", (unsigned)UART_MODEL_OUTPUT_MAX);
+        exit(1);
+    }
+    s_output[s_outputLength++] = c;
+    if (!s_uart.shifting)
+    {
+        s_uart.shifting = true;
+        s_uart.shiftEnd = s_uart.now + s_uart.byteNs;
+    }
+    else
+    {
+        assert(s_uart.fifo < (uint32_t)FSL_FEATURE_UART_FIFO_SIZEn(s_uart.base));
+        s_uart.fifo++;
+    }
+}
+
+/* Transmit part of UART_TransferHandleIRQ(). */
+static void uart_tx_irq(void)
+{
+    uart_handle_t *handle = s_uart.handle;
+    uint32_t savedIpsr = s_uart.ipsr;
+    double start = host_ns();
+    size_t count;
+    size_t tempCount;
+
+    s_uart.ipsr = UART_MODEL_UART_IPSR;
+    s_uart.uartActive = true;
+
+    count = FSL_FEATURE_UART_FIFO_SIZEn(s_uart.base) - s_uart.fifo;
+    while ((count) && (handle->txDataSize))
+    {
+        tempCount = MIN(handle->txDataSize, count);
+        for (size_t i = 0U; i < tempCount; i++)
+        {
+            uart_push(handle->txData[i]);
+        }
+        handle->txData += tempCount;
+        handle->txDataSize -= tempCount;
+        count -= tempCount;
+
+        if (!handle->txDataSize)
+        {
+            handle->txState = kUART_TxIdle;
+            s_uart.tie = false;
+            if (handle->callback)
+            {
+                handle->callback(s_uart.base, handle, kStatus_UART_TxIdle, handle->userData);
+            }
+        }
+    }
+
+    s_uart.uartActive = false;
+    s_uart.ipsr = savedIpsr;
+    s_uart.stats.txIsrCalls++;
+    s_uart.stats.txIsrHostNs += host_ns() - start;
+}
+
+/* Takes the transmit interrupt while it is pending and the CPU lets it in.
+ * TDRE is set when the FIFO holds no more than the watermark of 0. */
+static void uart_service(void)
+{
+    while (s_uart.irqEnabled && s_uart.tie && (s_uart.fifo == 0U) && !s_uart.masked && (s_uart.ipsr == 0U))
+    {
+        uart_tx_irq();
+    }
+}
+
+void uart_model_advance(double ns)
+{
+    double end = s_uart.now + ns;
+
+    uart_service();
+    while (s_uart.shifting && (s_uart.shiftEnd <= end))
+    {
+        s_uart.now = s_uart.shiftEnd;
+        if (s_uart.fifo != 0U)
+        {
+            s_uart.fifo--;
+            s_uart.shiftEnd += s_uart.byteNs;
+        }
+        else
+        {
+            s_uart.shifting = false;
+        }
+        uart_service();
+    }
+    s_uart.now = MAX(s_uart.now, end);
+    uart_service();
+}
+
+double uart_model_now(void)
+{
+    return s_uart.now;
+}
+
+/* Lets the time run on to the end of the byte shifting, for a CPU polling the UART. */
+static void uart_poll(void)
+{
+    double ns = s_uart.shiftEnd - s_uart.now;
+
+    s_uart.stats.pollingNs += ns;
+    uart_model_advance(ns);
+}
+
+void uart_model_receive(uint8_t c)
+{
+    uart_handle_t *handle = s_uart.handle;
+    uint32_t savedIpsr = s_uart.ipsr;
+
+    s_uart.ipsr = UART_MODEL_UART_IPSR;
+    s_uart.uartActive = true;
+    if ((handle != NULL) && (handle->rxDataSize))
+    {
+        *handle->rxData++ = c;
+        handle->rxDataSize--;
+        if (!handle->rxDataSize)
+        {
+            handle->rxState = kUART_RxIdle;
+            if (handle->callback)
+            {
+                handle->callback(s_uart.base, handle, kStatus_UART_RxIdle, handle->userData);
+            }
+        }
+    }
+    else
+    {
+        s_uart.stats.rxOverruns++;
+    }
+    s_uart.uartActive = false;
+    s_uart.ipsr = savedIpsr;
+    uart_service();
+}
+
+void uart_model_interrupt(void (*handler)(void), bool uartActive)
+{
+    uint32_t savedIpsr = s_uart.ipsr;
+    bool savedActive = s_uart.uartActive;
+
+    s_uart.ipsr = UART_MODEL_OTHER_IPSR;
+    s_uart.uartActive = savedActive || uartActive;
+    handler();
+    s_uart.uartActive = savedActive;
+    s_uart.ipsr = savedIpsr;
+    uart_service();
+}
+
+void uart_model_preempt(void (*handler)(void))
+{
+    s_uart.preempt = handler;
+}
+
+void uart_model_set_scheduler(bool running)
+{
+    s_uart.running = running;
+}
+
+const uint8_t *uart_model_output(uint32_t *length)
+{
+    *length = s_outputLength;
+    return s_output;
+}
+
+void uart_model_get_stats(uart_model_stats_t *stats)
+{
+    *stats = s_uart.stats;
+}
+
+/*******************************************************************************
+ * CPU
+ ******************************************************************************/
+uint32_t DisableGlobalIRQ(void)
+{
+    uint32_t primask = s_uart.masked ? 1U : 0U;
+
+    if (!s_uart.masked)
+    {
+        uart_model_masked = 0U;
+    }
+    s_uart.masked = true;
+    return primask;
+}
+
+void EnableGlobalIRQ(uint32_t primask)
+{
+    s_uart.masked = (primask != 0U);
+    if (!s_uart.masked)
+    {
+        uart_model_masked_max = MAX(uart_model_masked_max, uart_model_masked);
+        uart_service();
+    }
+}
+
+uint32_t __get_IPSR(void)
+{
+    return s_uart.ipsr;
+}
+
+uint32_t NVIC_GetActive(IRQn_Type irq)
+{
+    return ((irq == UART0_RX_TX_IRQn) && s_uart.uartActive) ? 1U : 0U;
+}
+
+void DisableIRQ(IRQn_Type irq)
+{
+    if (irq == UART0_RX_TX_IRQn)
+    {
+        s_uart.irqEnabled = false;
+    }
+}
+
+void uart_model_copied(size_t size)
+{
+    void (*handler)(void) = s_uart.preempt;
+
+    if (s_uart.masked)
+    {
+        uart_model_masked += size;
+    }
+    else if (handler != NULL)
+    {
+        s_uart.preempt = NULL;
+        uart_model_interrupt(handler, false);
+    }
+    else
+    {
+    }
+}
+
+/*******************************************************************************
+ * Driver
+ ******************************************************************************/
+void UART_GetDefaultConfig(uart_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->baudRate_Bps = 115200U;
+    config->txFifoWatermark = 0U;
+    config->rxFifoWatermark = 1U;
+}
+
+status_t UART_Init(UART_Type *base, const uart_config_t *config, uint32_t srcClock_Hz)
+{
+    (void)srcClock_Hz;
+
+    assert(config->txFifoWatermark == 0U);
+    s_uart.base = base;
+    /* start bit, 8 data bits, stop bit */
+    s_uart.byteNs = 1e10 / config->baudRate_Bps;
+    return kStatus_Success;
+}
+
+void UART_Deinit(UART_Type *base)
+{
+    (void)base;
+}
+
+uint32_t UART_GetInstance(UART_Type *base)
+{
+    static const uint32_t s_uartBases[] = UART_BASE_ADDRS;
+    uint32_t instance;
+
+    for (instance = 0U; instance < (sizeof(s_uartBases) / sizeof(s_uartBases[0])); instance++)
+    {
+        if ((uintptr_t)base == s_uartBases[instance])
+        {
+            break;
+        }
+    }
+    assert(instance < (sizeof(s_uartBases) / sizeof(s_uartBases[0])));
+    return instance;
+}
+
+void UART_EnableTx(UART_Type *base, bool enable)
+{
+    (void)base;
+    (void)enable;
+}
+
+void UART_EnableRx(UART_Type *base, bool enable)
+{
+    (void)base;
+    (void)enable;
+}
+
+/* A CPU that finds the UART busy spends the time until the next byte is out. */
+uint32_t UART_GetStatusFlags(UART_Type *base)
+{
+    uint32_t flags = 0U;
+
+    (void)base;
+    if (s_uart.fifo == 0U)
+    {
+        flags |= kUART_TxDataRegEmptyFlag;
+        if (!s_uart.shifting)
+        {
+            flags |= kUART_TransmissionCompleteFlag;
+        }
+    }
+    if (s_uart.shifting)
+    {
+        uart_poll();
+    }
+    return flags;
+}
+
+void UART_WriteBlocking(UART_Type *base, const uint8_t *data, size_t length)
+{
+    (void)base;
+    while (length--)
+    {
+        while (s_uart.fifo != 0U)
+        {
+            uart_poll();
+        }
+        uart_push(*(data++));
+    }
+}
+
+status_t UART_ReadBlocking(UART_Type *base, uint8_t *data, size_t length)
+{
+    (void)base;
+    (void)data;
+    (void)length;
+    return kStatus_Fail;
+}
+
+void UART_TransferCreateHandle(UART_Type *base,
+                               uart_handle_t *handle,
+                               uart_transfer_callback_t callback,
+                               void *userData)
+{
+    memset(handle, 0, sizeof(*handle));
+    handle->callback = callback;
+    handle->userData = userData;
+    s_uart.handle = handle;
+    s_uart.base = base;
+    s_uart.tie = false;
+    s_uart.irqEnabled = true;
+}
+
+status_t UART_TransferSendNonBlocking(UART_Type *base, uart_handle_t *handle, uart_transfer_t *xfer)
+{
+    (void)base;
+    assert(xfer->dataSize);
+    assert(xfer->data);
+
+    if (kUART_TxBusy == handle->txState)
+    {
+        return kStatus_UART_TxBusy;
+    }
+    handle->txData = xfer->data;
+    handle->txDataSize = xfer->dataSize;
+    handle->txDataSizeAll = xfer->dataSize;
+    handle->txState = kUART_TxBusy;
+    s_uart.tie = true;
+    uart_service();
+
+    return kStatus_Success;
+}
+
+status_t UART_TransferReceiveNonBlocking(UART_Type *base,
+                                         uart_handle_t *handle,
+                                         uart_transfer_t *xfer,
+                                         size_t *receivedBytes)
+{
+    (void)base;
+    assert(xfer->dataSize);
+    assert(xfer->data);
+
+    if (kUART_RxBusy == handle->rxState)
+    {
+        return kStatus_UART_RxBusy;
+    }
+    handle->rxData = xfer->data;
+    handle->rxDataSize = xfer->dataSize;
+    handle->rxDataSizeAll = xfer->dataSize;
+    handle->rxState = kUART_RxBusy;
+    if (receivedBytes)
+    {
+        *receivedBytes = 0U;
+    }
+
+    return kStatus_Success;
+}
+
+void UART_TransferAbortSend(UART_Type *base, uart_handle_t *handle)
+{
+    (void)base;
+    s_uart.tie = false;
+    handle->txDataSize = 0U;
+    handle->txState = kUART_TxIdle;
+}
+
+void UART_TransferAbortReceive(UART_Type *base, uart_handle_t *handle)
+{
+    (void)base;
+    handle->rxDataSize = 0U;
+    handle->rxState = kUART_RxIdle;
+}
+
+/*******************************************************************************
+ * FreeRTOS
+ ******************************************************************************/
+/* The task sleeps on the target, the host time of the delay is no CPU time of the caller. */
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    double start;
+    double isr;
+
+    if (!s_uart.running || s_uart.masked || (s_uart.ipsr != 0U))
+    {
+        printf("FAIL: vTaskDelay() outside a running task\n");
+        exit(1);
+    }
+    start = host_ns();
+    isr = s_uart.stats.txIsrHostNs;
+    uart_model_advance(xTicksToDelay * 1e9 / configTICK_RATE_HZ);
+    s_uart.stats.delayTicks += xTicksToDelay;
+    s_uart.stats.delayHostNs += host_ns() - start - (s_uart.stats.txIsrHostNs - isr);
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return s_uart.running ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+StreamBufferHandle_t xStreamBufferCreate(size_t xBufferSizeBytes, size_t xTriggerLevelBytes)
+{
+    StreamBufferHandle_t stream = calloc(1U, sizeof(*stream));
+
+    (void)xTriggerLevelBytes;
+    if (stream != NULL)
+    {
+        stream->data = malloc(xBufferSizeBytes);
+        stream->size = xBufferSizeBytes;
+    }
+    return stream;
+}
+
+BaseType_t xStreamBufferReset(StreamBufferHandle_t xStreamBuffer)
+{
+    xStreamBuffer->head = 0U;
+    xStreamBuffer->tail = 0U;
+    return pdTRUE;
+}
+
+size_t xStreamBufferSendFromISR(StreamBufferHandle_t xStreamBuffer,
+                                const void *pvTxData,
+                                size_t xDataLengthBytes,
+                                BaseType_t *const pxHigherPriorityTaskWoken)
+{
+    size_t sent = 0U;
+
+    (void)pxHigherPriorityTaskWoken;
+    while ((sent < xDataLengthBytes) && (xStreamBuffer->head - xStreamBuffer->tail < xStreamBuffer->size))
+    {
+        xStreamBuffer->data[xStreamBuffer->head++ % xStreamBuffer->size] = ((const uint8_t *)pvTxData)[sent++];
+    }
+    return sent;
+}
+
+/* The test is the only task: waiting on an empty stream would block it for good. */
+size_t xStreamBufferReceive(StreamBufferHandle_t xStreamBuffer,
+                            void *pvRxData,
+                            size_t xBufferLengthBytes,
+                            TickType_t xTicksToWait)
+{
+    size_t received = 0U;
+
+    (void)xTicksToWait;
+    if (xStreamBuffer->head == xStreamBuffer->tail)
+    {
+        printf("FAIL: the console waits for a character that never comes\n");
+        exit(1);
+    }
+    while ((received < xBufferLengthBytes) && (xStreamBuffer->tail != xStreamBuffer->head))
+    {
+        ((uint8_t *)pvRxData)[received++] = xStreamBuffer->data[xStreamBuffer->tail++ % xStreamBuffer->size];
+    }
+    return received;
+}
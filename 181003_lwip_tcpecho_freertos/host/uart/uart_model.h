@@ -0,0 +1,61 @@
+/*
+ * Device side of the UART model behind host/uart/fsl_uart.h, and the
+ * simulated CPU it runs on.
+ *
+ * The model plays UART0 of the K64F: an 8 byte transmit FIFO with the SDK
+ * default watermark of 0, so the transmit interrupt comes when the FIFO has
+ * run empty, in front of a shift register that sends one byte per 10 bit
+ * times of the baud rate. Time is simulated and only runs in
+ * uart_model_advance(), in vTaskDelay() and while the driver polls the
+ * UART; the transmit interrupt runs whenever it is pending and the CPU takes
+ * it, at once if interrupts are enabled and no other interrupt is running.
+ * Every byte the driver writes to the FIFO is appended to the output, in the
+ * order the wire would carry it.
+ */
+
+#ifndef UART_MODEL_H
+#define UART_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Counters of the model. */
+typedef struct uart_model_stats
+{
+    uint32_t txIsrCalls;  /* transmit interrupts taken */
+    double txIsrHostNs;   /* host ns spent in them, driver callbacks included */
+    double pollingNs;     /* simulated ns the CPU spent polling the UART */
+    uint32_t delayTicks;  /* ticks tasks waited in vTaskDelay() */
+    double delayHostNs;   /* host ns the model took for them, interrupts left out */
+    uint32_t rxOverruns;  /* characters received with no receive pending */
+} uart_model_stats_t;
+
+/*! @brief Lets the simulated time run on by ns, the UART sends meanwhile. */
+void uart_model_advance(double ns);
+
+/*! @brief Returns the simulated time in ns. */
+double uart_model_now(void);
+
+/*! @brief Receives a character, in the UART interrupt. */
+void uart_model_receive(uint8_t c);
+
+/*!
+ * @brief Runs handler as an interrupt of its own.
+ *
+ * With uartActive it runs as if it had preempted the UART interrupt, which is
+ * then active in the NVIC.
+ */
+void uart_model_interrupt(void (*handler)(void), bool uartActive);
+
+/*! @brief Runs handler as an interrupt right after the next memcpy() with interrupts enabled. */
+void uart_model_preempt(void (*handler)(void));
+
+/*! @brief Tells whether the scheduler has started, it has not at first. */
+void uart_model_set_scheduler(bool running);
+
+/*! @brief Returns the bytes sent so far, *length gets their count. */
+const uint8_t *uart_model_output(uint32_t *length);
+
+void uart_model_get_stats(uart_model_stats_t *stats);
+
+#endif /* UART_MODEL_H */
@@ -0,0 +1,447 @@
+/*
+ * Demultiplexing of udp_input(): the udp_pcbs list against the port hash of
+ * LWIP_UDP_PCB_HASH.
+ *
+ * The fuzz part runs random rounds of binds, rebinds, connects, disconnects
+ * and removes of up to 12 PCBs on a few ports and addresses, with and without
+ * SOF_REUSEADDR, between unicast, subnet broadcast and limited broadcast
+ * datagrams from a few sources. It logs the result of every call and which
+ * PCBs got each datagram, in order. The hash build runs the list build (its
+ * reference, udp_demux_bench_list beside it) for the same rounds and fails on
+ * the first line that differs. Multicast needs LWIP_IGMP, which this build
+ * does not have.
+ *
+ * The bench part binds 10, 100 and 1000 PCBs to their own ports and sends
+ * 16 byte datagrams to random ones of them through ip4_input() and prints
+ * the host datagrams per second and nanoseconds per datagram.
+ *
+ *   make -C host udp_demux_bench_list udp_demux_bench_hash
+ *   host/udp_demux_bench_hash [rounds [datagrams]]
+ *   host/udp_demux_bench_list log [rounds]      the fuzz log alone
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/udp.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/udp.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/ip.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define FUZZ_PCBS 12U
+#define FUZZ_STEPS 300U
+#define BENCH_PCBS_MAX 1000U
+#define BENCH_PORT_BASE 10000U
+#define BENCH_PAYLOAD 16U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t s_rounds = 2000U;
+static uint32_t s_datagrams = 1000000U;
+static const char *s_reference;
+
+static struct netif s_netif;
+static FILE *s_log;
+static uint32_t s_rng;
+static uint32_t s_delivered;
+static uint32_t s_errors;
+
+/* 7000, 7016 and 7032 share a bucket of the default UDP_PCB_HASH_SIZE. */
+static const u16_t s_ports[] = {7000U, 7001U, 7016U, 7032U};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t fuzz_rand(uint32_t n)
+{
+    s_rng = s_rng * 1103515245U + 12345U;
+    return (s_rng >> 8) % n;
+}
+
+static err_t bench_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(p);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    return ERR_OK;
+}
+
+static err_t bench_netif_init(struct netif *netif)
+{
+    netif->output = bench_output;
+    netif->mtu = 1500;
+    netif->flags |= NETIF_FLAG_BROADCAST;
+    return ERR_OK;
+}
+
+static void fuzz_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    fprintf(s_log, " %u", (unsigned)(uintptr_t)arg);
+    pbuf_free(p);
+}
+
+static void bench_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    s_delivered++;
+    pbuf_free(p);
+}
+
+static void random_addr(ip_addr_t *addr)
+{
+    switch (fuzz_rand(3U))
+    {
+        case 0:
+            IP_ADDR4(addr, 192, 168, 1, 102);
+            break;
+        case 1:
+            IP_ADDR4(addr, 192, 168, 1, 103);
+            break;
+        default:
+            ip_addr_set_any(0, addr);
+            break;
+    }
+}
+
+static void input_datagram(const ip4_addr_t *src, u16_t srcPort, const ip4_addr_t *dst, u16_t dstPort)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, IP_HLEN + UDP_HLEN + BENCH_PAYLOAD, PBUF_RAM);
+    struct ip_hdr *iphdr;
+    struct udp_hdr *udphdr;
+
+    if (p == NULL)
+    {
+        printf("FAIL: out of pbufs\n");
+        exit(1);
+    }
+    iphdr = (struct ip_hdr *)p->payload;
+    memset(p->payload, 0, p->len);
+    IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+    IPH_LEN_SET(iphdr, lwip_htons(p->len));
+    IPH_TTL_SET(iphdr, 64);
+    IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+    ip4_addr_copy(iphdr->src, *src);
+    ip4_addr_copy(iphdr->dest, *dst);
+    IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+
+    /* A zero UDP checksum means none. */
+    udphdr = (struct udp_hdr *)((uint8_t *)p->payload + IP_HLEN);
+    udphdr->src = lwip_htons(srcPort);
+    udphdr->dest = lwip_htons(dstPort);
+    udphdr->len = lwip_htons(UDP_HLEN + BENCH_PAYLOAD);
+    ip4_input(p, &s_netif);
+}
+
+static void fuzz_round(uint32_t round)
+{
+    struct udp_pcb *pcbs[FUZZ_PCBS] = {NULL};
+    ip_addr_t addr;
+    ip4_addr_t src;
+    ip4_addr_t dst;
+    u16_t port;
+    uint32_t step;
+    uint32_t i;
+    err_t err;
+
+    s_rng = round + 1U;
+    for (step = 0U; step < FUZZ_STEPS; step++)
+    {
+        i = fuzz_rand(FUZZ_PCBS);
+        fprintf(s_log, "%u.%u ", (unsigned)round, (unsigned)step);
+        switch (fuzz_rand(10U))
+        {
+            case 0:
+            case 1:
+                if (pcbs[i] != NULL)
+                {
+                    udp_remove(pcbs[i]);
+                }
+                pcbs[i] = udp_new();
+                udp_recv(pcbs[i], fuzz_recv, (void *)(uintptr_t)i);
+                if (fuzz_rand(2U) != 0U)
+                {
+                    ip_set_option(pcbs[i], SOF_REUSEADDR);
+                }
+                /* fall through: bind the new pcb */
+            case 2:
+                if (pcbs[i] == NULL)
+                {
+                    fprintf(s_log, "-\n");
+                    break;
+                }
+                random_addr(&addr);
+                port = s_ports[fuzz_rand(sizeof(s_ports) / sizeof(s_ports[0]))];
+                err = udp_bind(pcbs[i], &addr, port);
+                fprintf(s_log, "bind %u %s:%u %d\n", (unsigned)i, ipaddr_ntoa(&addr), (unsigned)port, err);
+                break;
+            case 3:
+                if (pcbs[i] == NULL)
+                {
+                    fprintf(s_log, "-\n");
+                    break;
+                }
+                IP_ADDR4(&addr, 192, 168, 1, 2U + fuzz_rand(2U));
+                port = (u16_t)(1000U + fuzz_rand(2U));
+                err = udp_connect(pcbs[i], &addr, port);
+                fprintf(s_log, "connect %u %s:%u %d\n", (unsigned)i, ipaddr_ntoa(&addr), (unsigned)port, err);
+                break;
+            case 4:
+                if (pcbs[i] != NULL)
+                {
+                    udp_disconnect(pcbs[i]);
+                }
+                fprintf(s_log, "disconnect %u\n", (unsigned)i);
+                break;
+            case 5:
+                if (pcbs[i] != NULL)
+                {
+                    udp_remove(pcbs[i]);
+                    pcbs[i] = NULL;
+                }
+                fprintf(s_log, "remove %u\n", (unsigned)i);
+                break;
+            default:
+                IP4_ADDR(&src, 192, 168, 1, 2U + fuzz_rand(2U));
+                switch (fuzz_rand(4U))
+                {
+                    case 0:
+                        IP4_ADDR(&dst, 192, 168, 1, 255);
+                        break;
+                    case 1:
+                        IP4_ADDR(&dst, 255, 255, 255, 255);
+                        break;
+                    default:
+                        IP4_ADDR(&dst, 192, 168, 1, 102);
+                        break;
+                }
+                port = s_ports[fuzz_rand(sizeof(s_ports) / sizeof(s_ports[0]))];
+                fprintf(s_log, "datagram %s:%u", ip4addr_ntoa(&dst), (unsigned)port);
+                input_datagram(&src, (u16_t)(1000U + fuzz_rand(2U)), &dst, port);
+                fprintf(s_log, "\n");
+                break;
+        }
+    }
+    for (i = 0U; i < FUZZ_PCBS; i++)
+    {
+        if (pcbs[i] != NULL)
+        {
+            udp_remove(pcbs[i]);
+        }
+    }
+}
+
+static void fuzz(FILE *log)
+{
+    uint32_t round;
+
+    s_log = log;
+    for (round = 0U; round < s_rounds; round++)
+    {
+        fuzz_round(round);
+    }
+    fflush(log);
+}
+
+/* Runs the fuzz here and in the reference build and compares the logs. */
+static void fuzz_compare(void)
+{
+    char *mine = NULL;
+    size_t mineLen = 0U;
+    FILE *log = open_memstream(&mine, &mineLen);
+    char command[4200];
+    char line[512];
+    char *cur;
+    char *end;
+    uint32_t lines = 0U;
+    FILE *ref;
+
+    if (log == NULL)
+    {
+        printf("FAIL: no memory for the log\n");
+        exit(1);
+    }
+    fuzz(log);
+    fclose(log);
+
+    snprintf(command, sizeof(command), "%s log %u", s_reference, (unsigned)s_rounds);
+    ref = popen(command, "r");
+    if (ref == NULL)
+    {
+        printf("FAIL: cannot run %s\n", s_reference);
+        exit(1);
+    }
+    cur = mine;
+    while (fgets(line, sizeof(line), ref) != NULL)
+    {
+        end = strchr(cur, '\n');
+        if ((end == NULL) || ((size_t)(end + 1 - cur) != strlen(line)) || (memcmp(cur, line, strlen(line)) != 0))
+        {
+            printf("error: after %u equal lines the reference logs\n  %sand this build\n  %.*s\n", (unsigned)lines,
+                   line, (end != NULL) ? (int)(end + 1 - cur) : (int)strlen(cur), cur);
+            s_errors++;
+            break;
+        }
+        cur = end + 1;
+        lines++;
+    }
+    /* After a difference the reference may die writing to the closed pipe. */
+    if ((pclose(ref) != 0) ? (s_errors == 0U) : ((s_errors == 0U) && ((*cur != '\0') || (lines == 0U))))
+    {
+        printf("error: the reference %s did not log the same %u rounds\n", s_reference, (unsigned)s_rounds);
+        s_errors++;
+    }
+    printf("fuzz: %u rounds, %u log lines %s the reference\n", (unsigned)s_rounds, (unsigned)lines,
+           (s_errors == 0U) ? "equal to" : "differ from");
+    free(mine);
+}
+
+static double bench_run(uint32_t count)
+{
+    static struct udp_pcb *pcbs[BENCH_PCBS_MAX];
+    ip4_addr_t src;
+    uint32_t n;
+    double start;
+
+    for (n = 0U; n < count; n++)
+    {
+        pcbs[n] = udp_new();
+        if ((pcbs[n] == NULL) || (udp_bind(pcbs[n], IP_ADDR_ANY, (u16_t)(BENCH_PORT_BASE + n)) != ERR_OK))
+        {
+            printf("FAIL: no PCB for port %u, raise MEMP_NUM_UDP_PCB\n", (unsigned)(BENCH_PORT_BASE + n));
+            exit(1);
+        }
+        udp_recv(pcbs[n], bench_recv, NULL);
+    }
+
+    IP4_ADDR(&src, 192, 168, 1, 2);
+    s_delivered = 0U;
+    s_rng = 1U;
+    start = now_ns();
+    for (n = 0U; n < s_datagrams; n++)
+    {
+        input_datagram(&src, 1000U, netif_ip4_addr(&s_netif), (u16_t)(BENCH_PORT_BASE + fuzz_rand(count)));
+    }
+    start = now_ns() - start;
+    if (s_delivered != s_datagrams)
+    {
+        printf("error: %u of %u datagrams delivered\n", (unsigned)s_delivered, (unsigned)s_datagrams);
+        s_errors++;
+    }
+
+    for (n = 0U; n < count; n++)
+    {
+        udp_remove(pcbs[n]);
+    }
+    return start / s_datagrams;
+}
+
+static void bench_task(void *arg)
+{
+    static const uint32_t counts[] = {10U, 100U, BENCH_PCBS_MAX};
+    ip4_addr_t ipaddr, netmask, gw;
+    double ns;
+    uint32_t i;
+
+    IP4_ADDR(&ipaddr, 192, 168, 1, 102);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 1, 1);
+
+    tcpip_init(NULL, NULL);
+    LOCK_TCPIP_CORE();
+    netif_add(&s_netif, &ipaddr, &netmask, &gw, NULL, bench_netif_init, ip4_input);
+    netif_set_default(&s_netif);
+    netif_set_up(&s_netif);
+    netif_set_link_up(&s_netif);
+
+    if (arg != NULL)
+    {
+        fuzz(stdout);
+        exit(0);
+    }
+    if (LWIP_UDP_PCB_HASH)
+    {
+        fuzz_compare();
+    }
+
+    printf("%u datagrams, %s\n", (unsigned)s_datagrams,
+           LWIP_UDP_PCB_HASH ? "port hash" : "linear list");
+    printf("%6s %12s %10s\n", "pcbs", "datagrams/s", "ns/dgram");
+    for (i = 0U; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        ns = bench_run(counts[i]);
+        printf("%6u %12.0f %10.0f\n", (unsigned)counts[i], 1e9 / ns, ns);
+    }
+    UNLOCK_TCPIP_CORE();
+
+    if (s_errors != 0U)
+    {
+        printf("FAIL: %u errors\n", (unsigned)s_errors);
+        exit(1);
+    }
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    static char reference[4096];
+    int logOnly = 0;
+    int i = 1;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if ((argc > 1) && (strcmp(argv[1], "log") == 0))
+    {
+        logOnly = 1;
+        i = 2;
+    }
+    if (argc > i)
+    {
+        s_rounds = strtoul(argv[i], NULL, 0);
+    }
+    if (argc > i + 1)
+    {
+        s_datagrams = strtoul(argv[i + 1], NULL, 0);
+    }
+    if ((s_rounds == 0U) || (s_datagrams == 0U))
+    {
+        fprintf(stderr, "usage: %s [rounds [datagrams]]\n       %s log [rounds]\n", argv[0], argv[0]);
+        return 2;
+    }
+    snprintf(reference, sizeof(reference), "%.*sudp_demux_bench_list",
+             (strrchr(argv[0], '/') != NULL) ? (int)(strrchr(argv[0], '/') - argv[0] + 1) : 0, argv[0]);
+    s_reference = reference;
+
+    if (sys_thread_new("bench", bench_task, logOnly ? (void *)1 : NULL, DEFAULT_THREAD_STACKSIZE,
+                       DEFAULT_THREAD_PRIO) == NULL)
+    {
+        return 1;
+    }
+    vTaskStartScheduler();
+    return 1;
+}
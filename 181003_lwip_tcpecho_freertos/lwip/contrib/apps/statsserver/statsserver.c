@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
+ * All rights reserved. 
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, 
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED 
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT 
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING 
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY 
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ * 
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ */
+
+
+
+/*
+ * Statistics server on the raw UDP API. It runs entirely in the tcpip thread.
+ *
+ * Any datagram sent to STATSSERVER_PORT is answered with a text report of
+ * the hot path latency histograms (LWIP_STATS_HIST), the per-netif packet
+ * counters (MIB2_STATS), the per-connection TCP counters (TCP_PCB_STATS), the
+ * PBUF_POOL exhaustion count (MEMP_STATS) and the text of the application
+ * report set with statsserver_set_app_report().
+ * A datagram starting with "reset" clears the histograms after the report,
+ * e.g.: echo reset | nc -u -w1 <board> 50001
+ */
+#include "statsserver.h"
+
+#include "lwip/opt.h"
+
+#if LWIP_UDP
+
+#include "lwip/udp.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+#include "lwip/ip_addr.h"
+#include "lwip/netif.h"
+#if TCP_PCB_STATS
+#include "lwip/priv/tcp_priv.h"
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+struct statsserver_report
+{
+  char *buf;
+  u16_t len;
+};
+
+static statsserver_app_report_fn statsserver_app_report;
+
+#define STATSSERVER_LWIP_REPORT (LWIP_STATS_HIST || MIB2_STATS || MEMP_STATS || TCP_PCB_STATS)
+
+#if STATSSERVER_LWIP_REPORT
+/*-----------------------------------------------------------------------------------*/
+static void
+statsserver_printf(struct statsserver_report *r, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  if (r->len >= STATSSERVER_BUFSIZE) {
+    return;
+  }
+  va_start(ap, fmt);
+  n = vsnprintf(r->buf + r->len, STATSSERVER_BUFSIZE - r->len, fmt, ap);
+  va_end(ap);
+  if (n > 0) {
+    /* a truncated line ends the report */
+    r->len = (u16_t)LWIP_MIN(r->len + n, STATSSERVER_BUFSIZE);
+  }
+}
+#endif /* STATSSERVER_LWIP_REPORT */
+
+/*-----------------------------------------------------------------------------------*/
+static void
+statsserver_report(struct statsserver_report *r)
+{
+#if LWIP_STATS_HIST
+  struct stats_hist hist;
+  int id, i;
+
+  /* one line per histogram: count, max and the non-empty log2 buckets */
+  statsserver_printf(r, "hist overhead %"U32_F"\n", lwip_stats.hist_overhead);
+  for (id = 0; id < STATS_HIST_MAX; id++) {
+    stats_hist_get((enum stats_hist_id)id, &hist);
+    statsserver_printf(r, "%s: n %"U32_F" max %"U32_F, stats_hist_name((enum stats_hist_id)id),
+                       hist.count, hist.max);
+    for (i = 0; i < STATS_HIST_BUCKETS; i++) {
+      if (hist.bucket[i] != 0) {
+        statsserver_printf(r, " %d:%"U32_F, i, hist.bucket[i]);
+      }
+    }
+    statsserver_printf(r, "\n");
+  }
+#endif /* LWIP_STATS_HIST */
+
+#if MIB2_STATS
+  {
+    struct netif *netif;
+    const struct stats_mib2_netif_ctrs *c;
+
+    for (netif = netif_list; netif != NULL; netif = netif->next) {
+      c = &netif->mib2_counters;
+      statsserver_printf(r, "netif %c%c%"U16_F": in %"U32_F" B %"U32_F" ucast %"U32_F" nucast %"U32_F
+                         " discards %"U32_F" errors %"U32_F" unknown, out %"U32_F" B %"U32_F" ucast %"U32_F
+                         " nucast %"U32_F" discards %"U32_F" errors\n",
+                         netif->name[0], netif->name[1], (u16_t)netif->num,
+                         c->ifinoctets, c->ifinucastpkts, c->ifinnucastpkts,
+                         c->ifindiscards, c->ifinerrors, c->ifinunknownprotos,
+                         c->ifoutoctets, c->ifoutucastpkts, c->ifoutnucastpkts,
+                         c->ifoutdiscards, c->ifouterrors);
+    }
+  }
+#endif /* MIB2_STATS */
+
+#if MEMP_STATS
+  statsserver_printf(r, "pbuf pool: used %"U32_F" max %"U32_F" err %"U32_F"\n",
+                     (u32_t)MEMP_STATS_GET(used, MEMP_PBUF_POOL),
+                     (u32_t)MEMP_STATS_GET(max, MEMP_PBUF_POOL),
+                     (u32_t)MEMP_STATS_GET(err, MEMP_PBUF_POOL));
+#endif /* MEMP_STATS */
+
+#if TCP_PCB_STATS
+  {
+    struct tcp_pcb *pcb;
+    char local[IPADDR_STRLEN_MAX], remote[IPADDR_STRLEN_MAX];
+
+    for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+      ipaddr_ntoa_r(&pcb->local_ip, local, sizeof(local));
+      ipaddr_ntoa_r(&pcb->remote_ip, remote, sizeof(remote));
+      statsserver_printf(r, "tcp %s:%"U16_F" %s:%"U16_F" state %d in %"U32_F" out %"U32_F
+                         " segs %"U32_F" rexmit %"U32_F" rto %"U32_F"\n",
+                         local, pcb->local_port, remote, pcb->remote_port, (int)pcb->state,
+                         pcb->stats.bytes_in, pcb->stats.bytes_out, pcb->stats.segs_out,
+                         pcb->stats.rexmit, pcb->stats.rto);
+    }
+  }
+#endif /* TCP_PCB_STATS */
+
+  if ((statsserver_app_report != NULL) && (r->len < STATSSERVER_BUFSIZE)) {
+    int n = statsserver_app_report(r->buf + r->len, STATSSERVER_BUFSIZE - r->len);
+    if (n > 0) {
+      r->len = (u16_t)LWIP_MIN(r->len + n, STATSSERVER_BUFSIZE);
+    }
+  }
+}
+
+/*-----------------------------------------------------------------------------------*/
+static void
+statsserver_recv(void *arg, struct udp_pcb *upcb, struct pbuf *p,
+                 const ip_addr_t *addr, u16_t port)
+{
+  struct statsserver_report r;
+  struct pbuf *q;
+  u8_t reset;
+
+  LWIP_UNUSED_ARG(arg);
+
+  reset = (pbuf_memcmp(p, 0, "reset", 5) == 0);
+  pbuf_free(p);
+
+  q = pbuf_alloc(PBUF_TRANSPORT, STATSSERVER_BUFSIZE, PBUF_RAM);
+  if (q == NULL) {
+    return;
+  }
+  r.buf = (char *)q->payload;
+  r.len = 0;
+  statsserver_report(&r);
+  pbuf_realloc(q, r.len);
+  udp_sendto(upcb, q, addr, port);
+  pbuf_free(q);
+
+#if LWIP_STATS_HIST
+  if (reset) {
+    stats_hist_reset();
+  }
+#else
+  LWIP_UNUSED_ARG(reset);
+#endif /* LWIP_STATS_HIST */
+}
+
+/*-----------------------------------------------------------------------------------*/
+void
+statsserver_init(void)
+{
+  struct udp_pcb *pcb;
+
+  pcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+  if (pcb == NULL) {
+    return;
+  }
+  if (udp_bind(pcb, IP_ANY_TYPE, STATSSERVER_PORT) != ERR_OK) {
+    udp_remove(pcb);
+    return;
+  }
+  udp_recv(pcb, statsserver_recv, NULL);
+}
+
+/*-----------------------------------------------------------------------------------*/
+void
+statsserver_set_app_report(statsserver_app_report_fn fn)
+{
+  statsserver_app_report = fn;
+}
+
+#endif /* LWIP_UDP */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
+ * All rights reserved. 
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, 
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED 
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT 
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING 
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY 
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ * 
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ */
+
+
+#ifndef LWIP_STATSSERVER_H
+#define LWIP_STATSSERVER_H
+
+#include "lwip/opt.h"
+
+/** STATSSERVER_PORT: UDP port the statistics server answers on. */
+#ifndef STATSSERVER_PORT
+#define STATSSERVER_PORT 50001
+#endif
+
+/** STATSSERVER_BUFSIZE: maximum size of a report, sent as one datagram. */
+#ifndef STATSSERVER_BUFSIZE
+#define STATSSERVER_BUFSIZE 1400
+#endif
+
+/**
+ * Application report: appends at most size - 1 characters and a terminating
+ * zero to buf and returns the number of characters appended.
+ */
+typedef int (*statsserver_app_report_fn)(char *buf, size_t size);
+
+/** Must be called from the tcpip thread or with the core lock held. */
+void statsserver_init(void);
+
+/**
+ * Sets a function whose text is appended to every report, e.g. the per-task
+ * CPU accounting of the application. It runs in the tcpip thread.
+ */
+void statsserver_set_app_report(statsserver_app_report_fn fn);
+
+#endif /* LWIP_STATSSERVER_H */
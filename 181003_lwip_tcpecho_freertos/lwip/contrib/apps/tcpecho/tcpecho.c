@@ -37,20 +37,239 @@
 
 #include "lwip/sys.h"
 #include "lwip/api.h"
+#include "lwip/memp.h"
+#if TCPECHO_ZEROCOPY
+#include "lwip/tcp.h"
+#endif /* TCPECHO_ZEROCOPY */
 
-//typedef struct {
-//	struct netconn *conn_args, *newconn_args;
-//	struct netbuf *buf_args;
-//	void *data_args;
-//	u16_t len_args;
-//}args;
+/** Accepted connection waiting for a handler task. */
+struct tcpecho_job {
+  struct netconn *conn;
+  u32_t accepted;          /* sys_now() when netconn_accept returned */
+};
+
+/* Jobs in the mailbox plus the one the accept loop is filling. Handlers copy
+   their job and free it before serving. */
+LWIP_MEMPOOL_DECLARE(TCPECHO_JOB, TCPECHO_ACCEPT_QUEUE_LEN + 1, sizeof(struct tcpecho_job), "TCPECHO_JOB")
+
+static sys_mbox_t tcpecho_jobs;
+static struct tcpecho_stats tcpecho_stats;
+
+#if TCPECHO_ZEROCOPY
+#if !LWIP_TCP_ZEROCOPY
+#error "TCPECHO_ZEROCOPY requires LWIP_TCP_ZEROCOPY"
+#endif
+#if TCPECHO_ZC_NUM >= MEMP_NUM_NETBUF
+#error "TCPECHO_ZC_NUM must leave netbufs for netconn_recv()"
+#endif
+
+/** Received netbuf echoed without copy, deleted once the echo is acked. */
+struct tcpecho_zc {
+  struct tcp_zc zc;
+  struct netbuf *buf;
+  u16_t pbufs;
+};
+
+LWIP_MEMPOOL_DECLARE(TCPECHO_ZC, TCPECHO_ZC_NUM, sizeof(struct tcpecho_zc), "TCPECHO_ZC")
+
+/** Received pbufs currently held by zero-copy echoes */
+static u16_t tcpecho_zc_pbufs;
+#endif /* TCPECHO_ZEROCOPY */
+
+/*-----------------------------------------------------------------------------------*/
+static void
+tcpecho_sample_heap(void)
+{
+#if configFRTOS_MEMORY_SCHEME != 3 /* heap_3 does not track its free space */
+  size_t free_heap = xPortGetFreeHeapSize();
+
+  if ((tcpecho_stats.heap_free_min == 0) || (free_heap < tcpecho_stats.heap_free_min)) {
+    tcpecho_stats.heap_free_min = (u32_t)free_heap;
+  }
+#endif
+}
+/*-----------------------------------------------------------------------------------*/
+static void
+tcpecho_refuse(struct netconn *conn)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  netconn_close(conn);
+  netconn_delete(conn);
+
+  SYS_ARCH_PROTECT(lev);
+  tcpecho_stats.refused++;
+  SYS_ARCH_UNPROTECT(lev);
+}
+/*-----------------------------------------------------------------------------------*/
+#if TCPECHO_ZEROCOPY
+/* Called by the stack (normally in the tcpip thread) once the echo of a
+   netbuf has been acknowledged and all references to it are gone. */
+static void
+tcpecho_zc_done(void *arg)
+{
+  struct tcpecho_zc *ezc = (struct tcpecho_zc *)arg;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  netbuf_delete(ezc->buf);
+  SYS_ARCH_PROTECT(lev);
+  tcpecho_zc_pbufs -= ezc->pbufs;
+  SYS_ARCH_UNPROTECT(lev);
+  LWIP_MEMPOOL_FREE(TCPECHO_ZC, ezc);
+}
+/*-----------------------------------------------------------------------------------*/
+/* Echo buf without copying its payload. Takes over buf and returns 1, or
+   returns 0 if buf is short or the pbuf budget is used up and the caller
+   must copy. */
+static int
+tcpecho_echo_zc(struct netconn *conn, struct netbuf *buf)
+{
+  struct tcpecho_zc *ezc;
+  void *data;
+  u16_t len;
+  u16_t pbufs = pbuf_clen(buf->p);
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (buf->p->tot_len < TCPECHO_ZC_MIN_LEN) {
+    return 0;
+  }
+  SYS_ARCH_PROTECT(lev);
+  if (tcpecho_zc_pbufs + pbufs > TCPECHO_ZC_MAX_PBUFS) {
+    SYS_ARCH_UNPROTECT(lev);
+    return 0;
+  }
+  tcpecho_zc_pbufs += pbufs;
+  SYS_ARCH_UNPROTECT(lev);
+
+  ezc = (struct tcpecho_zc *)LWIP_MEMPOOL_ALLOC(TCPECHO_ZC);
+  if (ezc == NULL) {
+    SYS_ARCH_PROTECT(lev);
+    tcpecho_zc_pbufs -= pbufs;
+    SYS_ARCH_UNPROTECT(lev);
+    return 0;
+  }
+  ezc->buf = buf;
+  ezc->pbufs = pbufs;
+  tcp_zc_init(&ezc->zc, tcpecho_zc_done, ezc);
+  do {
+    netbuf_data(buf, &data, &len);
+    if (netconn_write_zc(conn, data, len, NETCONN_NOFLAG, &ezc->zc) != ERR_OK) {
+      break;
+    }
+  } while (netbuf_next(buf) >= 0);
+  /* buf is deleted as soon as nothing references it any more */
+  tcp_zc_release(&ezc->zc);
+  return 1;
+}
+#endif /* TCPECHO_ZEROCOPY */
+/*-----------------------------------------------------------------------------------*/
+static void
+tcpecho_serve(const struct tcpecho_job *job)
+{
+  err_t err;
+  struct netbuf *buf;
+  void *data;
+  u16_t len;
+  u8_t first = 1;
+  struct netconn *newconn = job->conn;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  tcpecho_stats.active++;
+  if (tcpecho_stats.active > tcpecho_stats.active_max) {
+    tcpecho_stats.active_max = tcpecho_stats.active;
+  }
+  tcpecho_sample_heap();
+  SYS_ARCH_UNPROTECT(lev);
+
+  while ((err = netconn_recv(newconn, &buf)) == ERR_OK) {
+    /*printf("Recved\n");*/
+    if (first) {
+      u32_t latency = sys_now() - job->accepted;
+
+      first = 0;
+      SYS_ARCH_PROTECT(lev);
+      tcpecho_stats.first_byte_count++;
+      tcpecho_stats.first_byte_ms_total += latency;
+      if (latency > tcpecho_stats.first_byte_ms_max) {
+        tcpecho_stats.first_byte_ms_max = latency;
+      }
+      SYS_ARCH_UNPROTECT(lev);
+    }
+#if TCPECHO_ZEROCOPY
+    if (tcpecho_echo_zc(newconn, buf)) {
+      SYS_ARCH_PROTECT(lev);
+      tcpecho_stats.echo_zerocopy++;
+      SYS_ARCH_UNPROTECT(lev);
+      continue;
+    }
+#endif /* TCPECHO_ZEROCOPY */
+    do {
+         netbuf_data(buf, &data, &len);
+         err = netconn_write(newconn, data, len, NETCONN_COPY);
+#if 0
+        if (err != ERR_OK) {
+          printf("tcpecho: netconn_write: error \"%s\"\n", lwip_strerr(err));
+        }
+#endif
+    } while (netbuf_next(buf) >= 0);
+    netbuf_delete(buf);
+    SYS_ARCH_PROTECT(lev);
+    tcpecho_stats.echo_copied++;
+    SYS_ARCH_UNPROTECT(lev);
+  }
+
+  /*printf("Got EOF, looping\n");*/
+  /* Close connection and discard connection identifier. */
+  netconn_close(newconn);
+  netconn_delete(newconn);
+
+  SYS_ARCH_PROTECT(lev);
+  tcpecho_stats.active--;
+  SYS_ARCH_UNPROTECT(lev);
+}
+/*-----------------------------------------------------------------------------------*/
+static void
+tcpecho_take_job(struct tcpecho_job *job)
+{
+  void *msg;
+
+  sys_arch_mbox_fetch(&tcpecho_jobs, &msg, 0);
+  *job = *(struct tcpecho_job *)msg;
+  LWIP_MEMPOOL_FREE(TCPECHO_JOB, msg);
+}
 /*-----------------------------------------------------------------------------------*/
+#if TCPECHO_WORKER_POOL_SIZE > 0
 static void
-tcpecho_thread_new(void *arg);
+tcpecho_worker(void *arg)
+{
+  struct tcpecho_job job;
+  LWIP_UNUSED_ARG(arg);
+
+  while (1) {
+    tcpecho_take_job(&job);
+    tcpecho_serve(&job);
+  }
+}
+#else /* TCPECHO_WORKER_POOL_SIZE > 0 */
+static void
+tcpecho_thread_new(void *arg)
+{
+  struct tcpecho_job job;
+  LWIP_UNUSED_ARG(arg);
+
+  /* Every task is created for exactly one queued connection. */
+  tcpecho_take_job(&job);
+  tcpecho_serve(&job);
+  vTaskDelete(NULL);
+}
+#endif /* TCPECHO_WORKER_POOL_SIZE > 0 */
+/*-----------------------------------------------------------------------------------*/
 static void 
 tcpecho_thread(void *arg)
 {
   struct netconn *conn, *newconn;
+  struct tcpecho_job *job;
   err_t err;
   LWIP_UNUSED_ARG(arg);
 
@@ -76,7 +295,37 @@ tcpecho_thread(void *arg)
     /* Process the new connection. */
     if (err == ERR_OK)
     {
-      sys_thread_new("tcpecho_thread_new", tcpecho_thread_new, newconn, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
+      tcpecho_stats.accepted++;
+      job = (struct tcpecho_job *)LWIP_MEMPOOL_ALLOC(TCPECHO_JOB);
+      if (job == NULL) {
+        tcpecho_refuse(newconn);
+        continue;
+      }
+      job->conn = newconn;
+      job->accepted = sys_now();
+
+#if TCPECHO_REFUSE_WHEN_BUSY
+      if (sys_mbox_trypost(&tcpecho_jobs, job) != ERR_OK) {
+        LWIP_MEMPOOL_FREE(TCPECHO_JOB, job);
+        tcpecho_refuse(newconn);
+        continue;
+      }
+#else
+      sys_mbox_post(&tcpecho_jobs, job);
+#endif
+
+#if TCPECHO_WORKER_POOL_SIZE == 0
+      if (sys_thread_new("tcpecho_thread_new", tcpecho_thread_new, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO) == NULL) {
+        /* No task will take the job: pull one back out and refuse it. */
+        void *msg;
+
+        if (sys_arch_mbox_tryfetch(&tcpecho_jobs, &msg) != SYS_MBOX_EMPTY) {
+          job = (struct tcpecho_job *)msg;
+          tcpecho_refuse(job->conn);
+          LWIP_MEMPOOL_FREE(TCPECHO_JOB, job);
+        }
+      }
+#endif
     }
   }
 }
@@ -84,37 +333,32 @@ tcpecho_thread(void *arg)
 void
 tcpecho_init(void)
 {
+#if TCPECHO_WORKER_POOL_SIZE > 0
+  int i;
+#endif
+
+  LWIP_ERROR("tcpecho: cannot create job mailbox", (sys_mbox_new(&tcpecho_jobs, TCPECHO_ACCEPT_QUEUE_LEN) == ERR_OK), return;);
+  LWIP_MEMPOOL_INIT(TCPECHO_JOB);
+#if TCPECHO_ZEROCOPY
+  LWIP_MEMPOOL_INIT(TCPECHO_ZC);
+#endif /* TCPECHO_ZEROCOPY */
+
+#if TCPECHO_WORKER_POOL_SIZE > 0
+  for (i = 0; i < TCPECHO_WORKER_POOL_SIZE; i++) {
+    sys_thread_new("tcpecho_worker", tcpecho_worker, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
+  }
+#endif
   sys_thread_new("tcpecho_thread", tcpecho_thread, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
 }
 /*-----------------------------------------------------------------------------------*/
-static void
-tcpecho_thread_new(void *arg)
+void
+tcpecho_get_stats(struct tcpecho_stats *stats)
 {
-	err_t err;
-    struct netbuf *buf;
-    void *data;
-    u16_t len;
-    struct netconn *newconn = arg;
-
-    while ((err = netconn_recv(newconn, &buf)) == ERR_OK) {
-      /*printf("Recved\n");*/
-      do {
-           netbuf_data(buf, &data, &len);
-           err = netconn_write(newconn, data, len, NETCONN_COPY);
-#if 0
-          if (err != ERR_OK) {
-            printf("tcpecho: netconn_write: error \"%s\"\n", lwip_strerr(err));
-          }
-#endif
-      } while (netbuf_next(buf) >= 0);
-      netbuf_delete(buf);
-    }
+  SYS_ARCH_DECL_PROTECT(lev);
 
-    /*printf("Got EOF, looping\n");*/
-    /* Close connection and discard connection identifier. */
-    netconn_close(newconn);
-    netconn_delete(newconn);
-    vTaskDelete(NULL);
+  SYS_ARCH_PROTECT(lev);
+  *stats = tcpecho_stats;
+  SYS_ARCH_UNPROTECT(lev);
 }
 
 #endif /* LWIP_NETCONN */
@@ -33,6 +33,80 @@
 #ifndef LWIP_TCPECHO_H
 #define LWIP_TCPECHO_H
 
+#include "lwip/opt.h"
+
+/** TCPECHO_WORKER_POOL_SIZE: number of preallocated worker tasks serving
+ * accepted connections. 0 creates one task per connection instead.
+ */
+#ifndef TCPECHO_WORKER_POOL_SIZE
+#define TCPECHO_WORKER_POOL_SIZE 0
+#endif
+
+/** TCPECHO_ACCEPT_QUEUE_LEN: accepted connections waiting for a handler task.
+ * Every served and queued connection holds a netconn, so with a worker pool
+ * MEMP_NUM_NETCONN should cover TCPECHO_WORKER_POOL_SIZE +
+ * TCPECHO_ACCEPT_QUEUE_LEN + 2 (the listener and the connection being
+ * accepted). The stack resets connections it has no netconn for. A served
+ * connection also holds a netbuf while it waits in netconn_recv(), so
+ * MEMP_NUM_NETBUF bounds how many can be served at once.
+ */
+#ifndef TCPECHO_ACCEPT_QUEUE_LEN
+#define TCPECHO_ACCEPT_QUEUE_LEN 4
+#endif
+
+/** TCPECHO_REFUSE_WHEN_BUSY==1: close connections accepted while the queue
+ * is full. 0 stops accepting instead, so new clients wait in the listen backlog.
+ */
+#ifndef TCPECHO_REFUSE_WHEN_BUSY
+#define TCPECHO_REFUSE_WHEN_BUSY 0
+#endif
+
+/** TCPECHO_ZEROCOPY==1: echo received netbufs with netconn_write_zc() instead
+ * of copying them. Each netbuf is then held until its echo has been
+ * acknowledged. Requires LWIP_TCP_ZEROCOPY.
+ */
+#ifndef TCPECHO_ZEROCOPY
+#define TCPECHO_ZEROCOPY LWIP_TCP_ZEROCOPY
+#endif
+
+/** TCPECHO_ZC_MIN_LEN: netbufs shorter than this are echoed by copy, which is
+ * cheaper than a zero-copy pbuf per write and keeps TCP_SND_QUEUELEN free.
+ */
+#ifndef TCPECHO_ZC_MIN_LEN
+#define TCPECHO_ZC_MIN_LEN 512
+#endif
+
+/** TCPECHO_ZC_NUM: netbufs that can be echoed without copy at the same time.
+ * They come from MEMP_NUM_NETBUF, which also has to cover one netbuf for
+ * every connection waiting in netconn_recv(), or that call fails.
+ */
+#ifndef TCPECHO_ZC_NUM
+#define TCPECHO_ZC_NUM (MEMP_NUM_NETBUF / 2)
+#endif
+
+/** TCPECHO_ZC_MAX_PBUFS: received pbufs that may be held by zero-copy echoes.
+ * Keep it below PBUF_POOL_SIZE: the ACKs that release them arrive in the
+ * same pool. Netbufs over the budget are echoed by copy.
+ */
+#ifndef TCPECHO_ZC_MAX_PBUFS
+#define TCPECHO_ZC_MAX_PBUFS (PBUF_POOL_SIZE / 2)
+#endif
+
+/** Counters of the echo server, read with tcpecho_get_stats(). */
+struct tcpecho_stats {
+  u32_t accepted;            /* connections returned by netconn_accept */
+  u32_t refused;             /* connections closed without being served */
+  u32_t active;              /* connections currently served */
+  u32_t active_max;          /* high-water mark of active */
+  u32_t first_byte_count;    /* connections that received data */
+  u32_t first_byte_ms_total; /* sum of accept-to-first-byte latencies */
+  u32_t first_byte_ms_max;   /* worst accept-to-first-byte latency */
+  u32_t heap_free_min;       /* lowest free heap seen, 0 if the heap cannot tell */
+  u32_t echo_copied;         /* netbufs echoed by copying them */
+  u32_t echo_zerocopy;       /* netbufs echoed without copy */
+};
+
 void tcpecho_init(void);
+void tcpecho_get_stats(struct tcpecho_stats *stats);
 
 #endif /* LWIP_TCPECHO_H */
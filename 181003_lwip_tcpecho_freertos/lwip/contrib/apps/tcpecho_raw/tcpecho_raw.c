@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
+ * All rights reserved. 
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, 
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED 
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT 
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING 
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY 
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ * 
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ */
+
+
+/*
+ * Echo server on the raw TCP API. It runs entirely in the tcpip thread.
+ *
+ * Received pbufs are handed back to tcp_write() without TCP_WRITE_FLAG_COPY,
+ * so the echoed data is sent straight from the receive buffers. A pbuf is
+ * therefore kept until the peer has acknowledged every byte echoed from it.
+ * The receive window is reopened (tcp_recved) for the data tcp_write() has
+ * taken, so a connection holds at most TCP_WND bytes waiting for the send
+ * buffer and TCP_SND_BUF bytes waiting for their acknowledgement. Reopening
+ * only for acknowledged data would tie the window to the peer's delayed ACK.
+ */
+#include "tcpecho_raw.h"
+
+#include "lwip/opt.h"
+
+#if LWIP_TCP && LWIP_CALLBACK_API
+
+#include "lwip/tcp.h"
+#include "lwip/mem.h"
+
+enum tcpecho_raw_states
+{
+  ES_NONE = 0,
+  ES_ACCEPTED,
+  ES_CLOSING
+};
+
+struct tcpecho_raw_state
+{
+  u8_t state;
+  struct tcp_pcb *pcb;
+  /* received data not yet acknowledged by the peer */
+  struct pbuf *p;
+  /* bytes at the start of p already acknowledged */
+  u16_t acked;
+  /* bytes after 'acked' already passed to tcp_write */
+  u32_t written;
+};
+
+static struct tcp_pcb *tcpecho_raw_pcb;
+
+/*-----------------------------------------------------------------------------------*/
+static void
+tcpecho_raw_free(struct tcpecho_raw_state *es)
+{
+  if (es != NULL) {
+    if (es->p != NULL) {
+      pbuf_free(es->p);
+    }
+    mem_free(es);
+  }
+}
+/*-----------------------------------------------------------------------------------*/
+static void
+tcpecho_raw_close(struct tcp_pcb *tpcb, struct tcpecho_raw_state *es)
+{
+  tcp_arg(tpcb, NULL);
+  tcp_sent(tpcb, NULL);
+  tcp_recv(tpcb, NULL);
+  tcp_err(tpcb, NULL);
+  tcp_poll(tpcb, NULL, 0);
+
+  tcpecho_raw_free(es);
+
+  if (tcp_close(tpcb) != ERR_OK) {
+    tcp_abort(tpcb);
+  }
+}
+/*-----------------------------------------------------------------------------------*/
+static void
+tcpecho_raw_send(struct tcp_pcb *tpcb, struct tcpecho_raw_state *es)
+{
+  struct pbuf *q = es->p;
+  u32_t skip = es->acked + es->written;
+
+  /* find the first byte not handed to tcp_write yet */
+  while ((q != NULL) && (skip >= q->len)) {
+    skip -= q->len;
+    q = q->next;
+  }
+
+  while (q != NULL) {
+    u16_t avail = (u16_t)(q->len - skip);
+    u16_t len = LWIP_MIN(avail, tcp_sndbuf(tpcb));
+    u8_t flags = 0;
+    err_t err;
+
+    if (len == 0) {
+      break;
+    }
+    if ((len < avail) || (q->next != NULL)) {
+      flags |= TCP_WRITE_FLAG_MORE;
+    }
+    /* no TCP_WRITE_FLAG_COPY: q stays referenced in es->p until acknowledged */
+    err = tcp_write(tpcb, (const u8_t *)q->payload + skip, len, flags);
+    if (err != ERR_OK) {
+      /* out of segments or send buffer, tcpecho_raw_sent retries */
+      break;
+    }
+    es->written += len;
+    /* the data has moved to the send buffer: let the peer send more */
+    tcp_recved(tpcb, len);
+    if (len < avail) {
+      break;
+    }
+    skip = 0;
+    q = q->next;
+  }
+}
+/*-----------------------------------------------------------------------------------*/
+static err_t
+tcpecho_raw_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
+{
+  struct tcpecho_raw_state *es = (struct tcpecho_raw_state *)arg;
+
+  LWIP_ASSERT("unexpected ack", len <= es->written);
+  es->written -= len;
+
+  /* release the pbufs the peer has acknowledged completely */
+  while (es->p != NULL) {
+    struct pbuf *ptr = es->p;
+    u16_t avail = (u16_t)(ptr->len - es->acked);
+
+    if (len < avail) {
+      es->acked = (u16_t)(es->acked + len);
+      break;
+    }
+    len = (u16_t)(len - avail);
+    es->acked = 0;
+    es->p = ptr->next;
+    if (es->p != NULL) {
+      /* the rest of the chain stays linked: pbuf_free() drops the head and
+       * then the reference it held on es->p, ours keeps es->p alive */
+      pbuf_ref(es->p);
+    }
+    pbuf_free(ptr);
+  }
+
+  if (es->p != NULL) {
+    tcpecho_raw_send(tpcb, es);
+  } else if (es->state == ES_CLOSING) {
+    tcpecho_raw_close(tpcb, es);
+  }
+  return ERR_OK;
+}
+/*-----------------------------------------------------------------------------------*/
+static err_t
+tcpecho_raw_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+  struct tcpecho_raw_state *es = (struct tcpecho_raw_state *)arg;
+
+  LWIP_ASSERT("arg != NULL", es != NULL);
+
+  if (p == NULL) {
+    /* remote host closed connection, finish echoing what is left */
+    es->state = ES_CLOSING;
+    if (es->p == NULL) {
+      tcpecho_raw_close(tpcb, es);
+    }
+    return ERR_OK;
+  }
+
+  if ((err != ERR_OK) || (es->state != ES_ACCEPTED)) {
+    tcp_recved(tpcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+  }
+
+  if (es->p == NULL) {
+    es->p = p;
+  } else {
+    pbuf_cat(es->p, p);
+  }
+  tcpecho_raw_send(tpcb, es);
+  return ERR_OK;
+}
+/*-----------------------------------------------------------------------------------*/
+static err_t
+tcpecho_raw_poll(void *arg, struct tcp_pcb *tpcb)
+{
+  struct tcpecho_raw_state *es = (struct tcpecho_raw_state *)arg;
+
+  if (es == NULL) {
+    tcp_abort(tpcb);
+    return ERR_ABRT;
+  }
+  if (es->p != NULL) {
+    /* tcp_write may have failed for lack of segments */
+    tcpecho_raw_send(tpcb, es);
+  } else if (es->state == ES_CLOSING) {
+    tcpecho_raw_close(tpcb, es);
+  }
+  return ERR_OK;
+}
+/*-----------------------------------------------------------------------------------*/
+static void
+tcpecho_raw_error(void *arg, err_t err)
+{
+  LWIP_UNUSED_ARG(err);
+
+  /* the pcb is already gone */
+  tcpecho_raw_free((struct tcpecho_raw_state *)arg);
+}
+/*-----------------------------------------------------------------------------------*/
+static err_t
+tcpecho_raw_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  struct tcpecho_raw_state *es;
+
+  LWIP_UNUSED_ARG(arg);
+  if ((err != ERR_OK) || (newpcb == NULL)) {
+    return ERR_VAL;
+  }
+
+  es = (struct tcpecho_raw_state *)mem_malloc(sizeof(struct tcpecho_raw_state));
+  if (es == NULL) {
+    return ERR_MEM;
+  }
+  es->state = ES_ACCEPTED;
+  es->pcb = newpcb;
+  es->p = NULL;
+  es->acked = 0;
+  es->written = 0;
+
+  /* echo every segment right away instead of waiting for an ACK */
+  tcp_nagle_disable(newpcb);
+
+  tcp_arg(newpcb, es);
+  tcp_recv(newpcb, tcpecho_raw_recv);
+  tcp_sent(newpcb, tcpecho_raw_sent);
+  tcp_err(newpcb, tcpecho_raw_error);
+  tcp_poll(newpcb, tcpecho_raw_poll, 2);
+  return ERR_OK;
+}
+/*-----------------------------------------------------------------------------------*/
+void
+tcpecho_raw_init(void)
+{
+  err_t err;
+
+  tcpecho_raw_pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  LWIP_ERROR("tcpecho_raw: cannot create pcb", (tcpecho_raw_pcb != NULL), return;);
+
+  err = tcp_bind(tcpecho_raw_pcb, IP_ANY_TYPE, TCPECHO_RAW_PORT);
+  LWIP_ERROR("tcpecho_raw: cannot bind", (err == ERR_OK), tcp_close(tcpecho_raw_pcb); return;);
+
+  tcpecho_raw_pcb = tcp_listen(tcpecho_raw_pcb);
+  LWIP_ERROR("tcpecho_raw: cannot listen", (tcpecho_raw_pcb != NULL), return;);
+  tcp_accept(tcpecho_raw_pcb, tcpecho_raw_accept);
+}
+/*-----------------------------------------------------------------------------------*/
+
+#endif /* LWIP_TCP && LWIP_CALLBACK_API */
@@ -123,6 +123,20 @@ typedef u32_t          mem_ptr_t;
 
 #define PACK_STRUCT_FIELD(x) x
 
+// Checksum routines of the port (chksum.c), used instead of the generic
+// 16-bit loop of inet_chksum.c
+#ifndef LWIP_PORT_OPTIMIZED_CHKSUM
+#define LWIP_PORT_OPTIMIZED_CHKSUM 1
+#endif
+
+#if LWIP_PORT_OPTIMIZED_CHKSUM
+#include <stdint.h>
+uint16_t port_chksum(const void *dataptr, int len);
+uint16_t port_chksum_copy(void *dst, const void *src, uint16_t len);
+#define LWIP_CHKSUM port_chksum
+#define LWIP_CHKSUM_COPY(dst, src, len) port_chksum_copy(dst, src, len)
+#endif
+
 // Platform specific diagnostic output
 #include "sys_arch.h"//FSL
 
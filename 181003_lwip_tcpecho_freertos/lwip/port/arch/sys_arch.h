@@ -64,7 +64,12 @@
 #ifndef __ARCH_SYS_ARCH_H__
 #define __ARCH_SYS_ARCH_H__
 
+#if defined(LWIP_HOST_BUILD) && LWIP_HOST_BUILD
+#include <stdio.h>
+#define PRINTF printf
+#else
 #include "fsl_debug_console.h"
+#endif
 #include "lwip/opt.h"
 #include "arch/cc.h"
 
@@ -77,13 +82,33 @@
 
 #endif
 
+/* LWIP_SYS_MBOX_SPSC==1: Back the netconn recvmbox and acceptmbox with a
+ * lock-free single-producer/single-consumer ring of pointers instead of a
+ * FreeRTOS queue. A blocked reader or writer is woken by a direct task
+ * notification. All posts to these mailboxes come from the tcpip thread or
+ * from threads holding the core lock, and each one must be read by one thread
+ * at a time. Other mailboxes (the tcpip mailbox has many producers) remain
+ * FreeRTOS queues. */
+#ifndef LWIP_SYS_MBOX_SPSC
+#define LWIP_SYS_MBOX_SPSC 0
+#endif
+
+#if LWIP_SYS_MBOX_SPSC
+#define SYS_MBOX_NULL					( ( struct sys_mbox * ) NULL )
+#else
 #define SYS_MBOX_NULL					( ( QueueHandle_t ) NULL )
+#endif
 #define SYS_SEM_NULL					( ( SemaphoreHandle_t ) NULL )
 #define SYS_DEFAULT_THREAD_STACK_DEPTH	configMINIMAL_STACK_SIZE
 #if !NO_SYS
 typedef SemaphoreHandle_t sys_sem_t;
 typedef SemaphoreHandle_t sys_mutex_t;
+#if LWIP_SYS_MBOX_SPSC
+struct sys_mbox;
+typedef struct sys_mbox *sys_mbox_t;
+#else
 typedef QueueHandle_t sys_mbox_t;
+#endif
 typedef TaskHandle_t sys_thread_t;
 
 #define sys_mbox_valid( x ) ( ( ( *x ) == NULL) ? pdFALSE : pdTRUE )
@@ -116,8 +141,38 @@ extern "C" {
 
 void sys_assert( char *msg );
 
+/* Cycle counter for the latency histograms of LWIP_STATS_HIST: the DWT cycle
+ * counter on the target, the monotonic clock in nanoseconds on the host. */
+#if defined(LWIP_HOST_BUILD) && LWIP_HOST_BUILD
+uint32_t sys_arch_cycles( void );
+#define LWIP_STATS_CYCLES() sys_arch_cycles()
+#else
+/* Only deltas are used: the counter is not reset, it may be shared with the
+ * trace recorder. */
+#define LWIP_STATS_CYCLES_INIT() do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+                                      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+#define LWIP_STATS_CYCLES() (DWT->CYCCNT)
+#endif
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
 
 #endif /* __ARCH_SYS_ARCH_H__ */
+
+/* cc.h includes this header before lwIP defines its types, so err_t is only
+ * known when lwip/sys.h includes it again after lwip/err.h. */
+#if !NO_SYS && LWIP_SYS_MBOX_SPSC && defined(LWIP_HDR_SYS_H) && defined(LWIP_HDR_ERR_H) && \
+    !defined(sys_mbox_new_spsc)
+#if defined(__cplusplus)
+extern "C" {
+#endif /* __cplusplus */
+
+/* Creates a mailbox with a single producer and a single consumer. */
+err_t sys_mbox_new_spsc( sys_mbox_t *mbox, int size );
+#define sys_mbox_new_spsc sys_mbox_new_spsc
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+#endif
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ */
+
+/*
+ * Internet checksum routines used for LWIP_CHKSUM and LWIP_CHKSUM_COPY.
+ * Both return the same value as lwip_standard_chksum(): the non-inverted
+ * one's complement sum of the data taken as native 16-bit words.
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_PORT_OPTIMIZED_CHKSUM
+
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Folds a 64-bit accumulator of 32-bit words into a 16-bit sum. */
+static u16_t port_chksum_fold(uint64_t acc)
+{
+    u32_t sum;
+
+    acc = (acc & 0xFFFFFFFFULL) + (acc >> 32);
+    acc = (acc & 0xFFFFFFFFULL) + (acc >> 32);
+    sum = (u32_t)acc;
+    sum = FOLD_U32T(sum);
+    sum = FOLD_U32T(sum);
+    return (u16_t)sum;
+}
+
+/* Sums len bytes (a multiple of 4) from a 4-byte aligned pointer. */
+static uint64_t port_chksum_words(const u32_t *pw, int len, uint64_t acc)
+{
+#if defined(__GNUC__) && defined(__ARM_ARCH_7EM__)
+    /* Cortex-M4: one ADCS per word keeps the carries in the flags, so the
+     * end-around carry costs a single ADC per 32 bytes. */
+    u32_t sum = 0U;
+    u32_t a, b, c, d;
+
+    while (len >= 32)
+    {
+        __asm volatile(
+            "ldr  %[a], [%[p], #0]\n"
+            "ldr  %[b], [%[p], #4]\n"
+            "ldr  %[c], [%[p], #8]\n"
+            "ldr  %[d], [%[p], #12]\n"
+            "adds %[s], %[s], %[a]\n"
+            "adcs %[s], %[s], %[b]\n"
+            "adcs %[s], %[s], %[c]\n"
+            "adcs %[s], %[s], %[d]\n"
+            "ldr  %[a], [%[p], #16]\n"
+            "ldr  %[b], [%[p], #20]\n"
+            "ldr  %[c], [%[p], #24]\n"
+            "ldr  %[d], [%[p], #28]\n"
+            "adcs %[s], %[s], %[a]\n"
+            "adcs %[s], %[s], %[b]\n"
+            "adcs %[s], %[s], %[c]\n"
+            "adcs %[s], %[s], %[d]\n"
+            "adc  %[s], %[s], #0\n"
+            : [s] "+r"(sum), [a] "=&r"(a), [b] "=&r"(b), [c] "=&r"(c), [d] "=&r"(d)
+            : [p] "r"(pw)
+            : "cc", "memory");
+        pw += 8;
+        len -= 32;
+    }
+    acc += sum;
+#else
+    while (len >= 32)
+    {
+        acc += (uint64_t)pw[0] + pw[1] + pw[2] + pw[3];
+        acc += (uint64_t)pw[4] + pw[5] + pw[6] + pw[7];
+        pw += 8;
+        len -= 32;
+    }
+#endif
+    while (len >= 4)
+    {
+        acc += *pw++;
+        len -= 4;
+    }
+    return acc;
+}
+
+/**
+ * Computes the checksum a word at a time. Leading bytes are summed until the
+ * pointer is 4-byte aligned, then 32 bytes are summed per iteration.
+ *
+ * @param dataptr points to start of data to be summed at any boundary
+ * @param len length of data to be summed
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t port_chksum(const void *dataptr, int len)
+{
+    const u8_t *pb = (const u8_t *)dataptr;
+    uint64_t acc = 0U;
+    u16_t t = 0U;
+    u32_t sum;
+    int odd = ((mem_ptr_t)pb & 1);
+    int bulk;
+
+    /* Get aligned to u16_t */
+    if (odd && (len > 0))
+    {
+        ((u8_t *)&t)[1] = *pb++;
+        len--;
+    }
+    /* Get aligned to u32_t */
+    if (((mem_ptr_t)pb & 2) && (len > 1))
+    {
+        acc += *(const u16_t *)(const void *)pb;
+        pb += 2;
+        len -= 2;
+    }
+
+    bulk = len & ~3;
+    acc = port_chksum_words((const u32_t *)(const void *)pb, bulk, acc);
+    pb += bulk;
+    len -= bulk;
+
+    if (len > 1)
+    {
+        acc += *(const u16_t *)(const void *)pb;
+        pb += 2;
+        len -= 2;
+    }
+    /* Consume left-over byte, if any */
+    if (len > 0)
+    {
+        ((u8_t *)&t)[0] = *pb;
+    }
+    acc += t;
+
+    sum = port_chksum_fold(acc);
+    /* Swap if alignment was odd */
+    if (odd)
+    {
+        sum = SWAP_BYTES_IN_WORD(sum);
+    }
+    return (u16_t)sum;
+}
+
+#if LWIP_CHECKSUM_ON_COPY
+/**
+ * Copies len bytes from src to dst and returns their checksum. When both
+ * pointers share the same alignment the words are summed while they are
+ * copied, otherwise the data is copied first and summed afterwards.
+ *
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t port_chksum_copy(void *dst, const void *src, u16_t len)
+{
+    const u8_t *ps = (const u8_t *)src;
+    u8_t *pd = (u8_t *)dst;
+    const u32_t *sw;
+    u32_t *dw;
+    uint64_t acc = 0U;
+    u32_t head, bulk, sum, rest;
+
+    if ((((mem_ptr_t)ps ^ (mem_ptr_t)pd) & 3) != 0)
+    {
+        MEMCPY(dst, src, len);
+        return port_chksum(dst, len);
+    }
+
+    head = (4U - ((mem_ptr_t)ps & 3)) & 3;
+    if (head > len)
+    {
+        head = len;
+    }
+    MEMCPY(pd, ps, head);
+    ps += head;
+    pd += head;
+
+    bulk = (len - head) & ~3U;
+    sw = (const u32_t *)(const void *)ps;
+    dw = (u32_t *)(void *)pd;
+    for (rest = bulk; rest >= 16U; rest -= 16U)
+    {
+        u32_t a = sw[0], b = sw[1], c = sw[2], d = sw[3];
+
+        dw[0] = a;
+        dw[1] = b;
+        dw[2] = c;
+        dw[3] = d;
+        acc += (uint64_t)a + b + c + d;
+        sw += 4;
+        dw += 4;
+    }
+    for (; rest > 0U; rest -= 4U)
+    {
+        acc += *dw++ = *sw++;
+    }
+
+    rest = len - head - bulk;
+    MEMCPY(dw, sw, rest);
+    acc += port_chksum(dw, (int)rest);
+
+    /* The bulk was paired from offset 'head': realign it with the head bytes. */
+    sum = port_chksum_fold(acc);
+    if (head & 1U)
+    {
+        sum = SWAP_BYTES_IN_WORD(sum);
+    }
+    sum += port_chksum(dst, (int)head);
+    sum = FOLD_U32T(sum);
+    return (u16_t)sum;
+}
+#endif /* LWIP_CHECKSUM_ON_COPY */
+
+#endif /* LWIP_PORT_OPTIMIZED_CHKSUM */
@@ -66,9 +66,12 @@
 #include "lwip/mem.h"
 #include "lwip/pbuf.h"
 #include "lwip/stats.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
 #include "lwip/snmp.h"
 #include "lwip/ethip6.h"
 #include "netif/etharp.h"
+#include "netif/ethernet.h"
 #include "netif/ppp/pppoe.h"
 #include "lwip/igmp.h"
 #include "lwip/mld6.h"
@@ -90,6 +93,13 @@
 #define IFNAME0 'e'
 #define IFNAME1 'n'
 
+/* ENET interrupt time is accounted by the application's run time stats
+ * (runtime_stats.h, seen through FreeRTOSConfig.h) when it provides them. */
+#ifndef RUNTIME_STATS_ISR_ENTER
+#define RUNTIME_STATS_ISR_ENTER()
+#define RUNTIME_STATS_ISR_EXIT()
+#endif
+
 #if defined(FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL) && FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL
     #if defined(FSL_FEATURE_L2CACHE_LINESIZE_BYTE) \
         && ((!defined(FSL_SDK_DISBLE_L2CACHE_PRESENT)) || (FSL_SDK_DISBLE_L2CACHE_PRESENT == 0))
@@ -118,6 +128,79 @@
 typedef uint8_t rx_buffer_t[SDK_SIZEALIGN(ENET_RXBUFF_SIZE, FSL_ENET_BUFF_ALIGNMENT)];
 typedef uint8_t tx_buffer_t[SDK_SIZEALIGN(ENET_TXBUFF_SIZE, FSL_ENET_BUFF_ALIGNMENT)];
 
+#if ETHERNETIF_RX_ZERO_COPY
+#if !(defined(FSL_FEATURE_SOC_ENET_COUNT) && (FSL_FEATURE_SOC_ENET_COUNT > 0))
+#error "ETHERNETIF_RX_ZERO_COPY is only supported by the ENET driver."
+#endif
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "ETHERNETIF_RX_ZERO_COPY requires LWIP_SUPPORT_CUSTOM_PBUF."
+#endif
+#if ETH_PAD_SIZE
+#error "ETHERNETIF_RX_ZERO_COPY requires ETH_PAD_SIZE == 0."
+#endif
+
+/* Receive buffers owned by descriptors plus the spare ones. */
+#define ENET_RXBUFF_TOTAL_NUM (ENET_RXBD_NUM + ENET_RXBUFF_POOL_NUM)
+
+struct ethernetif;
+
+/**
+ * Custom pbuf wrapping one receive buffer. Entry i of the wrapper array
+ * always describes RxDataBuff[i].
+ */
+typedef struct rx_pbuf_wrapper
+{
+    struct pbuf_custom p; /* must be the first member */
+    struct ethernetif *ethernetif;
+    uint8_t *buffer;
+    struct rx_pbuf_wrapper *next;
+} rx_pbuf_wrapper_t;
+#else
+#define ENET_RXBUFF_TOTAL_NUM ENET_RXBD_NUM
+#endif /* ETHERNETIF_RX_ZERO_COPY */
+
+#if ETHERNETIF_TX_SCATTER_GATHER
+#if !(defined(FSL_FEATURE_SOC_ENET_COUNT) && (FSL_FEATURE_SOC_ENET_COUNT > 0)) || \
+    !(USE_RTOS && defined(FSL_RTOS_FREE_RTOS))
+#error "ETHERNETIF_TX_SCATTER_GATHER is only supported by the ENET driver with FreeRTOS."
+#endif
+#endif /* ETHERNETIF_TX_SCATTER_GATHER */
+
+#if ETHERNETIF_CHECKSUM_OFFLOAD
+#if !(defined(FSL_FEATURE_SOC_ENET_COUNT) && (FSL_FEATURE_SOC_ENET_COUNT > 0))
+#error "ETHERNETIF_CHECKSUM_OFFLOAD is only supported by the ENET driver."
+#endif
+#if !LWIP_CHECKSUM_CTRL_PER_NETIF
+#error "ETHERNETIF_CHECKSUM_OFFLOAD requires LWIP_CHECKSUM_CTRL_PER_NETIF."
+#endif
+
+/* Checksums the ENET handles for this netif; everything else stays in software. */
+#define ETHERNETIF_CHECKSUM_HW                                                                      \
+    (NETIF_CHECKSUM_GEN_IP | NETIF_CHECKSUM_GEN_UDP | NETIF_CHECKSUM_GEN_TCP | NETIF_CHECKSUM_GEN_ICMP | \
+     NETIF_CHECKSUM_CHECK_IP | NETIF_CHECKSUM_CHECK_UDP | NETIF_CHECKSUM_CHECK_TCP | NETIF_CHECKSUM_CHECK_ICMP)
+#endif /* ETHERNETIF_CHECKSUM_OFFLOAD */
+
+#if ETHERNETIF_RX_BATCH
+#if !(USE_RTOS && defined(FSL_RTOS_FREE_RTOS))
+#error "ETHERNETIF_RX_BATCH requires FreeRTOS."
+#endif
+#if ETHERNETIF_RX_BATCH > 32
+#error "ETHERNETIF_RX_BATCH must not exceed 32."
+#endif
+
+/**
+ * Received frames posted to the tcpip thread with one callback message.
+ */
+typedef struct enet_rx_batch
+{
+    struct netif *netif;
+    struct tcpip_callback_msg *msg;
+    struct enet_rx_batch *next;
+    uint8_t count;
+    struct pbuf *frames[ETHERNETIF_RX_BATCH];
+} enet_rx_batch_t;
+#endif /* ETHERNETIF_RX_BATCH */
+
 /**
  * Helper struct to hold private data used to operate your ethernet interface.
  */
@@ -136,6 +219,25 @@ struct ethernetif
     enet_tx_bd_struct_t *TxBuffDescrip;
     rx_buffer_t *RxDataBuff;
     tx_buffer_t *TxDataBuff;
+#if ETHERNETIF_RX_ZERO_COPY
+    rx_pbuf_wrapper_t *RxPbufs;
+    rx_pbuf_wrapper_t *RxFreeList; /* spare buffers not owned by a descriptor or a pbuf */
+#endif
+#if ETHERNETIF_TX_SCATTER_GATHER
+    struct pbuf *TxPbufs[ENET_TXBD_NUM]; /* frame to release when this descriptor completes */
+    uint8_t txProduceIdx;
+    uint8_t txReclaimIdx;
+    uint8_t txUsed;
+    volatile uint8_t txReclaimPending;
+    struct tcpip_callback_msg *txReclaimMsg;
+#endif
+#if ETHERNETIF_RX_BATCH
+    enet_rx_batch_t RxBatches[ETHERNETIF_RX_BATCH_NUM];
+    enet_rx_batch_t *RxBatchFree; /* batches not queued to the tcpip thread */
+#endif
+#if ETHERNETIF_CHECKSUM_OFFLOAD
+    ethernetif_checksum_stats_t chksumStats;
+#endif
 #if defined(FSL_FEATURE_SOC_LPC_ENET_COUNT) && (FSL_FEATURE_SOC_LPC_ENET_COUNT > 0)
     uint8_t txIdx;
 #if !(USE_RTOS && defined(FSL_RTOS_FREE_RTOS))
@@ -163,6 +265,7 @@ static void ethernet_callback(ENET_Type *base, enet_handle_t *handle, enet_event
     struct ethernetif *ethernetif = netif->state;
     BaseType_t xResult;
     
+    RUNTIME_STATS_ISR_ENTER();
 
     switch (event)
     {
@@ -189,11 +292,24 @@ static void ethernet_callback(ENET_Type *base, enet_handle_t *handle, enet_event
             {
                 xEventGroupSetBits(ethernetif->enetTransmitAccessEvent, ethernetif->txFlag);
             }
+#if ETHERNETIF_TX_SCATTER_GATHER
+            /* Release sent frames in the tcpip thread even if nothing else is sent. */
+            if (!ethernetif->txReclaimPending)
+            {
+                ethernetif->txReclaimPending = 1U;
+                if (tcpip_trycallback(ethernetif->txReclaimMsg) != ERR_OK)
+                {
+                    ethernetif->txReclaimPending = 0U;
+                }
+            }
+#endif
         }
         break;
         default:
             break;
     }
+
+    RUNTIME_STATS_ISR_EXIT();
 }
 #endif
 
@@ -283,6 +399,137 @@ static inline enet_tx_bd_struct_t *get_tx_desc(struct ethernetif *ethernetif, ui
 }
 #endif
 
+#if ETHERNETIF_RX_ZERO_COPY
+/**
+ * Returns a receive buffer to the spare pool once lwIP frees its pbuf.
+ * May be called from any task or from the ENET ISR.
+ */
+static void ethernetif_rx_release(struct pbuf *p)
+{
+    rx_pbuf_wrapper_t *wrapper = (rx_pbuf_wrapper_t *)p;
+    struct ethernetif *ethernetif = wrapper->ethernetif;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    SYS_ARCH_PROTECT(old_level);
+    wrapper->next = ethernetif->RxFreeList;
+    ethernetif->RxFreeList = wrapper;
+    SYS_ARCH_UNPROTECT(old_level);
+}
+
+/**
+ * Binds a wrapper to every receive buffer. The first ENET_RXBD_NUM buffers
+ * are handed to the descriptors by ENET_Init(), the rest are spare.
+ */
+static void enet_rx_pool_init(struct ethernetif *ethernetif)
+{
+    uint32_t i;
+
+    ethernetif->RxFreeList = NULL;
+
+    for (i = 0; i < ENET_RXBUFF_TOTAL_NUM; i++)
+    {
+        rx_pbuf_wrapper_t *wrapper = &ethernetif->RxPbufs[i];
+
+        wrapper->p.custom_free_function = ethernetif_rx_release;
+        wrapper->ethernetif = ethernetif;
+        wrapper->buffer = &(ethernetif->RxDataBuff[i][0]);
+        wrapper->next = NULL;
+
+        if (i >= ENET_RXBD_NUM)
+        {
+            wrapper->next = ethernetif->RxFreeList;
+            ethernetif->RxFreeList = wrapper;
+        }
+    }
+}
+
+/**
+ * Detaches the buffer of the current receive descriptor and returns it as a
+ * custom pbuf. The descriptor is re-armed with a spare buffer.
+ * Returns NULL if the frame spans several descriptors or no spare buffer is
+ * left; the frame is then still owned by the driver.
+ */
+static struct pbuf *enet_rx_frame_zero_copy(struct ethernetif *ethernetif, uint32_t length)
+{
+    volatile enet_rx_bd_struct_t *rxDesc = ethernetif->handle.rxBdCurrent[0];
+    rx_pbuf_wrapper_t *spare;
+    rx_pbuf_wrapper_t *wrapper;
+    struct pbuf *p;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    if ((!(rxDesc->control & ENET_BUFFDESCRIPTOR_RX_LAST_MASK)) || (length > sizeof(rx_buffer_t)))
+    {
+        return NULL;
+    }
+
+    SYS_ARCH_PROTECT(old_level);
+    spare = ethernetif->RxFreeList;
+    if (spare != NULL)
+    {
+        ethernetif->RxFreeList = spare->next;
+    }
+    SYS_ARCH_UNPROTECT(old_level);
+
+    if (spare == NULL)
+    {
+        return NULL;
+    }
+
+    wrapper = &ethernetif->RxPbufs[(rx_buffer_t *)rxDesc->buffer - ethernetif->RxDataBuff];
+#if defined(FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL) && FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL
+    DCACHE_InvalidateByRange((uint32_t)wrapper->buffer, length);
+#endif /* FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL */
+
+    /* Swap in the spare buffer, then let the driver give the descriptor back to the DMA. */
+    rxDesc->buffer = spare->buffer;
+    ENET_ReadFrame(ethernetif->base, &ethernetif->handle, NULL, 0U);
+
+    p = pbuf_alloced_custom(PBUF_RAW, length, PBUF_REF, &wrapper->p, wrapper->buffer, sizeof(rx_buffer_t));
+    LWIP_ASSERT("enet_rx_frame_zero_copy: pbuf_alloced_custom failed", (p != NULL));
+
+    return p;
+}
+#endif /* ETHERNETIF_RX_ZERO_COPY */
+
+#if ETHERNETIF_TX_SCATTER_GATHER
+/**
+ * Releases the frames of all descriptors the DMA has finished with,
+ * in ring order. Runs with the lwIP core lock held.
+ */
+static void enet_tx_reclaim(struct ethernetif *ethernetif)
+{
+    while (ethernetif->txUsed > 0U)
+    {
+        uint8_t idx = ethernetif->txReclaimIdx;
+
+        if (ethernetif->TxBuffDescrip[idx].control & ENET_BUFFDESCRIPTOR_TX_READY_MASK)
+        {
+            break;
+        }
+
+        if (ethernetif->TxPbufs[idx] != NULL)
+        {
+            pbuf_free(ethernetif->TxPbufs[idx]);
+            ethernetif->TxPbufs[idx] = NULL;
+        }
+
+        ethernetif->txReclaimIdx = (idx + 1U) % ENET_TXBD_NUM;
+        ethernetif->txUsed--;
+    }
+}
+
+/**
+ * tcpip thread callback posted by ethernet_callback() on TX completion.
+ */
+static void enet_tx_reclaim_callback(void *ctx)
+{
+    struct ethernetif *ethernetif = (struct ethernetif *)ctx;
+
+    ethernetif->txReclaimPending = 0U;
+    enet_tx_reclaim(ethernetif);
+}
+#endif /* ETHERNETIF_TX_SCATTER_GATHER */
+
 /**
  * Initializes ENET driver.
  */
@@ -313,6 +560,14 @@ static void enet_init(struct netif *netif, struct ethernetif *ethernetif,
 
     ENET_GetDefaultConfig(&config);
     config.ringNum = ENET_RING_NUM;
+#if ETHERNETIF_CHECKSUM_OFFLOAD
+    /* Insert the checksums into cleared fields; relies on the default store and forward mode. */
+    config.txAccelerConfig = kENET_TxAccelIpCheckEnabled | kENET_TxAccelProtoCheckEnabled;
+#ifndef ENET_ENHANCEDBUFFERDESCRIPTOR_MODE
+    /* Legacy descriptors carry no checksum status, so the MAC has to discard bad frames. */
+    config.rxAccelerConfig = kENET_RxAccelIpCheckEnabled | kENET_RxAccelProtoCheckEnabled;
+#endif
+#endif /* ETHERNETIF_CHECKSUM_OFFLOAD */
 
     status = PHY_Init(ethernetif->base, ethernetifConfig->phyAddress, sysClock);
     if (kStatus_Success != status)
@@ -385,6 +640,16 @@ static void enet_init(struct netif *netif, struct ethernetif *ethernetif,
     LWIP_ASSERT("Input Ethernet base error!", (instance != ARRAY_SIZE(enetBases)));
 #endif /* USE_RTOS */
 
+#if ETHERNETIF_TX_SCATTER_GATHER
+    memset(ethernetif->TxPbufs, 0, sizeof(ethernetif->TxPbufs));
+    ethernetif->txProduceIdx = 0U;
+    ethernetif->txReclaimIdx = 0U;
+    ethernetif->txUsed = 0U;
+    ethernetif->txReclaimPending = 0U;
+    ethernetif->txReclaimMsg = tcpip_callbackmsg_new(enet_tx_reclaim_callback, ethernetif);
+    LWIP_ASSERT("Cannot allocate TX reclaim message!", (ethernetif->txReclaimMsg != NULL));
+#endif /* ETHERNETIF_TX_SCATTER_GATHER */
+
     /* Initialize the ENET module.*/
     ENET_Init(ethernetif->base, &ethernetif->handle, &config, &buffCfg[0], netif->hwaddr, sysClock);
 
@@ -516,6 +781,10 @@ static void low_level_init(struct netif *netif, const uint8_t enetIdx,
     /* don't set NETIF_FLAG_ETHARP if this device is not an ethernet one */
     netif->flags |= NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
 
+#if ETHERNETIF_RX_ZERO_COPY
+    enet_rx_pool_init(ethernetif);
+#endif
+
     /* ENET driver initialization.*/
     enet_init(netif, ethernetif, ethernetifConfig);
 
@@ -534,6 +803,7 @@ static void low_level_init(struct netif *netif, const uint8_t enetIdx,
 #endif /* LWIP_IPV6 && LWIP_IPV6_MLD */
 }
 
+#if !ETHERNETIF_TX_SCATTER_GATHER
 /**
  * Returns next buffer for TX.
  * Can wait if no buffer available.
@@ -643,6 +913,112 @@ static err_t enet_send_frame(struct ethernetif *ethernetif, unsigned char *data,
     }
 #endif
 }
+#endif /* !ETHERNETIF_TX_SCATTER_GATHER */
+
+#if ETHERNETIF_TX_SCATTER_GATHER
+/**
+ * Queues a frame on the TX ring with one descriptor per non-empty pbuf.
+ * Waits for completed descriptors if the ring has no room for the frame.
+ */
+static err_t enet_send_frame_sg(struct ethernetif *ethernetif, struct pbuf *p)
+{
+    volatile enet_tx_bd_struct_t *txBuffDesc;
+    struct pbuf *q;
+    struct pbuf *hold = p;
+    uint8_t bdCount = 0U;
+    uint8_t first;
+    uint8_t last;
+    uint8_t idx;
+    uint16_t control;
+
+    for (q = p; q != NULL; q = q->next)
+    {
+        if (q->len != 0U)
+        {
+            bdCount++;
+        }
+    }
+
+    if (p->tot_len > ENET_FRAME_MAX_FRAMELEN)
+    {
+        return ERR_BUF;
+    }
+
+    /* A chain the ring can never hold is flattened into the descriptor's own buffer. */
+    if (bdCount > ENET_TXBD_NUM)
+    {
+        bdCount = 1U;
+        hold = NULL;
+    }
+
+    enet_tx_reclaim(ethernetif);
+    while ((ENET_TXBD_NUM - ethernetif->txUsed) < bdCount)
+    {
+        xEventGroupWaitBits(ethernetif->enetTransmitAccessEvent, ethernetif->txFlag, pdTRUE, (BaseType_t) false,
+                            portMAX_DELAY);
+        enet_tx_reclaim(ethernetif);
+    }
+
+    first = ethernetif->txProduceIdx;
+    idx = first;
+    last = first;
+
+    if (hold == NULL)
+    {
+        txBuffDesc = &ethernetif->TxBuffDescrip[idx];
+        txBuffDesc->buffer = &(ethernetif->TxDataBuff[idx][0]);
+        txBuffDesc->length = pbuf_copy_partial(p, txBuffDesc->buffer, p->tot_len, 0U);
+#if defined(FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL) && FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL
+        DCACHE_CleanByRange((uint32_t)txBuffDesc->buffer, txBuffDesc->length);
+#endif /* FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL */
+        txBuffDesc->control = (txBuffDesc->control & ENET_BUFFDESCRIPTOR_TX_WRAP_MASK) |
+                              ENET_BUFFDESCRIPTOR_TX_TRANMITCRC_MASK | ENET_BUFFDESCRIPTOR_TX_LAST_MASK;
+        idx = (idx + 1U) % ENET_TXBD_NUM;
+    }
+    else
+    {
+        for (q = p; q != NULL; q = q->next)
+        {
+            if (q->len == 0U)
+            {
+                continue;
+            }
+
+            txBuffDesc = &ethernetif->TxBuffDescrip[idx];
+            txBuffDesc->buffer = (uint8_t *)q->payload;
+            txBuffDesc->length = q->len;
+#if defined(FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL) && FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL
+            DCACHE_CleanByRange((uint32_t)q->payload, q->len);
+#endif /* FSL_SDK_ENABLE_DRIVER_CACHE_CONTROL */
+
+            control = (txBuffDesc->control & ENET_BUFFDESCRIPTOR_TX_WRAP_MASK) | ENET_BUFFDESCRIPTOR_TX_TRANMITCRC_MASK;
+            /* The first descriptor is handed over last so the DMA never sees a partial frame. */
+            if (idx != first)
+            {
+                control |= ENET_BUFFDESCRIPTOR_TX_READY_MASK;
+            }
+            txBuffDesc->control = control;
+
+            last = idx;
+            idx = (idx + 1U) % ENET_TXBD_NUM;
+        }
+
+        ethernetif->TxBuffDescrip[last].control |= ENET_BUFFDESCRIPTOR_TX_LAST_MASK;
+        pbuf_ref(hold);
+    }
+
+    ethernetif->TxPbufs[last] = hold;
+    ethernetif->txUsed += bdCount;
+    ethernetif->txProduceIdx = idx;
+    ethernetif->handle.txBdCurrent[0] = &ethernetif->TxBuffDescrip[idx];
+
+    __DSB();
+    ethernetif->TxBuffDescrip[first].control |= ENET_BUFFDESCRIPTOR_TX_READY_MASK;
+    ethernetif->base->TDAR = ENET_TDAR_TDAR_MASK;
+
+    return ERR_OK;
+}
+#endif /* ETHERNETIF_TX_SCATTER_GATHER */
 
 /**
  * This function should do the actual transmission of the packet. The packet is
@@ -664,12 +1040,22 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 {
     err_t result;
     struct ethernetif *ethernetif = netif->state;
+#if !ETHERNETIF_TX_SCATTER_GATHER
     struct pbuf *q;
     unsigned char *pucBuffer;
     unsigned char *pucChar;
+#endif
 
     LWIP_ASSERT("Output packet buffer empty", p);
 
+#if ETHERNETIF_TX_SCATTER_GATHER
+#if ETH_PAD_SIZE
+    pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
+#endif
+
+    /* Send frame straight from the pbufs. */
+    result = enet_send_frame_sg(ethernetif, p);
+#else
     pucBuffer = enet_get_tx_buffer(ethernetif);
     if (pucBuffer == NULL)
     {
@@ -717,6 +1103,7 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 
     /* Send frame. */
     result = enet_send_frame(ethernetif, pucBuffer, p->tot_len);
+#endif /* ETHERNETIF_TX_SCATTER_GATHER */
 
     MIB2_STATS_NETIF_ADD(netif, ifoutoctets, p->tot_len);
     if (((u8_t *)p->payload)[0] & 1)
@@ -896,6 +1283,30 @@ static void enet_read_frame(struct ethernetif *ethernetif, uint8_t *data, uint32
 #endif /* FSL_FEATURE_SOC_*_ENET_COUNT */
 }
 
+#if ETHERNETIF_CHECKSUM_OFFLOAD && defined(ENET_ENHANCEDBUFFERDESCRIPTOR_MODE)
+/**
+ * Checks the checksum status the ENET left in the descriptor of the next frame
+ * and counts the errors. Frames the ENET cannot check (e.g. IP fragments)
+ * report no error and are verified in software.
+ */
+static bool enet_rx_checksum_error(struct ethernetif *ethernetif)
+{
+    uint16_t status = ethernetif->handle.rxBdCurrent[0]->controlExtend0;
+
+    if (status & ENET_BUFFDESCRIPTOR_RX_IPHEADCHECKSUM_MASK)
+    {
+        ethernetif->chksumStats.rxIpHeaderErrors++;
+        return true;
+    }
+    if (status & ENET_BUFFDESCRIPTOR_RX_PROTOCOLCHECKSUM_MASK)
+    {
+        ethernetif->chksumStats.rxProtocolErrors++;
+        return true;
+    }
+    return false;
+}
+#endif
+
 /**
  * Should allocate a pbuf and transfer the bytes of the incoming
  * packet from the interface into the pbuf.
@@ -916,6 +1327,21 @@ static struct pbuf *low_level_input(struct netif *netif)
        variable. */
     status = enet_get_rx_frame_size(ethernetif, &len);
 
+#if ETHERNETIF_CHECKSUM_OFFLOAD && defined(ENET_ENHANCEDBUFFERDESCRIPTOR_MODE)
+    /* Drop frames with a bad checksum here and go on with the next one: a NULL
+       return ends the drain of ethernetif_input() until the next interrupt. */
+    while ((kStatus_Success == status) && (len != 0) && enet_rx_checksum_error(ethernetif))
+    {
+        enet_read_frame(ethernetif, NULL, 0U);
+
+        LINK_STATS_INC(link.chkerr);
+        LINK_STATS_INC(link.drop);
+        MIB2_STATS_NETIF_INC(netif, ifinerrors);
+
+        status = enet_get_rx_frame_size(ethernetif, &len);
+    }
+#endif
+
     if (kStatus_ENET_RxFrameEmpty != status)
     {
         /* Call enet_read_frame when there is a received frame. */
@@ -925,37 +1351,47 @@ static struct pbuf *low_level_input(struct netif *netif)
             len += ETH_PAD_SIZE; /* allow room for Ethernet padding */
 #endif
 
-            /* We allocate a pbuf chain of pbufs from the pool. */
-            p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
-
-            if (p != NULL)
+#if ETHERNETIF_RX_ZERO_COPY
+            /* Hand the DMA buffer itself to lwIP if a spare one can re-arm the descriptor. */
+            p = enet_rx_frame_zero_copy(ethernetif, len);
+            if (p == NULL)
+#endif
             {
+                /* We allocate a pbuf chain of pbufs from the pool. */
+                p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+
+                if (p != NULL)
+                {
 #if ETH_PAD_SIZE
-                pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
+                    pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
 #endif
-                if (p->next == 0) /* One-chain buffer.*/
-                {
-                    enet_read_frame(ethernetif, p->payload, p->len);
-                }
-                else    /* Multi-chain buffer.*/
-                {
-                    uint8_t data_tmp[ENET_FRAME_MAX_FRAMELEN];
-                    uint32_t data_tmp_len = 0;
+                    if (p->next == 0) /* One-chain buffer.*/
+                    {
+                        enet_read_frame(ethernetif, p->payload, p->len);
+                    }
+                    else    /* Multi-chain buffer.*/
+                    {
+                        uint8_t data_tmp[ENET_FRAME_MAX_FRAMELEN];
+                        uint32_t data_tmp_len = 0;
 
-                    enet_read_frame(ethernetif, data_tmp, p->tot_len);
+                        enet_read_frame(ethernetif, data_tmp, p->tot_len);
 
-                    /* We iterate over the pbuf chain until we have read the entire
-                    * packet into the pbuf. */
-                    for (q = p; (q != NULL) && ((data_tmp_len + q->len) <= sizeof(data_tmp)); q = q->next)
-                    {
-                        /* Read enough bytes to fill this pbuf in the chain. The
-                        * available data in the pbuf is given by the q->len
-                        * variable. */
-                        memcpy(q->payload,  &data_tmp[data_tmp_len], q->len);
-                        data_tmp_len += q->len;
+                        /* We iterate over the pbuf chain until we have read the entire
+                        * packet into the pbuf. */
+                        for (q = p; (q != NULL) && ((data_tmp_len + q->len) <= sizeof(data_tmp)); q = q->next)
+                        {
+                            /* Read enough bytes to fill this pbuf in the chain. The
+                            * available data in the pbuf is given by the q->len
+                            * variable. */
+                            memcpy(q->payload,  &data_tmp[data_tmp_len], q->len);
+                            data_tmp_len += q->len;
+                        }
                     }
                 }
+            }
 
+            if (p != NULL)
+            {
                 MIB2_STATS_NETIF_ADD(netif, ifinoctets, p->tot_len);
                 if (((u8_t *)p->payload)[0] & 1)
                 {
@@ -1009,6 +1445,85 @@ static struct pbuf *low_level_input(struct netif *netif)
     return p;
 }
 
+#if ETHERNETIF_RX_BATCH
+static void enet_rx_batch_put(struct ethernetif *ethernetif, enet_rx_batch_t *batch)
+{
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    batch->count = 0U;
+    SYS_ARCH_PROTECT(old_level);
+    batch->next = ethernetif->RxBatchFree;
+    ethernetif->RxBatchFree = batch;
+    SYS_ARCH_UNPROTECT(old_level);
+}
+
+static enet_rx_batch_t *enet_rx_batch_get(struct ethernetif *ethernetif)
+{
+    enet_rx_batch_t *batch;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    SYS_ARCH_PROTECT(old_level);
+    batch = ethernetif->RxBatchFree;
+    if (batch != NULL)
+    {
+        ethernetif->RxBatchFree = batch->next;
+    }
+    SYS_ARCH_UNPROTECT(old_level);
+    return batch;
+}
+
+/**
+ * Runs in the tcpip thread and feeds every frame of a batch to the stack,
+ * as tcpip_input() would have done for each of them.
+ */
+static void enet_rx_batch_callback(void *ctx)
+{
+    enet_rx_batch_t *batch = (enet_rx_batch_t *)ctx;
+    struct netif *netif = batch->netif;
+    uint8_t i;
+
+    for (i = 0U; i < batch->count; i++)
+    {
+        if (ethernet_input(batch->frames[i], netif) != ERR_OK)
+        {
+            pbuf_free(batch->frames[i]);
+        }
+    }
+    enet_rx_batch_put((struct ethernetif *)netif->state, batch);
+}
+
+static void enet_rx_batch_post(struct ethernetif *ethernetif, enet_rx_batch_t *batch)
+{
+    uint8_t i;
+
+    if (tcpip_trycallback(batch->msg) != ERR_OK)
+    {
+        LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: tcpip mailbox full\n"));
+        for (i = 0U; i < batch->count; i++)
+        {
+            pbuf_free(batch->frames[i]);
+            LINK_STATS_INC(link.drop);
+            MIB2_STATS_NETIF_INC(batch->netif, ifindiscards);
+        }
+        enet_rx_batch_put(ethernetif, batch);
+    }
+}
+
+static void enet_rx_batch_init(struct netif *netif, struct ethernetif *ethernetif)
+{
+    uint32_t i;
+
+    ethernetif->RxBatchFree = NULL;
+    for (i = 0U; i < ETHERNETIF_RX_BATCH_NUM; i++)
+    {
+        ethernetif->RxBatches[i].netif = netif;
+        ethernetif->RxBatches[i].msg = tcpip_callbackmsg_new(enet_rx_batch_callback, &ethernetif->RxBatches[i]);
+        LWIP_ASSERT("Cannot allocate RX batch message!", (ethernetif->RxBatches[i].msg != NULL));
+        enet_rx_batch_put(ethernetif, &ethernetif->RxBatches[i]);
+    }
+}
+#endif /* ETHERNETIF_RX_BATCH */
+
 /**
  * This function should be called when a packet is ready to be read
  * from the interface. It uses the function low_level_input() that
@@ -1021,12 +1536,38 @@ static struct pbuf *low_level_input(struct netif *netif)
 void ethernetif_input(struct netif *netif)
 {
     struct pbuf *p;
+#if ETHERNETIF_RX_BATCH
+    struct ethernetif *ethernetif;
+    enet_rx_batch_t *batch = NULL;
+#endif
+    STATS_HIST_DECL(t);
 
     LWIP_ASSERT("netif != NULL", (netif != NULL));
+    STATS_HIST_START(t);
+#if ETHERNETIF_RX_BATCH
+    ethernetif = netif->state;
+#endif
 
     /* move received packet into a new pbuf */
     while ((p = low_level_input(netif)) != NULL)
     {
+#if ETHERNETIF_RX_BATCH
+        if (batch == NULL)
+        {
+            batch = enet_rx_batch_get(ethernetif);
+        }
+        if (batch != NULL)
+        {
+            batch->frames[batch->count++] = p;
+            if (batch->count == ETHERNETIF_RX_BATCH)
+            {
+                enet_rx_batch_post(ethernetif, batch);
+                batch = NULL;
+            }
+            continue;
+        }
+        /* All batches are still queued: fall back to one message per frame. */
+#endif
         /* pass all packets to ethernet_input, which decides what packets it supports */
         if (netif->input(p, netif) != ERR_OK)
         {
@@ -1035,7 +1576,26 @@ void ethernetif_input(struct netif *netif)
             p = NULL;
         }
     }
+#if ETHERNETIF_RX_BATCH
+    if (batch != NULL)
+    {
+        enet_rx_batch_post(ethernetif, batch);
+    }
+#endif
+    STATS_HIST_STOP(STATS_HIST_NETIF_INPUT, t);
+}
+
+#if ETHERNETIF_CHECKSUM_OFFLOAD
+void ethernetif_get_checksum_stats(struct netif *netif, ethernetif_checksum_stats_t *stats)
+{
+    struct ethernetif *ethernetif = netif->state;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    SYS_ARCH_PROTECT(old_level);
+    *stats = ethernetif->chksumStats;
+    SYS_ARCH_UNPROTECT(old_level);
 }
+#endif /* ETHERNETIF_CHECKSUM_OFFLOAD */
 
 static ENET_Type *get_enet_base(const uint8_t enetIdx)
 {
@@ -1045,7 +1605,7 @@ static ENET_Type *get_enet_base(const uint8_t enetIdx)
 
     for (arrayIdx = 0, enetCount = 0; arrayIdx < ARRAY_SIZE(enets); arrayIdx++)
     {
-        if (enets[arrayIdx] != 0U)    /* process only defined positions */
+        if (enets[arrayIdx] != NULL)  /* process only defined positions */
         {                             /* (some SOC headers count ENETs from 1 instead of 0) */
             if (enetCount == enetIdx)
             {
@@ -1105,6 +1665,15 @@ static err_t ethernetif_init(struct netif *netif, struct ethernetif *ethernetif,
     ethernetif->base = get_enet_base(enetIdx);
     LWIP_ASSERT("ethernetif->base != NULL", (ethernetif->base != NULL));
 
+#if ETHERNETIF_RX_BATCH
+    enet_rx_batch_init(netif, ethernetif);
+#endif
+
+#if ETHERNETIF_CHECKSUM_OFFLOAD
+    memset(&ethernetif->chksumStats, 0, sizeof(ethernetif->chksumStats));
+    NETIF_SET_CHECKSUM_CTRL(netif, NETIF_CHECKSUM_ENABLE_ALL & ~ETHERNETIF_CHECKSUM_HW);
+#endif
+
     /* initialize the hardware */
     low_level_init(netif, enetIdx, ethernetifConfig);
 
@@ -1128,13 +1697,19 @@ err_t ethernetif0_init(struct netif *netif)
     static struct ethernetif ethernetif_0;
     AT_NONCACHEABLE_SECTION_ALIGN(static enet_rx_bd_struct_t rxBuffDescrip_0[ENET_RXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
     AT_NONCACHEABLE_SECTION_ALIGN(static enet_tx_bd_struct_t txBuffDescrip_0[ENET_TXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
-    SDK_ALIGN(static rx_buffer_t rxDataBuff_0[ENET_RXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
+    SDK_ALIGN(static rx_buffer_t rxDataBuff_0[ENET_RXBUFF_TOTAL_NUM], FSL_ENET_BUFF_ALIGNMENT);
     SDK_ALIGN(static tx_buffer_t txDataBuff_0[ENET_TXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
+#if ETHERNETIF_RX_ZERO_COPY
+    static rx_pbuf_wrapper_t rxPbufs_0[ENET_RXBUFF_TOTAL_NUM];
+#endif
 
     ethernetif_0.RxBuffDescrip = &(rxBuffDescrip_0[0]);
     ethernetif_0.TxBuffDescrip = &(txBuffDescrip_0[0]);
     ethernetif_0.RxDataBuff = &(rxDataBuff_0[0]);
     ethernetif_0.TxDataBuff = &(txDataBuff_0[0]);
+#if ETHERNETIF_RX_ZERO_COPY
+    ethernetif_0.RxPbufs = &(rxPbufs_0[0]);
+#endif
 
     return ethernetif_init(netif, &ethernetif_0, 0U, (ethernetif_config_t *)netif->state);
 }
@@ -1158,13 +1733,19 @@ err_t ethernetif1_init(struct netif *netif)
     static struct ethernetif ethernetif_1;
     AT_NONCACHEABLE_SECTION_ALIGN(static enet_rx_bd_struct_t rxBuffDescrip_1[ENET_RXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
     AT_NONCACHEABLE_SECTION_ALIGN(static enet_tx_bd_struct_t txBuffDescrip_1[ENET_TXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
-    SDK_ALIGN(static rx_buffer_t rxDataBuff_1[ENET_RXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
+    SDK_ALIGN(static rx_buffer_t rxDataBuff_1[ENET_RXBUFF_TOTAL_NUM], FSL_ENET_BUFF_ALIGNMENT);
     SDK_ALIGN(static tx_buffer_t txDataBuff_1[ENET_TXBD_NUM], FSL_ENET_BUFF_ALIGNMENT);
+#if ETHERNETIF_RX_ZERO_COPY
+    static rx_pbuf_wrapper_t rxPbufs_1[ENET_RXBUFF_TOTAL_NUM];
+#endif
 
     ethernetif_1.RxBuffDescrip = &(rxBuffDescrip_1[0]);
     ethernetif_1.TxBuffDescrip = &(txBuffDescrip_1[0]);
     ethernetif_1.RxDataBuff = &(rxDataBuff_1[0]);
     ethernetif_1.TxDataBuff = &(txDataBuff_1[0]);
+#if ETHERNETIF_RX_ZERO_COPY
+    ethernetif_1.RxPbufs = &(rxPbufs_1[0]);
+#endif
 
     return ethernetif_init(netif, &ethernetif_1, 1U, (ethernetif_config_t *)netif->state);
 }
@@ -87,6 +87,50 @@
     #define ENET_TXBUFF_SIZE (ENET_FRAME_MAX_FRAMELEN)
 #endif
 
+/*  ETHERNETIF_RX_ZERO_COPY==1: Pass received ENET buffers to lwIP as custom
+ *  PBUF_REF pbufs instead of copying them into PBUF_POOL pbufs. The descriptor
+ *  is re-armed with a spare buffer, and the buffer returns to the spare pool
+ *  when the pbuf is freed. Frames arriving while no spare buffer is left are
+ *  copied as before. Requires LWIP_SUPPORT_CUSTOM_PBUF and ETH_PAD_SIZE == 0. */
+#ifndef ETHERNETIF_RX_ZERO_COPY
+    #define ETHERNETIF_RX_ZERO_COPY (0)
+#endif
+/*  Number of spare receive buffers used to re-arm descriptors in zero-copy mode.
+ *  Bounds how many received frames the stack may hold at once without copying. */
+#ifndef ENET_RXBUFF_POOL_NUM
+    #define ENET_RXBUFF_POOL_NUM (2 * ENET_RXBD_NUM)
+#endif
+
+/*  ETHERNETIF_TX_SCATTER_GATHER==1: Map every pbuf of an outgoing frame onto
+ *  its own TX buffer descriptor instead of copying the frame into one buffer.
+ *  The frame is held with pbuf_ref() until the ENET reports it as sent.
+ *  Chains longer than the descriptor ring are still copied. */
+#ifndef ETHERNETIF_TX_SCATTER_GATHER
+    #define ETHERNETIF_TX_SCATTER_GATHER (0)
+#endif
+
+/*  ETHERNETIF_RX_BATCH: Maximum number of received frames handed to the tcpip
+ *  thread in one message (1..32). The receive interrupt drains the descriptor
+ *  ring into a batch and posts it once, instead of calling tcpip_input() per
+ *  frame. 0 keeps one message per frame. */
+#ifndef ETHERNETIF_RX_BATCH
+    #define ETHERNETIF_RX_BATCH (0)
+#endif
+/*  Number of batches that may wait for the tcpip thread at once. Frames
+ *  received while all of them are queued go through tcpip_input() one by one. */
+#ifndef ETHERNETIF_RX_BATCH_NUM
+    #define ETHERNETIF_RX_BATCH_NUM (2)
+#endif
+
+/*  ETHERNETIF_CHECKSUM_OFFLOAD==1: Let the ENET insert IP header and TCP/UDP/ICMP
+ *  checksums on transmit and verify them on receive. Software checksums are
+ *  switched off for this netif through its NETIF_CHECKSUM_* flags, which needs
+ *  LWIP_CHECKSUM_CTRL_PER_NETIF. Fragmented datagrams are still checksummed
+ *  in software. */
+#ifndef ETHERNETIF_CHECKSUM_OFFLOAD
+    #define ETHERNETIF_CHECKSUM_OFFLOAD (0)
+#endif
+
 #define ENET_OK             (0U)
 #define ENET_ERROR          (0xFFU)
 #define ENET_TIMEOUT        (0xFFFU)
@@ -125,6 +169,19 @@ typedef struct ethernetif_config
     uint8_t macAddress[NETIF_MAX_HWADDR_LEN];
 } ethernetif_config_t;
 
+#if ETHERNETIF_CHECKSUM_OFFLOAD
+/**
+ * Received frames dropped because the ENET found a bad checksum.
+ * Counted with enhanced buffer descriptors only. With legacy descriptors
+ * the MAC discards such frames itself and both counters stay 0.
+ */
+typedef struct ethernetif_checksum_stats
+{
+    uint32_t rxIpHeaderErrors;
+    uint32_t rxProtocolErrors;
+} ethernetif_checksum_stats_t;
+#endif
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* __cplusplus */
@@ -153,6 +210,16 @@ err_t ethernetif1_init(struct netif *netif);
  */
 void ethernetif_input( struct netif *netif);
 
+#if ETHERNETIF_CHECKSUM_OFFLOAD
+/**
+ * Returns the checksum offload failure counters of an ENET interface.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ * @param stats receives the counters
+ */
+void ethernetif_get_checksum_stats(struct netif *netif, ethernetif_checksum_stats_t *stats);
+#endif
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
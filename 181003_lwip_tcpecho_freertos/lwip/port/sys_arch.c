@@ -82,6 +82,20 @@
 #include "lwip/init.h"
 #endif
 
+#if LWIP_HOST_BUILD
+#include <stdlib.h>
+#endif
+
+/* Non-zero when called from an interrupt handler. */
+#if LWIP_HOST_BUILD
+/* Simulated interrupts of the host port, see host/port.c. */
+#define sys_arch_in_isr() xPortIsInsideInterrupt()
+#elif defined(__CA7_REV)
+#define sys_arch_in_isr() SystemGetIRQNestingLevel()
+#else
+#define sys_arch_in_isr() __get_IPSR()
+#endif
+
 #if LWIP_SOCKET_SET_ERRNO
 #ifndef errno
 int errno = 0;
@@ -98,12 +112,32 @@ void sys_assert( char *pcMessage )
     PRINTF(pcMessage);
     PRINTF("\n\r");
 #endif
+#if LWIP_HOST_BUILD
+    abort();
+#else
 #if !NO_SYS
     portENTER_CRITICAL();
 #endif
     for (;;)
     {}
+#endif
+}
+
+#if LWIP_HOST_BUILD && LWIP_STATS_HIST
+#include <time.h>
+
+/*
+ * Cycle counter of the host build: the monotonic clock in nanoseconds,
+ * truncated to 32 bits like the DWT counter of the target.
+ */
+u32_t sys_arch_cycles( void )
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u32_t)((u32_t)ts.tv_sec * 1000000000UL + (u32_t)ts.tv_nsec);
 }
+#endif
 
 /************************************************************************
 * Generates a pseudo-random number.
@@ -117,6 +151,143 @@ u32_t lwip_rand(void)
 }
 
 #if !NO_SYS
+#if LWIP_SYS_MBOX_SPSC
+/* Mailbox handle. Either wraps a FreeRTOS queue or, when queue is NULL, is
+ * a ring of pointers with one producer and one consumer. head is only
+ * written by the producer and tail only by the consumer. */
+struct sys_mbox
+{
+    QueueHandle_t queue;
+    volatile u32_t head;
+    volatile u32_t tail;
+    u32_t mask;
+    TaskHandle_t volatile reader;   /* consumer blocked on an empty ring */
+    TaskHandle_t volatile writer;   /* producer blocked on a full ring */
+    void **ring;
+};
+
+#define SYS_MBOX_QUEUE( pxMailBox ) ( ( *( pxMailBox ) )->queue )
+#define SYS_MBOX_IS_RING( pxMailBox ) ( ( *( pxMailBox ) )->queue == NULL )
+
+/* Orders the ring slot against the index that publishes it. */
+#if LWIP_HOST_BUILD
+#define sys_mbox_ring_barrier() __sync_synchronize()
+#else
+#define sys_mbox_ring_barrier() __DMB()
+#endif
+
+/* Wakes the task blocked on the other end of the ring, if any. */
+static void sys_mbox_ring_wake( TaskHandle_t xTask )
+{
+    portBASE_TYPE taskToWake = pdFALSE;
+
+    if( xTask == NULL )
+    {
+        return;
+    }
+    if( sys_arch_in_isr() )
+    {
+        vTaskNotifyGiveFromISR( xTask, &taskToWake );
+        portYIELD_FROM_ISR( taskToWake );
+    }
+    else
+    {
+        xTaskNotifyGive( xTask );
+    }
+}
+
+static int sys_mbox_ring_put( struct sys_mbox *pxRing, void *pvMsg )
+{
+u32_t ulHead = pxRing->head;
+
+    if( ( ulHead - pxRing->tail ) > pxRing->mask )
+    {
+        return 0;
+    }
+    pxRing->ring[ ulHead & pxRing->mask ] = pvMsg;
+    sys_mbox_ring_barrier();
+    pxRing->head = ulHead + 1UL;
+    /* Publish head before looking for a reader that went to sleep on it. */
+    sys_mbox_ring_barrier();
+    sys_mbox_ring_wake( pxRing->reader );
+    return 1;
+}
+
+static int sys_mbox_ring_get( struct sys_mbox *pxRing, void **ppvMsg )
+{
+u32_t ulTail = pxRing->tail;
+
+    if( ulTail == pxRing->head )
+    {
+        return 0;
+    }
+    sys_mbox_ring_barrier();
+    *ppvMsg = pxRing->ring[ ulTail & pxRing->mask ];
+    sys_mbox_ring_barrier();
+    pxRing->tail = ulTail + 1UL;
+    sys_mbox_ring_barrier();
+    sys_mbox_ring_wake( pxRing->writer );
+    return 1;
+}
+
+static void sys_mbox_ring_post( struct sys_mbox *pxRing, void *pvMsg )
+{
+    while( !sys_mbox_ring_put( pxRing, pvMsg ) )
+    {
+        pxRing->writer = xTaskGetCurrentTaskHandle();
+        sys_mbox_ring_barrier();
+        /* Re-check after announcing ourselves so a concurrent get is not missed. */
+        if( ( pxRing->head - pxRing->tail ) > pxRing->mask )
+        {
+            ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        }
+        pxRing->writer = NULL;
+    }
+}
+
+static u32_t sys_mbox_ring_fetch( struct sys_mbox *pxRing, void **ppvMsg, u32_t ulTimeOut, TickType_t xStartTime )
+{
+TickType_t xTimeOut = ulTimeOut / portTICK_PERIOD_MS;
+TickType_t xElapsed, xWait;
+
+    while( !sys_mbox_ring_get( pxRing, ppvMsg ) )
+    {
+        xElapsed = xTaskGetTickCount() - xStartTime;
+        if( ulTimeOut == 0UL )
+        {
+            xWait = portMAX_DELAY;
+        }
+        else if( xElapsed >= xTimeOut )
+        {
+            *ppvMsg = NULL;
+            return SYS_ARCH_TIMEOUT;
+        }
+        else
+        {
+            xWait = xTimeOut - xElapsed;
+        }
+
+        pxRing->reader = xTaskGetCurrentTaskHandle();
+        sys_mbox_ring_barrier();
+        /* Re-check after announcing ourselves so a concurrent put is not missed. */
+        if( pxRing->tail == pxRing->head )
+        {
+            ulTaskNotifyTake( pdTRUE, xWait );
+        }
+        pxRing->reader = NULL;
+    }
+
+    xElapsed = ( xTaskGetTickCount() - xStartTime ) * portTICK_PERIOD_MS;
+    if( ( ulTimeOut == 0UL ) && ( xElapsed == 0UL ) )
+    {
+        xElapsed = 1UL;
+    }
+    return xElapsed;
+}
+#else
+#define SYS_MBOX_QUEUE( pxMailBox ) ( *( pxMailBox ) )
+#endif /* LWIP_SYS_MBOX_SPSC */
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_mbox_new
  *---------------------------------------------------------------------------*
@@ -130,7 +301,21 @@ u32_t lwip_rand(void)
 err_t sys_mbox_new( sys_mbox_t *pxMailBox, int iSize )
 {
 err_t xReturn = ERR_MEM;
+#if LWIP_SYS_MBOX_SPSC
+    *pxMailBox = pvPortMalloc( sizeof( struct sys_mbox ) );
+    if( *pxMailBox == NULL )
+    {
+        return ERR_MEM;
+    }
+    ( *pxMailBox )->queue = xQueueCreate( iSize, sizeof( void * ) );
+    if( ( *pxMailBox )->queue == NULL )
+    {
+        vPortFree( *pxMailBox );
+        *pxMailBox = NULL;
+    }
+#else
     *pxMailBox = xQueueCreate( iSize, sizeof( void * ) );
+#endif
     if( *pxMailBox != NULL )
     {
         xReturn = ERR_OK;
@@ -139,6 +324,47 @@ err_t xReturn = ERR_MEM;
     return xReturn;
 }
 
+#if LWIP_SYS_MBOX_SPSC
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_new_spsc
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Creates a new mailbox backed by a lock-free ring of pointers. Only
+ *      one context may post and only one thread may fetch at a time.
+ *      The ring size is rounded up to a power of two.
+ * Inputs:
+ *      int size                -- Minimum number of elements in the mailbox
+ * Outputs:
+ *      sys_mbox_t              -- Handle to new mailbox
+ *---------------------------------------------------------------------------*/
+err_t sys_mbox_new_spsc( sys_mbox_t *pxMailBox, int iSize )
+{
+u32_t ulSize = 1UL;
+struct sys_mbox *pxRing;
+
+    while( ulSize < ( u32_t )iSize )
+    {
+        ulSize <<= 1;
+    }
+
+    pxRing = pvPortMalloc( sizeof( struct sys_mbox ) + ulSize * sizeof( void * ) );
+    *pxMailBox = pxRing;
+    if( pxRing == NULL )
+    {
+        return ERR_MEM;
+    }
+    pxRing->queue = NULL;
+    pxRing->head = 0UL;
+    pxRing->tail = 0UL;
+    pxRing->mask = ulSize - 1UL;
+    pxRing->reader = NULL;
+    pxRing->writer = NULL;
+    pxRing->ring = ( void ** )( pxRing + 1 );
+    SYS_STATS_INC_USED( mbox );
+    return ERR_OK;
+}
+#endif /* LWIP_SYS_MBOX_SPSC */
+
 
 /*---------------------------------------------------------------------------*
  * Routine:  sys_mbox_free
@@ -156,7 +382,16 @@ void sys_mbox_free( sys_mbox_t *pxMailBox )
 {
 unsigned long ulMessagesWaiting;
 
-    ulMessagesWaiting = uxQueueMessagesWaiting( *pxMailBox );
+#if LWIP_SYS_MBOX_SPSC
+    if( SYS_MBOX_IS_RING( pxMailBox ) )
+    {
+        ulMessagesWaiting = ( *pxMailBox )->head - ( *pxMailBox )->tail;
+    }
+    else
+#endif
+    {
+        ulMessagesWaiting = uxQueueMessagesWaiting( SYS_MBOX_QUEUE( pxMailBox ) );
+    }
     configASSERT( ( ulMessagesWaiting == 0 ) );
 
     #if SYS_STATS
@@ -170,7 +405,15 @@ unsigned long ulMessagesWaiting;
     }
     #endif /* SYS_STATS */
 
-    vQueueDelete( *pxMailBox );
+#if LWIP_SYS_MBOX_SPSC
+    if( !SYS_MBOX_IS_RING( pxMailBox ) )
+    {
+        vQueueDelete( SYS_MBOX_QUEUE( pxMailBox ) );
+    }
+    vPortFree( *pxMailBox );
+#else
+    vQueueDelete( SYS_MBOX_QUEUE( pxMailBox ) );
+#endif
 }
 
 /*---------------------------------------------------------------------------*
@@ -184,7 +427,14 @@ unsigned long ulMessagesWaiting;
  *---------------------------------------------------------------------------*/
 void sys_mbox_post( sys_mbox_t *pxMailBox, void *pxMessageToPost )
 {
-    while( xQueueSendToBack( *pxMailBox, &pxMessageToPost, portMAX_DELAY ) != pdTRUE );
+#if LWIP_SYS_MBOX_SPSC
+    if( SYS_MBOX_IS_RING( pxMailBox ) )
+    {
+        sys_mbox_ring_post( *pxMailBox, pxMessageToPost );
+        return;
+    }
+#endif
+    while( xQueueSendToBack( SYS_MBOX_QUEUE( pxMailBox ), &pxMessageToPost, portMAX_DELAY ) != pdTRUE );
 }
 
 /*---------------------------------------------------------------------------*
@@ -203,17 +453,27 @@ void sys_mbox_post( sys_mbox_t *pxMailBox, void *pxMessageToPost )
 err_t sys_mbox_trypost( sys_mbox_t *pxMailBox, void *pxMessageToPost )
 {
     portBASE_TYPE taskToWake = pdFALSE;
-    if( xQueueIsQueueFullFromISR( *pxMailBox ))
+#if LWIP_SYS_MBOX_SPSC
+    if( SYS_MBOX_IS_RING( pxMailBox ) )
     {
-        return ERR_VAL;
+        if( !sys_mbox_ring_put( *pxMailBox, pxMessageToPost ) )
+        {
+            SYS_STATS_INC( mbox.err );
+            return ERR_MEM;
+        }
+        return ERR_OK;
     }
-#ifdef __CA7_REV
-    if (SystemGetIRQNestingLevel())
-#else
-    if (__get_IPSR())
 #endif
+    /* A full mailbox is ERR_MEM for both backends, as sys_mbox_trypost()
+    documents. */
+    if( xQueueIsQueueFullFromISR( SYS_MBOX_QUEUE( pxMailBox ) ))
     {
-        if (pdTRUE == xQueueSendFromISR(*pxMailBox, &pxMessageToPost, &taskToWake))
+        SYS_STATS_INC( mbox.err );
+        return ERR_MEM;
+    }
+    if (sys_arch_in_isr())
+    {
+        if (pdTRUE == xQueueSendFromISR(SYS_MBOX_QUEUE( pxMailBox ), &pxMessageToPost, &taskToWake))
         {
             if(taskToWake == pdTRUE)
             {
@@ -230,7 +490,7 @@ err_t sys_mbox_trypost( sys_mbox_t *pxMailBox, void *pxMessageToPost )
     }
     else
     {
-        if(pdTRUE == xQueueSend(*pxMailBox, &pxMessageToPost, 0) )
+        if(pdTRUE == xQueueSend(SYS_MBOX_QUEUE( pxMailBox ), &pxMessageToPost, 0) )
         {
             return ERR_OK;
         }
@@ -281,9 +541,16 @@ unsigned long ulReturn;
         ppvBuffer = &pvDummy;
     }
 
+#if LWIP_SYS_MBOX_SPSC
+    if( SYS_MBOX_IS_RING( pxMailBox ) )
+    {
+        return sys_mbox_ring_fetch( *pxMailBox, ppvBuffer, ulTimeOut, xStartTime );
+    }
+#endif
+
     if( ulTimeOut != 0UL )
     {
-        if( pdTRUE == xQueueReceive( *pxMailBox, &( *ppvBuffer ), ulTimeOut/ portTICK_PERIOD_MS ) )
+        if( pdTRUE == xQueueReceive( SYS_MBOX_QUEUE( pxMailBox ), &( *ppvBuffer ), ulTimeOut/ portTICK_PERIOD_MS ) )
         {
             xEndTime = xTaskGetTickCount();
             xElapsed = ( xEndTime - xStartTime ) * portTICK_PERIOD_MS;
@@ -299,7 +566,7 @@ unsigned long ulReturn;
     }
     else
     {
-        while( pdTRUE != xQueueReceive( *pxMailBox, &( *ppvBuffer ), portMAX_DELAY ) );
+        while( pdTRUE != xQueueReceive( SYS_MBOX_QUEUE( pxMailBox ), &( *ppvBuffer ), portMAX_DELAY ) );
         xEndTime = xTaskGetTickCount();
         xElapsed = ( xEndTime - xStartTime ) * portTICK_PERIOD_MS;
 
@@ -338,7 +605,14 @@ unsigned long ulReturn;
         ppvBuffer = &pvDummy;
     }
 
-    if( pdTRUE == xQueueReceive( *pxMailBox, &( *ppvBuffer ), 0UL ) )
+#if LWIP_SYS_MBOX_SPSC
+    if( SYS_MBOX_IS_RING( pxMailBox ) )
+    {
+        ulReturn = sys_mbox_ring_get( *pxMailBox, ppvBuffer ) ? ERR_OK : SYS_MBOX_EMPTY;
+    }
+    else
+#endif
+    if( pdTRUE == xQueueReceive( SYS_MBOX_QUEUE( pxMailBox ), &( *ppvBuffer ), 0UL ) )
     {
         ulReturn = ERR_OK;
     }
@@ -604,11 +878,7 @@ sys_prot_t sys_arch_protect( void )
 {
     sys_prot_t result = 0;
 
-#ifdef __CA7_REV
-    if (SystemGetIRQNestingLevel())
-#else
-    if (__get_IPSR())
-#endif    
+    if (sys_arch_in_isr())
     {
         result = portSET_INTERRUPT_MASK_FROM_ISR();
     }
@@ -632,11 +902,7 @@ sys_prot_t sys_arch_protect( void )
  *---------------------------------------------------------------------------*/
 void sys_arch_unprotect( sys_prot_t xValue )
 {
-#ifdef __CA7_REV
-    if (SystemGetIRQNestingLevel())
-#else
-    if (__get_IPSR())
-#endif
+    if (sys_arch_in_isr())
     {
         portCLEAR_INTERRUPT_MASK_FROM_ISR(xValue);
     }
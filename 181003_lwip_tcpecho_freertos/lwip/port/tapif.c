@@ -0,0 +1,490 @@
+/*
+ * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ */
+
+/*
+ * Host network interface for running the stack on the host FreeRTOS port
+ * (host/port.c). Frames are exchanged with a Linux TAP device. Without one,
+ * outgoing frames are only captured and clients have to run in-process
+ * against the netif loopback. Every frame can be captured to a pcap file.
+ *
+ * Reception works like the ENET driver: a host thread blocks in read() on the
+ * TAP device, queues the frame and raises a simulated interrupt, whose
+ * handler passes the queued frames to the stack.
+ *
+ * For benchmarks, the TAPIF_DELAY_MS environment variable holds every sent
+ * frame back for that many milliseconds, which emulates the round-trip time
+ * of a longer link.
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_HOST_BUILD
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+#include "lwip/snmp.h"
+#include "lwip/sys.h"
+#include "lwip/ethip6.h"
+#include "netif/etharp.h"
+
+#include "tapif.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/* Define those to better describe your network interface. */
+#define IFNAME0 't'
+#define IFNAME1 'p'
+
+#define TAPIF_FRAME_MAX_LEN (1514U)
+
+/**
+ * Helper struct to hold private data used to operate the host interface.
+ */
+struct tapif
+{
+    int fd;       /* TAP device, -1 if unavailable */
+    FILE *pcap;   /* capture file, NULL if disabled */
+    struct netif *netif;
+    /* Frames read and not yet passed to the stack. The reader thread fills
+     * rx_head, the interrupt handler drains rx_tail. */
+    pthread_mutex_t rx_lock;
+    pthread_cond_t rx_space;
+    u32_t rx_head;
+    u32_t rx_tail;
+    u16_t rx_length[TAPIF_RX_FRAMES];
+    u8_t rx_frame[TAPIF_RX_FRAMES][TAPIF_FRAME_MAX_LEN];
+    /* Sent frames held back by the emulated link delay. low_level_output()
+     * fills tx_head, the delay thread writes them out from tx_tail. */
+    u32_t tx_delay_ms; /* 0 writes frames immediately */
+    pthread_mutex_t tx_lock;
+    pthread_cond_t tx_ready;
+    u32_t tx_head;
+    u32_t tx_tail;
+    struct timespec tx_due[TAPIF_TX_DELAY_FRAMES];
+    u16_t tx_length[TAPIF_TX_DELAY_FRAMES];
+    u8_t tx_frame[TAPIF_TX_DELAY_FRAMES][TAPIF_FRAME_MAX_LEN];
+};
+
+/* Record headers of the classic libpcap file format. */
+struct pcap_file_header
+{
+    u32_t magic;
+    u16_t version_major;
+    u16_t version_minor;
+    s32_t thiszone;
+    u32_t sigfigs;
+    u32_t snaplen;
+    u32_t linktype;
+};
+
+struct pcap_record_header
+{
+    u32_t ts_sec;
+    u32_t ts_usec;
+    u32_t incl_len;
+    u32_t orig_len;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+static struct tapif tapif_0 = {.fd = -1,
+                               .rx_lock = PTHREAD_MUTEX_INITIALIZER,
+                               .rx_space = PTHREAD_COND_INITIALIZER,
+                               .tx_lock = PTHREAD_MUTEX_INITIALIZER,
+                               .tx_ready = PTHREAD_COND_INITIALIZER};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+static void tapif_pcap_open(struct tapif *tapif, const char *path)
+{
+    struct pcap_file_header hdr = {0xa1b2c3d4UL, 2U, 4U, 0, 0U, TAPIF_FRAME_MAX_LEN, 1U /* Ethernet */};
+
+    tapif->pcap = (path != NULL) ? fopen(path, "wb") : NULL;
+    if (tapif->pcap != NULL)
+    {
+        fwrite(&hdr, sizeof(hdr), 1, tapif->pcap);
+    }
+}
+
+static void tapif_pcap_write(struct tapif *tapif, const u8_t *frame, u32_t length)
+{
+    struct pcap_record_header rec;
+    u32_t now;
+
+    if (tapif->pcap == NULL)
+    {
+        return;
+    }
+
+    /* Stack time is good enough to line the capture up with lwIP debug output. */
+    now = sys_now();
+    rec.ts_sec = now / 1000U;
+    rec.ts_usec = (now % 1000U) * 1000U;
+    rec.incl_len = length;
+    rec.orig_len = length;
+    fwrite(&rec, sizeof(rec), 1, tapif->pcap);
+    fwrite(frame, length, 1, tapif->pcap);
+    fflush(tapif->pcap);
+}
+
+/**
+ * Opens and configures the TAP device.
+ * Returns the file descriptor, or -1 if TAP is unavailable.
+ */
+static int tapif_open(const char *deviceName)
+{
+    struct ifreq ifr;
+    int fd;
+
+    fd = open("/dev/net/tun", O_RDWR);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, deviceName, sizeof(ifr.ifr_name) - 1);
+
+    if (ioctl(fd, TUNSETIFF, (void *)&ifr) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Passes one received frame to the stack.
+ */
+static void tapif_input_frame(struct netif *netif, const u8_t *frame, u16_t length)
+{
+    struct pbuf *p;
+
+    tapif_pcap_write((struct tapif *)netif->state, frame, length);
+
+    p = pbuf_alloc(PBUF_RAW, length, PBUF_POOL);
+    if (p == NULL)
+    {
+        LWIP_DEBUGF(NETIF_DEBUG, ("tapif_input: Fail to allocate new memory space\n"));
+
+        LINK_STATS_INC(link.memerr);
+        LINK_STATS_INC(link.drop);
+        MIB2_STATS_NETIF_INC(netif, ifindiscards);
+        return;
+    }
+
+    pbuf_take(p, frame, length);
+
+    MIB2_STATS_NETIF_ADD(netif, ifinoctets, p->tot_len);
+    if (frame[0] & 1)
+    {
+        /* broadcast or multicast packet*/
+        MIB2_STATS_NETIF_INC(netif, ifinnucastpkts);
+    }
+    else
+    {
+        /* unicast packet*/
+        MIB2_STATS_NETIF_INC(netif, ifinucastpkts);
+    }
+    LINK_STATS_INC(link.recv);
+
+    /* pass all packets to ethernet_input, which decides what packets it supports */
+    if (netif->input(p, netif) != ERR_OK)
+    {
+        LWIP_DEBUGF(NETIF_DEBUG, ("tapif_input: IP input error\n"));
+        pbuf_free(p);
+    }
+}
+
+/**
+ * Queues a frame on the emulated link. A full link drops it, like the queue
+ * of a congested router.
+ */
+static err_t tapif_delay_output(struct tapif *tapif, struct pbuf *p)
+{
+    struct timespec *due;
+    u32_t slot;
+
+    pthread_mutex_lock(&tapif->tx_lock);
+    if ((tapif->tx_head - tapif->tx_tail) == TAPIF_TX_DELAY_FRAMES)
+    {
+        pthread_mutex_unlock(&tapif->tx_lock);
+        LINK_STATS_INC(link.drop);
+        return ERR_OK;
+    }
+    slot = tapif->tx_head % TAPIF_TX_DELAY_FRAMES;
+    tapif->tx_length[slot] = pbuf_copy_partial(p, tapif->tx_frame[slot], p->tot_len, 0U);
+    due = &tapif->tx_due[slot];
+    clock_gettime(CLOCK_MONOTONIC, due);
+    due->tv_sec += tapif->tx_delay_ms / 1000U;
+    due->tv_nsec += (long)(tapif->tx_delay_ms % 1000U) * 1000000L;
+    if (due->tv_nsec >= 1000000000L)
+    {
+        due->tv_nsec -= 1000000000L;
+        due->tv_sec++;
+    }
+    tapif->tx_head++;
+    pthread_cond_signal(&tapif->tx_ready);
+    pthread_mutex_unlock(&tapif->tx_lock);
+
+    tapif_pcap_write(tapif, tapif->tx_frame[slot], tapif->tx_length[slot]);
+
+    return ERR_OK;
+}
+
+/**
+ * Host thread writing the frames held back by the emulated link delay once
+ * they are due.
+ */
+static void *tapif_delay_thread(void *arg)
+{
+    struct tapif *tapif = (struct tapif *)arg;
+    u32_t slot;
+
+    while (1)
+    {
+        pthread_mutex_lock(&tapif->tx_lock);
+        while (tapif->tx_head == tapif->tx_tail)
+        {
+            pthread_cond_wait(&tapif->tx_ready, &tapif->tx_lock);
+        }
+        pthread_mutex_unlock(&tapif->tx_lock);
+
+        /* Only this thread moves tx_tail, the slot stays valid until it does. */
+        slot = tapif->tx_tail % TAPIF_TX_DELAY_FRAMES;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tapif->tx_due[slot], NULL) != 0)
+        {
+        }
+        if (write(tapif->fd, tapif->tx_frame[slot], tapif->tx_length[slot]) != (ssize_t)tapif->tx_length[slot])
+        {
+            LINK_STATS_INC(link.err);
+        }
+
+        pthread_mutex_lock(&tapif->tx_lock);
+        tapif->tx_tail++;
+        pthread_mutex_unlock(&tapif->tx_lock);
+    }
+
+    return NULL;
+}
+
+/**
+ * Sends a frame through the TAP device.
+ */
+static err_t low_level_output(struct netif *netif, struct pbuf *p)
+{
+    struct tapif *tapif = netif->state;
+    u8_t frame[TAPIF_FRAME_MAX_LEN];
+    u16_t length;
+
+    if (p->tot_len > sizeof(frame))
+    {
+        LINK_STATS_INC(link.lenerr);
+        return ERR_BUF;
+    }
+
+    if (((u8_t *)p->payload)[0] & 1)
+    {
+        /* broadcast or multicast packet*/
+        MIB2_STATS_NETIF_INC(netif, ifoutnucastpkts);
+    }
+    else
+    {
+        /* unicast packet */
+        MIB2_STATS_NETIF_INC(netif, ifoutucastpkts);
+    }
+
+    if ((tapif->fd >= 0) && (tapif->tx_delay_ms != 0U))
+    {
+        MIB2_STATS_NETIF_ADD(netif, ifoutoctets, p->tot_len);
+        LINK_STATS_INC(link.xmit);
+        return tapif_delay_output(tapif, p);
+    }
+
+    length = pbuf_copy_partial(p, frame, p->tot_len, 0U);
+    tapif_pcap_write(tapif, frame, length);
+
+    if ((tapif->fd >= 0) && (write(tapif->fd, frame, length) != (ssize_t)length))
+    {
+        LINK_STATS_INC(link.err);
+        MIB2_STATS_NETIF_INC(netif, ifouterrors);
+        return ERR_IF;
+    }
+
+    MIB2_STATS_NETIF_ADD(netif, ifoutoctets, length);
+    LINK_STATS_INC(link.xmit);
+
+    return ERR_OK;
+}
+
+/**
+ * Host thread reading the TAP device. It blocks in read(), outside of the
+ * simulated CPU, and only hands frames over through the ring. When the ring
+ * is full it waits for the interrupt handler to drain it rather than drop.
+ */
+static void *tapif_rx_thread(void *arg)
+{
+    struct tapif *tapif = (struct tapif *)arg;
+    u32_t slot;
+    ssize_t length;
+
+    while (1)
+    {
+        pthread_mutex_lock(&tapif->rx_lock);
+        while ((tapif->rx_head - tapif->rx_tail) == TAPIF_RX_FRAMES)
+        {
+            pthread_cond_wait(&tapif->rx_space, &tapif->rx_lock);
+        }
+        pthread_mutex_unlock(&tapif->rx_lock);
+
+        /* Only this thread writes rx_head, the slot is free until it moves. */
+        slot = tapif->rx_head % TAPIF_RX_FRAMES;
+        length = read(tapif->fd, tapif->rx_frame[slot], TAPIF_FRAME_MAX_LEN);
+        if (length <= 0)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&tapif->rx_lock);
+        tapif->rx_length[slot] = (u16_t)length;
+        tapif->rx_head++;
+        pthread_mutex_unlock(&tapif->rx_lock);
+
+        vPortGenerateSimulatedInterrupt(TAPIF_IRQ_LINE);
+    }
+
+    return NULL;
+}
+
+/**
+ * Simulated receive interrupt, passes every queued frame to the stack.
+ */
+static void tapif_rx_irq(void)
+{
+    struct tapif *tapif = &tapif_0;
+    u32_t head;
+
+    pthread_mutex_lock(&tapif->rx_lock);
+    head = tapif->rx_head;
+    pthread_mutex_unlock(&tapif->rx_lock);
+
+    while (tapif->rx_tail != head)
+    {
+        u32_t slot = tapif->rx_tail % TAPIF_RX_FRAMES;
+
+        tapif_input_frame(tapif->netif, tapif->rx_frame[slot], tapif->rx_length[slot]);
+
+        pthread_mutex_lock(&tapif->rx_lock);
+        tapif->rx_tail++;
+        pthread_cond_signal(&tapif->rx_space);
+        pthread_mutex_unlock(&tapif->rx_lock);
+    }
+}
+
+err_t tapif_init(struct netif *netif)
+{
+    const tapif_config_t *tapifConfig = (const tapif_config_t *)netif->state;
+
+    LWIP_ASSERT("netif != NULL", (netif != NULL));
+    LWIP_ASSERT("tapifConfig != NULL", (tapifConfig != NULL));
+
+    MIB2_INIT_NETIF(netif, snmp_ifType_ethernet_csmacd, 100000000);
+
+    tapif_0.fd = tapif_open((tapifConfig->deviceName != NULL) ? tapifConfig->deviceName : TAPIF_DEFAULT_DEVICE);
+    tapif_pcap_open(&tapif_0, tapifConfig->pcapPath);
+
+    netif->state = &tapif_0;
+    netif->name[0] = IFNAME0;
+    netif->name[1] = IFNAME1;
+#if LWIP_IPV4
+    netif->output = etharp_output;
+#endif
+#if LWIP_IPV6
+    netif->output_ip6 = ethip6_output;
+#endif /* LWIP_IPV6 */
+    netif->linkoutput = low_level_output;
+
+    netif->hwaddr_len = ETH_HWADDR_LEN;
+    memcpy(netif->hwaddr, tapifConfig->macAddress, NETIF_MAX_HWADDR_LEN);
+    netif->mtu = 1500;
+    netif->flags |= NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+
+    tapif_0.netif = netif;
+    if (tapif_0.fd >= 0)
+    {
+        const char *delay = getenv("TAPIF_DELAY_MS");
+        pthread_t thread;
+
+        vPortSetInterruptHandler(TAPIF_IRQ_LINE, tapif_rx_irq);
+        if (pthread_create(&thread, NULL, tapif_rx_thread, &tapif_0) != 0)
+        {
+            return ERR_IF;
+        }
+        pthread_detach(thread);
+
+        tapif_0.tx_delay_ms = (delay != NULL) ? (u32_t)strtoul(delay, NULL, 10) : 0U;
+        if (tapif_0.tx_delay_ms != 0U)
+        {
+            if (pthread_create(&thread, NULL, tapif_delay_thread, &tapif_0) != 0)
+            {
+                return ERR_IF;
+            }
+            pthread_detach(thread);
+            LWIP_PLATFORM_DIAG(("tapif: sent frames are delayed by %u ms", (unsigned int)tapif_0.tx_delay_ms));
+        }
+    }
+    else
+    {
+        LWIP_PLATFORM_DIAG(("tapif: TAP device unavailable, only in-process clients can connect"));
+    }
+
+    return ERR_OK;
+}
+
+#endif /* LWIP_HOST_BUILD */
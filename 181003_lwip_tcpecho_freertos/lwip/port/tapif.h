@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ */
+
+#ifndef TAPIF_H
+#define TAPIF_H
+
+#include "lwip/opt.h"
+
+#if LWIP_HOST_BUILD
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+/* Name of the TAP device the host build attaches to. */
+#ifndef TAPIF_DEFAULT_DEVICE
+    #define TAPIF_DEFAULT_DEVICE "tap0"
+#endif
+
+/* Received frames queued between the TAP reader thread and the stack. */
+#ifndef TAPIF_RX_FRAMES
+    #define TAPIF_RX_FRAMES (8U)
+#endif
+
+/* Sent frames the emulated link delay (TAPIF_DELAY_MS) can hold back. Must
+ * cover the data in flight at the largest window, more is dropped. */
+#ifndef TAPIF_TX_DELAY_FRAMES
+    #define TAPIF_TX_DELAY_FRAMES (512U)
+#endif
+
+/* Simulated interrupt line of the TAP receive interrupt. */
+#ifndef TAPIF_IRQ_LINE
+    #define TAPIF_IRQ_LINE (0U)
+#endif
+
+/**
+ * Helper struct to hold data for configuration of the host interface.
+ */
+typedef struct tapif_config
+{
+    const char *deviceName;  /* TAP device to open, NULL for TAPIF_DEFAULT_DEVICE */
+    const char *pcapPath;    /* file capturing every frame, or NULL */
+    u8_t macAddress[NETIF_MAX_HWADDR_LEN];
+} tapif_config_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * This function should be passed as a parameter to netif_add()
+ * in the host build, in place of ethernetif0_init().
+ * If the TAP device cannot be opened, the interface stays up without a
+ * link peer; in-process clients then reach the stack through the netif
+ * loopback (LWIP_NETIF_LOOPBACK).
+ */
+err_t tapif_init(struct netif *netif);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* LWIP_HOST_BUILD */
+
+#endif /* TAPIF_H */
@@ -717,6 +717,42 @@ netconn_send(struct netconn *conn, struct netbuf *buf)
   return err;
 }
 
+/**
+ * @ingroup netconn_udp
+ * Send several datagrams over a UDP or RAW netconn with a single call
+ * into the tcpip_thread. Sending stops at the first datagram that fails.
+ *
+ * @param conn the UDP or RAW netconn over which to send data
+ * @param bufs array of netbufs containing the datagrams to send
+ * @param count number of netbufs in bufs
+ * @param sent receives the number of datagrams sent
+ * @return ERR_OK if all datagrams were sent, else the error of the first
+ *         datagram that was not sent
+ */
+err_t
+netconn_sendv(struct netconn *conn, struct netbuf *bufs, u16_t count, u16_t *sent)
+{
+  API_MSG_VAR_DECLARE(msg);
+  err_t err;
+
+  LWIP_ERROR("netconn_sendv: invalid conn", (conn != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_sendv: invalid sent", (sent != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_sendv: invalid bufs", (bufs != NULL) || (count == 0), return ERR_ARG;);
+
+  LWIP_DEBUGF(API_LIB_DEBUG, ("netconn_sendv: sending %"U16_F" datagrams\n", count));
+
+  API_MSG_VAR_ALLOC(msg);
+  API_MSG_VAR_REF(msg).conn = conn;
+  API_MSG_VAR_REF(msg).msg.bv.bufs = bufs;
+  API_MSG_VAR_REF(msg).msg.bv.count = count;
+  API_MSG_VAR_REF(msg).msg.bv.sent = 0;
+  err = netconn_apimsg(lwip_netconn_do_sendv, &API_MSG_VAR_REF(msg));
+  *sent = API_MSG_VAR_REF(msg).msg.bv.sent;
+  API_MSG_VAR_FREE(msg);
+
+  return err;
+}
+
 /**
  * @ingroup netconn_tcp
  * Send data over a TCP netconn.
@@ -731,9 +767,40 @@ netconn_send(struct netconn *conn, struct netbuf *buf)
  * @param bytes_written pointer to a location that receives the number of written bytes
  * @return ERR_OK if data was sent, any other err_t on error
  */
+#if LWIP_TCP_ZEROCOPY
 err_t
 netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
                      u8_t apiflags, size_t *bytes_written)
+{
+  return netconn_write_partly_zc(conn, dataptr, size, apiflags, bytes_written, NULL);
+}
+
+/**
+ * @ingroup netconn_tcp
+ * Send data over a TCP netconn without copying it, see tcp_write_zc().
+ * Each pbuf referencing the data holds a reference on zc; after the last
+ * write using zc, give up the caller's reference with tcp_zc_release().
+ * zc->done is then called once the data has been acknowledged and freed,
+ * after which the buffer may be reused. Use netconn_zc_signal as callback
+ * to have a semaphore signalled instead.
+ *
+ * @param conn the TCP netconn over which to send data
+ * @param dataptr pointer to the application buffer that contains the data to send
+ * @param size size of the application data to send
+ * @param apiflags NETCONN_MORE and/or NETCONN_DONTBLOCK (NETCONN_COPY is ignored)
+ * @param bytes_written pointer to a location that receives the number of written bytes
+ * @param zc tracking object initialised by tcp_zc_init(), NULL to behave
+ *        like netconn_write_partly()
+ * @return ERR_OK if data was sent, any other err_t on error
+ */
+err_t
+netconn_write_partly_zc(struct netconn *conn, const void *dataptr, size_t size,
+                        u8_t apiflags, size_t *bytes_written, struct tcp_zc *zc)
+#else /* LWIP_TCP_ZEROCOPY */
+err_t
+netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
+                     u8_t apiflags, size_t *bytes_written)
+#endif /* LWIP_TCP_ZEROCOPY */
 {
   API_MSG_VAR_DECLARE(msg);
   err_t err;
@@ -762,6 +829,9 @@ netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
   API_MSG_VAR_REF(msg).msg.w.dataptr = dataptr;
   API_MSG_VAR_REF(msg).msg.w.apiflags = apiflags;
   API_MSG_VAR_REF(msg).msg.w.len = size;
+#if LWIP_TCP_ZEROCOPY
+  API_MSG_VAR_REF(msg).msg.w.zc = zc;
+#endif /* LWIP_TCP_ZEROCOPY */
 #if LWIP_SO_SNDTIMEO
   if (conn->send_timeout != 0) {
     /* get the time we started, which is later compared to
@@ -790,6 +860,22 @@ netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
   return err;
 }
 
+#if LWIP_TCP_ZEROCOPY
+/**
+ * @ingroup netconn_tcp
+ * Completion callback for tcp_zc_init() that signals the semaphore passed
+ * as its argument, for threads that want to block until a zero-copy buffer
+ * is free again.
+ *
+ * @param arg pointer to a sys_sem_t
+ */
+void
+netconn_zc_signal(void *arg)
+{
+  sys_sem_signal((sys_sem_t *)arg);
+}
+#endif /* LWIP_TCP_ZEROCOPY */
+
 /**
  * @ingroup netconn_tcp
  * Close or shutdown a TCP netconn (doesn't delete it).
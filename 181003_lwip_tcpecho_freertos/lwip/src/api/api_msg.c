@@ -65,6 +65,13 @@
   (conn)->flags &= ~ NETCONN_FLAG_IN_NONBLOCKING_CONNECT; }} while(0)
 #define IN_NONBLOCKING_CONNECT(conn) (((conn)->flags & NETCONN_FLAG_IN_NONBLOCKING_CONNECT) != 0)
 
+/* recvmbox and acceptmbox are only posted to from tcpip thread context and
+   read by the application thread owning the netconn: a port may provide a
+   cheaper single-producer/single-consumer mailbox for them. */
+#ifndef sys_mbox_new_spsc
+#define sys_mbox_new_spsc sys_mbox_new
+#endif
+
 /* forward declarations */
 #if LWIP_TCP
 #if LWIP_TCPIP_CORE_LOCKING
@@ -681,7 +688,7 @@ netconn_alloc(enum netconn_type t, netconn_callback callback)
     goto free_and_return;
   }
 
-  if (sys_mbox_new(&conn->recvmbox, size) != ERR_OK) {
+  if (sys_mbox_new_spsc(&conn->recvmbox, size) != ERR_OK) {
     goto free_and_return;
   }
 #if !LWIP_NETCONN_SEM_PER_THREAD
@@ -1353,7 +1360,7 @@ lwip_netconn_do_listen(void *m)
               }
               msg->err = ERR_OK;
               if (!sys_mbox_valid(&msg->conn->acceptmbox)) {
-                msg->err = sys_mbox_new(&msg->conn->acceptmbox, DEFAULT_ACCEPTMBOX_SIZE);
+                msg->err = sys_mbox_new_spsc(&msg->conn->acceptmbox, DEFAULT_ACCEPTMBOX_SIZE);
               }
               if (msg->err == ERR_OK) {
                 msg->conn->state = NETCONN_LISTEN;
@@ -1382,54 +1389,92 @@ lwip_netconn_do_listen(void *m)
 #endif /* LWIP_TCP */
 
 /**
- * Send some data on a RAW or UDP pcb contained in a netconn
- * Called from netconn_send
+ * Send one netbuf on the RAW or UDP pcb of a netconn.
+ * Called from lwip_netconn_do_send and lwip_netconn_do_sendv.
  *
- * @param m the api_msg_msg pointing to the connection
+ * @param conn the netconn to send on
+ * @param b the netbuf to send
+ * @return ERR_OK if the netbuf was sent, any other err_t on error
  */
-void
-lwip_netconn_do_send(void *m)
+static err_t
+lwip_netconn_send_netbuf(struct netconn *conn, struct netbuf *b)
 {
-  struct api_msg *msg = (struct api_msg*)m;
+  err_t err;
 
-  if (ERR_IS_FATAL(msg->conn->last_err)) {
-    msg->err = msg->conn->last_err;
-  } else {
-    msg->err = ERR_CONN;
-    if (msg->conn->pcb.tcp != NULL) {
-      switch (NETCONNTYPE_GROUP(msg->conn->type)) {
+  if (ERR_IS_FATAL(conn->last_err)) {
+    return conn->last_err;
+  }
+  err = ERR_CONN;
+  if (conn->pcb.tcp != NULL) {
+    switch (NETCONNTYPE_GROUP(conn->type)) {
 #if LWIP_RAW
-      case NETCONN_RAW:
-        if (ip_addr_isany(&msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-          msg->err = raw_send(msg->conn->pcb.raw, msg->msg.b->p);
-        } else {
-          msg->err = raw_sendto(msg->conn->pcb.raw, msg->msg.b->p, &msg->msg.b->addr);
-        }
-        break;
+    case NETCONN_RAW:
+      if (ip_addr_isany(&b->addr) || IP_IS_ANY_TYPE_VAL(b->addr)) {
+        err = raw_send(conn->pcb.raw, b->p);
+      } else {
+        err = raw_sendto(conn->pcb.raw, b->p, &b->addr);
+      }
+      break;
 #endif
 #if LWIP_UDP
-      case NETCONN_UDP:
+    case NETCONN_UDP:
 #if LWIP_CHECKSUM_ON_COPY
-        if (ip_addr_isany(&msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-          msg->err = udp_send_chksum(msg->conn->pcb.udp, msg->msg.b->p,
-            msg->msg.b->flags & NETBUF_FLAG_CHKSUM, msg->msg.b->toport_chksum);
-        } else {
-          msg->err = udp_sendto_chksum(msg->conn->pcb.udp, msg->msg.b->p,
-            &msg->msg.b->addr, msg->msg.b->port,
-            msg->msg.b->flags & NETBUF_FLAG_CHKSUM, msg->msg.b->toport_chksum);
-        }
+      if (ip_addr_isany(&b->addr) || IP_IS_ANY_TYPE_VAL(b->addr)) {
+        err = udp_send_chksum(conn->pcb.udp, b->p,
+          b->flags & NETBUF_FLAG_CHKSUM, b->toport_chksum);
+      } else {
+        err = udp_sendto_chksum(conn->pcb.udp, b->p,
+          &b->addr, b->port,
+          b->flags & NETBUF_FLAG_CHKSUM, b->toport_chksum);
+      }
 #else /* LWIP_CHECKSUM_ON_COPY */
-        if (ip_addr_isany_val(msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-          msg->err = udp_send(msg->conn->pcb.udp, msg->msg.b->p);
-        } else {
-          msg->err = udp_sendto(msg->conn->pcb.udp, msg->msg.b->p, &msg->msg.b->addr, msg->msg.b->port);
-        }
+      if (ip_addr_isany_val(b->addr) || IP_IS_ANY_TYPE_VAL(b->addr)) {
+        err = udp_send(conn->pcb.udp, b->p);
+      } else {
+        err = udp_sendto(conn->pcb.udp, b->p, &b->addr, b->port);
+      }
 #endif /* LWIP_CHECKSUM_ON_COPY */
-        break;
+      break;
 #endif /* LWIP_UDP */
-      default:
-        break;
-      }
+    default:
+      break;
+    }
+  }
+  return err;
+}
+
+/**
+ * Send some data on a RAW or UDP pcb contained in a netconn
+ * Called from netconn_send
+ *
+ * @param m the api_msg_msg pointing to the connection
+ */
+void
+lwip_netconn_do_send(void *m)
+{
+  struct api_msg *msg = (struct api_msg*)m;
+
+  msg->err = lwip_netconn_send_netbuf(msg->conn, msg->msg.b);
+  TCPIP_APIMSG_ACK(msg);
+}
+
+/**
+ * Send an array of netbufs on a RAW or UDP pcb contained in a netconn,
+ * stopping at the first one that fails.
+ * Called from netconn_sendv
+ *
+ * @param m the api_msg_msg pointing to the connection
+ */
+void
+lwip_netconn_do_sendv(void *m)
+{
+  struct api_msg *msg = (struct api_msg*)m;
+
+  msg->err = ERR_OK;
+  for (msg->msg.bv.sent = 0; msg->msg.bv.sent < msg->msg.bv.count; msg->msg.bv.sent++) {
+    msg->err = lwip_netconn_send_netbuf(msg->conn, &msg->msg.bv.bufs[msg->msg.bv.sent]);
+    if (msg->err != ERR_OK) {
+      break;
     }
   }
   TCPIP_APIMSG_ACK(msg);
@@ -1553,7 +1598,14 @@ lwip_netconn_do_writemore(struct netconn *conn  WRITE_DELAYED_PARAM)
       }
     }
     LWIP_ASSERT("lwip_netconn_do_writemore: invalid length!", ((conn->write_offset + len) <= conn->current_msg->msg.w.len));
-    err = tcp_write(conn->pcb.tcp, dataptr, len, apiflags);
+#if LWIP_TCP_ZEROCOPY
+    if (conn->current_msg->msg.w.zc != NULL) {
+      err = tcp_write_zc(conn->pcb.tcp, dataptr, len, apiflags, conn->current_msg->msg.w.zc);
+    } else
+#endif /* LWIP_TCP_ZEROCOPY */
+    {
+      err = tcp_write(conn->pcb.tcp, dataptr, len, apiflags);
+    }
     /* if OK or memory error, check available space */
     if ((err == ERR_OK) || (err == ERR_MEM)) {
 err_mem:
@@ -216,6 +216,10 @@ struct lwip_sock {
   u8_t err;
   /** counter of how many threads are waiting for this socket using select */
   SELWAIT_T select_waiting;
+#if LWIP_SOCKET_EPOLL
+  /** epoll registrations of this socket, linked by sock_next */
+  struct lwip_epitem *epitems;
+#endif /* LWIP_SOCKET_EPOLL */
 };
 
 #if LWIP_NETCONN_SEM_PER_THREAD
@@ -244,6 +248,46 @@ struct lwip_select_cb {
   SELECT_SEM_T sem;
 };
 
+#if LWIP_SOCKET_EPOLL
+/** A socket registered with an epoll instance */
+struct lwip_epitem {
+  /** next registration of the same socket */
+  struct lwip_epitem *sock_next;
+  /** next entry on the ready list of ep */
+  struct lwip_epitem *next;
+  /** previous entry on the ready list of ep */
+  struct lwip_epitem *prev;
+  /** epoll instance this registration belongs to, NULL if the item is free */
+  struct lwip_epoll *ep;
+  /** registered socket */
+  struct lwip_sock *sock;
+  /** interest: EPOLLIN/EPOLLOUT/EPOLLERR plus EPOLLET/EPOLLONESHOT */
+  u32_t events;
+  /** user data returned with the events */
+  epoll_data_t data;
+  /** 1 while on the ready list of ep */
+  u8_t ready;
+};
+
+/** Description of an epoll instance */
+struct lwip_epoll {
+  /** sockets that (may) have events, in the order they became ready */
+  struct lwip_epitem *ready_head;
+  struct lwip_epitem *ready_tail;
+  /** semaphore to wake up tasks waiting in lwip_epoll_wait */
+  sys_sem_t sem;
+  /** number of tasks waiting in lwip_epoll_wait */
+  u8_t waiting;
+  /** 1 if this instance has been created */
+  u8_t used;
+};
+
+/** The events that can be reported, as opposed to the mode flags */
+#define EPOLL_EVENT_MASK (EPOLLIN | EPOLLOUT | EPOLLERR)
+/** epoll descriptors are numbered after the sockets */
+#define EPOLL_FD_OFFSET  (LWIP_SOCKET_OFFSET + NUM_SOCKETS)
+#endif /* LWIP_SOCKET_EPOLL */
+
 /** A struct sockaddr replacement that has the same alignment as sockaddr_in/
  *  sockaddr_in6 if instantiated.
  */
@@ -285,6 +329,12 @@ static void lwip_socket_drop_registered_memberships(int s);
 static struct lwip_sock sockets[NUM_SOCKETS];
 /** The global list of tasks waiting for select */
 static struct lwip_select_cb *select_cb_list;
+#if LWIP_SOCKET_EPOLL
+/** The epoll instances */
+static struct lwip_epoll epolls[LWIP_EPOLL_MAX];
+/** The socket registrations of all epoll instances */
+static struct lwip_epitem epoll_items[LWIP_EPOLL_MAX_ITEMS];
+#endif /* LWIP_SOCKET_EPOLL */
 /** This counter is increased from lwip_select when the list is changed
     and checked in event_callback to see if it has changed. */
 static volatile int select_cb_ctr;
@@ -305,6 +355,9 @@ static volatile int select_cb_ctr;
 
 /* Forward declaration of some functions */
 static void event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len);
+#if LWIP_SOCKET_EPOLL
+static int lwip_epoll_close(int epfd);
+#endif /* LWIP_SOCKET_EPOLL */
 #if !LWIP_TCPIP_CORE_LOCKING
 static void lwip_getsockopt_callback(void *arg);
 static void lwip_setsockopt_callback(void *arg);
@@ -389,6 +442,114 @@ tryget_socket(int s)
   return &sockets[s];
 }
 
+#if LWIP_SOCKET_EPOLL
+/**
+ * Get the current events of a socket, like lwip_selscan does.
+ * Must be called with SYS_ARCH protected.
+ */
+static u32_t
+lwip_epoll_poll(struct lwip_sock *sock)
+{
+  u32_t revents = 0;
+
+  if ((sock->lastdata != NULL) || (sock->rcvevent > 0)) {
+    revents |= EPOLLIN;
+  }
+  if (sock->sendevent != 0) {
+    revents |= EPOLLOUT;
+  }
+  if (sock->errevent != 0) {
+    revents |= EPOLLERR;
+  }
+  return revents;
+}
+
+/**
+ * Append a registration to the ready list of its epoll instance and wake up
+ * a waiting task if the list was empty.
+ * Must be called with SYS_ARCH protected.
+ */
+static void
+lwip_epoll_ready_add(struct lwip_epitem *item)
+{
+  struct lwip_epoll *ep = item->ep;
+
+  LWIP_ASSERT("item not ready", !item->ready);
+  item->next = NULL;
+  item->prev = ep->ready_tail;
+  if (ep->ready_tail != NULL) {
+    ep->ready_tail->next = item;
+  } else {
+    ep->ready_head = item;
+    if (ep->waiting) {
+      sys_sem_signal(&ep->sem);
+    }
+  }
+  ep->ready_tail = item;
+  item->ready = 1;
+}
+
+/**
+ * Remove a registration from the ready list of its epoll instance.
+ * Must be called with SYS_ARCH protected.
+ */
+static void
+lwip_epoll_ready_del(struct lwip_epitem *item)
+{
+  struct lwip_epoll *ep = item->ep;
+
+  if (!item->ready) {
+    return;
+  }
+  if (item->prev != NULL) {
+    item->prev->next = item->next;
+  } else {
+    ep->ready_head = item->next;
+  }
+  if (item->next != NULL) {
+    item->next->prev = item->prev;
+  } else {
+    ep->ready_tail = item->prev;
+  }
+  item->ready = 0;
+}
+
+/**
+ * Called by event_callback: queue the registrations of a socket whose
+ * interest matches its new state. Must be called with SYS_ARCH protected.
+ */
+static void
+lwip_epoll_notify(struct lwip_sock *sock)
+{
+  struct lwip_epitem *item;
+  u32_t revents = lwip_epoll_poll(sock);
+
+  for (item = sock->epitems; item != NULL; item = item->sock_next) {
+    if (!item->ready && (revents & item->events & EPOLL_EVENT_MASK)) {
+      lwip_epoll_ready_add(item);
+    }
+  }
+}
+
+/**
+ * Drop all epoll registrations of a socket that is being freed.
+ */
+static void
+lwip_epoll_drop_sock(struct lwip_sock *sock)
+{
+  struct lwip_epitem *item;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  for (item = sock->epitems; item != NULL; item = item->sock_next) {
+    lwip_epoll_ready_del(item);
+    item->ep = NULL;
+  }
+  sock->epitems = NULL;
+  SYS_ARCH_UNPROTECT(lev);
+}
+#endif /* LWIP_SOCKET_EPOLL */
+
 /**
  * Allocate a new socket for a given netconn.
  *
@@ -420,6 +581,9 @@ alloc_socket(struct netconn *newconn, int accepted)
       sockets[i].sendevent  = (NETCONNTYPE_GROUP(newconn->type) == NETCONN_TCP ? (accepted != 0) : 1);
       sockets[i].errevent   = 0;
       sockets[i].err        = 0;
+#if LWIP_SOCKET_EPOLL
+      sockets[i].epitems    = NULL;
+#endif /* LWIP_SOCKET_EPOLL */
       return i + LWIP_SOCKET_OFFSET;
     }
     SYS_ARCH_UNPROTECT(lev);
@@ -438,6 +602,10 @@ free_socket(struct lwip_sock *sock, int is_tcp)
 {
   void *lastdata;
 
+#if LWIP_SOCKET_EPOLL
+  lwip_epoll_drop_sock(sock);
+#endif /* LWIP_SOCKET_EPOLL */
+
   lastdata         = sock->lastdata;
   sock->lastdata   = NULL;
   sock->lastoffset = 0;
@@ -613,6 +781,12 @@ lwip_close(int s)
 
   LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_close(%d)\n", s));
 
+#if LWIP_SOCKET_EPOLL
+  if ((s >= EPOLL_FD_OFFSET) && (s < EPOLL_FD_OFFSET + LWIP_EPOLL_MAX)) {
+    return lwip_epoll_close(s);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
+
   sock = get_socket(s);
   if (!sock) {
     return -1;
@@ -925,6 +1099,118 @@ lwip_recv(int s, void *mem, size_t len, int flags)
   return lwip_recvfrom(s, mem, len, flags, NULL, NULL);
 }
 
+/**
+ * Receive several datagrams from a UDP or RAW socket. Only the first
+ * datagram is waited for (unless MSG_DONTWAIT is set or the socket is
+ * non-blocking), further entries of msgvec are filled with the datagrams
+ * already queued on the socket, like Linux does with MSG_WAITFORONE.
+ * With MSG_PEEK only the first datagram is returned.
+ *
+ * @return number of datagrams received (msg_len, msg_flags and msg_namelen
+ *         of each are updated), -1 on error
+ */
+int
+lwip_recvmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+  struct lwip_sock *sock;
+  struct netbuf    *buf;
+  struct msghdr    *msg;
+  unsigned int     n;
+  int              i;
+  u16_t            off, copylen;
+  err_t            err;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmmsg(%d, %p, %u, 0x%x)\n", s, (void *)msgvec, vlen, flags));
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  LWIP_ERROR("lwip_recvmmsg: invalid msgvec", (msgvec != NULL) && (vlen > 0),
+             sock_set_errno(sock, err_to_errno(ERR_ARG)); return -1;);
+
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+    sock_set_errno(sock, EOPNOTSUPP);
+    return -1;
+  }
+
+  for (n = 0; n < vlen; n++) {
+    msg = &msgvec[n].msg_hdr;
+    LWIP_ERROR("lwip_recvmmsg: invalid msghdr iov", (msg->msg_iov != NULL) || (msg->msg_iovlen == 0),
+               sock_set_errno(sock, err_to_errno(ERR_ARG)); return -1;);
+
+    /* Check if there is a datagram left from a MSG_PEEK. */
+    if (sock->lastdata) {
+      buf = (struct netbuf *)sock->lastdata;
+    } else {
+      /* only the first datagram may block */
+      if (((n > 0) || (flags & MSG_DONTWAIT) || netconn_is_nonblocking(sock->conn)) &&
+          (sock->rcvevent <= 0)) {
+        if (n > 0) {
+          break;
+        }
+        LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmmsg(%d): returning EWOULDBLOCK\n", s));
+        set_errno(EWOULDBLOCK);
+        return -1;
+      }
+      err = netconn_recv(sock->conn, &buf);
+      if (err != ERR_OK) {
+        if (n > 0) {
+          break;
+        }
+        LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmmsg(%d): error is \"%s\"!\n", s, lwip_strerr(err)));
+        sock_set_errno(sock, err_to_errno(err));
+        return -1;
+      }
+      LWIP_ASSERT("buf != NULL", buf != NULL);
+    }
+
+    /* scatter the datagram into the IO vectors */
+    off = 0;
+    for (i = 0; (i < msg->msg_iovlen) && (off < buf->p->tot_len); i++) {
+      copylen = buf->p->tot_len - off;
+      if (msg->msg_iov[i].iov_len < copylen) {
+        copylen = (u16_t)msg->msg_iov[i].iov_len;
+      }
+      pbuf_copy_partial(buf->p, msg->msg_iov[i].iov_base, copylen, off);
+      off += copylen;
+    }
+    msgvec[n].msg_len = off;
+    msg->msg_flags = (off < buf->p->tot_len) ? MSG_TRUNC : 0;
+    msg->msg_controllen = 0;
+
+    if ((msg->msg_name != NULL) && (msg->msg_namelen > 0)) {
+      union sockaddr_aligned saddr;
+      ip_addr_t *fromaddr = netbuf_fromaddr(buf);
+#if LWIP_IPV4 && LWIP_IPV6
+      /* Dual-stack: Map IPv4 addresses to IPv4 mapped IPv6 */
+      if (NETCONNTYPE_ISIPV6(netconn_type(sock->conn)) && IP_IS_V4(fromaddr)) {
+        ip4_2_ipv4_mapped_ipv6(ip_2_ip6(fromaddr), ip_2_ip4(fromaddr));
+        IP_SET_TYPE(fromaddr, IPADDR_TYPE_V6);
+      }
+#endif /* LWIP_IPV4 && LWIP_IPV6 */
+      IPADDR_PORT_TO_SOCKADDR(&saddr, fromaddr, netbuf_fromport(buf));
+      if (msg->msg_namelen > saddr.sa.sa_len) {
+        msg->msg_namelen = saddr.sa.sa_len;
+      }
+      MEMCPY(msg->msg_name, &saddr, msg->msg_namelen);
+    }
+
+    if (flags & MSG_PEEK) {
+      /* keep the datagram for the next call */
+      sock->lastdata = buf;
+      n++;
+      break;
+    }
+    sock->lastdata = NULL;
+    sock->lastoffset = 0;
+    netbuf_delete(buf);
+  }
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmmsg(%d) received=%u\n", s, n));
+  sock_set_errno(sock, 0);
+  return (int)n;
+}
+
 int
 lwip_send(int s, const void *data, size_t size, int flags)
 {
@@ -961,6 +1247,137 @@ lwip_send(int s, const void *data, size_t size, int flags)
   return (err == ERR_OK ? (int)written : -1);
 }
 
+#if LWIP_TCP && LWIP_TCP_ZEROCOPY
+/**
+ * Send on a TCP socket without copying the data, see netconn_write_partly_zc().
+ * Returns the number of bytes queued like lwip_send(). The caller gives up
+ * its own reference on zc with tcp_zc_release() after its last send; zc->done
+ * is called once the stack has released the buffer.
+ */
+int
+lwip_send_zc(int s, const void *data, size_t size, int flags, struct tcp_zc *zc)
+{
+  struct lwip_sock *sock;
+  err_t err;
+  u8_t write_flags;
+  size_t written;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_zc(%d, data=%p, size=%"SZT_F", flags=0x%x)\n",
+                              s, data, size, flags));
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) != NETCONN_TCP) {
+    sock_set_errno(sock, EOPNOTSUPP);
+    return -1;
+  }
+  if (zc == NULL) {
+    sock_set_errno(sock, err_to_errno(ERR_ARG));
+    return -1;
+  }
+
+  write_flags = ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
+                ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
+  written = 0;
+  err = netconn_write_partly_zc(sock->conn, data, size, write_flags, &written, zc);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_zc(%d) err=%d written=%"SZT_F"\n", s, err, written));
+  sock_set_errno(sock, err_to_errno(err));
+  return (err == ERR_OK ? (int)written : -1);
+}
+#endif /* LWIP_TCP && LWIP_TCP_ZEROCOPY */
+
+#if LWIP_UDP || LWIP_RAW
+/**
+ * Fill a netbuf with the destination and the data of a msghdr, used for
+ * UDP and RAW sockets.
+ *
+ * @param msg the message to send
+ * @param buf an empty netbuf, cleaned up by the caller also on error
+ * @return ERR_OK if buf is ready to be sent
+ */
+static err_t
+lwip_sock_msg_to_netbuf(const struct msghdr *msg, struct netbuf *buf)
+{
+  int i;
+#if LWIP_NETIF_TX_SINGLE_PBUF
+  size_t size;
+#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
+  err_t err = ERR_OK;
+
+  LWIP_ERROR("lwip_sock_msg_to_netbuf: invalid msghdr iov", (msg->msg_iov != NULL && msg->msg_iovlen != 0),
+             return ERR_ARG;);
+  LWIP_ERROR("lwip_sock_msg_to_netbuf: invalid msghdr name", (((msg->msg_name == NULL) && (msg->msg_namelen == 0)) ||
+             IS_SOCK_ADDR_LEN_VALID(msg->msg_namelen)),
+             return ERR_ARG;);
+
+  if (msg->msg_name) {
+    u16_t remote_port;
+    SOCKADDR_TO_IPADDR_PORT((const struct sockaddr *)msg->msg_name, &buf->addr, remote_port);
+    netbuf_fromport(buf) = remote_port;
+  }
+#if LWIP_NETIF_TX_SINGLE_PBUF
+  size = 0;
+  for (i = 0; i < msg->msg_iovlen; i++) {
+    size += msg->msg_iov[i].iov_len;
+  }
+  /* Allocate a new netbuf and copy the data into it. */
+  if (netbuf_alloc(buf, (u16_t)size) == NULL) {
+     err = ERR_MEM;
+  } else {
+    /* flatten the IO vectors */
+    size_t offset = 0;
+    for (i = 0; i < msg->msg_iovlen; i++) {
+      MEMCPY(&((u8_t*)buf->p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+      offset += msg->msg_iov[i].iov_len;
+    }
+#if LWIP_CHECKSUM_ON_COPY
+    {
+      /* This can be improved by using LWIP_CHKSUM_COPY() and aggregating the checksum for each IO vector */
+      u16_t chksum = ~inet_chksum_pbuf(buf->p);
+      netbuf_set_chksum(buf, chksum);
+    }
+#endif /* LWIP_CHECKSUM_ON_COPY */
+    err = ERR_OK;
+  }
+#else /* LWIP_NETIF_TX_SINGLE_PBUF */
+  /* create a chained netbuf from the IO vectors. NOTE: we assemble a pbuf chain
+     manually to avoid having to allocate, chain, and delete a netbuf for each iov */
+  for (i = 0; i < msg->msg_iovlen; i++) {
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_REF);
+    if (p == NULL) {
+      err = ERR_MEM; /* let the caller free buf */
+      break;
+    }
+    p->payload = msg->msg_iov[i].iov_base;
+    LWIP_ASSERT("iov_len < u16_t", msg->msg_iov[i].iov_len <= 0xFFFF);
+    p->len = p->tot_len = (u16_t)msg->msg_iov[i].iov_len;
+    /* netbuf empty, add new pbuf */
+    if (buf->p == NULL) {
+      buf->p = buf->ptr = p;
+      /* add pbuf to existing pbuf chain */
+    } else {
+      pbuf_cat(buf->p, p);
+    }
+  }
+#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
+
+  if (err == ERR_OK) {
+#if LWIP_IPV4 && LWIP_IPV6
+    /* Dual-stack: Unmap IPv4 mapped IPv6 addresses */
+    if (IP_IS_V6_VAL(buf->addr) && ip6_addr_isipv4mappedipv6(ip_2_ip6(&buf->addr))) {
+      unmap_ipv4_mapped_ipv6(ip_2_ip4(&buf->addr), ip_2_ip6(&buf->addr));
+      IP_SET_TYPE_VAL(buf->addr, IPADDR_TYPE_V4);
+    }
+#endif /* LWIP_IPV4 && LWIP_IPV6 */
+  }
+  return err;
+}
+#endif /* LWIP_UDP || LWIP_RAW */
+
 int
 lwip_sendmsg(int s, const struct msghdr *msg, int flags)
 {
@@ -1029,9 +1446,6 @@ lwip_sendmsg(int s, const struct msghdr *msg, int flags)
     struct netbuf *chain_buf;
 
     LWIP_UNUSED_ARG(flags);
-    LWIP_ERROR("lwip_sendmsg: invalid msghdr name", (((msg->msg_name == NULL) && (msg->msg_namelen == 0)) ||
-               IS_SOCK_ADDR_LEN_VALID(msg->msg_namelen)) ,
-               sock_set_errno(sock, err_to_errno(ERR_ARG)); return -1;);
 
     /* initialize chain buffer with destination */
     chain_buf = netbuf_new();
@@ -1039,69 +1453,9 @@ lwip_sendmsg(int s, const struct msghdr *msg, int flags)
       sock_set_errno(sock, err_to_errno(ERR_MEM));
       return -1;
     }
-    if (msg->msg_name) {
-      u16_t remote_port;
-      SOCKADDR_TO_IPADDR_PORT((const struct sockaddr *)msg->msg_name, &chain_buf->addr, remote_port);
-      netbuf_fromport(chain_buf) = remote_port;
-    }
-#if LWIP_NETIF_TX_SINGLE_PBUF
-    for (i = 0; i < msg->msg_iovlen; i++) {
-      size += msg->msg_iov[i].iov_len;
-    }
-    /* Allocate a new netbuf and copy the data into it. */
-    if (netbuf_alloc(chain_buf, (u16_t)size) == NULL) {
-       err = ERR_MEM;
-    } else {
-      /* flatten the IO vectors */
-      size_t offset = 0;
-      for (i = 0; i < msg->msg_iovlen; i++) {
-        MEMCPY(&((u8_t*)chain_buf->p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
-        offset += msg->msg_iov[i].iov_len;
-      }
-#if LWIP_CHECKSUM_ON_COPY
-      {
-        /* This can be improved by using LWIP_CHKSUM_COPY() and aggregating the checksum for each IO vector */
-        u16_t chksum = ~inet_chksum_pbuf(chain_buf->p);
-        netbuf_set_chksum(chain_buf, chksum);
-      }
-#endif /* LWIP_CHECKSUM_ON_COPY */
-      err = ERR_OK;
-    }
-#else /* LWIP_NETIF_TX_SINGLE_PBUF */
-    /* create a chained netbuf from the IO vectors. NOTE: we assemble a pbuf chain
-       manually to avoid having to allocate, chain, and delete a netbuf for each iov */
-    for (i = 0; i < msg->msg_iovlen; i++) {
-      struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_REF);
-      if (p == NULL) {
-        err = ERR_MEM; /* let netbuf_delete() cleanup chain_buf */
-        break;
-      }
-      p->payload = msg->msg_iov[i].iov_base;
-      LWIP_ASSERT("iov_len < u16_t", msg->msg_iov[i].iov_len <= 0xFFFF);
-      p->len = p->tot_len = (u16_t)msg->msg_iov[i].iov_len;
-      /* netbuf empty, add new pbuf */
-      if (chain_buf->p == NULL) {
-        chain_buf->p = chain_buf->ptr = p;
-        /* add pbuf to existing pbuf chain */
-      } else {
-        pbuf_cat(chain_buf->p, p);
-      }
-    }
-    /* save size of total chain */
+    err = lwip_sock_msg_to_netbuf(msg, chain_buf);
     if (err == ERR_OK) {
       size = netbuf_len(chain_buf);
-    }
-#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
-
-    if (err == ERR_OK) {
-#if LWIP_IPV4 && LWIP_IPV6
-      /* Dual-stack: Unmap IPv4 mapped IPv6 addresses */
-      if (IP_IS_V6_VAL(chain_buf->addr) && ip6_addr_isipv4mappedipv6(ip_2_ip6(&chain_buf->addr))) {
-        unmap_ipv4_mapped_ipv6(ip_2_ip4(&chain_buf->addr), ip_2_ip6(&chain_buf->addr));
-        IP_SET_TYPE_VAL(chain_buf->addr, IPADDR_TYPE_V4);
-      }
-#endif /* LWIP_IPV4 && LWIP_IPV6 */
-
       /* send the data */
       err = netconn_send(sock->conn, chain_buf);
     }
@@ -1118,6 +1472,82 @@ lwip_sendmsg(int s, const struct msghdr *msg, int flags)
 #endif /* LWIP_UDP || LWIP_RAW */
 }
 
+/**
+ * Send several datagrams on a UDP or RAW socket. The datagrams are passed
+ * to the tcpip_thread in batches of LWIP_SOCKET_MMSG_BATCH, so the cost of
+ * the call into the stack is shared by the batch.
+ *
+ * @return number of datagrams sent (msg_len of each is set to its size),
+ *         -1 if the first one could not be sent
+ */
+int
+lwip_sendmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+  struct lwip_sock *sock;
+#if LWIP_UDP || LWIP_RAW
+  struct netbuf bufs[LWIP_SOCKET_MMSG_BATCH];
+  unsigned int done = 0;
+  u16_t count, sent, i;
+  err_t err = ERR_OK;
+#endif /* LWIP_UDP || LWIP_RAW */
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_sendmmsg(%d, %p, %u)\n", s, (void *)msgvec, vlen));
+  LWIP_ERROR("lwip_sendmmsg: invalid msgvec", (msgvec != NULL) && (vlen > 0),
+             sock_set_errno(sock, err_to_errno(ERR_ARG)); return -1;);
+  LWIP_UNUSED_ARG(flags);
+
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+    sock_set_errno(sock, EOPNOTSUPP);
+    return -1;
+  }
+#if LWIP_UDP || LWIP_RAW
+  while ((done < vlen) && (err == ERR_OK)) {
+    /* prepare a batch of datagrams... */
+    for (count = 0; (count < LWIP_SOCKET_MMSG_BATCH) && (done + count < vlen); count++) {
+      memset(&bufs[count], 0, sizeof(struct netbuf));
+      ip_addr_set_any(NETCONNTYPE_ISIPV6(netconn_type(sock->conn)), &bufs[count].addr);
+      err = lwip_sock_msg_to_netbuf(&msgvec[done + count].msg_hdr, &bufs[count]);
+      if (err != ERR_OK) {
+        netbuf_free(&bufs[count]);
+        break;
+      }
+    }
+    /* ...and send it with one call into the stack */
+    sent = 0;
+    if (count > 0) {
+      err_t send_err = netconn_sendv(sock->conn, bufs, count, &sent);
+      if (send_err != ERR_OK) {
+        err = send_err;
+      }
+    }
+    for (i = 0; i < count; i++) {
+      if (i < sent) {
+        msgvec[done + i].msg_len = netbuf_len(&bufs[i]);
+      }
+      netbuf_free(&bufs[i]);
+    }
+    done += sent;
+  }
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_sendmmsg(%d) sent=%u err=%d\n", s, done, err));
+  if (done > 0) {
+    /* report the error with the next call */
+    sock_set_errno(sock, 0);
+    return (int)done;
+  }
+  sock_set_errno(sock, err_to_errno(err));
+  return -1;
+#else /* LWIP_UDP || LWIP_RAW */
+  sock_set_errno(sock, err_to_errno(ERR_ARG));
+  return -1;
+#endif /* LWIP_UDP || LWIP_RAW */
+}
+
 int
 lwip_sendto(int s, const void *data, size_t size, int flags,
        const struct sockaddr *to, socklen_t tolen)
@@ -1630,6 +2060,13 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       break;
   }
 
+#if LWIP_SOCKET_EPOLL
+  if ((sock->epitems != NULL) &&
+      (evt != NETCONN_EVT_RCVMINUS) && (evt != NETCONN_EVT_SENDMINUS)) {
+    lwip_epoll_notify(sock);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
+
   if (sock->select_waiting == 0) {
     /* noone is waiting for this socket, no need to check select_cb_list */
     SYS_ARCH_UNPROTECT(lev);
@@ -1684,6 +2121,327 @@ again:
   SYS_ARCH_UNPROTECT(lev);
 }
 
+#if LWIP_SOCKET_EPOLL
+/**
+ * Map an epoll descriptor to its instance.
+ *
+ * @param epfd externally used epoll descriptor
+ * @return struct lwip_epoll for the descriptor or NULL if not found
+ */
+static struct lwip_epoll *
+get_epoll(int epfd)
+{
+  epfd -= EPOLL_FD_OFFSET;
+  if ((epfd < 0) || (epfd >= LWIP_EPOLL_MAX) || !epolls[epfd].used) {
+    LWIP_DEBUGF(SOCKETS_DEBUG, ("get_epoll(%d): invalid\n", epfd + EPOLL_FD_OFFSET));
+    set_errno(EBADF);
+    return NULL;
+  }
+  return &epolls[epfd];
+}
+
+/**
+ * Find the registration of a socket with an epoll instance.
+ * Must be called with SYS_ARCH protected.
+ */
+static struct lwip_epitem *
+lwip_epoll_find(struct lwip_epoll *ep, struct lwip_sock *sock)
+{
+  struct lwip_epitem *item;
+
+  for (item = sock->epitems; item != NULL; item = item->sock_next) {
+    if (item->ep == ep) {
+      return item;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Unlink a registration from its socket and free it.
+ * Must be called with SYS_ARCH protected.
+ */
+static void
+lwip_epoll_item_free(struct lwip_epitem *item)
+{
+  struct lwip_epitem **pitem;
+
+  for (pitem = &item->sock->epitems; *pitem != NULL; pitem = &(*pitem)->sock_next) {
+    if (*pitem == item) {
+      *pitem = item->sock_next;
+      break;
+    }
+  }
+  lwip_epoll_ready_del(item);
+  item->ep = NULL;
+}
+
+/**
+ * Move the events of ready registrations to the caller. Level-triggered
+ * registrations that still have events stay on the ready list, all others
+ * are taken off until event_callback queues them again.
+ *
+ * @return number of entries filled in events
+ */
+static int
+lwip_epoll_collect(struct lwip_epoll *ep, struct epoll_event *events, int maxevents)
+{
+  struct lwip_epitem *item;
+  int nready = 0;
+  int todo;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  /* look at every registration at most once, level-triggered ones are
+     appended again */
+  for (item = ep->ready_head, todo = 0; item != NULL; item = item->next) {
+    todo++;
+  }
+  while ((todo-- > 0) && (nready < maxevents) && (ep->ready_head != NULL)) {
+    u32_t revents;
+
+    item = ep->ready_head;
+    lwip_epoll_ready_del(item);
+    revents = lwip_epoll_poll(item->sock) & item->events & EPOLL_EVENT_MASK;
+    if (revents != 0) {
+      events[nready].events = revents;
+      events[nready].data = item->data;
+      nready++;
+      if (item->events & EPOLLONESHOT) {
+        /* disabled until EPOLL_CTL_MOD */
+        item->events &= ~EPOLL_EVENT_MASK;
+      } else if (!(item->events & EPOLLET)) {
+        lwip_epoll_ready_add(item);
+      }
+    }
+    /* unlock interrupts with each step */
+    SYS_ARCH_UNPROTECT(lev);
+    SYS_ARCH_PROTECT(lev);
+  }
+  if ((ep->ready_head != NULL) && (ep->waiting > 0)) {
+    /* pass the remaining events on to another waiting task */
+    sys_sem_signal(&ep->sem);
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  return nready;
+}
+
+/**
+ * Create an epoll instance.
+ *
+ * @param size ignored, must be greater than zero (as on Linux)
+ * @return epoll descriptor, to be closed with lwip_close(); -1 on error
+ */
+int
+lwip_epoll_create(int size)
+{
+  int i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (size <= 0) {
+    set_errno(EINVAL);
+    return -1;
+  }
+  for (i = 0; i < LWIP_EPOLL_MAX; i++) {
+    SYS_ARCH_PROTECT(lev);
+    if (!epolls[i].used) {
+      epolls[i].used = 1;
+      SYS_ARCH_UNPROTECT(lev);
+      epolls[i].ready_head = NULL;
+      epolls[i].ready_tail = NULL;
+      epolls[i].waiting = 0;
+      if (sys_sem_new(&epolls[i].sem, 0) != ERR_OK) {
+        SYS_ARCH_SET(epolls[i].used, 0);
+        set_errno(ENOMEM);
+        return -1;
+      }
+      LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_create() = %d\n", i + EPOLL_FD_OFFSET));
+      set_errno(0);
+      return i + EPOLL_FD_OFFSET;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+  }
+  set_errno(EMFILE);
+  return -1;
+}
+
+/**
+ * Free an epoll instance and its registrations. No task may be waiting on it.
+ */
+static int
+lwip_epoll_close(int epfd)
+{
+  struct lwip_epoll *ep;
+  int i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  ep = get_epoll(epfd);
+  if (ep == NULL) {
+    return -1;
+  }
+  LWIP_ASSERT("lwip_epoll_close: tasks still waiting", ep->waiting == 0);
+  for (i = 0; i < LWIP_EPOLL_MAX_ITEMS; i++) {
+    SYS_ARCH_PROTECT(lev);
+    if (epoll_items[i].ep == ep) {
+      lwip_epoll_item_free(&epoll_items[i]);
+    }
+    SYS_ARCH_UNPROTECT(lev);
+  }
+  sys_sem_free(&ep->sem);
+  SYS_ARCH_SET(ep->used, 0);
+  set_errno(0);
+  return 0;
+}
+
+/**
+ * Add, modify or remove the registration of a socket with an epoll instance.
+ * EPOLLERR is always reported, whether requested or not.
+ *
+ * @param epfd epoll descriptor returned by lwip_epoll_create()
+ * @param op EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL
+ * @param fd socket to register
+ * @param event interest and user data (ignored for EPOLL_CTL_DEL)
+ * @return 0 on success, -1 on error
+ */
+int
+lwip_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+  struct lwip_epoll *ep;
+  struct lwip_sock *sock;
+  struct lwip_epitem *item;
+  int i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_ctl(%d, %d, %d)\n", epfd, op, fd));
+
+  ep = get_epoll(epfd);
+  if (ep == NULL) {
+    return -1;
+  }
+  sock = get_socket(fd);
+  if (sock == NULL) {
+    return -1;
+  }
+  if ((op != EPOLL_CTL_DEL) && (event == NULL)) {
+    set_errno(EINVAL);
+    return -1;
+  }
+
+  SYS_ARCH_PROTECT(lev);
+  item = lwip_epoll_find(ep, sock);
+  switch (op) {
+    case EPOLL_CTL_ADD:
+      if (item != NULL) {
+        SYS_ARCH_UNPROTECT(lev);
+        set_errno(EEXIST);
+        return -1;
+      }
+      for (i = 0; i < LWIP_EPOLL_MAX_ITEMS; i++) {
+        if (epoll_items[i].ep == NULL) {
+          item = &epoll_items[i];
+          break;
+        }
+      }
+      if (item == NULL) {
+        SYS_ARCH_UNPROTECT(lev);
+        set_errno(ENOMEM);
+        return -1;
+      }
+      item->ep = ep;
+      item->sock = sock;
+      item->ready = 0;
+      item->sock_next = sock->epitems;
+      sock->epitems = item;
+      break;
+    case EPOLL_CTL_MOD:
+    case EPOLL_CTL_DEL:
+      if (item == NULL) {
+        SYS_ARCH_UNPROTECT(lev);
+        set_errno(ENOENT);
+        return -1;
+      }
+      if (op == EPOLL_CTL_DEL) {
+        lwip_epoll_item_free(item);
+        SYS_ARCH_UNPROTECT(lev);
+        set_errno(0);
+        return 0;
+      }
+      break;
+    default:
+      SYS_ARCH_UNPROTECT(lev);
+      set_errno(EINVAL);
+      return -1;
+  }
+  item->events = event->events | EPOLLERR;
+  item->data = event->data;
+  /* report events the socket already has */
+  if (!item->ready && (lwip_epoll_poll(sock) & item->events & EPOLL_EVENT_MASK)) {
+    lwip_epoll_ready_add(item);
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  set_errno(0);
+  return 0;
+}
+
+/**
+ * Wait for events on the sockets registered with an epoll instance.
+ *
+ * @param epfd epoll descriptor returned by lwip_epoll_create()
+ * @param events array receiving the events
+ * @param maxevents number of entries in events (> 0)
+ * @param timeout maximum time to wait in milliseconds, -1 to wait forever
+ *                and 0 to return immediately
+ * @return number of entries filled in events (0 on timeout), -1 on error
+ */
+int
+lwip_epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+  struct lwip_epoll *ep;
+  int nready;
+  u32_t waited;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  ep = get_epoll(epfd);
+  if (ep == NULL) {
+    return -1;
+  }
+  if ((events == NULL) || (maxevents <= 0)) {
+    set_errno(EINVAL);
+    return -1;
+  }
+
+  for (;;) {
+    nready = lwip_epoll_collect(ep, events, maxevents);
+    if ((nready > 0) || (timeout == 0)) {
+      break;
+    }
+    SYS_ARCH_PROTECT(lev);
+    if (ep->ready_head != NULL) {
+      /* queued since we looked, but without events (yet): look again */
+      SYS_ARCH_UNPROTECT(lev);
+      continue;
+    }
+    ep->waiting++;
+    SYS_ARCH_UNPROTECT(lev);
+
+    waited = sys_arch_sem_wait(&ep->sem, (timeout < 0) ? 0 : (u32_t)timeout);
+
+    SYS_ARCH_PROTECT(lev);
+    ep->waiting--;
+    SYS_ARCH_UNPROTECT(lev);
+    if (waited == SYS_ARCH_TIMEOUT) {
+      timeout = 0;
+    } else if (timeout > 0) {
+      /* woken up: only wait for the rest of the time if nothing is ready */
+      timeout = (waited < (u32_t)timeout) ? (timeout - (int)waited) : 0;
+    }
+  }
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_wait(%d) nready=%d\n", epfd, nready));
+  set_errno(0);
+  return nready;
+}
+#endif /* LWIP_SOCKET_EPOLL */
+
 /**
  * Close one end of a full-duplex connection.
  */
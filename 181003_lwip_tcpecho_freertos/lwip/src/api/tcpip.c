@@ -48,6 +48,7 @@
 #include "lwip/ip.h"
 #include "lwip/pbuf.h"
 #include "lwip/etharp.h"
+#include "lwip/stats.h"
 #include "netif/ethernet.h"
 
 #define TCPIP_MSG_VAR_REF(name)     API_VAR_REF(name)
@@ -65,6 +66,13 @@ static sys_mbox_t mbox;
 sys_mutex_t lock_tcpip_core;
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 
+#if LWIP_STATS_HIST
+/* remember when a message was posted to measure its time in the mailbox */
+#define TCPIP_MSG_STAMP(msg) (msg)->posted = LWIP_STATS_CYCLES()
+#else /* LWIP_STATS_HIST */
+#define TCPIP_MSG_STAMP(msg)
+#endif /* LWIP_STATS_HIST */
+
 #if LWIP_TIMERS
 /* wait for a message, timeouts are processed while waiting */
 #define TCPIP_MBOX_FETCH(mbox, msg) sys_timeouts_mbox_fetch(mbox, msg)
@@ -87,6 +95,7 @@ static void
 tcpip_thread(void *arg)
 {
   struct tcpip_msg *msg;
+  STATS_HIST_DECL(t);
   LWIP_UNUSED_ARG(arg);
 
   if (tcpip_init_done != NULL) {
@@ -105,6 +114,8 @@ tcpip_thread(void *arg)
       LWIP_ASSERT("tcpip_thread: invalid message", 0);
       continue;
     }
+    STATS_HIST_START(t);
+    STATS_HIST_STOP(STATS_HIST_TCPIP_MBOX, msg->posted);
     switch (msg->type) {
 #if !LWIP_TCPIP_CORE_LOCKING
     case TCPIP_MSG_API:
@@ -155,6 +166,7 @@ tcpip_thread(void *arg)
       LWIP_ASSERT("tcpip_thread: invalid message", 0);
       break;
     }
+    STATS_HIST_STOP(STATS_HIST_TCPIP_MSG, t);
   }
 }
 
@@ -189,6 +201,7 @@ tcpip_inpkt(struct pbuf *p, struct netif *inp, netif_input_fn input_fn)
   msg->msg.inp.p = p;
   msg->msg.inp.netif = inp;
   msg->msg.inp.input_fn = input_fn;
+  TCPIP_MSG_STAMP(msg);
   if (sys_mbox_trypost(&mbox, msg) != ERR_OK) {
     memp_free(MEMP_TCPIP_MSG_INPKT, msg);
     return ERR_MEM;
@@ -246,8 +259,10 @@ tcpip_callback_with_block(tcpip_callback_fn function, void *ctx, u8_t block)
   msg->msg.cb.function = function;
   msg->msg.cb.ctx = ctx;
   if (block) {
+    TCPIP_MSG_STAMP(msg);
     sys_mbox_post(&mbox, msg);
   } else {
+    TCPIP_MSG_STAMP(msg);
     if (sys_mbox_trypost(&mbox, msg) != ERR_OK) {
       memp_free(MEMP_TCPIP_MSG_API, msg);
       return ERR_MEM;
@@ -281,6 +296,7 @@ tcpip_timeout(u32_t msecs, sys_timeout_handler h, void *arg)
   msg->msg.tmo.msecs = msecs;
   msg->msg.tmo.h = h;
   msg->msg.tmo.arg = arg;
+  TCPIP_MSG_STAMP(msg);
   sys_mbox_post(&mbox, msg);
   return ERR_OK;
 }
@@ -307,6 +323,7 @@ tcpip_untimeout(sys_timeout_handler h, void *arg)
   msg->type = TCPIP_MSG_UNTIMEOUT;
   msg->msg.tmo.h = h;
   msg->msg.tmo.arg = arg;
+  TCPIP_MSG_STAMP(msg);
   sys_mbox_post(&mbox, msg);
   return ERR_OK;
 }
@@ -344,6 +361,7 @@ tcpip_send_msg_wait_sem(tcpip_callback_fn fn, void *apimsg, sys_sem_t* sem)
   TCPIP_MSG_VAR_REF(msg).type = TCPIP_MSG_API;
   TCPIP_MSG_VAR_REF(msg).msg.api_msg.function = fn;
   TCPIP_MSG_VAR_REF(msg).msg.api_msg.msg = apimsg;
+  TCPIP_MSG_STAMP(&TCPIP_MSG_VAR_REF(msg));
   sys_mbox_post(&mbox, &TCPIP_MSG_VAR_REF(msg));
   sys_arch_sem_wait(sem, 0);
   TCPIP_MSG_VAR_FREE(msg);
@@ -391,6 +409,7 @@ tcpip_api_call(tcpip_api_call_fn fn, struct tcpip_api_call_data *call)
 #else /* LWIP_NETCONN_SEM_PER_THREAD */
   TCPIP_MSG_VAR_REF(msg).msg.api_call.sem = &call->sem;
 #endif /* LWIP_NETCONN_SEM_PER_THREAD */
+  TCPIP_MSG_STAMP(&TCPIP_MSG_VAR_REF(msg));
   sys_mbox_post(&mbox, &TCPIP_MSG_VAR_REF(msg));
   sys_arch_sem_wait(TCPIP_MSG_VAR_REF(msg).msg.api_call.sem, 0);
   TCPIP_MSG_VAR_FREE(msg);
@@ -446,6 +465,7 @@ err_t
 tcpip_trycallback(struct tcpip_callback_msg* msg)
 {
   LWIP_ASSERT("Invalid mbox", sys_mbox_valid_val(mbox));
+  TCPIP_MSG_STAMP((struct tcpip_msg *)msg);
   return sys_mbox_trypost(&mbox, msg);
 }
 
@@ -155,6 +155,12 @@ PACK_STRUCT_END
   #error "If you want to use TCP, TCP_WND must fit in an u16_t, so, you have to reduce it in your lwipopts.h (or enable window scaling)"
 #endif
 #endif /* LWIP_WND_SCALE */
+#if (LWIP_TCP && LWIP_TCP_RCV_AUTOTUNE && ((TCP_WND_AUTOTUNE_MIN > TCP_WND) || (TCP_WND_AUTOTUNE_MIN > 0xffff)))
+  #error "TCP_WND_AUTOTUNE_MIN must not be bigger than TCP_WND or 0xffff, so, you have to reduce it in your lwipopts.h"
+#endif
+#if (LWIP_TCP && LWIP_TCP_ZEROCOPY && !LWIP_SUPPORT_CUSTOM_PBUF)
+  #error "LWIP_TCP_ZEROCOPY needs LWIP_SUPPORT_CUSTOM_PBUF, so, you have to enable it in your lwipopts.h"
+#endif
 #if (LWIP_TCP && (TCP_SND_QUEUELEN > 0xffff))
   #error "If you want to use TCP, TCP_SND_QUEUELEN must fit in an u16_t, so, you have to reduce it in your lwipopts.h"
 #endif
@@ -141,7 +141,7 @@ icmp_input(struct pbuf *p, struct netif *inp)
       goto lenerr;
     }
 #if CHECKSUM_CHECK_ICMP
-    IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_CHECK_ICMP) {
+    IF__NETIF_CHECKSUM_ENABLED_OR(inp, NETIF_CHECKSUM_CHECK_ICMP, (p->flags & PBUF_FLAG_SW_CHKSUM) != 0) {
       if (inet_chksum_pbuf(p) != 0) {
         LWIP_DEBUGF(ICMP_DEBUG, ("icmp_input: checksum failed for received ICMP echo\n"));
         pbuf_free(p);
@@ -207,7 +207,8 @@ icmp_input(struct pbuf *p, struct netif *inp)
       ip4_addr_copy(iphdr->dest, *ip4_current_src_addr());
       ICMPH_TYPE_SET(iecho, ICMP_ER);
 #if CHECKSUM_GEN_ICMP
-      IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_GEN_ICMP) {
+      /* a reply that gets fragmented cannot be checksummed by the netif */
+      IF__NETIF_CHECKSUM_ENABLED_OR(inp, NETIF_CHECKSUM_GEN_ICMP, (inp->mtu != 0) && (p->tot_len > inp->mtu)) {
         /* adjust the checksum */
         if (iecho->chksum > PP_HTONS(0xffffU - (ICMP_ECHO << 8))) {
           iecho->chksum += PP_HTONS(ICMP_ECHO << 8) + 1;
@@ -655,6 +655,9 @@ ip4_reass(struct pbuf *p)
 
     MIB2_STATS_INC(mib2.ipreasmoks);
 
+    /* checksum offload does not cover reassembled datagrams */
+    p->flags |= PBUF_FLAG_SW_CHKSUM;
+
     /* Return the pbuf chain */
     return p;
   }
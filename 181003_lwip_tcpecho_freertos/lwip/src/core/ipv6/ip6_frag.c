@@ -598,6 +598,9 @@ ip6_reass(struct pbuf *p)
       return NULL;
     }
 
+    /* checksum offload does not cover reassembled datagrams */
+    p->flags |= PBUF_FLAG_SW_CHKSUM;
+
     /* Return the pbuf chain */
     return p;
   }
@@ -131,6 +131,13 @@ void eth_rx_irq()
    aligned there. Therefore, PBUF_POOL_BUFSIZE_ALIGNED can be used here. */
 #define PBUF_POOL_BUFSIZE_ALIGNED LWIP_MEM_ALIGN_SIZE(PBUF_POOL_BUFSIZE)
 
+#if LWIP_TCP && LWIP_TCP_RCV_AUTOTUNE
+volatile u8_t pbuf_pool_empty_count;
+#define PBUF_POOL_EMPTY_COUNT() pbuf_pool_empty_count++
+#else /* LWIP_TCP && LWIP_TCP_RCV_AUTOTUNE */
+#define PBUF_POOL_EMPTY_COUNT()
+#endif /* LWIP_TCP && LWIP_TCP_RCV_AUTOTUNE */
+
 #if !LWIP_TCP || !TCP_QUEUE_OOSEQ || !PBUF_POOL_FREE_OOSEQ
 #define PBUF_POOL_IS_EMPTY()
 #else /* !LWIP_TCP || !TCP_QUEUE_OOSEQ || !PBUF_POOL_FREE_OOSEQ */
@@ -153,7 +160,8 @@ volatile u8_t pbuf_free_ooseq_pending;
 /**
  * Attempt to reclaim some memory from queued out-of-sequence TCP segments
  * if we run out of pool pbufs. It's better to give priority to new packets
- * if we're running out.
+ * if we're running out. With TCP_OOSEQ_EVICT_PBUFS > 0, only the highest
+ * sequence segments are evicted, otherwise one pcb's whole queue is freed.
  *
  * This must be done in the correct thread context therefore this function
  * can only be used with NO_SYS=0 and through tcpip_callback.
@@ -164,6 +172,19 @@ static
 void
 pbuf_free_ooseq(void)
 {
+#if TCP_OOSEQ_EVICT_PBUFS
+  u16_t freed = 0, n;
+  SYS_ARCH_SET(pbuf_free_ooseq_pending, 0);
+
+  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_free_ooseq: evicting out-of-sequence pbufs\n"));
+  while (freed < TCP_OOSEQ_EVICT_PBUFS) {
+    n = tcp_ooseq_evict();
+    if (n == 0) {
+      break;
+    }
+    freed += n;
+  }
+#else /* TCP_OOSEQ_EVICT_PBUFS */
   struct tcp_pcb* pcb;
   SYS_ARCH_SET(pbuf_free_ooseq_pending, 0);
 
@@ -171,11 +192,16 @@ pbuf_free_ooseq(void)
     if (NULL != pcb->ooseq) {
       /** Free the ooseq pbufs of one PCB only */
       LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_free_ooseq: freeing out-of-sequence pbufs\n"));
-      tcp_segs_free(pcb->ooseq);
-      pcb->ooseq = NULL;
+      while (pcb->ooseq != NULL) {
+        struct tcp_seg *seg = pcb->ooseq;
+        pcb->ooseq = seg->next;
+        tcp_seg_free(seg);
+        TCP_OOSEQ_STATS_INC(tcp_ooseq.evict);
+      }
       return;
     }
   }
+#endif /* TCP_OOSEQ_EVICT_PBUFS */
 }
 
 #if !NO_SYS
@@ -285,6 +311,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
     p = (struct pbuf *)memp_malloc(MEMP_PBUF_POOL);
     LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc: allocated pbuf %p\n", (void *)p));
     if (p == NULL) {
+      PBUF_POOL_EMPTY_COUNT();
       PBUF_POOL_IS_EMPTY();
       return NULL;
     }
@@ -317,6 +344,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
     while (rem_len > 0) {
       q = (struct pbuf *)memp_malloc(MEMP_PBUF_POOL);
       if (q == NULL) {
+        PBUF_POOL_EMPTY_COUNT();
         PBUF_POOL_IS_EMPTY();
         /* free chain so far allocated */
         pbuf_free(p);
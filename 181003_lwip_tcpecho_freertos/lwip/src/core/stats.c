@@ -44,11 +44,43 @@
 #include "lwip/stats.h"
 #include "lwip/mem.h"
 #include "lwip/debug.h"
+#include "lwip/sys.h"
 
 #include <string.h>
 
 struct stats_ lwip_stats;
 
+#if LWIP_STATS_HIST
+static const char *const stats_hist_names[STATS_HIST_MAX] = {
+  "tcpip mbox",
+  "tcpip msg",
+  "netif input",
+  "tcp_input",
+  "tcp_output"
+};
+
+/** Measure what one STATS_HIST_START/STATS_HIST_STOP pair costs */
+static u32_t
+stats_hist_calibrate(void)
+{
+  struct stats_hist scratch;
+  u32_t best = 0xFFFFFFFFUL;
+  u32_t t, cycles;
+  int i;
+
+  memset(&scratch, 0, sizeof(scratch));
+  for (i = 0; i < 8; i++) {
+    t = LWIP_STATS_CYCLES();
+    stats_hist_add(&scratch, 0);
+    cycles = LWIP_STATS_CYCLES() - t;
+    if (cycles < best) {
+      best = cycles;
+    }
+  }
+  return best;
+}
+#endif /* LWIP_STATS_HIST */
+
 void
 stats_init(void)
 {
@@ -57,8 +89,81 @@ stats_init(void)
   lwip_stats.mem.name = "MEM";
 #endif /* MEM_STATS */
 #endif /* LWIP_DEBUG */
+#if LWIP_STATS_HIST
+  LWIP_STATS_CYCLES_INIT();
+  lwip_stats.hist_overhead = stats_hist_calibrate();
+#endif /* LWIP_STATS_HIST */
+}
+
+#if LWIP_STATS_HIST
+/**
+ * Add one sample to a histogram. Runs in constant time; like the other
+ * counters, histograms are updated without locking, so each one should only
+ * be fed from one context.
+ *
+ * @param hist the histogram
+ * @param cycles duration in LWIP_STATS_CYCLES() units
+ */
+void
+stats_hist_add(struct stats_hist *hist, u32_t cycles)
+{
+  u32_t n;
+
+#if defined(__GNUC__)
+  n = (u32_t)(31 - __builtin_clz(cycles | 1));
+#else
+  u32_t v = cycles;
+  for (n = 0; v > 1; n++) {
+    v >>= 1;
+  }
+#endif
+  if (n >= STATS_HIST_BUCKETS) {
+    n = STATS_HIST_BUCKETS - 1;
+  }
+  hist->bucket[n]++;
+  hist->count++;
+  if (cycles > hist->max) {
+    hist->max = cycles;
+  }
+}
+
+/**
+ * Copy a histogram, e.g. to report it from another thread.
+ */
+void
+stats_hist_get(enum stats_hist_id id, struct stats_hist *hist)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  LWIP_ASSERT("invalid histogram", id < STATS_HIST_MAX);
+  SYS_ARCH_PROTECT(lev);
+  MEMCPY(hist, &lwip_stats.hist[id], sizeof(struct stats_hist));
+  SYS_ARCH_UNPROTECT(lev);
+}
+
+/**
+ * Clear all histograms.
+ */
+void
+stats_hist_reset(void)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  memset(lwip_stats.hist, 0, sizeof(lwip_stats.hist));
+  SYS_ARCH_UNPROTECT(lev);
 }
 
+/**
+ * Name of a histogram, for reports.
+ */
+const char *
+stats_hist_name(enum stats_hist_id id)
+{
+  return (id < STATS_HIST_MAX) ? stats_hist_names[id] : "?";
+}
+#endif /* LWIP_STATS_HIST */
+
 #if LWIP_STATS_DISPLAY
 void
 stats_display_proto(struct stats_proto *proto, const char *name)
@@ -78,6 +183,18 @@ stats_display_proto(struct stats_proto *proto, const char *name)
   LWIP_PLATFORM_DIAG(("cachehit: %"STAT_COUNTER_F"\n", proto->cachehit));
 }
 
+#if TCP_STATS && TCP_QUEUE_OOSEQ
+void
+stats_display_tcp_ooseq(struct stats_tcp_ooseq *ooseq)
+{
+  LWIP_PLATFORM_DIAG(("\nTCP OOSEQ\n\t"));
+  LWIP_PLATFORM_DIAG(("queued: %"STAT_COUNTER_F"\n\t", ooseq->queued));
+  LWIP_PLATFORM_DIAG(("hit: %"STAT_COUNTER_F"\n\t", ooseq->hit));
+  LWIP_PLATFORM_DIAG(("evict: %"STAT_COUNTER_F"\n\t", ooseq->evict));
+  LWIP_PLATFORM_DIAG(("max: %"STAT_COUNTER_F"\n", ooseq->max));
+}
+#endif /* TCP_STATS && TCP_QUEUE_OOSEQ */
+
 #if IGMP_STATS || MLD6_STATS
 void
 stats_display_igmp(struct stats_igmp *igmp, const char *name)
@@ -139,6 +256,27 @@ stats_display_sys(struct stats_sys *sys)
 }
 #endif /* SYS_STATS */
 
+#if LWIP_STATS_HIST
+void
+stats_display_hist(void)
+{
+  struct stats_hist hist;
+  int id, i;
+
+  LWIP_PLATFORM_DIAG(("\nHIST (cycles, overhead %"U32_F")\n", lwip_stats.hist_overhead));
+  for (id = 0; id < STATS_HIST_MAX; id++) {
+    stats_hist_get((enum stats_hist_id)id, &hist);
+    LWIP_PLATFORM_DIAG(("%s: count %"U32_F" max %"U32_F"\n\t", stats_hist_name((enum stats_hist_id)id),
+                        hist.count, hist.max));
+    for (i = 0; i < STATS_HIST_BUCKETS; i++) {
+      if (hist.bucket[i] != 0) {
+        LWIP_PLATFORM_DIAG(("<2^%d: %"U32_F"\n\t", i + 1, hist.bucket[i]));
+      }
+    }
+  }
+}
+#endif /* LWIP_STATS_HIST */
+
 void
 stats_display(void)
 {
@@ -157,11 +295,13 @@ stats_display(void)
   ICMP6_STATS_DISPLAY();
   UDP_STATS_DISPLAY();
   TCP_STATS_DISPLAY();
+  TCP_OOSEQ_STATS_DISPLAY();
   MEM_STATS_DISPLAY();
   for (i = 0; i < MEMP_MAX; i++) {
     MEMP_STATS_DISPLAY(i);
   }
   SYS_STATS_DISPLAY();
+  STATS_HIST_DISPLAY();
 }
 #endif /* LWIP_STATS_DISPLAY */
 
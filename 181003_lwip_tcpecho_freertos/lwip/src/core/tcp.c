@@ -56,6 +56,7 @@
 #include "lwip/priv/tcp_priv.h"
 #include "lwip/debug.h"
 #include "lwip/stats.h"
+#include "lwip/sys.h"
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
 #include "lwip/nd6.h"
@@ -781,6 +782,86 @@ tcp_update_rcv_ann_wnd(struct tcp_pcb *pcb)
   }
 }
 
+#if LWIP_TCP_RCV_AUTOTUNE
+/**
+ * Receive window auto-tuning, called by tcp_recved() instead of simply
+ * giving the drained data back to rcv_wnd.
+ *
+ * A connection needs a window of what the application drains in one
+ * round-trip time. The round-trip time is estimated as the shortest time a
+ * full window took to arrive, since the sender is window-limited while the
+ * window is too small. Whenever the application drained more in one
+ * round-trip time than before, the window is set to twice that amount. The
+ * recorded amount decays by 1/8 per round-trip time without growth.
+ * When PBUF_POOL ran empty in the meantime, the window is halved instead,
+ * by not opening it again for the data the application has read.
+ *
+ * @param pcb the tcp_pcb for which data is read
+ * @param len the amount of bytes that have been read by the application
+ */
+static void
+tcp_rcv_autotune(struct tcp_pcb *pcb, u16_t len)
+{
+  u32_t now = sys_now();
+  u32_t target;
+
+  if (pcb->rcv_pool_empty != pbuf_pool_empty_count) {
+    /* memory pressure: shrink, and only grow again once the drain rate
+       recorded for the old window has decayed below the measured one */
+    pcb->rcv_pool_empty = pbuf_pool_empty_count;
+    pcb->rcv_space = pcb->rcv_wnd_max;
+    pcb->rcv_wnd_target = LWIP_MAX(pcb->rcv_wnd_max / 2, TCP_WND_INITIAL);
+  }
+  if (pcb->rcv_wnd_max > pcb->rcv_wnd_target) {
+    /* the window must not move left: keep back what was read instead */
+    tcpwnd_size_t keep = (tcpwnd_size_t)LWIP_MIN(len, pcb->rcv_wnd_max - pcb->rcv_wnd_target);
+    pcb->rcv_wnd_max -= keep;
+    pcb->rcv_wnd += len - keep;
+    return;
+  }
+  pcb->rcv_wnd += len;
+
+  /* round-trip time sample: the time a full window takes to arrive */
+  if ((pcb->rcv_rtt_time != 0) && TCP_SEQ_GEQ(pcb->rcv_nxt, pcb->rcv_rtt_seq)) {
+    u32_t rtt = LWIP_MAX(now - pcb->rcv_rtt_time, 1);
+    if ((pcb->rcv_rtt == 0) || (rtt < pcb->rcv_rtt)) {
+      if (pcb->rcv_rtt == 0) {
+        pcb->rcv_copied = 0;
+        pcb->rcv_round_time = now;
+      }
+      pcb->rcv_rtt = rtt;
+    }
+    pcb->rcv_rtt_time = 0;
+  }
+  if (pcb->rcv_rtt_time == 0) {
+    pcb->rcv_rtt_seq = pcb->rcv_nxt + pcb->rcv_wnd_max;
+    pcb->rcv_rtt_time = LWIP_MAX(now, 1);
+  }
+  if (pcb->rcv_rtt == 0) {
+    return;
+  }
+
+  /* drain rate: data read by the application per round-trip time */
+  pcb->rcv_copied += len;
+  if ((u32_t)(now - pcb->rcv_round_time) >= pcb->rcv_rtt) {
+    if (pcb->rcv_copied > pcb->rcv_space) {
+      pcb->rcv_space = pcb->rcv_copied;
+      target = LWIP_MIN(2 * pcb->rcv_copied, TCP_WND_LIMIT(pcb));
+      if (target > pcb->rcv_wnd_max) {
+        LWIP_DEBUGF(TCP_WND_DEBUG, ("tcp_rcv_autotune: window %"TCPWNDSIZE_F" -> %"U32_F" (rtt %"U32_F" ms)\n",
+                                    pcb->rcv_wnd_max, target, pcb->rcv_rtt));
+        pcb->rcv_wnd += (tcpwnd_size_t)(target - pcb->rcv_wnd_max);
+        pcb->rcv_wnd_max = pcb->rcv_wnd_target = (tcpwnd_size_t)target;
+      }
+    } else {
+      pcb->rcv_space -= pcb->rcv_space / 8;
+    }
+    pcb->rcv_copied = 0;
+    pcb->rcv_round_time = now;
+  }
+}
+#endif /* LWIP_TCP_RCV_AUTOTUNE */
+
 /**
  * @ingroup tcp_raw
  * This function should be called by the application when it has
@@ -799,7 +880,11 @@ tcp_recved(struct tcp_pcb *pcb, u16_t len)
   LWIP_ASSERT("don't call tcp_recved for listen-pcbs",
     pcb->state != LISTEN);
 
+#if LWIP_TCP_RCV_AUTOTUNE
+  tcp_rcv_autotune(pcb, len);
+#else /* LWIP_TCP_RCV_AUTOTUNE */
   pcb->rcv_wnd += len;
+#endif /* LWIP_TCP_RCV_AUTOTUNE */
   if (pcb->rcv_wnd > TCP_WND_MAX(pcb)) {
     pcb->rcv_wnd = TCP_WND_MAX(pcb);
   } else if (pcb->rcv_wnd == 0) {
@@ -820,7 +905,11 @@ tcp_recved(struct tcp_pcb *pcb, u16_t len)
    * watermark is TCP_WND/4), then send an explicit update now.
    * Otherwise wait for a packet to be sent in the normal course of
    * events (or more window to be available later) */
+#if LWIP_TCP_RCV_AUTOTUNE
+  if (wnd_inflation >= (int)LWIP_MIN(TCP_WND_UPDATE_THRESHOLD, TCP_WND_MAX(pcb) / 4)) {
+#else /* LWIP_TCP_RCV_AUTOTUNE */
   if (wnd_inflation >= TCP_WND_UPDATE_THRESHOLD) {
+#endif /* LWIP_TCP_RCV_AUTOTUNE */
     tcp_ack_now(pcb);
     tcp_output(pcb);
   }
@@ -943,7 +1032,10 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
   pcb->snd_lbb = iss - 1;
   /* Start with a window that does not need scaling. When window scaling is
      enabled and used, the window is enlarged when both sides agree on scaling. */
-  pcb->rcv_wnd = pcb->rcv_ann_wnd = TCPWND_MIN16(TCP_WND);
+  pcb->rcv_wnd = pcb->rcv_ann_wnd = TCP_WND_INITIAL;
+#if LWIP_TCP_RCV_AUTOTUNE
+  pcb->rcv_wnd_max = pcb->rcv_wnd_target = TCP_WND_INITIAL;
+#endif /* LWIP_TCP_RCV_AUTOTUNE */
   pcb->rcv_ann_right_edge = pcb->rcv_nxt;
   pcb->snd_wnd = TCP_WND;
   /* As initial send MSS, we use TCP_MSS but limit it to 536.
@@ -1165,6 +1257,7 @@ tcp_slowtmr_start:
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_active_pcbs", tcp_active_pcbs == pcb);
         tcp_active_pcbs = pcb->next;
       }
+      tcp_pcb_hash_remove(&tcp_active_pcbs, pcb);
 
       if (pcb_reset) {
         tcp_rst(pcb->snd_nxt, pcb->rcv_nxt, &pcb->local_ip, &pcb->remote_ip,
@@ -1231,6 +1324,7 @@ tcp_slowtmr_start:
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_tw_pcbs", tcp_tw_pcbs == pcb);
         tcp_tw_pcbs = pcb->next;
       }
+      tcp_pcb_hash_remove(&tcp_tw_pcbs, pcb);
       pcb2 = pcb;
       pcb = pcb->next;
       memp_free(MEMP_TCP_PCB, pcb2);
@@ -1431,8 +1525,81 @@ tcp_seg_copy(struct tcp_seg *seg)
   }
   SMEMCPY((u8_t *)cseg, (const u8_t *)seg, sizeof(struct tcp_seg));
   pbuf_ref(cseg->p);
+  /* segments are only copied to be put on ooseq */
+  TCP_OOSEQ_STATS_INC(tcp_ooseq.queued);
   return cseg;
 }
+
+/**
+ * Sums up the data held on the ooseq queues of all active pcbs.
+ *
+ * @param bytes if != NULL, receives the number of bytes queued
+ * @return the number of pbufs queued
+ */
+u16_t
+tcp_ooseq_usage(u32_t *bytes)
+{
+  struct tcp_pcb *pcb;
+  struct tcp_seg *seg;
+  u32_t blen = 0;
+  u16_t qlen = 0;
+
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    for (seg = pcb->ooseq; seg != NULL; seg = seg->next) {
+      blen += seg->p->tot_len;
+      qlen += pbuf_clen(seg->p);
+    }
+  }
+  if (bytes != NULL) {
+    *bytes = blen;
+  }
+  return qlen;
+}
+
+/**
+ * Evicts the highest sequence segment from the ooseq queue that holds the
+ * most pbufs. The end of a queue is the data the application needs last, so
+ * the segments closest to rcv_nxt are kept as long as possible.
+ *
+ * @return the number of pbufs freed, 0 if no ooseq data was queued
+ */
+u16_t
+tcp_ooseq_evict(void)
+{
+  struct tcp_pcb *pcb, *victim = NULL;
+  struct tcp_seg *seg, *prev;
+  u16_t qlen, victim_qlen = 0;
+
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    qlen = 0;
+    for (seg = pcb->ooseq; seg != NULL; seg = seg->next) {
+      qlen += pbuf_clen(seg->p);
+    }
+    if (qlen > victim_qlen) {
+      victim = pcb;
+      victim_qlen = qlen;
+    }
+  }
+  if (victim == NULL) {
+    return 0;
+  }
+
+  prev = NULL;
+  for (seg = victim->ooseq; seg->next != NULL; seg = seg->next) {
+    prev = seg;
+  }
+  if (prev == NULL) {
+    victim->ooseq = NULL;
+  } else {
+    prev->next = NULL;
+  }
+  LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_ooseq_evict: evicting seqno %"U32_F" len %"U16_F"\n",
+                                seg->tcphdr->seqno, seg->len));
+  qlen = pbuf_clen(seg->p);
+  tcp_seg_free(seg);
+  TCP_OOSEQ_STATS_INC(tcp_ooseq.evict);
+  return qlen;
+}
 #endif /* TCP_QUEUE_OOSEQ */
 
 #if LWIP_CALLBACK_API
@@ -1608,7 +1775,11 @@ tcp_alloc(u8_t prio)
     pcb->snd_buf = TCP_SND_BUF;
     /* Start with a window that does not need scaling. When window scaling is
        enabled and used, the window is enlarged when both sides agree on scaling. */
-    pcb->rcv_wnd = pcb->rcv_ann_wnd = TCPWND_MIN16(TCP_WND);
+    pcb->rcv_wnd = pcb->rcv_ann_wnd = TCP_WND_INITIAL;
+#if LWIP_TCP_RCV_AUTOTUNE
+    pcb->rcv_wnd_max = pcb->rcv_wnd_target = TCP_WND_INITIAL;
+    pcb->rcv_pool_empty = pbuf_pool_empty_count;
+#endif /* LWIP_TCP_RCV_AUTOTUNE */
     pcb->ttl = TCP_TTL;
     /* As initial send MSS, we use TCP_MSS but limit it to 536.
        The send MSS is updated when an MSS option is received. */
@@ -1850,6 +2021,174 @@ tcp_pcb_purge(struct tcp_pcb *pcb)
   }
 }
 
+#if LWIP_TCP_PCB_HASH
+/** Buckets of active and TIME-WAIT pcbs, hashed on the 4-tuple. Both lists
+    are kept in one table because a 4-tuple is in at most one of them. */
+static struct tcp_pcb *tcp_conn_hash[TCP_PCB_HASH_SIZE];
+/** Buckets of listening pcbs, hashed on the local port */
+static struct tcp_pcb_listen *tcp_listen_hash[TCP_LISTEN_PCB_HASH_SIZE];
+
+#define TCP_LISTEN_HASH(port) ((port) & (TCP_LISTEN_PCB_HASH_SIZE - 1))
+
+/** Fold an IP address into 32 bits for hashing */
+static u32_t
+tcp_hash_addr(const ip_addr_t *addr)
+{
+#if LWIP_IPV6
+  if (IP_IS_V6(addr)) {
+    const u32_t *a = ip_2_ip6(addr)->addr;
+    return a[0] ^ a[1] ^ a[2] ^ a[3];
+  }
+#endif /* LWIP_IPV6 */
+#if LWIP_IPV4
+  return ip4_addr_get_u32(ip_2_ip4(addr));
+#else /* LWIP_IPV4 */
+  return 0;
+#endif /* LWIP_IPV4 */
+}
+
+/** Bucket of tcp_conn_hash that holds the given 4-tuple */
+static u16_t
+tcp_conn_hash_index(u16_t local_port, const ip_addr_t *local_ip,
+                    u16_t remote_port, const ip_addr_t *remote_ip)
+{
+  u32_t h = tcp_hash_addr(local_ip) ^ tcp_hash_addr(remote_ip) ^
+            (((u32_t)local_port << 16) | remote_port);
+  /* mix the high bits down so that the mask below sees all of them */
+  h ^= h >> 16;
+  h *= 0x45d9f3bUL;
+  h ^= h >> 16;
+  return (u16_t)(h & (TCP_PCB_HASH_SIZE - 1));
+}
+
+/**
+ * Add a pcb to the demux hash table matching the list it is registered with.
+ * Called by TCP_REG after the pcb has been put on the list.
+ *
+ * @param pcblist the list the pcb has just been put on
+ * @param pcb the pcb, with its local and (if connected) remote address set
+ */
+void
+tcp_pcb_hash_add(struct tcp_pcb **pcblist, struct tcp_pcb *pcb)
+{
+  if ((pcblist == &tcp_active_pcbs) || (pcblist == &tcp_tw_pcbs)) {
+    u16_t idx = tcp_conn_hash_index(pcb->local_port, &pcb->local_ip,
+                                    pcb->remote_port, &pcb->remote_ip);
+    pcb->hash_next = tcp_conn_hash[idx];
+    tcp_conn_hash[idx] = pcb;
+  } else if (pcblist == &tcp_listen_pcbs.pcbs) {
+    struct tcp_pcb_listen *lpcb = (struct tcp_pcb_listen *)pcb;
+    u16_t idx = TCP_LISTEN_HASH(lpcb->local_port);
+    lpcb->hash_next = tcp_listen_hash[idx];
+    tcp_listen_hash[idx] = lpcb;
+  }
+}
+
+/**
+ * Remove a pcb from the demux hash table matching the list it is taken off.
+ * Must be called before the pcb's addresses or ports are changed.
+ *
+ * @param pcblist the list the pcb is removed from
+ * @param pcb the pcb to remove
+ */
+void
+tcp_pcb_hash_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb)
+{
+  if ((pcblist == &tcp_active_pcbs) || (pcblist == &tcp_tw_pcbs)) {
+    struct tcp_pcb **pp = &tcp_conn_hash[tcp_conn_hash_index(pcb->local_port, &pcb->local_ip,
+                                                             pcb->remote_port, &pcb->remote_ip)];
+    for (; *pp != NULL; pp = &(*pp)->hash_next) {
+      if (*pp == pcb) {
+        *pp = pcb->hash_next;
+        break;
+      }
+    }
+    pcb->hash_next = NULL;
+  } else if (pcblist == &tcp_listen_pcbs.pcbs) {
+    struct tcp_pcb_listen *lpcb = (struct tcp_pcb_listen *)pcb;
+    struct tcp_pcb_listen **pp = &tcp_listen_hash[TCP_LISTEN_HASH(lpcb->local_port)];
+    for (; *pp != NULL; pp = &(*pp)->hash_next) {
+      if (*pp == lpcb) {
+        *pp = lpcb->hash_next;
+        break;
+      }
+    }
+    lpcb->hash_next = NULL;
+  }
+}
+
+/**
+ * Find the active or TIME-WAIT pcb for a 4-tuple.
+ * Callers tell the two apart by pcb->state.
+ *
+ * @return the matching pcb or NULL
+ */
+struct tcp_pcb *
+tcp_pcb_hash_lookup(u16_t local_port, const ip_addr_t *local_ip,
+                    u16_t remote_port, const ip_addr_t *remote_ip)
+{
+  struct tcp_pcb *pcb;
+
+  pcb = tcp_conn_hash[tcp_conn_hash_index(local_port, local_ip, remote_port, remote_ip)];
+  for (; pcb != NULL; pcb = pcb->hash_next) {
+    if (pcb->remote_port == remote_port &&
+        pcb->local_port == local_port &&
+        ip_addr_cmp(&pcb->remote_ip, remote_ip) &&
+        ip_addr_cmp(&pcb->local_ip, local_ip)) {
+      break;
+    }
+  }
+  return pcb;
+}
+
+/**
+ * Find the listening pcb that accepts connections to a local address and
+ * port, with the same precedence as the list walk in tcp_input().
+ *
+ * @return the matching listening pcb or NULL
+ */
+struct tcp_pcb_listen *
+tcp_listen_pcb_hash_lookup(u16_t local_port, const ip_addr_t *local_ip)
+{
+  struct tcp_pcb_listen *lpcb;
+#if SO_REUSE
+  struct tcp_pcb_listen *lpcb_any = NULL;
+#endif /* SO_REUSE */
+
+  for (lpcb = tcp_listen_hash[TCP_LISTEN_HASH(local_port)]; lpcb != NULL; lpcb = lpcb->hash_next) {
+    if (lpcb->local_port == local_port) {
+      if (IP_IS_ANY_TYPE_VAL(lpcb->local_ip)) {
+        /* found an ANY TYPE (IPv4/IPv6) match */
+#if SO_REUSE
+        lpcb_any = lpcb;
+#else /* SO_REUSE */
+        break;
+#endif /* SO_REUSE */
+      } else if (IP_ADDR_PCB_VERSION_MATCH_EXACT(lpcb, local_ip)) {
+        if (ip_addr_cmp(&lpcb->local_ip, local_ip)) {
+          /* found an exact match */
+          break;
+        } else if (ip_addr_isany(&lpcb->local_ip)) {
+          /* found an ANY-match */
+#if SO_REUSE
+          lpcb_any = lpcb;
+#else /* SO_REUSE */
+          break;
+#endif /* SO_REUSE */
+        }
+      }
+    }
+  }
+#if SO_REUSE
+  /* only pass to ANY if no specific local IP has been found */
+  if (lpcb == NULL) {
+    lpcb = lpcb_any;
+  }
+#endif /* SO_REUSE */
+  return lpcb;
+}
+#endif /* LWIP_TCP_PCB_HASH */
+
 /**
  * Purges the PCB and removes it from a PCB list. Any delayed ACKs are sent first.
  *
@@ -85,6 +85,9 @@ struct tcp_pcb *tcp_input_pcb;
 static err_t tcp_process(struct tcp_pcb *pcb);
 static void tcp_receive(struct tcp_pcb *pcb);
 static void tcp_parseopt(struct tcp_pcb *pcb);
+#if LWIP_TCP_SACK
+static void tcp_sack_mark(struct tcp_pcb *pcb, u32_t left, u32_t right);
+#endif /* LWIP_TCP_SACK */
 
 static void tcp_listen_input(struct tcp_pcb_listen *pcb);
 static void tcp_timewait_input(struct tcp_pcb *pcb);
@@ -92,23 +95,20 @@ static void tcp_timewait_input(struct tcp_pcb *pcb);
 static int tcp_input_delayed_close(struct tcp_pcb *pcb);
 
 /**
- * The initial input processing of TCP. It verifies the TCP header, demultiplexes
- * the segment between the PCBs and passes it on to tcp_process(), which implements
- * the TCP finite state machine. This function is called by the IP layer (in
- * ip_input()).
- *
- * @param p received TCP segment to process (p->payload pointing to the TCP header)
- * @param inp network interface on which this segment was received
+ * Does the work of tcp_input().
  */
-void
-tcp_input(struct pbuf *p, struct netif *inp)
+static void
+tcp_input_pbuf(struct pbuf *p, struct netif *inp)
 {
-  struct tcp_pcb *pcb, *prev;
+  struct tcp_pcb *pcb;
   struct tcp_pcb_listen *lpcb;
+#if !LWIP_TCP_PCB_HASH
+  struct tcp_pcb *prev;
 #if SO_REUSE
   struct tcp_pcb *lpcb_prev = NULL;
   struct tcp_pcb_listen *lpcb_any = NULL;
 #endif /* SO_REUSE */
+#endif /* !LWIP_TCP_PCB_HASH */
   u8_t hdrlen_bytes;
   err_t err;
 
@@ -141,7 +141,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
   }
 
 #if CHECKSUM_CHECK_TCP
-  IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_CHECK_TCP) {
+  IF__NETIF_CHECKSUM_ENABLED_OR(inp, NETIF_CHECKSUM_CHECK_TCP, (p->flags & PBUF_FLAG_SW_CHKSUM) != 0) {
     /* Verify TCP checksum. */
     u16_t chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len,
                                ip_current_src_addr(), ip_current_dest_addr());
@@ -220,6 +220,19 @@ tcp_input(struct pbuf *p, struct netif *inp)
 
   /* Demultiplex an incoming segment. First, we check if it is destined
      for an active connection. */
+#if LWIP_TCP_PCB_HASH
+  /* One table holds both active and TIME-WAIT connections. */
+  pcb = tcp_pcb_hash_lookup(tcphdr->dest, ip_current_dest_addr(),
+                            tcphdr->src, ip_current_src_addr());
+  if ((pcb != NULL) && (pcb->state == TIME_WAIT)) {
+    LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packed for TIME_WAITing connection.\n"));
+    tcp_timewait_input(pcb);
+    pbuf_free(p);
+    return;
+  }
+  LWIP_ASSERT("tcp_input: active pcb->state != CLOSED", (pcb == NULL) || (pcb->state != CLOSED));
+  LWIP_ASSERT("tcp_input: active pcb->state != LISTEN", (pcb == NULL) || (pcb->state != LISTEN));
+#else /* LWIP_TCP_PCB_HASH */
   prev = NULL;
 
   for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
@@ -246,8 +259,13 @@ tcp_input(struct pbuf *p, struct netif *inp)
     }
     prev = pcb;
   }
+#endif /* LWIP_TCP_PCB_HASH */
 
   if (pcb == NULL) {
+#if LWIP_TCP_PCB_HASH
+    lpcb = tcp_listen_pcb_hash_lookup(tcphdr->dest, ip_current_dest_addr());
+    if (lpcb != NULL) {
+#else /* LWIP_TCP_PCB_HASH */
     /* If it did not go to an active connection, we check the connections
        in the TIME-WAIT state. */
     for (pcb = tcp_tw_pcbs; pcb != NULL; pcb = pcb->next) {
@@ -317,6 +335,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
       } else {
         TCP_STATS_INC(tcp.cachehit);
       }
+#endif /* LWIP_TCP_PCB_HASH */
 
       LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packed for LISTENing connection.\n"));
       tcp_listen_input(lpcb);
@@ -527,6 +546,25 @@ dropped:
   pbuf_free(p);
 }
 
+/**
+ * The initial input processing of TCP. It verifies the TCP header, demultiplexes
+ * the segment between the PCBs and passes it on to tcp_process(), which implements
+ * the TCP finite state machine. This function is called by the IP layer (in
+ * ip_input()).
+ *
+ * @param p received TCP segment to process (p->payload pointing to the TCP header)
+ * @param inp network interface on which this segment was received
+ */
+void
+tcp_input(struct pbuf *p, struct netif *inp)
+{
+  STATS_HIST_DECL(t);
+
+  STATS_HIST_START(t);
+  tcp_input_pbuf(p, inp);
+  STATS_HIST_STOP(STATS_HIST_TCP_INPUT, t);
+}
+
 /** Called from tcp_input to check for TF_CLOSED flag. This results in closing
  * and deallocating a pcb at the correct place to ensure noone references it
  * any more.
@@ -1024,10 +1062,11 @@ tcp_receive(struct tcp_pcb *pcb)
   u32_t right_wnd_edge;
   u16_t new_tot_len;
   int found_dupack = 0;
-#if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS
+#if TCP_QUEUE_OOSEQ && (TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS || \
+    TCP_OOSEQ_GLOBAL_MAX_BYTES || TCP_OOSEQ_GLOBAL_MAX_PBUFS || TCP_STATS)
   u32_t ooseq_blen;
   u16_t ooseq_qlen;
-#endif /* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS */
+#endif
 
   LWIP_ASSERT("tcp_receive: wrong state", pcb->state >= ESTABLISHED);
 
@@ -1128,8 +1167,16 @@ tcp_receive(struct tcp_pcb *pcb)
          in fast retransmit. Also reset the congestion window to the
          slow start threshold. */
       if (pcb->flags & TF_INFR) {
-        pcb->flags &= ~TF_INFR;
-        pcb->cwnd = pcb->ssthresh;
+#if LWIP_TCP_SACK
+        if ((pcb->flags & TF_SACK) && TCP_SEQ_LT(ackno, pcb->snd_recover)) {
+          /* Partial ACK: stay in fast recovery, the next hole is
+             retransmitted below. */
+        } else
+#endif /* LWIP_TCP_SACK */
+        {
+          pcb->flags &= ~TF_INFR;
+          pcb->cwnd = pcb->ssthresh;
+        }
       }
 
       /* Reset the number of retransmissions. */
@@ -1143,8 +1190,8 @@ tcp_receive(struct tcp_pcb *pcb)
       pcb->lastack = ackno;
 
       /* Update the congestion control variables (cwnd and
-         ssthresh). */
-      if (pcb->state >= ESTABLISHED) {
+         ssthresh). Not while fast recovery continues after a partial ACK. */
+      if ((pcb->state >= ESTABLISHED) && !(pcb->flags & TF_INFR)) {
         if (pcb->cwnd < pcb->ssthresh) {
           if ((tcpwnd_size_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
             pcb->cwnd += pcb->mss;
@@ -1277,6 +1324,13 @@ tcp_receive(struct tcp_pcb *pcb)
 
       pcb->rttest = 0;
     }
+
+#if LWIP_TCP_SACK
+    /* In fast recovery, retransmit the holes this ACK has revealed */
+    if ((pcb->flags & TF_INFR) && (pcb->flags & TF_SACK)) {
+      tcp_rexmit_sack(pcb);
+    }
+#endif /* LWIP_TCP_SACK */
   }
 
   /* If the incoming segment contains data, we must process it
@@ -1460,6 +1514,7 @@ tcp_receive(struct tcp_pcb *pcb)
 #endif /* TCP_QUEUE_OOSEQ */
 
         pcb->rcv_nxt = seqno + tcplen;
+        TCP_PCB_STATS_ADD(pcb, bytes_in, inseg.len);
 
         /* Update the receiver's (our) window. */
         LWIP_ASSERT("tcp_receive: tcplen > rcv_wnd\n", pcb->rcv_wnd >= tcplen);
@@ -1498,6 +1553,7 @@ tcp_receive(struct tcp_pcb *pcb)
           seqno = pcb->ooseq->tcphdr->seqno;
 
           pcb->rcv_nxt += TCP_TCPLEN(cseg);
+          TCP_PCB_STATS_ADD(pcb, bytes_in, cseg->len);
           LWIP_ASSERT("tcp_receive: ooseq tcplen > rcv_wnd\n",
                       pcb->rcv_wnd >= TCP_TCPLEN(cseg));
           pcb->rcv_wnd -= TCP_TCPLEN(cseg);
@@ -1527,12 +1583,21 @@ tcp_receive(struct tcp_pcb *pcb)
 
           pcb->ooseq = cseg->next;
           tcp_seg_free(cseg);
+          TCP_OOSEQ_STATS_INC(tcp_ooseq.hit);
         }
 #endif /* TCP_QUEUE_OOSEQ */
 
 
         /* Acknowledge the segment(s). */
-        tcp_ack(pcb);
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+        if ((pcb->flags & TF_SACK) && (pcb->ooseq != NULL)) {
+          /* the sender is waiting for the remaining holes: tell it at once */
+          tcp_ack_now(pcb);
+        } else
+#endif /* LWIP_TCP_SACK && TCP_QUEUE_OOSEQ */
+        {
+          tcp_ack(pcb);
+        }
 
 #if LWIP_IPV6 && LWIP_ND6_TCP_REACHABILITY_HINTS
         if (ip_current_is_v6()) {
@@ -1543,7 +1608,9 @@ tcp_receive(struct tcp_pcb *pcb)
 
       } else {
         /* We get here if the incoming segment is out-of-sequence. */
+#if !(LWIP_TCP_SACK && TCP_QUEUE_OOSEQ)
         tcp_send_empty_ack(pcb);
+#endif /* !(LWIP_TCP_SACK && TCP_QUEUE_OOSEQ) */
 #if TCP_QUEUE_OOSEQ
         /* We queue the segment on the ->ooseq queue. */
         if (pcb->ooseq == NULL) {
@@ -1665,9 +1732,10 @@ tcp_receive(struct tcp_pcb *pcb)
             prev = next;
           }
         }
-#if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS
+#if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS || TCP_STATS
         /* Check that the data on ooseq doesn't exceed one of the limits
-           and throw away everything above that limit. */
+           and throw away everything above that limit. A limit of 0 means
+           no limit, also if only the other one is set. */
         ooseq_blen = 0;
         ooseq_qlen = 0;
         prev = NULL;
@@ -1675,10 +1743,10 @@ tcp_receive(struct tcp_pcb *pcb)
           struct pbuf *p = next->p;
           ooseq_blen += p->tot_len;
           ooseq_qlen += pbuf_clen(p);
-          if ((ooseq_blen > TCP_OOSEQ_MAX_BYTES) ||
-              (ooseq_qlen > TCP_OOSEQ_MAX_PBUFS)) {
+          if (((TCP_OOSEQ_MAX_BYTES != 0) && (ooseq_blen > TCP_OOSEQ_MAX_BYTES)) ||
+              ((TCP_OOSEQ_MAX_PBUFS != 0) && (ooseq_qlen > TCP_OOSEQ_MAX_PBUFS))) {
              /* too much ooseq data, dump this and everything after it */
-             tcp_segs_free(next);
+             ooseq_qlen -= pbuf_clen(p);
              if (prev == NULL) {
                /* first ooseq segment is too much, dump the whole queue */
                pcb->ooseq = NULL;
@@ -1686,10 +1754,38 @@ tcp_receive(struct tcp_pcb *pcb)
                /* just dump 'next' and everything after it */
                prev->next = NULL;
              }
+             while (next != NULL) {
+               cseg = next;
+               next = next->next;
+               tcp_seg_free(cseg);
+               TCP_OOSEQ_STATS_INC(tcp_ooseq.evict);
+             }
              break;
           }
         }
-#endif /* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS */
+#if TCP_STATS
+        if (STATS_GET(tcp_ooseq.max) < ooseq_qlen) {
+          STATS_GET(tcp_ooseq.max) = ooseq_qlen;
+        }
+#endif /* TCP_STATS */
+#endif /* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS || TCP_STATS */
+#if TCP_OOSEQ_GLOBAL_MAX_BYTES || TCP_OOSEQ_GLOBAL_MAX_PBUFS
+        /* Enforce the limits over all pcbs by evicting the highest sequence
+           data of the largest queues first. */
+        for (;;) {
+          ooseq_qlen = tcp_ooseq_usage(&ooseq_blen);
+          if (!(((TCP_OOSEQ_GLOBAL_MAX_BYTES != 0) && (ooseq_blen > TCP_OOSEQ_GLOBAL_MAX_BYTES)) ||
+                ((TCP_OOSEQ_GLOBAL_MAX_PBUFS != 0) && (ooseq_qlen > TCP_OOSEQ_GLOBAL_MAX_PBUFS)))) {
+            break;
+          }
+          tcp_ooseq_evict();
+        }
+#endif /* TCP_OOSEQ_GLOBAL_MAX_BYTES || TCP_OOSEQ_GLOBAL_MAX_PBUFS */
+#if LWIP_TCP_SACK
+        /* ACK only now that the SACK blocks can include this segment */
+        pcb->rcv_sack_recent = seqno;
+        tcp_send_empty_ack(pcb);
+#endif /* LWIP_TCP_SACK */
 #endif /* TCP_QUEUE_OOSEQ */
       }
     } else {
@@ -1779,10 +1875,12 @@ tcp_parseopt(struct tcp_pcb *pcb)
           }
           pcb->rcv_scale = TCP_RCV_SCALE;
           pcb->flags |= TF_WND_SCALE;
+          LWIP_ASSERT("window not at default value", pcb->rcv_wnd == TCP_WND_INITIAL);
+          LWIP_ASSERT("window not at default value", pcb->rcv_ann_wnd == TCP_WND_INITIAL);
+#if !LWIP_TCP_RCV_AUTOTUNE
           /* window scaling is enabled, we can use the full receive window */
-          LWIP_ASSERT("window not at default value", pcb->rcv_wnd == TCPWND_MIN16(TCP_WND));
-          LWIP_ASSERT("window not at default value", pcb->rcv_ann_wnd == TCPWND_MIN16(TCP_WND));
           pcb->rcv_wnd = pcb->rcv_ann_wnd = TCP_WND;
+#endif /* !LWIP_TCP_RCV_AUTOTUNE */
         }
         break;
 #endif
@@ -1811,6 +1909,43 @@ tcp_parseopt(struct tcp_pcb *pcb)
         tcp_optidx += LWIP_TCP_OPT_LEN_TS - 6;
         break;
 #endif
+#if LWIP_TCP_SACK
+      case LWIP_TCP_OPT_SACK_PERM:
+        LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK_PERM\n"));
+        if (tcp_getoptbyte() != LWIP_TCP_OPT_LEN_SACK_PERM || (tcp_optidx - 2 + LWIP_TCP_OPT_LEN_SACK_PERM) > tcphdr_optlen) {
+          /* Bad length */
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+          return;
+        }
+        if (flags & TCP_SYN) {
+          /* The remote host accepts SACK blocks (and will send them) */
+          pcb->flags |= TF_SACK;
+        }
+        break;
+      case LWIP_TCP_OPT_SACK:
+        LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK\n"));
+        data = tcp_getoptbyte();
+        if ((data < 10) || (((data - 2) & 7) != 0) || (tcp_optidx - 2 + data) > tcphdr_optlen) {
+          /* Bad length */
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+          return;
+        }
+        for (data = (u8_t)((data - 2) / 8); data > 0; data--) {
+          u32_t left, right;
+          left = (u32_t)tcp_getoptbyte() << 24;
+          left |= (u32_t)tcp_getoptbyte() << 16;
+          left |= (u32_t)tcp_getoptbyte() << 8;
+          left |= tcp_getoptbyte();
+          right = (u32_t)tcp_getoptbyte() << 24;
+          right |= (u32_t)tcp_getoptbyte() << 16;
+          right |= (u32_t)tcp_getoptbyte() << 8;
+          right |= tcp_getoptbyte();
+          if ((pcb->flags & TF_SACK) && (flags & TCP_ACK) && !(flags & TCP_SYN)) {
+            tcp_sack_mark(pcb, left, right);
+          }
+        }
+        break;
+#endif /* LWIP_TCP_SACK */
       default:
         LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: other\n"));
         data = tcp_getoptbyte();
@@ -1828,6 +1963,42 @@ tcp_parseopt(struct tcp_pcb *pcb)
   }
 }
 
+#if LWIP_TCP_SACK
+/**
+ * Mark the unacked segments covered by a received SACK block, so that
+ * fast recovery does not retransmit them.
+ *
+ * Called from tcp_parseopt().
+ *
+ * @param pcb the tcp_pcb that received the SACK block
+ * @param left first sequence number of the block
+ * @param right sequence number following the block
+ */
+static void
+tcp_sack_mark(struct tcp_pcb *pcb, u32_t left, u32_t right)
+{
+  struct tcp_seg *seg;
+  u32_t seg_seqno;
+
+  /* ignore blocks that are malformed, already acked or beyond what was sent */
+  if (!TCP_SEQ_LT(left, right) || TCP_SEQ_LEQ(right, pcb->lastack) ||
+      TCP_SEQ_GT(right, pcb->snd_nxt)) {
+    return;
+  }
+  /* the unacked queue is sorted by sequence number */
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    seg_seqno = lwip_ntohl(seg->tcphdr->seqno);
+    if (TCP_SEQ_GEQ(seg_seqno, right)) {
+      break;
+    }
+    if (TCP_SEQ_GEQ(seg_seqno, left) &&
+        TCP_SEQ_LEQ(seg_seqno + TCP_TCPLEN(seg), right)) {
+      seg->flags |= TF_SEG_SACKED;
+    }
+  }
+}
+#endif /* LWIP_TCP_SACK */
+
 void
 tcp_trigger_input_pcb_close(void)
 {
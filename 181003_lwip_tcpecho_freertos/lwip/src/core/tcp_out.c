@@ -52,7 +52,7 @@
 #include "lwip/stats.h"
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
-#if LWIP_TCP_TIMESTAMPS
+#if LWIP_TCP_TIMESTAMPS || LWIP_TCP_ZEROCOPY
 #include "lwip/sys.h"
 #endif
 
@@ -364,8 +364,122 @@ tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
  * - TCP_WRITE_FLAG_MORE (0x02) for TCP connection, PSH flag will not be set on last segment sent,
  * @return ERR_OK if enqueued, another err_t on error
  */
+#if LWIP_TCP_ZEROCOPY
+static err_t tcp_write_ext(struct tcp_pcb *pcb, const void *arg, u16_t len,
+                           u8_t apiflags, struct tcp_zc *zc);
+
 err_t
 tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
+{
+  return tcp_write_ext(pcb, arg, len, apiflags, NULL);
+}
+
+/**
+ * @ingroup tcp_raw
+ * Prepare a tcp_zc for tracking zero-copy writes. It holds one reference
+ * for the caller, which must be given up by tcp_zc_release() once all
+ * writes using it have been issued.
+ *
+ * @param zc tracking object, must stay valid until done has been called
+ * @param done callback called once the buffer is no longer referenced
+ * @param arg argument passed to done
+ */
+void
+tcp_zc_init(struct tcp_zc *zc, tcp_zc_fn done, void *arg)
+{
+  LWIP_ASSERT("tcp_zc_init: invalid zc", zc != NULL);
+  zc->done = done;
+  zc->arg = arg;
+  zc->pending = 1;
+}
+
+/**
+ * @ingroup tcp_raw
+ * Drop one reference from a tcp_zc and call its done callback when this
+ * was the last one. Called by the application after its last
+ * tcp_write_zc(), and internally whenever a zero-copy pbuf is freed.
+ *
+ * @param zc tracking object initialised by tcp_zc_init()
+ */
+void
+tcp_zc_release(struct tcp_zc *zc)
+{
+  u16_t pending;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  LWIP_ASSERT("tcp_zc_release: no reference left", zc->pending > 0);
+  pending = --zc->pending;
+  SYS_ARCH_UNPROTECT(lev);
+  if ((pending == 0) && (zc->done != NULL)) {
+    zc->done(zc->arg);
+  }
+}
+
+/** Free function of the zero-copy pbufs: releases their tcp_zc reference */
+static void
+tcp_zc_pbuf_free(struct pbuf *p)
+{
+  struct tcp_zc *zc = ((struct tcp_zc_pbuf *)p)->zc;
+
+  memp_free(MEMP_TCP_ZC_PBUF, p);
+  tcp_zc_release(zc);
+}
+
+/** Allocate a PBUF_REF pbuf referencing len bytes at data, tracked by zc */
+static struct pbuf *
+tcp_zc_pbuf_alloc(const u8_t *data, u16_t len, struct tcp_zc *zc)
+{
+  struct tcp_zc_pbuf *zp;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  zp = (struct tcp_zc_pbuf *)memp_malloc(MEMP_TCP_ZC_PBUF);
+  if (zp == NULL) {
+    return NULL;
+  }
+  zp->pc.custom_free_function = tcp_zc_pbuf_free;
+  zp->zc = zc;
+  SYS_ARCH_PROTECT(lev);
+  zc->pending++;
+  SYS_ARCH_UNPROTECT(lev);
+  return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &zp->pc,
+                             LWIP_CONST_CAST(u8_t *, data), len);
+}
+
+/**
+ * @ingroup tcp_raw
+ * Write data for sending without copying it, like tcp_write() without
+ * TCP_WRITE_FLAG_COPY. Unlike that, the application learns when the
+ * memory may be reused: every pbuf referencing the data holds a reference
+ * on zc, and zc->done is called when the last one is freed, i.e. after
+ * the data has been acknowledged (or the connection has been aborted)
+ * and the netif has let go of it.
+ *
+ * The data may be partly copied into the tail of a previous segment.
+ *
+ * @param pcb Protocol control block for the TCP connection to enqueue data for.
+ * @param arg Pointer to the data to be enqueued for sending.
+ * @param len Data length in bytes
+ * @param apiflags TCP_WRITE_FLAG_MORE or 0 (TCP_WRITE_FLAG_COPY is ignored)
+ * @param zc tracking object initialised by tcp_zc_init()
+ * @return ERR_OK if enqueued, another err_t on error
+ */
+err_t
+tcp_write_zc(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags,
+             struct tcp_zc *zc)
+{
+  LWIP_ERROR("tcp_write_zc: zc == NULL (programmer violates API)",
+             zc != NULL, return ERR_ARG;);
+  return tcp_write_ext(pcb, arg, len, (u8_t)(apiflags & ~TCP_WRITE_FLAG_COPY), zc);
+}
+
+static err_t
+tcp_write_ext(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags,
+              struct tcp_zc *zc)
+#else /* LWIP_TCP_ZEROCOPY */
+err_t
+tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
+#endif /* LWIP_TCP_ZEROCOPY */
 {
   struct pbuf *concat_p = NULL;
   struct tcp_seg *last_unsent = NULL, *seg = NULL, *prev_seg = NULL, *queue = NULL;
@@ -520,6 +634,17 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
         /* If the last unsent pbuf is of type PBUF_ROM, try to extend it. */
         struct pbuf *p;
         for (p = last_unsent->p; p->next != NULL; p = p->next);
+#if LWIP_TCP_ZEROCOPY
+        if (zc != NULL) {
+          /* zero-copy pbufs are never extended, each one holds a reference */
+          if ((concat_p = tcp_zc_pbuf_alloc((const u8_t*)arg + pos, seglen, zc)) == NULL) {
+            LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
+                        ("tcp_write: could not allocate memory for zero-copy pbuf\n"));
+            goto memerr;
+          }
+          queuelen += pbuf_clen(concat_p);
+        } else
+#endif /* LWIP_TCP_ZEROCOPY */
         if (p->type == PBUF_ROM && (const u8_t *)p->payload + p->len == (const u8_t *)arg) {
           LWIP_ASSERT("tcp_write: ROM pbufs cannot be oversized", pos == 0);
           extendlen = seglen;
@@ -586,7 +711,20 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 #if TCP_OVERSIZE
       LWIP_ASSERT("oversize == 0", oversize == 0);
 #endif /* TCP_OVERSIZE */
-      if ((p2 = pbuf_alloc(PBUF_TRANSPORT, seglen, PBUF_ROM)) == NULL) {
+#if LWIP_TCP_ZEROCOPY
+      if (zc != NULL) {
+        /* the data pbuf follows the header pbuf, so it needs no headroom */
+        p2 = tcp_zc_pbuf_alloc((const u8_t*)arg + pos, seglen, zc);
+      } else
+#endif /* LWIP_TCP_ZEROCOPY */
+      {
+        p2 = pbuf_alloc(PBUF_TRANSPORT, seglen, PBUF_ROM);
+        if (p2 != NULL) {
+          /* reference the non-volatile payload data */
+          ((struct pbuf_rom*)p2)->payload = (const u8_t*)arg + pos;
+        }
+      }
+      if (p2 == NULL) {
         LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("tcp_write: could not allocate memory for zero-copy pbuf\n"));
         goto memerr;
       }
@@ -598,8 +736,6 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
         chksum = SWAP_BYTES_IN_WORD(chksum);
       }
 #endif /* TCP_CHECKSUM_ON_COPY */
-      /* reference the non-volatile payload data */
-      ((struct pbuf_rom*)p2)->payload = (const u8_t*)arg + pos;
 
       /* Second, allocate a pbuf for the headers. */
       if ((p = pbuf_alloc(PBUF_TRANSPORT, optlen, PBUF_RAM)) == NULL) {
@@ -813,6 +949,12 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
       optflags |= TF_SEG_OPTS_WND_SCALE;
     }
 #endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK
+    if ((pcb->state != SYN_RCVD) || (pcb->flags & TF_SACK)) {
+      /* Same for SACK permitted in a <SYN,ACK> */
+      optflags |= TF_SEG_OPTS_SACK_PERM;
+    }
+#endif /* LWIP_TCP_SACK */
   }
 #if LWIP_TCP_TIMESTAMPS
   if ((pcb->flags & TF_TIMESTAMP)) {
@@ -909,6 +1051,101 @@ tcp_build_wnd_scale_option(u32_t *opts)
 }
 #endif
 
+#if LWIP_TCP_SACK
+/** Build a SACK permitted option (2 bytes long) at the specified options pointer)
+ *
+ * @param opts option pointer where to store the SACK permitted option
+ */
+static void
+tcp_build_sack_perm_option(u32_t *opts)
+{
+  /* Pad with two NOP options to make everything nicely aligned */
+  opts[0] = PP_HTONL(0x01010402);
+}
+
+#if TCP_QUEUE_OOSEQ
+/** Get the next range of contiguous data from the ooseq queue
+ *
+ * @param seg in: first segment of the range, out: first segment after it
+ * @param left receives the first sequence number of the range
+ * @param right receives the sequence number following the range
+ */
+static void
+tcp_sack_next_block(struct tcp_seg **seg, u32_t *left, u32_t *right)
+{
+  struct tcp_seg *s = *seg;
+
+  *left = s->tcphdr->seqno;
+  *right = *left;
+  while ((s != NULL) && (s->tcphdr->seqno == *right)) {
+    *right += TCP_TCPLEN(s);
+    s = s->next;
+  }
+  *seg = s;
+}
+
+/** Count the SACK blocks needed to describe the ooseq queue
+ *
+ * @param pcb tcp_pcb
+ * @param max maximum number of blocks that fit into the options
+ */
+static u8_t
+tcp_get_num_sacks(struct tcp_pcb *pcb, u8_t max)
+{
+  struct tcp_seg *seg = pcb->ooseq;
+  u32_t left, right;
+  u8_t num = 0;
+
+  while ((seg != NULL) && (num < max)) {
+    tcp_sack_next_block(&seg, &left, &right);
+    num++;
+  }
+  return num;
+}
+
+/** Build a SACK option with num blocks at the specified options pointer.
+ * The first block is the one holding the most recently received segment
+ * (RFC 2018), the others follow in sequence order.
+ *
+ * @param pcb tcp_pcb
+ * @param opts option pointer where to store the SACK option
+ * @param num number of blocks, as returned by tcp_get_num_sacks()
+ */
+static void
+tcp_build_sack_option(struct tcp_pcb *pcb, u32_t *opts, u8_t num)
+{
+  struct tcp_seg *seg;
+  u32_t left, right, recent_left, recent_right;
+  u8_t i;
+
+  /* Pad with two NOP options to make everything nicely aligned */
+  opts[0] = lwip_htonl(0x01010500 | (LWIP_TCP_OPT_LEN_SACK_OUT(num) - 2));
+  /* the first block if the last arrival has been trimmed away meanwhile */
+  seg = pcb->ooseq;
+  tcp_sack_next_block(&seg, &recent_left, &recent_right);
+  while (seg != NULL) {
+    tcp_sack_next_block(&seg, &left, &right);
+    if (TCP_SEQ_BETWEEN(pcb->rcv_sack_recent, left, right - 1)) {
+      recent_left = left;
+      recent_right = right;
+      break;
+    }
+  }
+  opts[1] = lwip_htonl(recent_left);
+  opts[2] = lwip_htonl(recent_right);
+  i = 1;
+  for (seg = pcb->ooseq; (seg != NULL) && (i < num); ) {
+    tcp_sack_next_block(&seg, &left, &right);
+    if (left != recent_left) {
+      opts[1 + 2 * i] = lwip_htonl(left);
+      opts[2 + 2 * i] = lwip_htonl(right);
+      i++;
+    }
+  }
+}
+#endif /* TCP_QUEUE_OOSEQ */
+#endif /* LWIP_TCP_SACK */
+
 /**
  * Send an ACK without data.
  *
@@ -921,15 +1158,26 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
   struct pbuf *p;
   u8_t optlen = 0;
   struct netif *netif;
-#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+  u8_t sack_optoff = 0, num_sacks = 0;
+#endif /* LWIP_TCP_SACK && TCP_QUEUE_OOSEQ */
+#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || (LWIP_TCP_SACK && TCP_QUEUE_OOSEQ)
   struct tcp_hdr *tcphdr;
-#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP */
+#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || (LWIP_TCP_SACK && TCP_QUEUE_OOSEQ) */
 
 #if LWIP_TCP_TIMESTAMPS
   if (pcb->flags & TF_TIMESTAMP) {
     optlen = LWIP_TCP_OPT_LENGTH(TF_SEG_OPTS_TS);
   }
 #endif
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+  if ((pcb->flags & TF_SACK) && (pcb->ooseq != NULL)) {
+    /* 40 bytes of options leave room for 3 blocks next to a timestamp */
+    num_sacks = tcp_get_num_sacks(pcb, (u8_t)LWIP_MIN(LWIP_TCP_MAX_SACK_NUM, optlen ? 3 : 4));
+    sack_optoff = optlen;
+    optlen += LWIP_TCP_OPT_LEN_SACK_OUT(num_sacks);
+  }
+#endif /* LWIP_TCP_SACK && TCP_QUEUE_OOSEQ */
 
   p = tcp_output_alloc_header(pcb, optlen, 0, lwip_htonl(pcb->snd_nxt));
   if (p == NULL) {
@@ -938,9 +1186,9 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
     LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_output: (ACK) could not allocate pbuf\n"));
     return ERR_BUF;
   }
-#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP
+#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || (LWIP_TCP_SACK && TCP_QUEUE_OOSEQ)
   tcphdr = (struct tcp_hdr *)p->payload;
-#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP */
+#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || (LWIP_TCP_SACK && TCP_QUEUE_OOSEQ) */
   LWIP_DEBUGF(TCP_OUTPUT_DEBUG,
               ("tcp_output: sending ACK for %"U32_F"\n", pcb->rcv_nxt));
 
@@ -952,6 +1200,11 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
     tcp_build_timestamp_option(pcb, (u32_t *)(tcphdr + 1));
   }
 #endif
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+  if (num_sacks > 0) {
+    tcp_build_sack_option(pcb, (u32_t *)(void *)((u8_t *)(tcphdr + 1) + sack_optoff), num_sacks);
+  }
+#endif /* LWIP_TCP_SACK && TCP_QUEUE_OOSEQ */
 
   netif = ip_route(&pcb->local_ip, &pcb->remote_ip);
   if (netif == NULL) {
@@ -982,15 +1235,10 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
 }
 
 /**
- * @ingroup tcp_raw
- * Find out what we can send and send it
- *
- * @param pcb Protocol control block for the TCP connection to send data
- * @return ERR_OK if data has been sent or nothing to send
- *         another err_t on error
+ * Does the work of tcp_output().
  */
-err_t
-tcp_output(struct tcp_pcb *pcb)
+static err_t
+tcp_output_pcb(struct tcp_pcb *pcb)
 {
   struct tcp_seg *seg, *useg;
   u32_t wnd, snd_nxt;
@@ -1016,6 +1264,15 @@ tcp_output(struct tcp_pcb *pcb)
 
   seg = pcb->unsent;
 
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+  /* Data segments carry no SACK blocks, so send those in an empty ACK
+     first while out-of-sequence data is queued. */
+  if ((pcb->flags & TF_ACK_NOW) && (pcb->flags & TF_SACK) &&
+      (pcb->ooseq != NULL) && (seg != NULL)) {
+    tcp_send_empty_ack(pcb);
+  }
+#endif /* LWIP_TCP_SACK && TCP_QUEUE_OOSEQ */
+
   /* If the TF_ACK_NOW flag is set and no data will be sent (either
    * because the ->unsent queue is empty or because the window does
    * not allow it), construct an empty ACK segment and send it.
@@ -1178,6 +1435,26 @@ output_done:
   return ERR_OK;
 }
 
+/**
+ * @ingroup tcp_raw
+ * Find out what we can send and send it
+ *
+ * @param pcb Protocol control block for the TCP connection to send data
+ * @return ERR_OK if data has been sent or nothing to send
+ *         another err_t on error
+ */
+err_t
+tcp_output(struct tcp_pcb *pcb)
+{
+  err_t err;
+  STATS_HIST_DECL(t);
+
+  STATS_HIST_START(t);
+  err = tcp_output_pcb(pcb);
+  STATS_HIST_STOP(STATS_HIST_TCP_OUTPUT, t);
+  return err;
+}
+
 /**
  * Called by tcp_output() to actually send a TCP segment over IP.
  *
@@ -1245,6 +1522,12 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
     opts += 1;
   }
 #endif
+#if LWIP_TCP_SACK
+  if (seg->flags & TF_SEG_OPTS_SACK_PERM) {
+    tcp_build_sack_perm_option(opts);
+    opts += 1;
+  }
+#endif
 
   /* Set retransmission timer running if it is not currently enabled
      This must be set before checking the route. */
@@ -1312,6 +1595,8 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
   }
 #endif /* CHECKSUM_GEN_TCP */
   TCP_STATS_INC(tcp.xmit);
+  TCP_PCB_STATS_INC(pcb, segs_out);
+  TCP_PCB_STATS_ADD(pcb, bytes_out, seg->len);
 
   NETIF_SET_HWADDRHINT(netif, &(pcb->addr_hint));
   err = ip_output_if(seg->p, &pcb->local_ip, &pcb->remote_ip, pcb->ttl,
@@ -1404,6 +1689,15 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
     return;
   }
 
+#if LWIP_TCP_SACK
+  /* The receiver may have discarded data it selectively acknowledged
+     (RFC 2018), so everything is sent again and fast recovery is over. */
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    seg->flags &= ~(TF_SEG_SACKED | TF_SEG_REXMIT);
+  }
+  pcb->flags &= ~TF_INFR;
+#endif /* LWIP_TCP_SACK */
+
   /* Move all unacked segments to the head of the unsent queue */
   for (seg = pcb->unacked; seg->next != NULL; seg = seg->next);
   /* concatenate unsent queue after unacked queue */
@@ -1423,6 +1717,7 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
   if (pcb->nrtx < 0xFF) {
     ++pcb->nrtx;
   }
+  TCP_PCB_STATS_INC(pcb, rto);
 
   /* Don't take any RTT measurements after retransmitting. */
   pcb->rttest = 0;
@@ -1452,6 +1747,9 @@ tcp_rexmit(struct tcp_pcb *pcb)
   /* Keep the unsent queue sorted. */
   seg = pcb->unacked;
   pcb->unacked = seg->next;
+#if LWIP_TCP_SACK
+  seg->flags |= TF_SEG_REXMIT;
+#endif /* LWIP_TCP_SACK */
 
   cur_seg = &(pcb->unsent);
   while (*cur_seg &&
@@ -1476,6 +1774,7 @@ tcp_rexmit(struct tcp_pcb *pcb)
 
   /* Do the actual retransmission. */
   MIB2_STATS_INC(mib2.tcpretranssegs);
+  TCP_PCB_STATS_INC(pcb, rexmit);
   /* No need to call tcp_output: we are always called from tcp_input()
      and thus tcp_output directly returns. */
 }
@@ -1497,6 +1796,13 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
                  (u16_t)pcb->dupacks, pcb->lastack,
                  lwip_ntohl(pcb->unacked->tcphdr->seqno)));
     tcp_rexmit(pcb);
+#if LWIP_TCP_SACK
+    if (pcb->flags & TF_SACK) {
+      /* recovery lasts until everything sent so far is acknowledged */
+      pcb->snd_recover = pcb->snd_nxt;
+      tcp_rexmit_sack(pcb);
+    }
+#endif /* LWIP_TCP_SACK */
 
     /* Set ssthresh to half of the minimum of the current
      * cwnd and the advertised window */
@@ -1520,6 +1826,65 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
 }
 
 
+#if LWIP_TCP_SACK
+/**
+ * Requeue the holes in the SACK scoreboard for retransmission: unacked
+ * segments below the highest selectively acknowledged one that have been
+ * neither selectively acknowledged nor retransmitted during this fast
+ * recovery. The first unacked segment always counts as a hole, which also
+ * covers partial ACKs.
+ *
+ * Called by tcp_rexmit_fast() and by tcp_receive() while in fast recovery.
+ *
+ * @param pcb the tcp_pcb for which to retransmit the missing segments
+ */
+void
+tcp_rexmit_sack(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg, *high = NULL;
+  struct tcp_seg **pseg, **cur_seg;
+  u8_t first = 1;
+
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if (seg->flags & TF_SEG_SACKED) {
+      high = seg;
+    }
+  }
+
+  pseg = &pcb->unacked;
+  while (((seg = *pseg) != NULL) && (seg != high) && (first || (high != NULL))) {
+    first = 0;
+    if (seg->flags & (TF_SEG_SACKED | TF_SEG_REXMIT)) {
+      pseg = &seg->next;
+      continue;
+    }
+    /* Move the hole to the unsent queue, keeping that sorted */
+    *pseg = seg->next;
+    seg->flags |= TF_SEG_REXMIT;
+    cur_seg = &(pcb->unsent);
+    while (*cur_seg &&
+      TCP_SEQ_LT(lwip_ntohl((*cur_seg)->tcphdr->seqno), lwip_ntohl(seg->tcphdr->seqno))) {
+        cur_seg = &((*cur_seg)->next );
+    }
+    seg->next = *cur_seg;
+    *cur_seg = seg;
+#if TCP_OVERSIZE
+    if (seg->next == NULL) {
+      /* the retransmitted segment is last in unsent, so reset unsent_oversize */
+      pcb->unsent_oversize = 0;
+    }
+#endif /* TCP_OVERSIZE */
+
+    /* Don't take any rtt measurements after retransmitting. */
+    pcb->rttest = 0;
+    MIB2_STATS_INC(mib2.tcpretranssegs);
+    TCP_PCB_STATS_INC(pcb, rexmit);
+  }
+  /* No need to call tcp_output: we are always called from tcp_input()
+     and thus tcp_output directly returns. */
+}
+#endif /* LWIP_TCP_SACK */
+
 /**
  * Send keepalive packets to keep a connection active although
  * no data is sent over it.
@@ -108,9 +108,50 @@ const struct lwip_cyclic_timer lwip_cyclic_timers[] = {
 
 #if LWIP_TIMERS && !LWIP_TIMERS_CUSTOM
 
+#if LWIP_TIMERS_WHEEL
+/* Pending timeouts are kept in a hierarchical timing wheel. Level n has
+ * TIMEOUTS_WHEEL_SLOTS slots, each spanning TIMEOUTS_WHEEL_SLOTS^n
+ * milliseconds of wheel time. A timeout is filed on the lowest level that
+ * reaches its due time and moves down when the wheel arrives at the start
+ * of its slot, so level 0 slots only hold timeouts due at that exact tick.
+ * Timeouts further away than the whole wheel wait on the top level and are
+ * filed again each time their slot comes round.
+ *
+ * Wheel time runs in step with sys_now(), except that time skipped by
+ * sys_restart_timeouts() (or passing while nothing is pending) does not
+ * count, as with the delta list.
+ */
+#define TIMEOUTS_WHEEL_BITS     5
+#define TIMEOUTS_WHEEL_LEVELS   5
+#define TIMEOUTS_WHEEL_SLOTS    (1UL << TIMEOUTS_WHEEL_BITS)
+#define TIMEOUTS_WHEEL_MASK     (TIMEOUTS_WHEEL_SLOTS - 1)
+#define TIMEOUTS_WHEEL_SHIFT(level) ((level) * TIMEOUTS_WHEEL_BITS)
+/* longest distance that can be filed without re-filing */
+#define TIMEOUTS_WHEEL_RANGE    ((1UL << TIMEOUTS_WHEEL_SHIFT(TIMEOUTS_WHEEL_LEVELS)) - 1)
+
+#if (TIMERS_WHEEL_HASH_SIZE & (TIMERS_WHEEL_HASH_SIZE - 1)) != 0
+#error "TIMERS_WHEEL_HASH_SIZE must be a power of 2"
+#endif
+
+/** The wheel slots: lists ordered by sequence number on level 0 */
+static struct sys_timeo *timeouts_wheel[TIMEOUTS_WHEEL_LEVELS][TIMEOUTS_WHEEL_SLOTS];
+/** One bit per non-empty slot, used to skip empty slots */
+static u32_t timeouts_wheel_used[TIMEOUTS_WHEEL_LEVELS];
+/** Timeouts hashed by handler and argument for sys_untimeout() */
+static struct sys_timeo *timeouts_hash[TIMERS_WHEEL_HASH_SIZE];
+/** Wheel tick reached, timeouts due earlier have been called */
+static u32_t timeouts_wheel_time;
+/** sys_now() at timeouts_wheel_time */
+static u32_t timeouts_last_time;
+static u32_t timeouts_seq;
+static u16_t timeouts_pending;
+#define TIMEOUTS_EMPTY()        (timeouts_pending == 0)
+#else /* LWIP_TIMERS_WHEEL */
 /** The one and only timeout list */
 static struct sys_timeo *next_timeout;
 static u32_t timeouts_last_time;
+#define TIMEOUTS_EMPTY()        (next_timeout == NULL)
+#endif /* LWIP_TIMERS_WHEEL */
 
 #if LWIP_TCP
 /** global variable that shows if the tcp timer is currently scheduled or not */
@@ -186,6 +227,194 @@ void sys_timeouts_init(void)
   timeouts_last_time = sys_now();
 }
 
+#if LWIP_TIMERS_WHEEL
+/** Index of the lowest bit set in a non-zero word */
+static u32_t
+timeouts_wheel_ffs(u32_t x)
+{
+  static const u8_t debruijn[32] = {
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+  };
+  return debruijn[(u32_t)((x & (0UL - x)) * 0x077CB531UL) >> 27];
+}
+
+/**
+ * Find the next wheel tick that has work: a level 0 slot to expire or a
+ * higher level slot to move down.
+ *
+ * @param cur first tick to look at
+ * @param tick receives the tick found
+ * @return 1 if a tick was found, 0 if the wheel is empty
+ */
+static u8_t
+timeouts_wheel_next(u32_t cur, u32_t *tick)
+{
+  u32_t level, start, idx, used, span, next, dist = 0;
+  u8_t found = 0;
+
+  for (level = 0; level < TIMEOUTS_WHEEL_LEVELS; level++) {
+    used = timeouts_wheel_used[level];
+    if (used == 0) {
+      continue;
+    }
+    /* first slot boundary at or after cur */
+    span = 1UL << TIMEOUTS_WHEEL_SHIFT(level);
+    start = (cur + span - 1) & ~(span - 1);
+    idx = (start >> TIMEOUTS_WHEEL_SHIFT(level)) & TIMEOUTS_WHEEL_MASK;
+    if (idx != 0) {
+      used = (used >> idx) | (used << (TIMEOUTS_WHEEL_SLOTS - idx));
+    }
+    next = start + (timeouts_wheel_ffs(used) << TIMEOUTS_WHEEL_SHIFT(level));
+    if (!found || ((u32_t)(next - cur) < dist)) {
+      dist = next - cur;
+      found = 1;
+    }
+  }
+  *tick = cur + dist;
+  return found;
+}
+
+/** File a timeout into the wheel slot covering its due time */
+static void
+timeouts_wheel_add(struct sys_timeo *timeout)
+{
+  struct sys_timeo **slot, *t;
+  u32_t cur, dist, level, idx;
+
+  cur = timeouts_wheel_time;
+  dist = timeout->time - cur;
+  if ((s32_t)dist < 0) {
+    /* already due */
+    timeout->time = cur;
+    dist = 0;
+  }
+  for (level = 0; level < TIMEOUTS_WHEEL_LEVELS - 1; level++) {
+    if (dist < (1UL << TIMEOUTS_WHEEL_SHIFT(level + 1))) {
+      break;
+    }
+  }
+  if (dist > TIMEOUTS_WHEEL_RANGE) {
+    dist = TIMEOUTS_WHEEL_RANGE;
+  }
+  idx = ((cur + dist) >> TIMEOUTS_WHEEL_SHIFT(level)) & TIMEOUTS_WHEEL_MASK;
+  slot = &timeouts_wheel[level][idx];
+  timeout->slot = (u16_t)((level << TIMEOUTS_WHEEL_BITS) | idx);
+  timeouts_wheel_used[level] |= 1UL << idx;
+
+  timeout->next = NULL;
+  if (*slot == NULL) {
+    timeout->prev = timeout;
+    *slot = timeout;
+    return;
+  }
+  t = (*slot)->prev;
+  if (level == 0) {
+    /* timeouts moved down from upper levels may have been started before
+       timeouts already in this slot */
+    while ((s32_t)(t->seq - timeout->seq) > 0) {
+      if (t == *slot) {
+        /* insert as first entry */
+        timeout->prev = t->prev;
+        timeout->next = t;
+        t->prev = timeout;
+        *slot = timeout;
+        return;
+      }
+      t = t->prev;
+    }
+  }
+  /* insert after t */
+  timeout->prev = t;
+  timeout->next = t->next;
+  if (t->next != NULL) {
+    t->next->prev = timeout;
+  } else {
+    (*slot)->prev = timeout;
+  }
+  t->next = timeout;
+}
+
+/** Unlink a timeout from its wheel slot */
+static void
+timeouts_wheel_remove(struct sys_timeo *timeout)
+{
+  u32_t level = timeout->slot >> TIMEOUTS_WHEEL_BITS;
+  u32_t idx = timeout->slot & TIMEOUTS_WHEEL_MASK;
+  struct sys_timeo **slot = &timeouts_wheel[level][idx];
+
+  if (timeout == *slot) {
+    *slot = timeout->next;
+    if (*slot == NULL) {
+      timeouts_wheel_used[level] &= ~(1UL << idx);
+    } else {
+      (*slot)->prev = timeout->prev;
+    }
+  } else {
+    timeout->prev->next = timeout->next;
+    if (timeout->next != NULL) {
+      timeout->next->prev = timeout->prev;
+    } else {
+      (*slot)->prev = timeout->prev;
+    }
+  }
+}
+
+/** Move the upper level slots starting at 'tick' down the wheel */
+static void
+timeouts_wheel_cascade(u32_t tick)
+{
+  struct sys_timeo *t, *next;
+  u32_t level, idx;
+
+  for (level = TIMEOUTS_WHEEL_LEVELS - 1; level > 0; level--) {
+    if ((tick & ((1UL << TIMEOUTS_WHEEL_SHIFT(level)) - 1)) != 0) {
+      continue;
+    }
+    idx = (tick >> TIMEOUTS_WHEEL_SHIFT(level)) & TIMEOUTS_WHEEL_MASK;
+    t = timeouts_wheel[level][idx];
+    timeouts_wheel[level][idx] = NULL;
+    timeouts_wheel_used[level] &= ~(1UL << idx);
+    for (; t != NULL; t = next) {
+      next = t->next;
+      timeouts_wheel_add(t);
+    }
+  }
+}
+
+/** Hash bucket for sys_untimeout() lookups */
+static struct sys_timeo **
+timeouts_hash_bucket(sys_timeout_handler handler, void *arg)
+{
+  mem_ptr_t h = (mem_ptr_t)handler ^ ((mem_ptr_t)arg * 31);
+  h ^= h >> 11;
+  h ^= h >> 5;
+  return &timeouts_hash[h & (TIMERS_WHEEL_HASH_SIZE - 1)];
+}
+
+static void
+timeouts_hash_add(struct sys_timeo *timeout)
+{
+  struct sys_timeo **bucket = timeouts_hash_bucket(timeout->h, timeout->arg);
+
+  timeout->hash_next = *bucket;
+  if (*bucket != NULL) {
+    (*bucket)->hash_pprev = &timeout->hash_next;
+  }
+  timeout->hash_pprev = bucket;
+  *bucket = timeout;
+}
+
+static void
+timeouts_hash_remove(struct sys_timeo *timeout)
+{
+  *timeout->hash_pprev = timeout->hash_next;
+  if (timeout->hash_next != NULL) {
+    timeout->hash_next->hash_pprev = timeout->hash_pprev;
+  }
+}
+#endif /* LWIP_TIMERS_WHEEL */
+
 /**
  * Create a one-shot timer (aka timeout). Timeouts are processed in the
  * following cases:
@@ -204,8 +433,12 @@ void
 sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
 #endif /* LWIP_DEBUG_TIMERNAMES */
 {
-  struct sys_timeo *timeout, *t;
-  u32_t now, diff;
+  struct sys_timeo *timeout;
+#if !LWIP_TIMERS_WHEEL
+  struct sys_timeo *t;
+  u32_t diff;
+#endif /* !LWIP_TIMERS_WHEEL */
+  u32_t now;
 
   timeout = (struct sys_timeo *)memp_malloc(MEMP_SYS_TIMEOUT);
   if (timeout == NULL) {
@@ -214,6 +447,26 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
   }
 
   now = sys_now();
+#if LWIP_TIMERS_WHEEL
+  if (timeouts_pending == 0) {
+    /* don't let the wheel run through a period in which nothing was pending */
+    timeouts_last_time = now;
+  }
+
+  timeout->h = handler;
+  timeout->arg = arg;
+  timeout->time = timeouts_wheel_time + (now - timeouts_last_time) + msecs;
+  timeout->seq = timeouts_seq++;
+#if LWIP_DEBUG_TIMERNAMES
+  timeout->handler_name = handler_name;
+  LWIP_DEBUGF(TIMERS_DEBUG, ("sys_timeout: %p msecs=%"U32_F" handler=%s arg=%p\n",
+    (void *)timeout, msecs, handler_name, (void *)arg));
+#endif /* LWIP_DEBUG_TIMERNAMES */
+
+  timeouts_wheel_add(timeout);
+  timeouts_hash_add(timeout);
+  timeouts_pending++;
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout == NULL) {
     diff = 0;
     timeouts_last_time = now;
@@ -259,6 +512,7 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
       }
     }
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /**
@@ -269,6 +523,30 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
  * @param handler callback function that would be called by the timeout
  * @param arg callback argument that would be passed to handler
 */
+#if LWIP_TIMERS_WHEEL
+void
+sys_untimeout(sys_timeout_handler handler, void *arg)
+{
+  struct sys_timeo *t, *first = NULL;
+  u32_t cur = timeouts_wheel_time;
+
+  for (t = *timeouts_hash_bucket(handler, arg); t != NULL; t = t->hash_next) {
+    if ((t->h == handler) && (t->arg == arg)) {
+      /* pick the one the list would have held first */
+      if ((first == NULL) || ((u32_t)(t->time - cur) < (u32_t)(first->time - cur)) ||
+          ((t->time == first->time) && ((s32_t)(t->seq - first->seq) < 0))) {
+        first = t;
+      }
+    }
+  }
+  if (first != NULL) {
+    timeouts_wheel_remove(first);
+    timeouts_hash_remove(first);
+    timeouts_pending--;
+    memp_free(MEMP_SYS_TIMEOUT, first);
+  }
+}
+#else /* LWIP_TIMERS_WHEEL */
 void
 sys_untimeout(sys_timeout_handler handler, void *arg)
 {
@@ -297,6 +575,7 @@ sys_untimeout(sys_timeout_handler handler, void *arg)
   }
   return;
 }
+#endif /* LWIP_TIMERS_WHEEL */
 
 /**
  * @ingroup lwip_nosys
@@ -311,6 +590,63 @@ static
 #endif /* !NO_SYS */
 void
 sys_check_timeouts(void)
+#if LWIP_TIMERS_WHEEL
+{
+  if (timeouts_pending != 0) {
+    struct sys_timeo *tmptimeout;
+    struct sys_timeo **slot;
+    sys_timeout_handler handler;
+    void *arg;
+    u32_t now, target, tick, cur;
+
+    now = sys_now();
+    /* this cares for wraparounds */
+    target = timeouts_wheel_time + (now - timeouts_last_time);
+    cur = timeouts_wheel_time;
+    while ((timeouts_pending != 0) && timeouts_wheel_next(cur, &tick) &&
+           ((s32_t)(target - tick) >= 0)) {
+      PBUF_CHECK_FREE_OOSEQ();
+      /* handlers see the wheel at 'tick': a timeout they start with
+         msecs == 0 is filed into this slot and still called below */
+      timeouts_wheel_time = tick;
+      timeouts_last_time = now - (target - tick);
+      timeouts_wheel_cascade(tick);
+      slot = &timeouts_wheel[0][tick & TIMEOUTS_WHEEL_MASK];
+      while ((tmptimeout = *slot) != NULL) {
+        /* timeout has expired */
+        LWIP_ASSERT("sys_check_timeouts: timeout in wrong slot", tmptimeout->time == tick);
+        timeouts_wheel_remove(tmptimeout);
+        timeouts_hash_remove(tmptimeout);
+        timeouts_pending--;
+        handler = tmptimeout->h;
+        arg = tmptimeout->arg;
+#if LWIP_DEBUG_TIMERNAMES
+        if (handler != NULL) {
+          LWIP_DEBUGF(TIMERS_DEBUG, ("sct calling h=%s arg=%p\n",
+            tmptimeout->handler_name, arg));
+        }
+#endif /* LWIP_DEBUG_TIMERNAMES */
+        memp_free(MEMP_SYS_TIMEOUT, tmptimeout);
+        if (handler != NULL) {
+#if !NO_SYS
+          /* For LWIP_TCPIP_CORE_LOCKING, lock the core before calling the
+             timeout handler function. */
+          LOCK_TCPIP_CORE();
+#endif /* !NO_SYS */
+          handler(arg);
+#if !NO_SYS
+          UNLOCK_TCPIP_CORE();
+#endif /* !NO_SYS */
+        }
+        LWIP_TCPIP_THREAD_ALIVE();
+      }
+      cur = tick + 1;
+    }
+    timeouts_wheel_time = target;
+    timeouts_last_time = now;
+  }
+}
+#else /* LWIP_TIMERS_WHEEL */
 {
   if (next_timeout) {
     struct sys_timeo *tmptimeout;
@@ -359,6 +695,7 @@ sys_check_timeouts(void)
     } while (had_one);
   }
 }
+#endif /* LWIP_TIMERS_WHEEL */
 
 /** Set back the timestamp of the last call to sys_check_timeouts()
  * This is necessary if sys_check_timeouts() hasn't been called for a long
@@ -381,6 +718,21 @@ u32_t
 sys_timeouts_sleeptime(void)
 {
   u32_t diff;
+#if LWIP_TIMERS_WHEEL
+  u32_t tick;
+  if ((timeouts_pending == 0) || !timeouts_wheel_next(timeouts_wheel_time, &tick)) {
+    return 0xffffffff;
+  }
+  /* may be a tick that only moves timeouts down the wheel: waking up early
+     is harmless */
+  tick -= timeouts_wheel_time;
+  diff = sys_now() - timeouts_last_time;
+  if (diff > tick) {
+    return 0;
+  } else {
+    return tick - diff;
+  }
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout == NULL) {
     return 0xffffffff;
   }
@@ -390,6 +742,7 @@ sys_timeouts_sleeptime(void)
   } else {
     return next_timeout->time - diff;
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 #if !NO_SYS
@@ -407,7 +760,7 @@ sys_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg)
   u32_t sleeptime;
 
 again:
-  if (!next_timeout) {
+  if (TIMEOUTS_EMPTY()) {
     sys_arch_mbox_fetch(mbox, msg, 0);
     return;
   }
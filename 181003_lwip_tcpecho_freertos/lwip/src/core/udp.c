@@ -73,6 +73,16 @@
 #define UDP_ENSURE_LOCAL_PORT_RANGE(port) ((u16_t)(((port) & ~UDP_LOCAL_PORT_RANGE_START) + UDP_LOCAL_PORT_RANGE_START))
 #endif
 
+/* A netif offloading checksums cannot insert them into datagrams that the
+   IP layer fragments: those are checksummed in software. */
+#if LWIP_IPV6
+#define UDP_IP_HLEN(dst_ip) (IP_IS_V6(dst_ip) ? IP6_HLEN : IP_HLEN)
+#else
+#define UDP_IP_HLEN(dst_ip) IP_HLEN
+#endif
+#define UDP_WILL_FRAGMENT(netif, q, dst_ip) \
+  (((netif)->mtu != 0) && ((q)->tot_len > (netif)->mtu - UDP_IP_HLEN(dst_ip)))
+
 /* last local UDP port */
 static u16_t udp_port = UDP_LOCAL_PORT_RANGE_START;
 
@@ -80,6 +90,53 @@ static u16_t udp_port = UDP_LOCAL_PORT_RANGE_START;
 /* exported in udp.h (was static) */
 struct udp_pcb *udp_pcbs;
 
+#if LWIP_UDP_PCB_HASH
+/** Bound pcbs hashed on their local port. Within a bucket, pcbs of the same
+    port are in the order udp_input() prefers them; udp_pcbs is no longer
+    reordered when this table is in use. */
+static struct udp_pcb *udp_port_hash[UDP_PCB_HASH_SIZE];
+/** Counts the moves to the front of udp_pcbs that the list would see */
+static u32_t udp_hash_clock;
+
+#define UDP_PORT_HASH(port) ((port) & (UDP_PCB_HASH_SIZE - 1))
+
+/** Note that a pcb goes to the front of udp_pcbs */
+#define udp_hash_touch(pcb) ((pcb)->hash_stamp = ++udp_hash_clock)
+
+/** Put a pcb into the bucket for its local port, after the pcbs that went to
+    the front of udp_pcbs later than it did: where the list would have it.
+    A pcb rebound to another port thus keeps its place among the pcbs of that
+    port. The stamps compare right while they are less than 2^31 apart. */
+static void
+udp_hash_add(struct udp_pcb *pcb)
+{
+  struct udp_pcb **pp = &udp_port_hash[UDP_PORT_HASH(pcb->local_port)];
+  while ((*pp != NULL) && ((s32_t)((*pp)->hash_stamp - pcb->hash_stamp) > 0)) {
+    pp = &(*pp)->hash_next;
+  }
+  pcb->hash_next = *pp;
+  *pp = pcb;
+}
+
+/** Take a pcb out of the bucket for its local port, if it is there */
+static void
+udp_hash_remove(struct udp_pcb *pcb)
+{
+  struct udp_pcb **pp;
+  for (pp = &udp_port_hash[UDP_PORT_HASH(pcb->local_port)]; *pp != NULL; pp = &(*pp)->hash_next) {
+    if (*pp == pcb) {
+      *pp = pcb->hash_next;
+      break;
+    }
+  }
+  pcb->hash_next = NULL;
+}
+#else /* LWIP_UDP_PCB_HASH */
+#define udp_hash_touch(pcb)
+#define udp_hash_add(pcb)
+#define udp_hash_remove(pcb)
+#endif /* LWIP_UDP_PCB_HASH */
+
 /**
  * Initialize this module.
  */
@@ -236,7 +293,13 @@ udp_input(struct pbuf *p, struct netif *inp)
    * 'Perfect match' pcbs (connected to the remote port & ip address) are
    * preferred. If no perfect match is found, the first unconnected pcb that
    * matches the local port and ip address gets the datagram. */
+#if LWIP_UDP_PCB_HASH
+  /* Only pcbs bound to the destination port can match, and they all sit
+   * in one bucket. */
+  for (pcb = udp_port_hash[UDP_PORT_HASH(dest)]; pcb != NULL; pcb = pcb->hash_next) {
+#else /* LWIP_UDP_PCB_HASH */
   for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next) {
+#endif /* LWIP_UDP_PCB_HASH */
     /* print the PCB local and remote address */
     LWIP_DEBUGF(UDP_DEBUG, ("pcb ("));
     ip_addr_debug_print(UDP_DEBUG, &pcb->local_ip);
@@ -263,12 +326,20 @@ udp_input(struct pbuf *p, struct netif *inp)
           (ip_addr_isany_val(pcb->remote_ip) ||
           ip_addr_cmp(&pcb->remote_ip, ip_current_src_addr()))) {
         /* the first fully matching PCB */
+        /* first in its bucket is not first in the list */
+        udp_hash_touch(pcb);
         if (prev != NULL) {
           /* move the pcb to the front of udp_pcbs so that is
              found faster next time */
+#if LWIP_UDP_PCB_HASH
+          prev->hash_next = pcb->hash_next;
+          pcb->hash_next = udp_port_hash[UDP_PORT_HASH(dest)];
+          udp_port_hash[UDP_PORT_HASH(dest)] = pcb;
+#else /* LWIP_UDP_PCB_HASH */
           prev->next = pcb->next;
           pcb->next = udp_pcbs;
           udp_pcbs = pcb;
+#endif /* LWIP_UDP_PCB_HASH */
         } else {
           UDP_STATS_INC(udp.cachehit);
         }
@@ -302,7 +373,7 @@ udp_input(struct pbuf *p, struct netif *inp)
   if (for_us) {
     LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE, ("udp_input: calculating checksum\n"));
 #if CHECKSUM_CHECK_UDP
-    IF__NETIF_CHECKSUM_ENABLED(inp, CHECKSUM_CHECK_UDP) {
+    IF__NETIF_CHECKSUM_ENABLED_OR(inp, NETIF_CHECKSUM_CHECK_UDP, (p->flags & PBUF_FLAG_SW_CHKSUM) != 0) {
 #if LWIP_UDPLITE
       if (ip_current_header_proto() == IP_PROTO_UDPLITE) {
         /* Do the UDP Lite checksum */
@@ -355,7 +426,11 @@ udp_input(struct pbuf *p, struct netif *inp)
         struct udp_pcb *mpcb;
         u8_t p_header_changed = 0;
         s16_t hdrs_len = (s16_t)(ip_current_header_tot_len() + UDP_HLEN);
+#if LWIP_UDP_PCB_HASH
+        for (mpcb = udp_port_hash[UDP_PORT_HASH(dest)]; mpcb != NULL; mpcb = mpcb->hash_next) {
+#else /* LWIP_UDP_PCB_HASH */
         for (mpcb = udp_pcbs; mpcb != NULL; mpcb = mpcb->next) {
+#endif /* LWIP_UDP_PCB_HASH */
           if (mpcb != pcb) {
             /* compare PCB local addr+port to UDP destination addr+port */
             if ((mpcb->local_port == dest) &&
@@ -769,7 +844,7 @@ udp_sendto_if_src_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *d
     udphdr->len = lwip_htons(chklen_hdr);
     /* calculate checksum */
 #if CHECKSUM_GEN_UDP
-    IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_UDP) {
+    IF__NETIF_CHECKSUM_ENABLED_OR(netif, NETIF_CHECKSUM_GEN_UDP, UDP_WILL_FRAGMENT(netif, q, dst_ip)) {
 #if LWIP_CHECKSUM_ON_COPY
       if (have_chksum) {
         chklen = UDP_HLEN;
@@ -800,7 +875,7 @@ udp_sendto_if_src_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *d
     udphdr->len = lwip_htons(q->tot_len);
     /* calculate checksum */
 #if CHECKSUM_GEN_UDP
-    IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_UDP) {
+    IF__NETIF_CHECKSUM_ENABLED_OR(netif, NETIF_CHECKSUM_GEN_UDP, UDP_WILL_FRAGMENT(netif, q, dst_ip)) {
       /* Checksum is mandatory over IPv6. */
       if (IP_IS_V6(dst_ip) || (pcb->flags & UDP_FLAGS_NOCHKSUM) == 0) {
         u16_t udpchksum;
@@ -945,6 +1020,11 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
 
   ip_addr_set_ipaddr(&pcb->local_ip, ipaddr);
 
+  if ((rebind != 0) && (pcb->local_port != port)) {
+    /* moves to the bucket of the new port */
+    udp_hash_remove(pcb);
+    rebind = 2;
+  }
   pcb->local_port = port;
   mib2_udp_bind(pcb);
   /* pcb not active yet? */
@@ -952,6 +1032,10 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     /* place the PCB on the active list if not already there */
     pcb->next = udp_pcbs;
     udp_pcbs = pcb;
+    udp_hash_touch(pcb);
+  }
+  if (rebind != 1) {
+    udp_hash_add(pcb);
   }
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("udp_bind: bound to "));
   ip_addr_debug_print(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, &pcb->local_ip);
@@ -1012,6 +1096,8 @@ udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
   /* PCB not yet on the list, add PCB now */
   pcb->next = udp_pcbs;
   udp_pcbs = pcb;
+  udp_hash_touch(pcb);
+  udp_hash_add(pcb);
   return ERR_OK;
 }
 
@@ -1072,6 +1158,7 @@ udp_remove(struct udp_pcb *pcb)
   struct udp_pcb *pcb2;
 
   mib2_udp_unbind(pcb);
+  udp_hash_remove(pcb);
   /* pcb to be removed is first in list? */
   if (udp_pcbs == pcb) {
     /* make list start at 2nd pcb */
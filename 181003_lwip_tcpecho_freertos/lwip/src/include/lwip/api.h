@@ -193,6 +193,7 @@ enum netconn_igmp {
 /* forward-declare some structs to avoid to include their headers */
 struct ip_pcb;
 struct tcp_pcb;
+struct tcp_zc;
 struct udp_pcb;
 struct raw_pcb;
 struct netconn;
@@ -317,11 +318,20 @@ err_t   netconn_recv_tcp_pbuf(struct netconn *conn, struct pbuf **new_buf);
 err_t   netconn_sendto(struct netconn *conn, struct netbuf *buf,
                              const ip_addr_t *addr, u16_t port);
 err_t   netconn_send(struct netconn *conn, struct netbuf *buf);
+err_t   netconn_sendv(struct netconn *conn, struct netbuf *bufs, u16_t count, u16_t *sent);
 err_t   netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
                              u8_t apiflags, size_t *bytes_written);
 /** @ingroup netconn_tcp */
 #define netconn_write(conn, dataptr, size, apiflags) \
           netconn_write_partly(conn, dataptr, size, apiflags, NULL)
+#if LWIP_TCP_ZEROCOPY
+err_t   netconn_write_partly_zc(struct netconn *conn, const void *dataptr, size_t size,
+                                u8_t apiflags, size_t *bytes_written, struct tcp_zc *zc);
+/** @ingroup netconn_tcp */
+#define netconn_write_zc(conn, dataptr, size, apiflags, zc) \
+          netconn_write_partly_zc(conn, dataptr, size, apiflags, NULL, zc)
+void    netconn_zc_signal(void *arg);
+#endif /* LWIP_TCP_ZEROCOPY */
 err_t   netconn_close(struct netconn *conn);
 err_t   netconn_shutdown(struct netconn *conn, u8_t shut_rx, u8_t shut_tx);
 
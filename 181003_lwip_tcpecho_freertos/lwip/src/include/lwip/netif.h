@@ -344,9 +344,14 @@ struct netif {
 #define NETIF_SET_CHECKSUM_CTRL(netif, chksumflags) do { \
   (netif)->chksum_flags = chksumflags; } while(0)
 #define IF__NETIF_CHECKSUM_ENABLED(netif, chksumflag) if (((netif) == NULL) || (((netif)->chksum_flags & (chksumflag)) != 0))
+/** Like IF__NETIF_CHECKSUM_ENABLED, but 'force' makes software handle packets
+    the netif cannot offload (e.g. fragmented datagrams) */
+#define IF__NETIF_CHECKSUM_ENABLED_OR(netif, chksumflag, force) \
+  if ((force) || ((netif) == NULL) || (((netif)->chksum_flags & (chksumflag)) != 0))
 #else /* LWIP_CHECKSUM_CTRL_PER_NETIF */
 #define NETIF_SET_CHECKSUM_CTRL(netif, chksumflags)
 #define IF__NETIF_CHECKSUM_ENABLED(netif, chksumflag)
+#define IF__NETIF_CHECKSUM_ENABLED_OR(netif, chksumflag, force)
 #endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
 
 /** The list of network interfaces. */
@@ -120,6 +120,26 @@
 #if !defined LWIP_TIMERS_CUSTOM || defined __DOXYGEN__
 #define LWIP_TIMERS_CUSTOM              0
 #endif
+
+/**
+ * LWIP_TIMERS_WHEEL==1: Keep pending timeouts in a hierarchical timing wheel
+ * instead of a sorted delta list, so that sys_timeout() and sys_untimeout()
+ * do not have to walk the list. Timeouts still expire in the same order
+ * (timeouts due at the same time in the order they were started). Each
+ * timeout in MEMP_SYS_TIMEOUT grows by 5 words.
+ */
+#if !defined LWIP_TIMERS_WHEEL || defined __DOXYGEN__
+#define LWIP_TIMERS_WHEEL               0
+#endif
+
+/**
+ * TIMERS_WHEEL_HASH_SIZE: Number of hash buckets sys_untimeout() uses to find
+ * a timeout by handler and argument when LWIP_TIMERS_WHEEL is enabled.
+ * Must be a power of 2.
+ */
+#if !defined TIMERS_WHEEL_HASH_SIZE || defined __DOXYGEN__
+#define TIMERS_WHEEL_HASH_SIZE          16
+#endif
 /**
  * @}
  */
@@ -390,6 +410,15 @@
 #define MEMP_NUM_TCP_SEG                16
 #endif
 
+/**
+ * MEMP_NUM_TCP_ZC_PBUF: the number of pbufs that can reference application
+ * buffers passed to tcp_write_zc() at the same time.
+ * (requires the LWIP_TCP_ZEROCOPY option)
+ */
+#if !defined MEMP_NUM_TCP_ZC_PBUF || defined __DOXYGEN__
+#define MEMP_NUM_TCP_ZC_PBUF            MEMP_NUM_TCP_SEG
+#endif
+
 /**
  * MEMP_NUM_REASSDATA: the number of IP packets simultaneously queued for
  * reassembly (whole packets, not fragments!)
@@ -1111,6 +1140,25 @@
 #if !defined LWIP_NETBUF_RECVINFO || defined __DOXYGEN__
 #define LWIP_NETBUF_RECVINFO            0
 #endif
+
+/**
+ * LWIP_UDP_PCB_HASH==1: Demultiplex incoming datagrams through a hash table
+ * keyed on the local port instead of walking the whole udp_pcbs list. Only
+ * pcbs bound to the destination port are compared, and the pcb that last got
+ * a datagram is kept at the front of its bucket, so a connected flow is
+ * usually found on the first compare. Delivery rules are unchanged.
+ */
+#if !defined LWIP_UDP_PCB_HASH || defined __DOXYGEN__
+#define LWIP_UDP_PCB_HASH               0
+#endif
+
+/**
+ * UDP_PCB_HASH_SIZE: Number of hash buckets when LWIP_UDP_PCB_HASH is
+ * enabled. Must be a power of 2.
+ */
+#if !defined UDP_PCB_HASH_SIZE || defined __DOXYGEN__
+#define UDP_PCB_HASH_SIZE               16
+#endif
 /**
  * @}
  */
@@ -1246,6 +1294,36 @@
 #define TCP_OOSEQ_MAX_PBUFS             0
 #endif
 
+/**
+ * TCP_OOSEQ_GLOBAL_MAX_BYTES: The maximum number of bytes queued on ooseq by
+ * all pcbs together. When a new segment exceeds it, the highest sequence
+ * segment of the pcb holding the most ooseq pbufs is evicted until the queues
+ * fit again. Default is 0 (no limit). Only valid for TCP_QUEUE_OOSEQ==1.
+ */
+#if !defined TCP_OOSEQ_GLOBAL_MAX_BYTES || defined __DOXYGEN__
+#define TCP_OOSEQ_GLOBAL_MAX_BYTES      0
+#endif
+
+/**
+ * TCP_OOSEQ_GLOBAL_MAX_PBUFS: The maximum number of pbufs queued on ooseq by
+ * all pcbs together, evicted like TCP_OOSEQ_GLOBAL_MAX_BYTES.
+ * Default is 0 (no limit). Only valid for TCP_QUEUE_OOSEQ==1.
+ */
+#if !defined TCP_OOSEQ_GLOBAL_MAX_PBUFS || defined __DOXYGEN__
+#define TCP_OOSEQ_GLOBAL_MAX_PBUFS      0
+#endif
+
+/**
+ * TCP_OOSEQ_EVICT_PBUFS: The number of pbufs to reclaim from the ooseq queues
+ * when the pbuf pool runs empty (see PBUF_POOL_FREE_OOSEQ). With a value > 0,
+ * the highest sequence segments of the largest queues are evicted until at
+ * least this many pbufs were freed, keeping the data closest to rcv_nxt.
+ * Default is 0, which frees the complete ooseq queue of one pcb.
+ */
+#if !defined TCP_OOSEQ_EVICT_PBUFS || defined __DOXYGEN__
+#define TCP_OOSEQ_EVICT_PBUFS           0
+#endif
+
 /**
  * TCP_LISTEN_BACKLOG: Enable the backlog option for tcp listen pcb.
  */
@@ -1262,6 +1340,33 @@
 #define TCP_DEFAULT_LISTEN_BACKLOG      0xff
 #endif
 
+/**
+ * LWIP_TCP_PCB_HASH==1: Demultiplex incoming segments through hash tables
+ * instead of walking tcp_active_pcbs, tcp_tw_pcbs and the listen list.
+ * Active and TIME-WAIT pcbs are hashed on their 4-tuple, listening pcbs on
+ * their local port. Costs one pointer per pcb plus the bucket arrays, and
+ * pays off once there are more than a few dozen pcbs.
+ */
+#if !defined LWIP_TCP_PCB_HASH || defined __DOXYGEN__
+#define LWIP_TCP_PCB_HASH               0
+#endif
+
+/**
+ * TCP_PCB_HASH_SIZE: Number of hash buckets for active and TIME-WAIT pcbs
+ * when LWIP_TCP_PCB_HASH is enabled. Must be a power of 2.
+ */
+#if !defined TCP_PCB_HASH_SIZE || defined __DOXYGEN__
+#define TCP_PCB_HASH_SIZE               64
+#endif
+
+/**
+ * TCP_LISTEN_PCB_HASH_SIZE: Number of hash buckets for listening pcbs when
+ * LWIP_TCP_PCB_HASH is enabled. Must be a power of 2.
+ */
+#if !defined TCP_LISTEN_PCB_HASH_SIZE || defined __DOXYGEN__
+#define TCP_LISTEN_PCB_HASH_SIZE        8
+#endif
+
 /**
  * TCP_OVERSIZE: The maximum number of bytes that tcp_write may
  * allocate ahead of time in an attempt to create shorter pbuf chains
@@ -1290,6 +1395,26 @@
 #define LWIP_TCP_TIMESTAMPS             0
 #endif
 
+/**
+ * LWIP_TCP_SACK==1: support TCP selective acknowledgements (RFC 2018).
+ * SACK-permitted is offered in every SYN and accepted from the remote host.
+ * When both sides agree, ACKs sent while TCP_QUEUE_OOSEQ holds data describe
+ * the out-of-sequence ranges in SACK blocks, and SACK blocks received from
+ * the remote host are used during fast recovery to retransmit only the
+ * segments that are missing.
+ */
+#if !defined LWIP_TCP_SACK || defined __DOXYGEN__
+#define LWIP_TCP_SACK                   0
+#endif
+
+/**
+ * LWIP_TCP_MAX_SACK_NUM: The maximum number of SACK blocks sent in an ACK
+ * (1..4). Only 3 fit together with the timestamp option.
+ */
+#if !defined LWIP_TCP_MAX_SACK_NUM || defined __DOXYGEN__
+#define LWIP_TCP_MAX_SACK_NUM           4
+#endif
+
 /**
  * TCP_WND_UPDATE_THRESHOLD: difference in window to trigger an
  * explicit window update
@@ -1329,6 +1454,36 @@
 #define LWIP_WND_SCALE                  0
 #define TCP_RCV_SCALE                   0
 #endif
+
+/**
+ * LWIP_TCP_RCV_AUTOTUNE==1: Auto-tune the receive window of each connection.
+ * A connection starts with TCP_WND_AUTOTUNE_MIN and the window is grown up to
+ * TCP_WND (or 0xffff if window scaling is not used on it) to twice what the
+ * application drains per round-trip time. When PBUF_POOL runs empty, the
+ * window is halved again by keeping back data the application has read.
+ */
+#if !defined LWIP_TCP_RCV_AUTOTUNE || defined __DOXYGEN__
+#define LWIP_TCP_RCV_AUTOTUNE           0
+#endif
+
+/**
+ * TCP_WND_AUTOTUNE_MIN: The receive window a connection starts with, and the
+ * smallest window it is shrunk to, when LWIP_TCP_RCV_AUTOTUNE is enabled.
+ */
+#if !defined TCP_WND_AUTOTUNE_MIN || defined __DOXYGEN__
+#define TCP_WND_AUTOTUNE_MIN            LWIP_MIN(TCP_WND, (4 * TCP_MSS))
+#endif
+
+/**
+ * LWIP_TCP_ZEROCOPY==1: Enable tcp_write_zc(), netconn_write_zc() and
+ * lwip_send_zc(). These send from application buffers without copying and
+ * report through a callback when the stack has released the last reference
+ * to the buffer, i.e. when the data has been acknowledged and freed.
+ * Uses custom pbufs from the MEMP_TCP_ZC_PBUF pool.
+ */
+#if !defined LWIP_TCP_ZEROCOPY || defined __DOXYGEN__
+#define LWIP_TCP_ZEROCOPY               0
+#endif
 /**
  * @}
  */
@@ -1770,6 +1925,42 @@
 #define LWIP_SOCKET_OFFSET              0
 #endif
 
+/**
+ * LWIP_SOCKET_MMSG_BATCH: The number of datagrams lwip_sendmmsg() passes to
+ * the tcpip_thread with one call. The netbufs of a batch live on the stack
+ * of the calling thread.
+ */
+#if !defined LWIP_SOCKET_MMSG_BATCH || defined __DOXYGEN__
+#define LWIP_SOCKET_MMSG_BATCH          8
+#endif
+
+/**
+ * LWIP_SOCKET_EPOLL==1: Enable lwip_epoll_create(), lwip_epoll_ctl() and
+ * lwip_epoll_wait(). Sockets registered with an epoll instance are put on
+ * its ready list by the socket event callback, so waiting costs time in the
+ * number of ready sockets instead of scanning every descriptor like select.
+ * Level- and edge-triggered (EPOLLET) registrations are supported.
+ */
+#if !defined LWIP_SOCKET_EPOLL || defined __DOXYGEN__
+#define LWIP_SOCKET_EPOLL               0
+#endif
+
+/**
+ * LWIP_EPOLL_MAX: The number of epoll instances that can exist at the same
+ * time. (requires the LWIP_SOCKET_EPOLL option)
+ */
+#if !defined LWIP_EPOLL_MAX || defined __DOXYGEN__
+#define LWIP_EPOLL_MAX                  2
+#endif
+
+/**
+ * LWIP_EPOLL_MAX_ITEMS: The number of socket registrations shared by all
+ * epoll instances. (requires the LWIP_SOCKET_EPOLL option)
+ */
+#if !defined LWIP_EPOLL_MAX_ITEMS || defined __DOXYGEN__
+#define LWIP_EPOLL_MAX_ITEMS            MEMP_NUM_NETCONN
+#endif
+
 /**
  * LWIP_TCP_KEEPALIVE==1: Enable TCP_KEEPIDLE, TCP_KEEPINTVL and TCP_KEEPCNT
  * options processing. Note that TCP_KEEPIDLE and TCP_KEEPINTVL have to be set
@@ -2010,6 +2201,27 @@
 #define MIB2_STATS                      0
 #endif
 
+/**
+ * LWIP_STATS_HIST==1: Keep log2 histograms of the time spent in hot paths
+ * (tcpip mailbox queueing and message handling, netif input, tcp_input and
+ * tcp_output). Each sample costs two reads of LWIP_STATS_CYCLES() plus a
+ * constant-time bucket update; the measured cost is stored in
+ * lwip_stats.hist_overhead by stats_init(). The port has to provide
+ * LWIP_STATS_CYCLES() returning a free-running u32_t counter (and may provide
+ * LWIP_STATS_CYCLES_INIT() to start it).
+ */
+#if !defined LWIP_STATS_HIST || defined __DOXYGEN__
+#define LWIP_STATS_HIST                 0
+#endif
+
+/**
+ * TCP_PCB_STATS==1: Count payload bytes, segments and retransmissions per
+ * TCP connection in tcp_pcb->stats.
+ */
+#if !defined TCP_PCB_STATS || defined __DOXYGEN__
+#define TCP_PCB_STATS                   0
+#endif
+
 #else
 
 #define LINK_STATS                      0
@@ -2030,6 +2242,8 @@
 #define MLD6_STATS                      0
 #define ND6_STATS                       0
 #define MIB2_STATS                      0
+#define LWIP_STATS_HIST                 0
+#define TCP_PCB_STATS                   0
 
 #endif /* LWIP_STATS */
 /**
@@ -52,7 +52,7 @@ extern "C" {
  * Currently, the pbuf_custom code is only needed for one specific configuration
  * of IP_FRAG, unless required by external driver/application code. */
 #ifndef LWIP_SUPPORT_CUSTOM_PBUF
-#define LWIP_SUPPORT_CUSTOM_PBUF ((IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF) || (LWIP_IPV6 && LWIP_IPV6_FRAG))
+#define LWIP_SUPPORT_CUSTOM_PBUF ((IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF) || (LWIP_IPV6 && LWIP_IPV6_FRAG) || (LWIP_TCP && LWIP_TCP_ZEROCOPY))
 #endif
 
 /* @todo: We need a mechanism to prevent wasting memory in every pbuf
@@ -137,6 +137,9 @@ typedef enum {
 #define PBUF_FLAG_LLMCAST   0x10U
 /** indicates this pbuf includes a TCP FIN flag */
 #define PBUF_FLAG_TCP_FIN   0x20U
+/** indicates the transport checksum of this packet was not verified by the
+    netif even if it offloads checksums (e.g. reassembled from fragments) */
+#define PBUF_FLAG_SW_CHKSUM 0x40U
 
 /** Main packet buffer struct */
 struct pbuf {
@@ -217,6 +220,11 @@ void pbuf_free_ooseq(void);
   #define PBUF_CHECK_FREE_OOSEQ()
 #endif /* LWIP_TCP && TCP_QUEUE_OOSEQ && NO_SYS && PBUF_POOL_FREE_OOSEQ*/
 
+#if LWIP_TCP && LWIP_TCP_RCV_AUTOTUNE
+/** Incremented each time PBUF_POOL runs empty, tells TCP to shrink windows */
+extern volatile u8_t pbuf_pool_empty_count;
+#endif /* LWIP_TCP && LWIP_TCP_RCV_AUTOTUNE */
+
 /* Initializes the pbuf module. This call is empty for now, but may not be in future. */
 #define pbuf_init()
 
@@ -82,9 +82,20 @@ err_t            tcp_send_empty_ack(struct tcp_pcb *pcb);
 void             tcp_rexmit  (struct tcp_pcb *pcb);
 void             tcp_rexmit_rto  (struct tcp_pcb *pcb);
 void             tcp_rexmit_fast (struct tcp_pcb *pcb);
+#if LWIP_TCP_SACK
+void             tcp_rexmit_sack (struct tcp_pcb *pcb);
+#endif /* LWIP_TCP_SACK */
 u32_t            tcp_update_rcv_ann_wnd(struct tcp_pcb *pcb);
 err_t            tcp_process_refused_data(struct tcp_pcb *pcb);
 
+#if TCP_PCB_STATS
+#define TCP_PCB_STATS_INC(pcb, x)    ++(pcb)->stats.x
+#define TCP_PCB_STATS_ADD(pcb, x, n) (pcb)->stats.x += (n)
+#else /* TCP_PCB_STATS */
+#define TCP_PCB_STATS_INC(pcb, x)
+#define TCP_PCB_STATS_ADD(pcb, x, n)
+#endif /* TCP_PCB_STATS */
+
 /**
  * This is the Nagle algorithm: try to combine user data to send as few TCP
  * segments as possible. Only send if
@@ -264,13 +275,28 @@ struct tcp_seg {
 #define TF_SEG_DATA_CHECKSUMMED (u8_t)0x04U /* ALL data (not the header) is
                                                checksummed into 'chksum' */
 #define TF_SEG_OPTS_WND_SCALE   (u8_t)0x08U /* Include WND SCALE option */
+#define TF_SEG_OPTS_SACK_PERM   (u8_t)0x10U /* Include SACK Permitted option */
+#define TF_SEG_SACKED           (u8_t)0x20U /* Selectively acknowledged by the
+                                               remote host (unacked only) */
+#define TF_SEG_REXMIT           (u8_t)0x40U /* Retransmitted during the current
+                                               fast recovery */
   struct tcp_hdr *tcphdr;  /* the TCP header */
 };
 
+#if LWIP_TCP_ZEROCOPY
+/* A PBUF_REF pbuf referencing data passed to tcp_write_zc() */
+struct tcp_zc_pbuf {
+  struct pbuf_custom pc;
+  struct tcp_zc *zc;
+};
+#endif /* LWIP_TCP_ZEROCOPY */
+
 #define LWIP_TCP_OPT_EOL        0
 #define LWIP_TCP_OPT_NOP        1
 #define LWIP_TCP_OPT_MSS        2
 #define LWIP_TCP_OPT_WS         3
+#define LWIP_TCP_OPT_SACK_PERM  4
+#define LWIP_TCP_OPT_SACK       5
 #define LWIP_TCP_OPT_TS         8
 
 #define LWIP_TCP_OPT_LEN_MSS    4
@@ -287,10 +313,20 @@ struct tcp_seg {
 #define LWIP_TCP_OPT_LEN_WS_OUT 0
 #endif
 
+#if LWIP_TCP_SACK
+#define LWIP_TCP_OPT_LEN_SACK_PERM      2
+#define LWIP_TCP_OPT_LEN_SACK_PERM_OUT  4 /* aligned for output (includes NOP padding) */
+/* SACK option carrying n blocks, aligned for output (includes NOP padding) */
+#define LWIP_TCP_OPT_LEN_SACK_OUT(n)    (4 + 8 * (n))
+#else
+#define LWIP_TCP_OPT_LEN_SACK_PERM_OUT  0
+#endif
+
 #define LWIP_TCP_OPT_LENGTH(flags) \
   (flags & TF_SEG_OPTS_MSS       ? LWIP_TCP_OPT_LEN_MSS    : 0) + \
   (flags & TF_SEG_OPTS_TS        ? LWIP_TCP_OPT_LEN_TS_OUT : 0) + \
-  (flags & TF_SEG_OPTS_WND_SCALE ? LWIP_TCP_OPT_LEN_WS_OUT : 0)
+  (flags & TF_SEG_OPTS_WND_SCALE ? LWIP_TCP_OPT_LEN_WS_OUT : 0) + \
+  (flags & TF_SEG_OPTS_SACK_PERM ? LWIP_TCP_OPT_LEN_SACK_PERM_OUT : 0)
 
 /** This returns a TCP header option for MSS in an u32_t */
 #define TCP_BUILD_MSS_OPTION(mss) lwip_htonl(0x02040000 | ((mss) & 0xFFFF))
@@ -307,6 +343,13 @@ struct tcp_seg {
 #define TCPWND_MIN16(x)    x
 #endif /* LWIP_WND_SCALE */
 
+/** The receive window a new pcb starts with, before any scaling is agreed */
+#if LWIP_TCP_RCV_AUTOTUNE
+#define TCP_WND_INITIAL    TCPWND_MIN16(TCP_WND_AUTOTUNE_MIN)
+#else /* LWIP_TCP_RCV_AUTOTUNE */
+#define TCP_WND_INITIAL    TCPWND_MIN16(TCP_WND)
+#endif /* LWIP_TCP_RCV_AUTOTUNE */
+
 /* Global variables: */
 extern struct tcp_pcb *tcp_input_pcb;
 extern u32_t tcp_ticks;
@@ -334,6 +377,19 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
    3) All PCBs in the tcp_listen_pcbs list is in LISTEN state.
    4) All PCBs in the tcp_tw_pcbs list is in TIME-WAIT state.
 */
+#if LWIP_TCP_PCB_HASH
+/* Keep the demux hash tables in step with the active, TIME-WAIT and listen
+   lists. Registering with or removing from any other list is ignored. */
+void tcp_pcb_hash_add(struct tcp_pcb **pcblist, struct tcp_pcb *pcb);
+void tcp_pcb_hash_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb);
+struct tcp_pcb *tcp_pcb_hash_lookup(u16_t local_port, const ip_addr_t *local_ip,
+                                    u16_t remote_port, const ip_addr_t *remote_ip);
+struct tcp_pcb_listen *tcp_listen_pcb_hash_lookup(u16_t local_port, const ip_addr_t *local_ip);
+#else /* LWIP_TCP_PCB_HASH */
+#define tcp_pcb_hash_add(pcblist, pcb)
+#define tcp_pcb_hash_remove(pcblist, pcb)
+#endif /* LWIP_TCP_PCB_HASH */
+
 /* Define two macros, TCP_REG and TCP_RMV that registers a TCP PCB
    with a PCB list or removes a PCB from a list, respectively. */
 #ifndef TCP_DEBUG_PCB_LISTS
@@ -352,6 +408,7 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
                             (npcb)->next = *(pcbs); \
                             LWIP_ASSERT("TCP_REG: npcb->next != npcb", (npcb)->next != (npcb)); \
                             *(pcbs) = (npcb); \
+                            tcp_pcb_hash_add((pcbs), (npcb)); \
                             LWIP_ASSERT("TCP_RMV: tcp_pcbs sane", tcp_pcbs_sane()); \
               tcp_timer_needed(); \
                             } while(0)
@@ -368,6 +425,7 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
                                } \
                             } \
                             (npcb)->next = NULL; \
+                            tcp_pcb_hash_remove((pcbs), (npcb)); \
                             LWIP_ASSERT("TCP_RMV: tcp_pcbs sane", tcp_pcbs_sane()); \
                             LWIP_DEBUGF(TCP_DEBUG, ("TCP_RMV: removed %p from %p\n", (npcb), *(pcbs))); \
                             } while(0)
@@ -378,6 +436,7 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
   do {                                             \
     (npcb)->next = *pcbs;                          \
     *(pcbs) = (npcb);                              \
+    tcp_pcb_hash_add((pcbs), (npcb));              \
     tcp_timer_needed();                            \
   } while (0)
 
@@ -398,6 +457,7 @@ extern struct tcp_pcb ** const tcp_pcb_lists[NUM_TCP_PCB_LISTS];
       }                                            \
     }                                              \
     (npcb)->next = NULL;                           \
+    tcp_pcb_hash_remove((pcbs), (npcb));           \
   } while(0)
 
 #endif /* LWIP_DEBUG */
@@ -429,6 +489,10 @@ void tcp_pcb_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb);
 void tcp_segs_free(struct tcp_seg *seg);
 void tcp_seg_free(struct tcp_seg *seg);
 struct tcp_seg *tcp_seg_copy(struct tcp_seg *seg);
+#if TCP_QUEUE_OOSEQ
+u16_t tcp_ooseq_usage(u32_t *bytes);
+u16_t tcp_ooseq_evict(void);
+#endif /* TCP_QUEUE_OOSEQ */
 
 #define tcp_ack(pcb)                               \
   do {                                             \
@@ -122,6 +122,10 @@ enum tcpip_msg_type {
 
 struct tcpip_msg {
   enum tcpip_msg_type type;
+#if LWIP_STATS_HIST
+  /** LWIP_STATS_CYCLES() when the message was posted */
+  u32_t posted;
+#endif /* LWIP_STATS_HIST */
   union {
     struct {
       tcpip_callback_fn function;
@@ -159,6 +159,13 @@ struct msghdr {
   int           msg_flags;
 };
 
+/** One datagram for lwip_recvmmsg() and lwip_sendmmsg() */
+struct mmsghdr {
+  struct msghdr msg_hdr;
+  /** number of bytes received or sent */
+  unsigned int  msg_len;
+};
+
 /* Socket protocol types (TCP/UDP/RAW) */
 #define SOCK_STREAM     1
 #define SOCK_DGRAM      2
@@ -237,6 +244,7 @@ struct linger {
 #define MSG_OOB        0x04    /* Unimplemented: Requests out-of-band data. The significance and semantics of out-of-band data are protocol-specific */
 #define MSG_DONTWAIT   0x08    /* Nonblocking i/o for this operation only */
 #define MSG_MORE       0x10    /* Sender will send more */
+#define MSG_TRUNC      0x20    /* Returned in msg_flags: the datagram was larger than the buffer supplied */
 
 
 /*
@@ -430,6 +438,35 @@ typedef struct fd_set
 #error "external FD_SETSIZE too small for number of sockets"
 #endif /* FD_SET */
 
+#if LWIP_SOCKET_EPOLL
+/* Event flags for lwip_epoll_ctl/lwip_epoll_wait, values as on Linux */
+#ifndef EPOLLIN
+#define EPOLLIN       0x001U
+#define EPOLLOUT      0x004U
+#define EPOLLERR      0x008U
+#define EPOLLONESHOT  (1U << 30)
+#define EPOLLET       (1U << 31)
+#endif /* EPOLLIN */
+
+/* Operations for lwip_epoll_ctl */
+#ifndef EPOLL_CTL_ADD
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+#endif /* EPOLL_CTL_ADD */
+
+typedef union epoll_data {
+  void *ptr;
+  int fd;
+  u32_t u32;
+} epoll_data_t;
+
+struct epoll_event {
+  u32_t events;      /* EPOLL* flags */
+  epoll_data_t data; /* returned unchanged by lwip_epoll_wait */
+};
+#endif /* LWIP_SOCKET_EPOLL */
+
 /** LWIP_TIMEVAL_PRIVATE: if you want to use the struct timeval provided
  * by your system, set this to 0 and include <sys/time.h> in cc.h */
 #ifndef LWIP_TIMEVAL_PRIVATE
@@ -463,10 +500,17 @@ void lwip_socket_thread_cleanup(void); /* LWIP_NETCONN_SEM_PER_THREAD==1: destro
 #define lwip_recvfrom     recvfrom
 #define lwip_send         send
 #define lwip_sendmsg      sendmsg
+#define lwip_sendmmsg     sendmmsg
+#define lwip_recvmmsg     recvmmsg
 #define lwip_sendto       sendto
 #define lwip_socket       socket
 #define lwip_select       select
 #define lwip_ioctlsocket  ioctl
+#if LWIP_SOCKET_EPOLL
+#define lwip_epoll_create epoll_create
+#define lwip_epoll_ctl    epoll_ctl
+#define lwip_epoll_wait   epoll_wait
+#endif /* LWIP_SOCKET_EPOLL */
 
 #if LWIP_POSIX_SOCKETS_IO_NAMES
 #define lwip_read         read
@@ -496,6 +540,8 @@ int lwip_recvfrom(int s, void *mem, size_t len, int flags,
       struct sockaddr *from, socklen_t *fromlen);
 int lwip_send(int s, const void *dataptr, size_t size, int flags);
 int lwip_sendmsg(int s, const struct msghdr *message, int flags);
+int lwip_sendmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags);
+int lwip_recvmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags);
 int lwip_sendto(int s, const void *dataptr, size_t size, int flags,
     const struct sockaddr *to, socklen_t tolen);
 int lwip_socket(int domain, int type, int protocol);
@@ -505,6 +551,15 @@ int lwip_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptse
                 struct timeval *timeout);
 int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
+#if LWIP_SOCKET_EPOLL
+int lwip_epoll_create(int size);
+int lwip_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event);
+int lwip_epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout);
+#endif /* LWIP_SOCKET_EPOLL */
+#if LWIP_TCP && LWIP_TCP_ZEROCOPY
+struct tcp_zc;
+int lwip_send_zc(int s, const void *dataptr, size_t size, int flags, struct tcp_zc *zc);
+#endif /* LWIP_TCP && LWIP_TCP_ZEROCOPY */
 
 #if LWIP_COMPAT_SOCKETS
 #if LWIP_COMPAT_SOCKETS != 2
@@ -536,6 +591,8 @@ int lwip_fcntl(int s, int cmd, int val);
 #define send(s,dataptr,size,flags)                lwip_send(s,dataptr,size,flags)
 /** @ingroup socket */
 #define sendmsg(s,message,flags)                  lwip_sendmsg(s,message,flags)
+#define sendmmsg(s,msgvec,vlen,flags)             lwip_sendmmsg(s,msgvec,vlen,flags)
+#define recvmmsg(s,msgvec,vlen,flags)             lwip_recvmmsg(s,msgvec,vlen,flags)
 /** @ingroup socket */
 #define sendto(s,dataptr,size,flags,to,tolen)     lwip_sendto(s,dataptr,size,flags,to,tolen)
 /** @ingroup socket */
@@ -544,6 +601,14 @@ int lwip_fcntl(int s, int cmd, int val);
 #define select(maxfdp1,readset,writeset,exceptset,timeout)     lwip_select(maxfdp1,readset,writeset,exceptset,timeout)
 /** @ingroup socket */
 #define ioctlsocket(s,cmd,argp)                   lwip_ioctl(s,cmd,argp)
+#if LWIP_SOCKET_EPOLL
+/** @ingroup socket */
+#define epoll_create(size)                        lwip_epoll_create(size)
+/** @ingroup socket */
+#define epoll_ctl(epfd,op,fd,event)               lwip_epoll_ctl(epfd,op,fd,event)
+/** @ingroup socket */
+#define epoll_wait(epfd,events,maxevents,timeout) lwip_epoll_wait(epfd,events,maxevents,timeout)
+#endif /* LWIP_SOCKET_EPOLL */
 
 #if LWIP_POSIX_SOCKETS_IO_NAMES
 /** @ingroup socket */
@@ -76,6 +76,14 @@ struct stats_proto {
   STAT_COUNTER cachehit;
 };
 
+/** TCP out-of-sequence queue stats */
+struct stats_tcp_ooseq {
+  STAT_COUNTER queued;           /* Segments put on an ooseq queue. */
+  STAT_COUNTER hit;              /* Segments passed on in order from an ooseq queue. */
+  STAT_COUNTER evict;            /* Segments evicted by a limit or pool pressure. */
+  STAT_COUNTER max;              /* Most pbufs held on one ooseq queue. */
+};
+
 /** IGMP stats */
 struct stats_igmp {
   STAT_COUNTER xmit;             /* Transmitted packets. */
@@ -120,6 +128,34 @@ struct stats_sys {
   struct stats_syselem mbox;
 };
 
+#if LWIP_STATS_HIST
+/** Hot paths timed with LWIP_STATS_HIST */
+enum stats_hist_id {
+  /** time a message waited in the tcpip_thread mailbox */
+  STATS_HIST_TCPIP_MBOX,
+  /** time tcpip_thread spent handling one message */
+  STATS_HIST_TCPIP_MSG,
+  /** time a netif driver spent passing received frames to the stack */
+  STATS_HIST_NETIF_INPUT,
+  /** time spent in tcp_input() */
+  STATS_HIST_TCP_INPUT,
+  /** time spent in tcp_output() */
+  STATS_HIST_TCP_OUTPUT,
+  STATS_HIST_MAX
+};
+
+/** Number of histogram buckets: bucket n counts samples of 2^n to 2^(n+1)-1
+ * cycles, the last bucket also counts all longer samples. */
+#define STATS_HIST_BUCKETS 24
+
+/** Log2 histogram of durations, in LWIP_STATS_CYCLES() units */
+struct stats_hist {
+  u32_t count;
+  u32_t max;
+  u32_t bucket[STATS_HIST_BUCKETS];
+};
+#endif /* LWIP_STATS_HIST */
+
 /** SNMP MIB2 stats */
 struct stats_mib2 {
   /* IP */
@@ -262,6 +298,10 @@ struct stats_ {
   /** TCP */
   struct stats_proto tcp;
 #endif
+#if TCP_STATS && TCP_QUEUE_OOSEQ
+  /** TCP out-of-sequence queues */
+  struct stats_tcp_ooseq tcp_ooseq;
+#endif
 #if MEM_STATS
   /** Heap */
   struct stats_mem mem;
@@ -298,6 +338,12 @@ struct stats_ {
   /** SNMP MIB2 */
   struct stats_mib2 mib2;
 #endif
+#if LWIP_STATS_HIST
+  /** Hot path latency histograms */
+  struct stats_hist hist[STATS_HIST_MAX];
+  /** Cycles one histogram sample costs, measured by stats_init() */
+  u32_t hist_overhead;
+#endif
 };
 
 /** Global variable containing lwIP internal statistics. Add this to your debugger's watchlist. */
@@ -329,6 +375,14 @@ void stats_init(void);
 #define TCP_STATS_DISPLAY()
 #endif
 
+#if TCP_STATS && TCP_QUEUE_OOSEQ
+#define TCP_OOSEQ_STATS_INC(x) STATS_INC(x)
+#define TCP_OOSEQ_STATS_DISPLAY() stats_display_tcp_ooseq(&lwip_stats.tcp_ooseq)
+#else
+#define TCP_OOSEQ_STATS_INC(x)
+#define TCP_OOSEQ_STATS_DISPLAY()
+#endif
+
 #if UDP_STATS
 #define UDP_STATS_INC(x) STATS_INC(x)
 #define UDP_STATS_DISPLAY() stats_display_proto(&lwip_stats.udp, "UDP")
@@ -421,6 +475,30 @@ void stats_init(void);
 #define SYS_STATS_DISPLAY()
 #endif
 
+#if LWIP_STATS_HIST
+#ifndef LWIP_STATS_CYCLES
+#error "LWIP_STATS_HIST needs a cycle counter, define LWIP_STATS_CYCLES() in your port"
+#endif
+#ifndef LWIP_STATS_CYCLES_INIT
+#define LWIP_STATS_CYCLES_INIT()
+#endif
+/** Declare a start time for STATS_HIST_START/STATS_HIST_STOP */
+#define STATS_HIST_DECL(t) u32_t t
+#define STATS_HIST_START(t) (t) = LWIP_STATS_CYCLES()
+/** Add the time since STATS_HIST_START(t) to histogram 'id' */
+#define STATS_HIST_STOP(id, t) stats_hist_add(&lwip_stats.hist[id], LWIP_STATS_CYCLES() - (t))
+#define STATS_HIST_DISPLAY() stats_display_hist()
+void stats_hist_add(struct stats_hist *hist, u32_t cycles);
+void stats_hist_get(enum stats_hist_id id, struct stats_hist *hist);
+void stats_hist_reset(void);
+const char *stats_hist_name(enum stats_hist_id id);
+#else
+#define STATS_HIST_DECL(t)
+#define STATS_HIST_START(t)
+#define STATS_HIST_STOP(id, t)
+#define STATS_HIST_DISPLAY()
+#endif
+
 #if IP6_STATS
 #define IP6_STATS_INC(x) STATS_INC(x)
 #define IP6_STATS_DISPLAY() stats_display_proto(&lwip_stats.ip6, "IPv6")
@@ -472,16 +550,20 @@ void stats_init(void);
 void stats_display(void);
 void stats_display_proto(struct stats_proto *proto, const char *name);
 void stats_display_igmp(struct stats_igmp *igmp, const char *name);
+void stats_display_tcp_ooseq(struct stats_tcp_ooseq *ooseq);
 void stats_display_mem(struct stats_mem *mem, const char *name);
 void stats_display_memp(struct stats_mem *mem, int index);
 void stats_display_sys(struct stats_sys *sys);
+void stats_display_hist(void);
 #else /* LWIP_STATS_DISPLAY */
 #define stats_display()
 #define stats_display_proto(proto, name)
 #define stats_display_igmp(igmp, name)
+#define stats_display_tcp_ooseq(ooseq)
 #define stats_display_mem(mem, name)
 #define stats_display_memp(mem, index)
 #define stats_display_sys(sys)
+#define stats_display_hist()
 #endif /* LWIP_STATS_DISPLAY */
 
 #ifdef __cplusplus
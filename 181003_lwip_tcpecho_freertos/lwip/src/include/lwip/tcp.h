@@ -135,17 +135,24 @@ typedef err_t (*tcp_connected_fn)(void *arg, struct tcp_pcb *tpcb, err_t err);
 #define RCV_WND_SCALE(pcb, wnd) (((wnd) >> (pcb)->rcv_scale))
 #define SND_WND_SCALE(pcb, wnd) (((wnd) << (pcb)->snd_scale))
 #define TCPWND16(x)             ((u16_t)LWIP_MIN((x), 0xFFFF))
-#define TCP_WND_MAX(pcb)        ((tcpwnd_size_t)(((pcb)->flags & TF_WND_SCALE) ? TCP_WND : TCPWND16(TCP_WND)))
+#define TCP_WND_LIMIT(pcb)      ((tcpwnd_size_t)(((pcb)->flags & TF_WND_SCALE) ? TCP_WND : TCPWND16(TCP_WND)))
 typedef u32_t tcpwnd_size_t;
 #else
 #define RCV_WND_SCALE(pcb, wnd) (wnd)
 #define SND_WND_SCALE(pcb, wnd) (wnd)
 #define TCPWND16(x)             (x)
-#define TCP_WND_MAX(pcb)        TCP_WND
+#define TCP_WND_LIMIT(pcb)      TCP_WND
 typedef u16_t tcpwnd_size_t;
 #endif
 
-#if LWIP_WND_SCALE || TCP_LISTEN_BACKLOG || LWIP_TCP_TIMESTAMPS
+#if LWIP_TCP_RCV_AUTOTUNE
+/* the receive window currently granted, grown up to TCP_WND_LIMIT() */
+#define TCP_WND_MAX(pcb)        ((pcb)->rcv_wnd_max)
+#else
+#define TCP_WND_MAX(pcb)        TCP_WND_LIMIT(pcb)
+#endif
+
+#if LWIP_WND_SCALE || TCP_LISTEN_BACKLOG || LWIP_TCP_TIMESTAMPS || LWIP_TCP_SACK
 typedef u16_t tcpflags_t;
 #else
 typedef u8_t tcpflags_t;
@@ -168,8 +175,15 @@ enum tcp_state {
 /**
  * members common to struct tcp_pcb and struct tcp_listen_pcb
  */
+#if LWIP_TCP_PCB_HASH
+#define TCP_PCB_HASH_NEXT(type) type *hash_next; /* for the demux hash bucket */
+#else /* LWIP_TCP_PCB_HASH */
+#define TCP_PCB_HASH_NEXT(type)
+#endif /* LWIP_TCP_PCB_HASH */
+
 #define TCP_PCB_COMMON(type) \
   type *next; /* for the linked list */ \
+  TCP_PCB_HASH_NEXT(type) \
   void *callback_arg; \
   enum tcp_state state; /* TCP state */ \
   u8_t prio; \
@@ -196,6 +210,22 @@ struct tcp_pcb_listen {
 };
 
 
+#if TCP_PCB_STATS
+/** Per-connection counters, see TCP_PCB_STATS */
+struct tcp_pcb_stats {
+  /** payload bytes passed to IP, retransmissions included */
+  u32_t bytes_out;
+  /** payload bytes received in sequence */
+  u32_t bytes_in;
+  /** segments passed to IP */
+  u32_t segs_out;
+  /** segments queued again by fast retransmit or SACK recovery */
+  u32_t rexmit;
+  /** retransmission timeouts */
+  u32_t rto;
+};
+#endif /* TCP_PCB_STATS */
+
 /** the TCP protocol control block */
 struct tcp_pcb {
 /** common PCB members */
@@ -223,6 +253,9 @@ struct tcp_pcb {
 #endif
 #if LWIP_TCP_TIMESTAMPS
 #define TF_TIMESTAMP   0x0400U   /* Timestamp option enabled */
+#endif
+#if LWIP_TCP_SACK
+#define TF_SACK        0x0800U   /* SACK option enabled */
 #endif
 
   /* the rest of the fields are in host byte order
@@ -238,6 +271,17 @@ struct tcp_pcb {
   tcpwnd_size_t rcv_wnd;   /* receiver window available */
   tcpwnd_size_t rcv_ann_wnd; /* receiver window to announce */
   u32_t rcv_ann_right_edge; /* announced right edge of window */
+#if LWIP_TCP_RCV_AUTOTUNE
+  tcpwnd_size_t rcv_wnd_max;    /* receive window granted (rcv_wnd + unread data) */
+  tcpwnd_size_t rcv_wnd_target; /* window to shrink rcv_wnd_max to */
+  u32_t rcv_space;     /* most data the application drained in one RTT */
+  u32_t rcv_copied;    /* data drained in the current RTT round */
+  u32_t rcv_round_time; /* sys_now() at the start of the round */
+  u32_t rcv_rtt_seq;   /* rcv_nxt that ends the current RTT sample */
+  u32_t rcv_rtt_time;  /* sys_now() at the start of the RTT sample, 0: none */
+  u32_t rcv_rtt;       /* shortest time a full window took to arrive (ms) */
+  u8_t rcv_pool_empty; /* pbuf_pool_empty_count already reacted to */
+#endif /* LWIP_TCP_RCV_AUTOTUNE */
 
   /* Retransmission timer. */
   s16_t rtime;
@@ -255,6 +299,10 @@ struct tcp_pcb {
   /* fast retransmit/recovery */
   u8_t dupacks;
   u32_t lastack; /* Highest acknowledged seqno. */
+#if LWIP_TCP_SACK
+  u32_t snd_recover;     /* snd_nxt when fast recovery started */
+  u32_t rcv_sack_recent; /* seqno of the last segment queued on ooseq */
+#endif /* LWIP_TCP_SACK */
 
   /* congestion avoidance/control variables */
   tcpwnd_size_t cwnd;
@@ -327,6 +375,10 @@ struct tcp_pcb {
   u8_t snd_scale;
   u8_t rcv_scale;
 #endif
+
+#if TCP_PCB_STATS
+  struct tcp_pcb_stats stats;
+#endif /* TCP_PCB_STATS */
 };
 
 #if LWIP_EVENT_API
@@ -410,6 +462,32 @@ err_t            tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx);
 err_t            tcp_write   (struct tcp_pcb *pcb, const void *dataptr, u16_t len,
                               u8_t apiflags);
 
+#if LWIP_TCP_ZEROCOPY
+/** Function prototype for the completion callback of a zero-copy write.
+ * Called once the stack holds no more reference to the buffer, from the
+ * thread that freed the last pbuf (normally the tcpip thread), so it must
+ * not block.
+ *
+ * @param arg Argument passed to tcp_zc_init()
+ */
+typedef void (*tcp_zc_fn)(void *arg);
+
+/** Tracks the pbufs referencing an application buffer sent by
+ * tcp_write_zc(). Owned by the application, must stay valid until
+ * the callback has been called. */
+struct tcp_zc {
+  tcp_zc_fn done;
+  void *arg;
+  /* pbufs still referencing the buffer, plus one until tcp_zc_release() */
+  u16_t pending;
+};
+
+void             tcp_zc_init (struct tcp_zc *zc, tcp_zc_fn done, void *arg);
+void             tcp_zc_release(struct tcp_zc *zc);
+err_t            tcp_write_zc(struct tcp_pcb *pcb, const void *dataptr, u16_t len,
+                              u8_t apiflags, struct tcp_zc *zc);
+#endif /* LWIP_TCP_ZEROCOPY */
+
 void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 
 #define TCP_PRIO_MIN    1
@@ -85,6 +85,20 @@ typedef void (* sys_timeout_handler)(void *arg);
 
 struct sys_timeo {
   struct sys_timeo *next;
+#if LWIP_TIMERS_WHEEL
+  /** previous entry in the wheel slot, the first entry points to the last */
+  struct sys_timeo *prev;
+  /** next entry in the sys_untimeout() hash bucket */
+  struct sys_timeo *hash_next;
+  /** pointer pointing to this entry in the hash bucket */
+  struct sys_timeo **hash_pprev;
+  /** start order, keeps timeouts due at the same time in FIFO order */
+  u32_t seq;
+  /** wheel slot this entry is linked into (level * slots + index) */
+  u16_t slot;
+#endif /* LWIP_TIMERS_WHEEL */
+  /** due time: relative to the previous entry in the list, or the absolute
+      wheel time if LWIP_TIMERS_WHEEL is enabled */
   u32_t time;
   sys_timeout_handler h;
   void *arg;
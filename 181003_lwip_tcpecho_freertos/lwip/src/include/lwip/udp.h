@@ -85,6 +85,13 @@ struct udp_pcb {
 /* Protocol specific PCB members */
 
   struct udp_pcb *next;
+#if LWIP_UDP_PCB_HASH
+  /** next pcb in the same demux hash bucket */
+  struct udp_pcb *hash_next;
+  /** when the pcb last went to the front of udp_pcbs, as it would without
+      the hash table: orders the pcbs within their bucket */
+  u32_t hash_stamp;
+#endif /* LWIP_UDP_PCB_HASH */
 
   u8_t flags;
   /** ports are in host byte order */
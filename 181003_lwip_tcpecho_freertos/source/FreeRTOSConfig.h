@@ -62,27 +62,53 @@
 #define configUSE_APPLICATION_TASK_TAG          0
 
 /* Used memory allocation (heap_x.c) */
-#define configFRTOS_MEMORY_SCHEME               3
-/* Tasks.c additions (e.g. Thread Aware Debug capability) */
+#define configFRTOS_MEMORY_SCHEME               6
+/* Tasks.c additions (e.g. Thread Aware Debug capability). They only describe
+the TCB layout to the MCUXpresso debugger, so the host build leaves them out. */
+#if defined(LWIP_HOST_BUILD) && LWIP_HOST_BUILD
+#define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H 0
+#else
 #define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H 1
+#endif
 
 /* Memory allocation related definitions. */
 #define configSUPPORT_STATIC_ALLOCATION         0
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
-/*#define configTOTAL_HEAP_SIZE                   0  not used by heap_3.c allocator */
+#if defined(LWIP_HOST_BUILD) && LWIP_HOST_BUILD
+/* Stack words are 8 bytes wide on the host, task stacks need twice the space. */
+#ifndef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE                   ((size_t)(256 * 1024))
+#endif
+#else
+/* heap_6 owns this array, the linker heap (0x400) is left to the C library. */
+#define configTOTAL_HEAP_SIZE                   ((size_t)(25600))
+#endif
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
 /* Hook function related definitions. */
+#if defined(LWIP_HOST_BUILD) && LWIP_HOST_BUILD
+/* The host port sleeps in the idle hook until the next simulated interrupt. */
+#define configUSE_IDLE_HOOK                     1
+#else
 #define configUSE_IDLE_HOOK                     0
+#endif
 #define configUSE_TICK_HOOK                     0
 #define configCHECK_FOR_STACK_OVERFLOW          0
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
-/* Run time and task stats gathering related definitions. */
+/* Run time and task stats gathering related definitions. The run time stats
+(common/runtime_stats.h) are opt-in: build with configGENERATE_RUN_TIME_STATS=1
+to enable them. */
+#ifndef configGENERATE_RUN_TIME_STATS
 #define configGENERATE_RUN_TIME_STATS           0
+#endif
 #define configUSE_TRACE_FACILITY                1
-#define configUSE_STATS_FORMATTING_FUNCTIONS    1
+/* The binary trace recorder (common/trace_recorder.h) is opt-in as well. */
+#ifndef configUSE_TRACE_RECORDER
+#define configUSE_TRACE_RECORDER                0
+#endif
+#define configUSE_STATS_FORMATTING_FUNCTIONS    configGENERATE_RUN_TIME_STATS
 
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
@@ -95,7 +121,12 @@
 #define configTIMER_TASK_STACK_DEPTH            (configMINIMAL_STACK_SIZE * 2)
 
 /* Define to trap errors during development. */
+#if defined(LWIP_HOST_BUILD) && LWIP_HOST_BUILD
+void vAssertCalled(const char *pcFile, unsigned long ulLine);
+#define configASSERT(x) if((x) == 0) {vAssertCalled(__FILE__, __LINE__);}
+#else
 #define configASSERT(x) if((x) == 0) {taskDISABLE_INTERRUPTS(); for (;;);}
+#endif
 
 /* Optional functions - most linkers will remove unused functions anyway. */
 #define INCLUDE_vTaskPrioritySet                1
@@ -146,6 +177,17 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 standard names. */
 #define vPortSVCHandler SVC_Handler
 #define xPortPendSVHandler PendSV_Handler
+/* With run time stats SysTick_Handler is the wrapper in common/runtime_stats.c,
+which accounts the tick as ISR time. */
+#if !configGENERATE_RUN_TIME_STATS
 #define xPortSysTickHandler SysTick_Handler
+#endif
+
+/* The binary trace recorder and the run time stats implement the trace hook
+macros, they have to be seen before FreeRTOS.h supplies the empty defaults. */
+#ifndef __ASSEMBLER__
+#include "trace_recorder.h"
+#include "runtime_stats.h"
+#endif
 
 #endif /* FREERTOS_CONFIG_H */
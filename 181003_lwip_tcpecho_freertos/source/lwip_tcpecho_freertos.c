@@ -41,8 +41,13 @@
 #if LWIP_NETCONN
 
 #include "tcpecho/tcpecho.h"
+#include "tcpecho_raw/tcpecho_raw.h"
+#include "statsserver/statsserver.h"
 #include "lwip/tcpip.h"
 #include "netif/ethernet.h"
+#if LWIP_HOST_BUILD
+#include "tapif.h"
+#else
 #include "ethernetif.h"
 
 #include "board.h"
@@ -50,6 +55,7 @@
 #include "fsl_device_registers.h"
 #include "pin_mux.h"
 #include "clock_config.h"
+#endif
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
@@ -75,13 +81,31 @@
 /* MAC address configuration. */
 #define configMAC_ADDR {0x02, 0x12, 0x13, 0x10, 0x15, 0x11}
 
+#if LWIP_HOST_BUILD
+/* Capture file of the host build, NULL to disable. */
+#ifndef EXAMPLE_PCAP_PATH
+#define EXAMPLE_PCAP_PATH NULL
+#endif
+#else
 /* Address of PHY interface. */
 #define EXAMPLE_PHY_ADDRESS BOARD_ENET0_PHY_ADDRESS
 
 /* System clock name. */
 #define EXAMPLE_CLOCK_NAME kCLOCK_CoreSysClk
+#endif
 
 
+/*! @brief 1 to serve the echo from the raw TCP API inside the tcpip thread,
+ *  0 to use the netconn based tcpecho threads. */
+#ifndef EXAMPLE_TCPECHO_RAW
+#define EXAMPLE_TCPECHO_RAW 0
+#endif
+
+/*! @brief 1 to answer statistics requests on UDP port STATSSERVER_PORT. */
+#ifndef EXAMPLE_STATSSERVER
+#define EXAMPLE_STATSSERVER (LWIP_STATS_HIST || MIB2_STATS || TCP_PCB_STATS || configGENERATE_RUN_TIME_STATS)
+#endif
+
 /*! @brief Stack size of the temporary lwIP initialization thread. */
 #define INIT_THREAD_STACKSIZE 512
 
@@ -107,11 +131,19 @@ static void stack_init(void *arg)
 {
     static struct netif fsl_netif0;
     ip4_addr_t fsl_netif0_ipaddr, fsl_netif0_netmask, fsl_netif0_gw;
+#if LWIP_HOST_BUILD
+    tapif_config_t fsl_enet_config0 = {
+        .deviceName = NULL,
+        .pcapPath = EXAMPLE_PCAP_PATH,
+        .macAddress = configMAC_ADDR,
+    };
+#else
     ethernetif_config_t fsl_enet_config0 = {
         .phyAddress = EXAMPLE_PHY_ADDRESS,
         .clockName = EXAMPLE_CLOCK_NAME,
         .macAddress = configMAC_ADDR,
     };
+#endif
 
     LWIP_UNUSED_ARG(arg);
 
@@ -121,8 +153,13 @@ static void stack_init(void *arg)
 
     tcpip_init(NULL, NULL);
 
+#if LWIP_HOST_BUILD
+    netif_add(&fsl_netif0, &fsl_netif0_ipaddr, &fsl_netif0_netmask, &fsl_netif0_gw,
+              &fsl_enet_config0, tapif_init, tcpip_input);
+#else
     netif_add(&fsl_netif0, &fsl_netif0_ipaddr, &fsl_netif0_netmask, &fsl_netif0_gw,
               &fsl_enet_config0, ethernetif0_init, tcpip_input);
+#endif
     netif_set_default(&fsl_netif0);
     netif_set_up(&fsl_netif0);
 
@@ -137,7 +174,21 @@ static void stack_init(void *arg)
            ((u8_t *)&fsl_netif0_gw)[2], ((u8_t *)&fsl_netif0_gw)[3]);
     PRINTF("************************************************\r\n");
 
+#if EXAMPLE_TCPECHO_RAW
+    LOCK_TCPIP_CORE();
+    tcpecho_raw_init();
+    UNLOCK_TCPIP_CORE();
+#else
     tcpecho_init();
+#endif
+#if EXAMPLE_STATSSERVER
+    LOCK_TCPIP_CORE();
+    statsserver_init();
+#if configGENERATE_RUN_TIME_STATS
+    statsserver_set_app_report(runtime_stats_format);
+#endif
+    UNLOCK_TCPIP_CORE();
+#endif
 
     vTaskDelete(NULL);
 }
@@ -147,16 +198,24 @@ static void stack_init(void *arg)
  */
 int main(void)
 {
+#if !LWIP_HOST_BUILD
     SYSMPU_Type *base = SYSMPU;
     BOARD_InitPins();
     BOARD_BootClockRUN();
     BOARD_InitDebugConsole();
     /* Disable SYSMPU. */
     base->CESR &= ~SYSMPU_CESR_VLD_MASK;
+#else
+    /* Keep the console in order with the pcap when stdout is redirected. */
+    setvbuf(stdout, NULL, _IOLBF, 0);
+#endif
+    trace_recorder_init();
 
     /* Initialize lwIP from thread */
     if(sys_thread_new("main", stack_init, NULL, INIT_THREAD_STACKSIZE, INIT_THREAD_PRIO) == NULL)
         LWIP_ASSERT("main(): Task creation failed.", 0);
+    if (runtime_stats_start() != 0)
+        LWIP_ASSERT("main(): Task creation failed.", 0);
 
     vTaskStartScheduler();
 
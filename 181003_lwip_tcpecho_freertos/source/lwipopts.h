@@ -82,6 +82,31 @@
 #define LWIP_SOCKET 0
 
 #endif
+/* ---------- High-throughput TCP profile ---------- */
+/* Define TCP_HIGH_THROUGHPUT to 1 to trade about 120 KB of RAM for single
+   connection throughput. It allows a window larger than 64 KB by using window
+   scaling, and uses a larger send buffer. The receive window starts at
+   4 * TCP_MSS and is auto-tuned up to TCP_WND as the application drains the
+   data. It is halved again when the PBUF_POOL runs empty. The netconn
+   receive mailbox and the tcpip input messages are sized so that a full
+   window can be queued, otherwise the excess segments are dropped. */
+#ifndef TCP_HIGH_THROUGHPUT
+#define TCP_HIGH_THROUGHPUT 0
+#endif
+
+#if TCP_HIGH_THROUGHPUT
+#define LWIP_WND_SCALE 1
+#define TCP_RCV_SCALE 1
+#define LWIP_TCP_RCV_AUTOTUNE 1
+#define TCP_WND (48 * TCP_MSS)
+#define TCP_SND_BUF (16 * TCP_MSS)
+#define MEM_SIZE (48 * 1024)
+#define MEMP_NUM_TCP_SEG 64
+#define PBUF_POOL_SIZE 48
+#define DEFAULT_TCP_RECVMBOX_SIZE (TCP_WND / TCP_MSS + 2)
+#define MEMP_NUM_TCPIP_MSG_INPKT TCPIP_MBOX_SIZE
+#endif /* TCP_HIGH_THROUGHPUT */
+
 /* ---------- Memory options ---------- */
 /**
  * MEM_ALIGNMENT: should be set to the alignment of the CPU
@@ -154,7 +179,23 @@
 /* Controls if TCP should queue segments that arrive out of
    order. Define to 0 if your device is low on memory. */
 #ifndef TCP_QUEUE_OOSEQ
-#define TCP_QUEUE_OOSEQ 0
+#define TCP_QUEUE_OOSEQ 1
+#endif
+
+/* Out-of-order data may hold at most 3 pool pbufs per connection and 6 for
+   all connections, so that the rest of the PBUF_POOL_SIZE pool is left for
+   incoming frames. When the pool still runs empty, the 2 highest sequence
+   pbufs are evicted instead of a whole queue. */
+#ifndef TCP_OOSEQ_MAX_PBUFS
+#define TCP_OOSEQ_MAX_PBUFS 3
+#endif
+
+#ifndef TCP_OOSEQ_GLOBAL_MAX_PBUFS
+#define TCP_OOSEQ_GLOBAL_MAX_PBUFS 6
+#endif
+
+#ifndef TCP_OOSEQ_EVICT_PBUFS
+#define TCP_OOSEQ_EVICT_PBUFS 2
 #endif
 
 /* TCP Maximum segment size. */
@@ -183,6 +224,12 @@
 #define TCP_LISTEN_BACKLOG 1
 #endif
 
+/* Zero-copy sends with completion notification, lets tcpecho echo the
+   received netbufs without copying their payload. */
+#ifndef LWIP_TCP_ZEROCOPY
+#define LWIP_TCP_ZEROCOPY 1
+#endif
+
 /* ---------- ICMP options ---------- */
 #ifndef LWIP_ICMP
 #define LWIP_ICMP 1
@@ -223,22 +270,18 @@ Some MCU allow computing and verifying the IP, UDP, TCP and ICMP checksums by ha
  - To use this feature let the following define uncommented.
  - To disable it and process by CPU comment the  the checksum.
 */
-//#define CHECKSUM_BY_HARDWARE
+#if !LWIP_HOST_BUILD
+#define CHECKSUM_BY_HARDWARE
+#endif
 
 #ifdef CHECKSUM_BY_HARDWARE
-/* CHECKSUM_GEN_IP==0: Generate checksums by hardware for outgoing IP packets.*/
-#define CHECKSUM_GEN_IP 0
-/* CHECKSUM_GEN_UDP==0: Generate checksums by hardware for outgoing UDP packets.*/
-#define CHECKSUM_GEN_UDP 0
-/* CHECKSUM_GEN_TCP==0: Generate checksums by hardware for outgoing TCP packets.*/
-#define CHECKSUM_GEN_TCP 0
-/* CHECKSUM_CHECK_IP==0: Check checksums by hardware for incoming IP packets.*/
-#define CHECKSUM_CHECK_IP 0
-/* CHECKSUM_CHECK_UDP==0: Check checksums by hardware for incoming UDP packets.*/
-#define CHECKSUM_CHECK_UDP 0
-/* CHECKSUM_CHECK_TCP==0: Check checksums by hardware for incoming TCP packets.*/
-#define CHECKSUM_CHECK_TCP 0
-#else
+/* The ENET inserts and verifies IP/TCP/UDP/ICMP checksums. The software
+   checksums below stay compiled in and are switched off for the ENET netif only,
+   so loopback traffic and fragmented datagrams are still covered. */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF 1
+#define ETHERNETIF_CHECKSUM_OFFLOAD 1
+#endif
+
 /* CHECKSUM_GEN_IP==1: Generate checksums in software for outgoing IP packets.*/
 #define CHECKSUM_GEN_IP 1
 /* CHECKSUM_GEN_UDP==1: Generate checksums in software for outgoing UDP packets.*/
@@ -251,6 +294,11 @@ Some MCU allow computing and verifying the IP, UDP, TCP and ICMP checksums by ha
 #define CHECKSUM_CHECK_UDP 1
 /* CHECKSUM_CHECK_TCP==1: Check checksums in software for incoming TCP packets.*/
 #define CHECKSUM_CHECK_TCP 1
+/* LWIP_CHECKSUM_ON_COPY==1: Checksum data while it is copied into pbufs. Only
+   when checksums are computed in software: with the ENET inserting them, the
+   sum would be thrown away by the netif. */
+#ifndef CHECKSUM_BY_HARDWARE
+#define LWIP_CHECKSUM_ON_COPY 1
 #endif
 
 /**
@@ -289,8 +337,23 @@ Some MCU allow computing and verifying the IP, UDP, TCP and ICMP checksums by ha
 #define U32_F "u"
 #define S32_F "d"
 #define X32_F "x"
+#if LWIP_HOST_BUILD
+/* size_t is 64 bits wide on the host. */
+#define SZT_F "zu"
+#else
 #define SZT_F "u"
 #endif
+#endif
+
+#if LWIP_HOST_BUILD
+/**
+ * LWIP_NETIF_LOOPBACK==1: Let in-process clients of the host build reach the
+ * stack through its own address when no TAP device is available.
+ */
+#ifndef LWIP_NETIF_LOOPBACK
+#define LWIP_NETIF_LOOPBACK 1
+#endif
+#endif
 
 #define TCPIP_MBOX_SIZE 32
 #define TCPIP_THREAD_STACKSIZE 1024
@@ -315,7 +378,9 @@ Some MCU allow computing and verifying the IP, UDP, TCP and ICMP checksums by ha
  * NETCONN_TCP. The queue size value itself is platform-dependent, but is passed
  * to sys_mbox_new() when the recvmbox is created.
  */
+#ifndef DEFAULT_TCP_RECVMBOX_SIZE
 #define DEFAULT_TCP_RECVMBOX_SIZE 12
+#endif
 
 /**
  * DEFAULT_ACCEPTMBOX_SIZE: The mailbox size for the incoming connections.
@@ -68,6 +68,9 @@
 #include "fsl_debug_console_conf.h"
 #include "fsl_log.h"
 #include "fsl_str.h"
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+#include "fsl_io.h"
+#endif
 
 /*******************************************************************************
  * Definitions
@@ -179,6 +182,14 @@ status_t DbgConsole_TryGetchar(char *ch)
 }
 #endif
 
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+/* See fsl_debug_console.h for documentation of this function. */
+uint32_t DbgConsole_GetDropCount(void)
+{
+    return IO_GetDropCount();
+}
+#endif
+
 /* See fsl_debug_console.h for documentation of this function. */
 int DbgConsole_Getchar(void)
 {
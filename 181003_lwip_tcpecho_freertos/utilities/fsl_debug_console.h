@@ -194,6 +194,16 @@ status_t DbgConsole_Flush(void);
 status_t DbgConsole_TryGetchar(char *ch);
 #endif
 
+#ifdef DEBUG_CONSOLE_TRANSFER_INTERRUPT
+/*!
+ * @brief Debug console get the dropped log bytes
+ * With the DROP transmit overflow policy a log that does not fit in the transmit ring is dropped,
+ * this function tells how many bytes were lost that way since the debug console was initialized.
+ * @return Number of log bytes dropped.
+ */
+uint32_t DbgConsole_GetDropCount(void);
+#endif
+
 #endif /* SDK_DEBUGCONSOLE */
 
 /*! @} */
@@ -0,0 +1,318 @@
+/*
+ * Asynchronous logger with deferred formatting, see async_log.h.
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "async_log.h"
+
+#include <string.h>
+
+#if defined(__arm__)
+#include "fsl_device_registers.h"
+#include "fsl_debug_console.h"
+#else
+#include <stdio.h>
+#include <time.h>
+#define PRINTF printf
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if (ASYNC_LOG_RECORDS & (ASYNC_LOG_RECORDS - 1U)) != 0
+#error "ASYNC_LOG_RECORDS must be a power of two"
+#endif
+
+/* Text records carry no format, the text is stored in place of the arguments. */
+#define ASYNC_LOG_TEXT NULL
+#define ASYNC_LOG_TEXT_CHUNK (ASYNC_LOG_MAX_ARGS * sizeof(uintptr_t))
+
+/* A slot holds the record of position pos once seq == pos + 1: the consumer
+ * never sees a half written record, and a slot needs no clearing for reuse. */
+struct async_log_record
+{
+    uint32_t seq;
+    const char *fmt;
+    uintptr_t args[ASYNC_LOG_MAX_ARGS];
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static struct async_log_record s_ring[ASYNC_LOG_RECORDS];
+static uint32_t s_head; /* next position to reserve, producers */
+static uint32_t s_tail; /* next position to print, the consumer */
+static struct async_log_stats s_stats;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* Reserves n consecutive slots without a lock; a compare and swap is
+ * LDREX/STREX on the Cortex-M4, so interrupts can log too. */
+static int async_log_reserve(uint32_t n, uint32_t *pos)
+{
+    uint32_t head = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+
+    do
+    {
+        /* Signed: a stale head may lag behind a tail the drain just moved,
+         * the compare and swap then fails and the test is repeated. */
+        if ((int32_t)(head - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE) + n) > (int32_t)ASYNC_LOG_RECORDS)
+        {
+            __atomic_fetch_add(&s_stats.dropped, 1U, __ATOMIC_RELAXED);
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&s_head, &head, head + n, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    *pos = head;
+    return 1;
+}
+
+static void async_log_publish(uint32_t pos)
+{
+    __atomic_store_n(&s_ring[pos & (ASYNC_LOG_RECORDS - 1U)].seq, pos + 1U, __ATOMIC_RELEASE);
+}
+
+static void async_log_write(const char *fmt, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3)
+{
+    struct async_log_record *rec;
+    uint32_t pos;
+
+    if (!async_log_reserve(1U, &pos))
+    {
+        return;
+    }
+    rec = &s_ring[pos & (ASYNC_LOG_RECORDS - 1U)];
+    rec->fmt = fmt;
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+    rec->args[3] = a3;
+    async_log_publish(pos);
+    __atomic_fetch_add(&s_stats.written, 1U, __ATOMIC_RELAXED);
+}
+
+void async_log0(const char *fmt)
+{
+    async_log_write(fmt, 0U, 0U, 0U, 0U);
+}
+
+void async_log1(const char *fmt, uintptr_t a0)
+{
+    async_log_write(fmt, a0, 0U, 0U, 0U);
+}
+
+void async_log2(const char *fmt, uintptr_t a0, uintptr_t a1)
+{
+    async_log_write(fmt, a0, a1, 0U, 0U);
+}
+
+void async_log3(const char *fmt, uintptr_t a0, uintptr_t a1, uintptr_t a2)
+{
+    async_log_write(fmt, a0, a1, a2, 0U);
+}
+
+void async_log4(const char *fmt, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3)
+{
+    async_log_write(fmt, a0, a1, a2, a3);
+}
+
+void async_log_puts(const char *text)
+{
+    struct async_log_record *rec;
+    uint32_t len = (uint32_t)strlen(text);
+    uint32_t n;
+    uint32_t pos;
+    uint32_t i;
+
+    if (len > ASYNC_LOG_TEXT_MAX)
+    {
+        len = ASYNC_LOG_TEXT_MAX;
+    }
+    if (len == 0U)
+    {
+        return;
+    }
+    /* All chunks are reserved at once so no other record lands in between. */
+    n = (len + ASYNC_LOG_TEXT_CHUNK - 1U) / ASYNC_LOG_TEXT_CHUNK;
+    if (!async_log_reserve(n, &pos))
+    {
+        return;
+    }
+    for (i = 0U; i < n; i++)
+    {
+        rec = &s_ring[(pos + i) & (ASYNC_LOG_RECORDS - 1U)];
+        rec->fmt = ASYNC_LOG_TEXT;
+        memset(rec->args, 0, sizeof(rec->args));
+        memcpy(rec->args, text + i * ASYNC_LOG_TEXT_CHUNK,
+               (len - i * ASYNC_LOG_TEXT_CHUNK < ASYNC_LOG_TEXT_CHUNK) ? len - i * ASYNC_LOG_TEXT_CHUNK :
+                                                                          ASYNC_LOG_TEXT_CHUNK);
+        async_log_publish(pos + i);
+    }
+    __atomic_fetch_add(&s_stats.written, n, __ATOMIC_RELAXED);
+}
+
+uint32_t async_log_drain(void)
+{
+    struct async_log_record *slot;
+    struct async_log_record rec;
+    char text[ASYNC_LOG_TEXT_CHUNK + 1U];
+    uint32_t tail = s_tail;
+    uint32_t fill;
+    uint32_t count = 0U;
+
+    fill = __atomic_load_n(&s_head, __ATOMIC_RELAXED) - tail;
+    if (fill > s_stats.max_fill)
+    {
+        s_stats.max_fill = fill;
+    }
+
+    for (;;)
+    {
+        slot = &s_ring[tail & (ASYNC_LOG_RECORDS - 1U)];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1U)
+        {
+            /* Empty, or the next producer has not finished its record yet. */
+            break;
+        }
+        memcpy(&rec, slot, sizeof(rec));
+        /* Hand the slot back before the slow part. */
+        tail++;
+        __atomic_store_n(&s_tail, tail, __ATOMIC_RELEASE);
+
+        if (rec.fmt == ASYNC_LOG_TEXT)
+        {
+            memcpy(text, rec.args, ASYNC_LOG_TEXT_CHUNK);
+            text[ASYNC_LOG_TEXT_CHUNK] = '\0';
+            PRINTF("%s", text);
+        }
+        else
+        {
+            PRINTF(rec.fmt, rec.args[0], rec.args[1], rec.args[2], rec.args[3]);
+        }
+        count++;
+    }
+    s_stats.drained += count;
+    return count;
+}
+
+static void async_log_task(void *arg)
+{
+    TickType_t wake = xTaskGetTickCount();
+
+    (void)arg;
+
+    for (;;)
+    {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(ASYNC_LOG_DRAIN_MS));
+        async_log_drain();
+    }
+}
+
+int async_log_start(void)
+{
+    if (xTaskCreate(async_log_task, "log", ASYNC_LOG_TASK_STACK, NULL, ASYNC_LOG_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+void async_log_get_stats(struct async_log_stats *stats)
+{
+    stats->written = __atomic_load_n(&s_stats.written, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&s_stats.dropped, __ATOMIC_RELAXED);
+    stats->drained = s_stats.drained;
+    stats->max_fill = s_stats.max_fill;
+}
+
+#if ASYNC_LOG_BENCHMARK
+
+#define ASYNC_LOG_BENCH_CALLS 32U
+#define ASYNC_LOG_BENCH_PRINTS 4U
+#define ASYNC_LOG_BENCH_FMT "\rlog bench %i: %s\n"
+
+#if defined(__arm__)
+#define ASYNC_LOG_CYCLES() (DWT->CYCCNT)
+#define ASYNC_LOG_HZ() (SystemCoreClock)
+#else
+static uint32_t async_log_host_cycles(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#define ASYNC_LOG_CYCLES() async_log_host_cycles()
+#define ASYNC_LOG_HZ() (1000000000UL)
+#endif
+
+static uint32_t async_log_per_s(uint32_t count, uint32_t cycles)
+{
+    return (cycles != 0U) ? (uint32_t)(((uint64_t)count * ASYNC_LOG_HZ()) / cycles) : 0U;
+}
+
+void async_log_benchmark(void)
+{
+    static const char text[] = "benchmark line";
+    uint32_t log_min = UINT32_MAX;
+    uint32_t log_total = 0U;
+    uint32_t print_min = UINT32_MAX;
+    uint32_t print_total = 0U;
+    uint32_t drain;
+    uint32_t start;
+    uint32_t t;
+    uint32_t i;
+
+#if defined(__arm__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    /* Caller side: only the record is written, the ring is then dropped. */
+    for (i = 0U; i < ASYNC_LOG_BENCH_CALLS; i++)
+    {
+        start = ASYNC_LOG_CYCLES();
+        ASYNC_LOG(ASYNC_LOG_BENCH_FMT, i, ASYNC_LOG_STR(text));
+        t = ASYNC_LOG_CYCLES() - start;
+        log_total += t;
+        log_min = (t < log_min) ? t : log_min;
+    }
+    s_tail = s_head;
+
+    /* The blocking path: formatting and UART_WriteBlocking in the caller. */
+    for (i = 0U; i < ASYNC_LOG_BENCH_PRINTS; i++)
+    {
+        start = ASYNC_LOG_CYCLES();
+        PRINTF(ASYNC_LOG_BENCH_FMT, i, text);
+        t = ASYNC_LOG_CYCLES() - start;
+        print_total += t;
+        print_min = (t < print_min) ? t : print_min;
+    }
+
+    /* Sustained rate: a full ring printed by the drain. */
+    for (i = 0U; i < ASYNC_LOG_RECORDS; i++)
+    {
+        ASYNC_LOG(ASYNC_LOG_BENCH_FMT, i, ASYNC_LOG_STR(text));
+    }
+    start = ASYNC_LOG_CYCLES();
+    i = async_log_drain();
+    drain = ASYNC_LOG_CYCLES() - start;
+
+    PRINTF("\rASYNC_LOG: %u cycles per call (min %u), up to %u calls/s, burst of %u records\n",
+           (unsigned)(log_total / ASYNC_LOG_BENCH_CALLS), (unsigned)log_min,
+           (unsigned)async_log_per_s(1U, log_min), (unsigned)ASYNC_LOG_RECORDS);
+    PRINTF("\rPRINTF: %u cycles per call (min %u), %u lines/s\n", (unsigned)(print_total / ASYNC_LOG_BENCH_PRINTS),
+           (unsigned)print_min, (unsigned)async_log_per_s(ASYNC_LOG_BENCH_PRINTS, print_total));
+    PRINTF("\rdrain: %u lines/s sustained\n", (unsigned)async_log_per_s(i, drain));
+}
+
+#endif /* ASYNC_LOG_BENCHMARK */
@@ -0,0 +1,125 @@
+/*
+ * Asynchronous logger with deferred formatting.
+ *
+ * ASYNC_LOG() does not format anything: it stores the format string pointer
+ * and up to ASYNC_LOG_MAX_ARGS raw arguments in a fixed size record of a
+ * lock-free ring and returns. A low priority drain task formats the records
+ * with PRINTF and so is the only writer of the debug console; callers never
+ * wait for the UART and need no serial port mutex. Tasks and interrupts may
+ * log concurrently. When the ring is full the record is dropped and counted.
+ *
+ * Since formatting happens later, the format string and every %s argument
+ * must stay valid and unchanged until the record is drained: use literals
+ * and constant strings. Text that changes, like a shared buffer, is copied
+ * into the ring with async_log_puts().
+ */
+
+#ifndef _ASYNC_LOG_H_
+#define _ASYNC_LOG_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Records in the ring, a power of two. */
+#ifndef ASYNC_LOG_RECORDS
+#define ASYNC_LOG_RECORDS 64U
+#endif
+
+/*! @brief Longest text accepted by async_log_puts(), longer text is cut. */
+#ifndef ASYNC_LOG_TEXT_MAX
+#define ASYNC_LOG_TEXT_MAX 64U
+#endif
+
+/*! @brief Period in which the drain task empties the ring. */
+#ifndef ASYNC_LOG_DRAIN_MS
+#define ASYNC_LOG_DRAIN_MS 10U
+#endif
+
+#ifndef ASYNC_LOG_TASK_PRIORITY
+#define ASYNC_LOG_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#endif
+
+#ifndef ASYNC_LOG_TASK_STACK
+#define ASYNC_LOG_TASK_STACK (configMINIMAL_STACK_SIZE + 110)
+#endif
+
+/*! @brief 1 to compare ASYNC_LOG() with PRINTF from async_log_benchmark(). */
+#ifndef ASYNC_LOG_BENCHMARK
+#define ASYNC_LOG_BENCHMARK 0
+#endif
+
+#define ASYNC_LOG_MAX_ARGS 4U
+
+/*! @brief Passes a constant string for a %s conversion. */
+#define ASYNC_LOG_STR(s) ((uintptr_t)(const char *)(s))
+
+/*!
+ * @brief Logs a printf style message with up to four int, unsigned, char or
+ * ASYNC_LOG_STR() arguments.
+ */
+#define ASYNC_LOG(...) \
+    ASYNC_LOG_SELECT(__VA_ARGS__, async_log4, async_log3, async_log2, async_log1, async_log0, _)(__VA_ARGS__)
+#define ASYNC_LOG_SELECT(_0, _1, _2, _3, _4, name, ...) name
+
+struct async_log_stats
+{
+    uint32_t written;   /* records stored */
+    uint32_t dropped;   /* records lost to a full ring */
+    uint32_t drained;   /* records printed */
+    uint32_t max_fill;  /* most records waiting, seen by the drain */
+};
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void async_log0(const char *fmt);
+void async_log1(const char *fmt, uintptr_t a0);
+void async_log2(const char *fmt, uintptr_t a0, uintptr_t a1);
+void async_log3(const char *fmt, uintptr_t a0, uintptr_t a1, uintptr_t a2);
+void async_log4(const char *fmt, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3);
+
+/*! @brief Copies text into the ring, it is printed as is. */
+void async_log_puts(const char *text);
+
+/*!
+ * @brief Prints every record published so far, from a single consumer.
+ *
+ * The drain task calls it; before the scheduler starts main() may call it.
+ *
+ * @return Number of records printed.
+ */
+uint32_t async_log_drain(void);
+
+/*!
+ * @brief Creates the drain task.
+ *
+ * @return 0 on success, -1 if the task could not be created.
+ */
+int async_log_start(void);
+
+void async_log_get_stats(struct async_log_stats *stats);
+
+#if ASYNC_LOG_BENCHMARK
+/*!
+ * @brief Measures the caller side cost of ASYNC_LOG() and PRINTF and the
+ * lines per second the drain and PRINTF sustain, and prints the result.
+ *
+ * Call from main() after the debug console is up and before the scheduler
+ * starts: it empties the ring behind the back of the drain task.
+ */
+void async_log_benchmark(void);
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _ASYNC_LOG_H_ */
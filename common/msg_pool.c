@@ -0,0 +1,327 @@
+/*
+ * Fixed-block message pool, see msg_pool.h.
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "msg_pool.h"
+
+#include <string.h>
+
+#if MSG_POOL_BENCHMARK
+#if defined(__arm__)
+#include "fsl_device_registers.h"
+#include "fsl_debug_console.h"
+#else
+#include <stdio.h>
+#include <time.h>
+#define PRINTF printf
+#endif
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* The free list head packs the first free block number in the low half and a
+ * tag in the high half. Every change bumps the tag, so a compare and swap
+ * based on a head read before another context popped and pushed the same
+ * block back fails instead of linking a block that is in use (ABA). */
+#define MSG_POOL_INDEX_MASK 0xFFFFU
+#define MSG_POOL_TAG_ONE 0x10000U
+#define MSG_POOL_NONE 0xFFFFU
+
+#define MSG_POOL_ALIGN(x) (((x) + portBYTE_ALIGNMENT_MASK) & ~(size_t)portBYTE_ALIGNMENT_MASK)
+
+struct msg_pool
+{
+    uint32_t head;     /* tag and first free block */
+    uint32_t waiters;  /* tasks waiting in msg_pool_alloc() */
+    uint32_t stride;   /* bytes from one block to the next */
+    uint16_t blocks;
+    uint8_t *base;     /* first block */
+    uint16_t *next;    /* next free block of each free block */
+    SemaphoreHandle_t freed; /* given on a release while a task waits */
+    struct msg_pool_stats stats;
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+msg_pool_t *msg_pool_create(uint16_t blocks, size_t block_size)
+{
+    msg_pool_t *pool;
+    size_t stride = MSG_POOL_ALIGN(block_size);
+    size_t header = MSG_POOL_ALIGN(sizeof(struct msg_pool));
+    uint16_t i;
+
+    configASSERT((blocks > 0U) && (blocks <= MSG_POOL_MAX_BLOCKS) && (block_size > 0U));
+
+    /* Header, blocks and free links in one allocation; pvPortMalloc()
+     * returns portBYTE_ALIGNMENT aligned memory, so every block is too. */
+    pool = pvPortMalloc(header + (size_t)blocks * stride + (size_t)blocks * sizeof(uint16_t));
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+    pool->freed = xSemaphoreCreateCounting(blocks, 0U);
+    if (pool->freed == NULL)
+    {
+        vPortFree(pool);
+        return NULL;
+    }
+    pool->base = (uint8_t *)pool + header;
+    pool->next = (uint16_t *)(pool->base + (size_t)blocks * stride);
+    pool->stride = (uint32_t)stride;
+    pool->blocks = blocks;
+    pool->waiters = 0U;
+    for (i = 0U; i < blocks; i++)
+    {
+        pool->next[i] = (uint16_t)(i + 1U);
+    }
+    pool->next[blocks - 1U] = MSG_POOL_NONE;
+    pool->head = 0U;
+
+    memset(&pool->stats, 0, sizeof(pool->stats));
+    pool->stats.blocks = blocks;
+    pool->stats.block_size = (uint32_t)stride;
+    return pool;
+}
+
+/* Pops the first free block without a lock; a compare and swap is
+ * LDREX/STREX on the Cortex-M4, so interrupts can allocate too. */
+static void *msg_pool_pop(msg_pool_t *pool)
+{
+    uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+    uint32_t index;
+    uint32_t next;
+    uint32_t used;
+    uint32_t max;
+
+    do
+    {
+        index = head & MSG_POOL_INDEX_MASK;
+        if (index == MSG_POOL_NONE)
+        {
+            return NULL;
+        }
+        /* May read the link of a block another context just took, the tag
+         * then makes the compare and swap fail. */
+        next = ((head + MSG_POOL_TAG_ONE) & ~MSG_POOL_INDEX_MASK) |
+               __atomic_load_n(&pool->next[index], __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, next, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    used = __atomic_add_fetch(&pool->stats.used, 1U, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&pool->stats.max_used, __ATOMIC_RELAXED);
+    while ((used > max) &&
+           !__atomic_compare_exchange_n(&pool->stats.max_used, &max, used, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+    return pool->base + index * pool->stride;
+}
+
+static void msg_pool_push(msg_pool_t *pool, void *block)
+{
+    uint32_t offset = (uint32_t)((uint8_t *)block - pool->base);
+    uint32_t index = offset / pool->stride;
+    uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+
+    configASSERT(((uint8_t *)block >= pool->base) && (index < pool->blocks) && ((offset % pool->stride) == 0U));
+
+    __atomic_fetch_sub(&pool->stats.used, 1U, __ATOMIC_RELAXED);
+    do
+    {
+        __atomic_store_n(&pool->next[index], (uint16_t)(head & MSG_POOL_INDEX_MASK), __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, ((head + MSG_POOL_TAG_ONE) & ~MSG_POOL_INDEX_MASK) | index,
+                                          1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+}
+
+void *msg_pool_alloc(msg_pool_t *pool, TickType_t wait)
+{
+    TimeOut_t timeout;
+    void *block = msg_pool_pop(pool);
+
+    if ((block == NULL) && (wait != 0U))
+    {
+        __atomic_fetch_add(&pool->stats.waits, 1U, __ATOMIC_RELAXED);
+        vTaskSetTimeOutState(&timeout);
+        /* Announced before the pop that follows: a release either finds the
+         * waiter and gives the semaphore, or it happened before the pop. */
+        __atomic_fetch_add(&pool->waiters, 1U, __ATOMIC_SEQ_CST);
+        for (;;)
+        {
+            block = msg_pool_pop(pool);
+            if ((block != NULL) || (xTaskCheckForTimeOut(&timeout, &wait) != pdFALSE))
+            {
+                break;
+            }
+            /* A give can be left over from a block another task got first,
+             * the loop then pops again and goes back to waiting. */
+            (void)xSemaphoreTake(pool->freed, wait);
+        }
+        __atomic_fetch_sub(&pool->waiters, 1U, __ATOMIC_SEQ_CST);
+    }
+    if (block == NULL)
+    {
+        __atomic_fetch_add(&pool->stats.failed, 1U, __ATOMIC_RELAXED);
+    }
+    return block;
+}
+
+void *msg_pool_alloc_from_isr(msg_pool_t *pool)
+{
+    void *block = msg_pool_pop(pool);
+
+    if (block == NULL)
+    {
+        __atomic_fetch_add(&pool->stats.failed, 1U, __ATOMIC_RELAXED);
+    }
+    return block;
+}
+
+void msg_pool_free(msg_pool_t *pool, void *block)
+{
+    msg_pool_push(pool, block);
+    if (__atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) != 0U)
+    {
+        (void)xSemaphoreGive(pool->freed);
+    }
+}
+
+void msg_pool_free_from_isr(msg_pool_t *pool, void *block, BaseType_t *woken)
+{
+    msg_pool_push(pool, block);
+    if (__atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) != 0U)
+    {
+        (void)xSemaphoreGiveFromISR(pool->freed, woken);
+    }
+}
+
+BaseType_t msg_pool_send(msg_pool_t *pool, QueueHandle_t queue, void *block, TickType_t wait)
+{
+    if (xQueueSend(queue, &block, wait) != pdPASS)
+    {
+        msg_pool_free(pool, block);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+void msg_pool_get_stats(const msg_pool_t *pool, struct msg_pool_stats *stats)
+{
+    stats->blocks = pool->stats.blocks;
+    stats->block_size = pool->stats.block_size;
+    stats->used = __atomic_load_n(&pool->stats.used, __ATOMIC_RELAXED);
+    stats->max_used = __atomic_load_n(&pool->stats.max_used, __ATOMIC_RELAXED);
+    stats->waits = __atomic_load_n(&pool->stats.waits, __ATOMIC_RELAXED);
+    stats->failed = __atomic_load_n(&pool->stats.failed, __ATOMIC_RELAXED);
+}
+
+#if MSG_POOL_BENCHMARK
+
+#define MSG_POOL_BENCH_MSGS 256U
+#define MSG_POOL_BENCH_SIZE 8U
+
+#if defined(__arm__)
+#define MSG_POOL_CYCLES() (DWT->CYCCNT)
+#define MSG_POOL_HZ() (SystemCoreClock)
+#else
+static uint32_t msg_pool_host_cycles(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#define MSG_POOL_CYCLES() msg_pool_host_cycles()
+#define MSG_POOL_HZ() (1000000000UL)
+#endif
+
+static uint32_t msg_pool_per_s(uint32_t count, uint32_t cycles)
+{
+    return (cycles != 0U) ? (uint32_t)(((uint64_t)count * MSG_POOL_HZ()) / cycles) : 0U;
+}
+
+void msg_pool_benchmark(void)
+{
+    msg_pool_t *pool = msg_pool_create(1U, MSG_POOL_BENCH_SIZE);
+    QueueHandle_t queue = xQueueCreate(1U, sizeof(void *));
+    uint32_t heap_alloc;
+    uint32_t heap_queue;
+    uint32_t pool_alloc;
+    uint32_t pool_queue;
+    uint32_t start;
+    void *block;
+    uint32_t i;
+
+    if ((pool == NULL) || (queue == NULL))
+    {
+        PRINTF("\rmsg_pool benchmark: out of heap\n");
+        return;
+    }
+
+#if defined(__arm__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    /* Allocation and release alone. */
+    start = MSG_POOL_CYCLES();
+    for (i = 0U; i < MSG_POOL_BENCH_MSGS; i++)
+    {
+        block = pvPortMalloc(MSG_POOL_BENCH_SIZE);
+        vPortFree(block);
+    }
+    heap_alloc = MSG_POOL_CYCLES() - start;
+
+    start = MSG_POOL_CYCLES();
+    for (i = 0U; i < MSG_POOL_BENCH_MSGS; i++)
+    {
+        block = msg_pool_alloc(pool, 0U);
+        msg_pool_free(pool, block);
+    }
+    pool_alloc = MSG_POOL_CYCLES() - start;
+
+    /* The whole message path: fill, queue by reference, receive, release. */
+    start = MSG_POOL_CYCLES();
+    for (i = 0U; i < MSG_POOL_BENCH_MSGS; i++)
+    {
+        block = pvPortMalloc(MSG_POOL_BENCH_SIZE);
+        memset(block, (int)i, MSG_POOL_BENCH_SIZE);
+        (void)xQueueSend(queue, &block, 0U);
+        (void)xQueueReceive(queue, &block, 0U);
+        vPortFree(block);
+    }
+    heap_queue = MSG_POOL_CYCLES() - start;
+
+    start = MSG_POOL_CYCLES();
+    for (i = 0U; i < MSG_POOL_BENCH_MSGS; i++)
+    {
+        block = msg_pool_alloc(pool, 0U);
+        memset(block, (int)i, MSG_POOL_BENCH_SIZE);
+        (void)msg_pool_send(pool, queue, block, 0U);
+        (void)xQueueReceive(queue, &block, 0U);
+        msg_pool_free(pool, block);
+    }
+    pool_queue = MSG_POOL_CYCLES() - start;
+
+    vQueueDelete(queue);
+    vSemaphoreDelete(pool->freed);
+    vPortFree(pool);
+
+    PRINTF("\rpvPortMalloc: %u cycles per alloc+free, %u cycles per message, %u msgs/s\n",
+           (unsigned)(heap_alloc / MSG_POOL_BENCH_MSGS), (unsigned)(heap_queue / MSG_POOL_BENCH_MSGS),
+           (unsigned)msg_pool_per_s(MSG_POOL_BENCH_MSGS, heap_queue));
+    PRINTF("\rmsg_pool: %u cycles per alloc+free, %u cycles per message, %u msgs/s\n",
+           (unsigned)(pool_alloc / MSG_POOL_BENCH_MSGS), (unsigned)(pool_queue / MSG_POOL_BENCH_MSGS),
+           (unsigned)msg_pool_per_s(MSG_POOL_BENCH_MSGS, pool_queue));
+}
+
+#endif /* MSG_POOL_BENCHMARK */
@@ -0,0 +1,109 @@
+/*
+ * Fixed-block message pool.
+ *
+ * A pool hands out blocks of one size carved from a single allocation made
+ * at creation. Allocation and release pop and push a lock-free free list, a
+ * compare and swap on a tagged head, so both take constant time, may run in
+ * interrupts and never suspend the scheduler the way pvPortMalloc() and
+ * vPortFree() do. A task may wait for a block with a timeout.
+ *
+ * Blocks are meant to travel through a queue of block pointers: the
+ * producer fills a block and sends it by reference with msg_pool_send(),
+ * the consumer takes it with xQueueReceive() and releases it with
+ * msg_pool_free() once it is done with it.
+ */
+
+#ifndef _MSG_POOL_H_
+#define _MSG_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Most blocks a pool can hold, block numbers are 16 bits wide. */
+#define MSG_POOL_MAX_BLOCKS 0xFFFEU
+
+/*! @brief 1 to compare the pool with pvPortMalloc() from msg_pool_benchmark(). */
+#ifndef MSG_POOL_BENCHMARK
+#define MSG_POOL_BENCHMARK 0
+#endif
+
+typedef struct msg_pool msg_pool_t;
+
+struct msg_pool_stats
+{
+    uint32_t blocks;     /* blocks in the pool */
+    uint32_t block_size; /* bytes per block, rounded up to portBYTE_ALIGNMENT */
+    uint32_t used;       /* blocks allocated now */
+    uint32_t max_used;   /* high-water mark of used */
+    uint32_t waits;      /* allocations that found the pool empty and waited */
+    uint32_t failed;     /* allocations that returned NULL */
+};
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Creates a pool of blocks blocks of block_size bytes.
+ *
+ * The pool is allocated once with pvPortMalloc() and never freed.
+ *
+ * @return The pool, or NULL if there is not enough heap.
+ */
+msg_pool_t *msg_pool_create(uint16_t blocks, size_t block_size);
+
+/*!
+ * @brief Allocates a block from a task.
+ *
+ * @param wait Ticks to wait for a block to be freed when the pool is empty.
+ * @return The block, or NULL if none was freed in time.
+ */
+void *msg_pool_alloc(msg_pool_t *pool, TickType_t wait);
+
+/*! @brief Allocates a block from an interrupt, never waits. */
+void *msg_pool_alloc_from_isr(msg_pool_t *pool);
+
+/*! @brief Releases a block from a task, waking a task waiting for one. */
+void msg_pool_free(msg_pool_t *pool, void *block);
+
+/*! @brief Releases a block from an interrupt. */
+void msg_pool_free_from_isr(msg_pool_t *pool, void *block, BaseType_t *woken);
+
+/*!
+ * @brief Sends a block by reference to a queue of block pointers.
+ *
+ * If the queue stays full for wait ticks the block goes back to the pool.
+ *
+ * @return pdPASS if the block was queued, the consumer then owns it.
+ */
+BaseType_t msg_pool_send(msg_pool_t *pool, QueueHandle_t queue, void *block, TickType_t wait);
+
+void msg_pool_get_stats(const msg_pool_t *pool, struct msg_pool_stats *stats);
+
+#if MSG_POOL_BENCHMARK
+/*!
+ * @brief Passes messages through a queue with pool blocks and with
+ * pvPortMalloc()/vPortFree() and prints the cycles per message of both.
+ *
+ * Call from main() after the debug console is up and before the scheduler
+ * starts.
+ */
+void msg_pool_benchmark(void);
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _MSG_POOL_H_ */
@@ -0,0 +1,303 @@
+/*
+ * Per-task CPU accounting on a cycle counter, see runtime_stats.h.
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if configGENERATE_RUN_TIME_STATS
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__arm__)
+#include "fsl_device_registers.h"
+#include "fsl_debug_console.h"
+#else
+#include <time.h>
+#define PRINTF printf
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if (RUNTIME_STATS_MAX_TASKS & (RUNTIME_STATS_MAX_TASKS - 1U)) != 0
+#error "RUNTIME_STATS_MAX_TASKS must be a power of two"
+#endif
+
+#if !configUSE_TRACE_FACILITY
+#error "runtime_stats needs configUSE_TRACE_FACILITY for the task numbers"
+#endif
+
+#if defined(__arm__)
+#define RUNTIME_STATS_HZ() (SystemCoreClock)
+#else
+#define RUNTIME_STATS_HZ() (1000000000UL)
+#endif
+
+#define RUNTIME_STATS_CALIBRATE_RUNS 8U
+
+/* Counters of the previous sample, by slot of the task number. */
+struct runtime_stats_prev
+{
+    uint32_t number;
+    uint32_t run_time;
+    uint32_t switches;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+volatile uint32_t runtime_stats_switches[RUNTIME_STATS_MAX_TASKS];
+volatile uint32_t runtime_stats_isr_nesting;
+volatile uint32_t runtime_stats_isr_start;
+volatile uint32_t runtime_stats_isr_ticks;
+
+static struct runtime_stats_snapshot s_snapshot;
+static struct runtime_stats_snapshot s_work;
+static struct runtime_stats_prev s_prev[RUNTIME_STATS_MAX_TASKS];
+static TaskStatus_t s_status[RUNTIME_STATS_MAX_TASKS];
+static uint32_t s_switch_cost;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+#if !defined(__arm__)
+uint32_t runtime_stats_host_counter(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#endif
+
+#if defined(__arm__)
+extern void xPortSysTickHandler(void);
+
+/* The tick is the one interrupt every application has: account it here
+ * instead of mapping xPortSysTickHandler straight to the vector. */
+void SysTick_Handler(void)
+{
+    RUNTIME_STATS_ISR_ENTER();
+    xPortSysTickHandler();
+    RUNTIME_STATS_ISR_EXIT();
+}
+#endif
+
+/* Measures what configGENERATE_RUN_TIME_STATS and the switch out hook add to
+ * vTaskSwitchContext(): the hook's counter read, run time charge and switch
+ * count, then the kernel's own counter read and compare, less the cost of the
+ * measurement itself. */
+static uint32_t runtime_stats_measure_switch_cost(void)
+{
+    volatile uint32_t run_time = 0U;
+    volatile uint32_t switched_in = 0U;
+    uint32_t best = UINT32_MAX;
+    uint32_t empty = UINT32_MAX;
+    uint32_t start;
+    uint32_t now;
+    uint32_t i;
+
+    for (i = 0U; i < RUNTIME_STATS_CALIBRATE_RUNS; i++)
+    {
+        start = RUNTIME_STATS_COUNTER();
+        now = RUNTIME_STATS_COUNTER() - start;
+        if (now < empty)
+        {
+            empty = now;
+        }
+
+        start = RUNTIME_STATS_COUNTER();
+        RUNTIME_STATS_SWITCHED_OUT(0U);
+        RUNTIME_STATS_CHARGE(run_time, switched_in);
+        now = RUNTIME_STATS_COUNTER();
+        if (now > switched_in)
+        {
+            run_time += now - switched_in;
+        }
+        switched_in = now;
+        now = RUNTIME_STATS_COUNTER() - start;
+        if (now < best)
+        {
+            best = now;
+        }
+    }
+    /* Task number 0 is never handed out, its slot only served the test. */
+    runtime_stats_switches[0] = 0U;
+    return (best > empty) ? best - empty : 0U;
+}
+
+void runtime_stats_counter_init(void)
+{
+#if defined(__arm__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    s_switch_cost = runtime_stats_measure_switch_cost();
+}
+
+static uint32_t runtime_stats_per_s(uint32_t count, uint32_t window, uint32_t hz)
+{
+    return (window != 0U) ? (uint32_t)(((uint64_t)count * hz) / window) : 0U;
+}
+
+static uint16_t runtime_stats_share(uint64_t ticks, uint32_t window)
+{
+    uint64_t share;
+
+    if (window == 0U)
+    {
+        return 0U;
+    }
+    share = (ticks * 10000U) / window;
+    return (share > 10000U) ? 10000U : (uint16_t)share;
+}
+
+static void runtime_stats_sample(uint32_t window)
+{
+    struct runtime_stats_snapshot *snap = &s_work;
+    struct runtime_stats_task *task;
+    struct runtime_stats_prev *prev;
+    UBaseType_t n;
+    UBaseType_t i;
+    uint32_t slot;
+    uint32_t switches;
+    uint32_t total_switches = 0U;
+    uint32_t isr;
+    uint32_t start = RUNTIME_STATS_COUNTER();
+    static uint32_t prev_isr;
+
+    n = uxTaskGetSystemState(s_status, RUNTIME_STATS_MAX_TASKS, NULL);
+    isr = runtime_stats_isr_ticks;
+
+    snap->hz = RUNTIME_STATS_HZ();
+    snap->window = window;
+    snap->ntasks = (uint16_t)n;
+    for (i = 0U; i < n; i++)
+    {
+        task = &snap->task[i];
+        slot = s_status[i].xTaskNumber & (RUNTIME_STATS_MAX_TASKS - 1U);
+        prev = &s_prev[slot];
+        if (prev->number != s_status[i].xTaskNumber)
+        {
+            /* First sample of this task: its counters started at zero. */
+            prev->number = s_status[i].xTaskNumber;
+            prev->run_time = 0U;
+            prev->switches = 0U;
+        }
+        switches = runtime_stats_switches[slot];
+
+        strncpy(task->name, s_status[i].pcTaskName, RUNTIME_STATS_NAME_LEN);
+        task->name[RUNTIME_STATS_NAME_LEN - 1U] = '\0';
+        task->number = s_status[i].xTaskNumber;
+        task->cycles = s_status[i].ulRunTimeCounter - prev->run_time;
+        task->cpu = runtime_stats_share(task->cycles, window);
+        task->switches_per_s = runtime_stats_per_s(switches - prev->switches, window, snap->hz);
+        task->stack_free = s_status[i].usStackHighWaterMark;
+        total_switches += switches - prev->switches;
+
+        prev->run_time = s_status[i].ulRunTimeCounter;
+        prev->switches = switches;
+    }
+    snap->switches_per_s = runtime_stats_per_s(total_switches, window, snap->hz);
+    snap->isr = runtime_stats_share(isr - prev_isr, window);
+    prev_isr = isr;
+    snap->switch_cost = s_switch_cost;
+    snap->switch_share = runtime_stats_share((uint64_t)s_switch_cost * total_switches, window);
+    snap->seq++;
+    snap->sample_cost = RUNTIME_STATS_COUNTER() - start;
+
+    taskENTER_CRITICAL();
+    memcpy(&s_snapshot, snap, sizeof(s_snapshot));
+    taskEXIT_CRITICAL();
+}
+
+static void runtime_stats_task(void *arg)
+{
+#if RUNTIME_STATS_CONSOLE
+    static char buf[RUNTIME_STATS_MAX_TASKS * 48U + 160U];
+#endif
+    TickType_t wake = xTaskGetTickCount();
+    uint32_t last = RUNTIME_STATS_COUNTER();
+    uint32_t now;
+
+    (void)arg;
+
+    for (;;)
+    {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(RUNTIME_STATS_PERIOD_MS));
+        now = RUNTIME_STATS_COUNTER();
+        runtime_stats_sample(now - last);
+        last = now;
+#if RUNTIME_STATS_CONSOLE
+        runtime_stats_format(buf, sizeof(buf));
+        PRINTF("%s", buf);
+#endif
+    }
+}
+
+int runtime_stats_start(void)
+{
+    if (xTaskCreate(runtime_stats_task, "rtstats", RUNTIME_STATS_TASK_STACK, NULL, RUNTIME_STATS_TASK_PRIORITY,
+                    NULL) != pdPASS)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+void runtime_stats_get(struct runtime_stats_snapshot *snap)
+{
+    taskENTER_CRITICAL();
+    memcpy(snap, &s_snapshot, sizeof(*snap));
+    taskEXIT_CRITICAL();
+}
+
+int runtime_stats_format(char *buf, size_t size)
+{
+    static struct runtime_stats_snapshot snap;
+    size_t len = 0U;
+    int n;
+    uint32_t i;
+
+#define RUNTIME_STATS_APPEND(...)                               \
+    do                                                          \
+    {                                                           \
+        if (len < size)                                         \
+        {                                                       \
+            n = snprintf(buf + len, size - len, __VA_ARGS__);   \
+            len = (n < 0) ? size : len + (size_t)n;             \
+        }                                                       \
+    } while (0)
+
+    if (size == 0U)
+    {
+        return 0;
+    }
+    buf[0] = '\0';
+    runtime_stats_get(&snap);
+    RUNTIME_STATS_APPEND("cpu sample %lu: window %lu ticks at %lu Hz, %lu switches/s, isr %u.%02u%%, "
+                         "switch cost %lu ticks (%u.%02u%%), sample cost %lu ticks\n",
+                         (unsigned long)snap.seq, (unsigned long)snap.window, (unsigned long)snap.hz,
+                         (unsigned long)snap.switches_per_s, snap.isr / 100U, snap.isr % 100U,
+                         (unsigned long)snap.switch_cost, snap.switch_share / 100U, snap.switch_share % 100U,
+                         (unsigned long)snap.sample_cost);
+    for (i = 0U; i < snap.ntasks; i++)
+    {
+        RUNTIME_STATS_APPEND("%-*s %3u.%02u%% %6lu sw/s stack %u\n", (int)RUNTIME_STATS_NAME_LEN,
+                             snap.task[i].name, snap.task[i].cpu / 100U, snap.task[i].cpu % 100U,
+                             (unsigned long)snap.task[i].switches_per_s, snap.task[i].stack_free);
+    }
+#undef RUNTIME_STATS_APPEND
+
+    return (int)((len < size) ? len : size - 1U);
+}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
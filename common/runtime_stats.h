@@ -0,0 +1,223 @@
+/*
+ * Per-task CPU accounting on a cycle counter.
+ *
+ * With configGENERATE_RUN_TIME_STATS the kernel charges the time between two
+ * context switches to the task switched out. The run time counter is the DWT
+ * cycle counter on the target and the monotonic clock in nanoseconds on a
+ * host build, both 32 bits wide. The kernel drops the slice in which the
+ * counter wrapped, so the switch out hook charges the task first; from there
+ * on only differences are used, which stay right across a wrap as long as a
+ * task runs and the sampling period are shorter than one wrap (35 s at
+ * 120 MHz).
+ *
+ * A sampler task turns the counters into a snapshot every
+ * RUNTIME_STATS_PERIOD_MS: CPU share and context switches per second of every
+ * task, the share spent in instrumented interrupt handlers and the cost of the
+ * accounting itself. runtime_stats_get() and runtime_stats_format() read it.
+ *
+ * The accounting is off unless the application's FreeRTOSConfig.h sets
+ * configGENERATE_RUN_TIME_STATS to 1. This header is shared by all projects and
+ * included at the end of their FreeRTOSConfig.h, so it must not depend on any
+ * FreeRTOS type.
+ */
+
+#ifndef _RUNTIME_STATS_H_
+#define _RUNTIME_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Sampling period of the sampler task. */
+#ifndef RUNTIME_STATS_PERIOD_MS
+#define RUNTIME_STATS_PERIOD_MS 1000U
+#endif
+
+/*! @brief Tasks in a snapshot, a power of two: switches are counted per task
+ * number modulo this value. */
+#ifndef RUNTIME_STATS_MAX_TASKS
+#define RUNTIME_STATS_MAX_TASKS 16U
+#endif
+
+/*! @brief Priority of the sampler task. It runs just above idle so it never
+ * preempts the application; a late sample only covers a longer window. */
+#ifndef RUNTIME_STATS_TASK_PRIORITY
+#define RUNTIME_STATS_TASK_PRIORITY (tskIDLE_PRIORITY + 1U)
+#endif
+
+#ifndef RUNTIME_STATS_TASK_STACK
+#define RUNTIME_STATS_TASK_STACK (configMINIMAL_STACK_SIZE * 2)
+#endif
+
+/*! @brief 1 to print every snapshot on the debug console. */
+#ifndef RUNTIME_STATS_CONSOLE
+#define RUNTIME_STATS_CONSOLE 0
+#endif
+
+#ifndef RUNTIME_STATS_NAME_LEN
+#if configMAX_TASK_NAME_LEN < 12
+#define RUNTIME_STATS_NAME_LEN configMAX_TASK_NAME_LEN
+#else
+#define RUNTIME_STATS_NAME_LEN 12
+#endif
+#endif
+
+struct runtime_stats_task
+{
+    char name[RUNTIME_STATS_NAME_LEN];
+    uint32_t number;         /* TCB number */
+    uint32_t cycles;         /* run time in the last period */
+    uint32_t switches_per_s; /* times switched out per second */
+    uint16_t cpu;            /* CPU share in 1/100 % */
+    uint16_t stack_free;     /* stack high water mark in words */
+};
+
+struct runtime_stats_snapshot
+{
+    uint32_t seq;            /* number of the sample, 0 before the first one */
+    uint32_t hz;             /* run time counter frequency */
+    uint32_t window;         /* length of the period in counter ticks */
+    uint32_t switches_per_s; /* all context switches per second */
+    uint16_t isr;            /* share of instrumented interrupts in 1/100 % */
+    uint16_t ntasks;
+    uint32_t switch_cost;    /* ticks added to every context switch */
+    uint16_t switch_share;   /* switch_cost times the switches in 1/100 % */
+    uint32_t sample_cost;    /* ticks spent taking the last sample */
+    struct runtime_stats_task task[RUNTIME_STATS_MAX_TASKS];
+};
+
+#if configGENERATE_RUN_TIME_STATS
+
+#if defined(__arm__)
+/* DWT->CYCCNT, spelled out since CMSIS is not visible from FreeRTOSConfig.h. */
+#define RUNTIME_STATS_COUNTER() (*(volatile uint32_t *)0xE0001004UL)
+#else
+#define RUNTIME_STATS_COUNTER() runtime_stats_host_counter()
+#endif
+
+extern volatile uint32_t runtime_stats_switches[RUNTIME_STATS_MAX_TASKS];
+extern volatile uint32_t runtime_stats_isr_nesting;
+extern volatile uint32_t runtime_stats_isr_start;
+extern volatile uint32_t runtime_stats_isr_ticks;
+
+/*! @brief Counts a switch out of task number n, from traceTASK_SWITCHED_OUT. */
+#define RUNTIME_STATS_SWITCHED_OUT(n) (runtime_stats_switches[(n) & (RUNTIME_STATS_MAX_TASKS - 1U)]++)
+
+/*!
+ * @brief Charges the run time of the task being switched out.
+ *
+ * vTaskSwitchContext() only adds the run time when the counter is above the
+ * switch in time, which loses the slice in which the counter wrapped. Charging
+ * it here first, with the unsigned difference, leaves the kernel the few ticks
+ * up to its own counter read.
+ */
+#define RUNTIME_STATS_CHARGE(counter, switched_in)            \
+    do                                                        \
+    {                                                         \
+        uint32_t runtime_stats_now = RUNTIME_STATS_COUNTER(); \
+        (counter) += runtime_stats_now - (switched_in);       \
+        (switched_in) = runtime_stats_now;                    \
+    } while (0)
+
+/*!
+ * @brief Accounts the time of an interrupt handler as ISR time.
+ *
+ * Put RUNTIME_STATS_ISR_ENTER() first and RUNTIME_STATS_ISR_EXIT() last in a
+ * handler. Nested handlers are only counted once: a preempting handler always
+ * leaves the nesting count as it found it.
+ */
+#define RUNTIME_STATS_ISR_ENTER()                             \
+    do                                                        \
+    {                                                         \
+        if (runtime_stats_isr_nesting++ == 0U)                \
+        {                                                     \
+            runtime_stats_isr_start = RUNTIME_STATS_COUNTER(); \
+        }                                                     \
+    } while (0)
+
+#define RUNTIME_STATS_ISR_EXIT()                                                          \
+    do                                                                                    \
+    {                                                                                     \
+        if (--runtime_stats_isr_nesting == 0U)                                            \
+        {                                                                                 \
+            runtime_stats_isr_ticks += RUNTIME_STATS_COUNTER() - runtime_stats_isr_start; \
+        }                                                                                 \
+    } while (0)
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*! @brief Starts the run time counter, from portCONFIGURE_TIMER_FOR_RUN_TIME_STATS. */
+void runtime_stats_counter_init(void);
+
+#if !defined(__arm__)
+uint32_t runtime_stats_host_counter(void);
+#endif
+
+/*!
+ * @brief Creates the sampler task.
+ *
+ * @return 0 on success, -1 if the task could not be created.
+ */
+int runtime_stats_start(void);
+
+/*! @brief Copies the latest snapshot. */
+void runtime_stats_get(struct runtime_stats_snapshot *snap);
+
+/*!
+ * @brief Prints the latest snapshot as a text table.
+ *
+ * Uses a static copy of the snapshot, so calls must not overlap.
+ *
+ * @return Number of characters written, without the terminating zero.
+ */
+int runtime_stats_format(char *buf, size_t size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+/*******************************************************************************
+ * FreeRTOS port and trace hooks
+ ******************************************************************************/
+
+/* Expanded in vTaskStartScheduler(): the first task starts its slice now, not
+ * at counter value zero. */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()        \
+    do                                                  \
+    {                                                   \
+        runtime_stats_counter_init();                   \
+        ulTaskSwitchedInTime = RUNTIME_STATS_COUNTER(); \
+    } while (0)
+
+#define portGET_RUN_TIME_COUNTER_VALUE() RUNTIME_STATS_COUNTER()
+
+/* Expanded in vTaskSwitchContext(), where the kernel's ulTaskSwitchedInTime is
+ * visible. */
+#define traceTASK_SWITCHED_OUT()                                                    \
+    do                                                                              \
+    {                                                                               \
+        RUNTIME_STATS_SWITCHED_OUT(pxCurrentTCB->uxTCBNumber);                      \
+        RUNTIME_STATS_CHARGE(pxCurrentTCB->ulRunTimeCounter, ulTaskSwitchedInTime); \
+    } while (0)
+
+#else /* configGENERATE_RUN_TIME_STATS */
+
+#define RUNTIME_STATS_ISR_ENTER()
+#define RUNTIME_STATS_ISR_EXIT()
+static inline int runtime_stats_start(void)
+{
+    return 0;
+}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
+
+#endif /* _RUNTIME_STATS_H_ */
@@ -0,0 +1,154 @@
+/*
+ * Binary kernel trace recorder, see trace_recorder.h.
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "FreeRTOSConfig.h"
+
+#if configUSE_TRACE_RECORDER
+
+#include <string.h>
+
+#if defined(__arm__)
+#include "fsl_device_registers.h"
+#else
+#include <time.h>
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if (TRACE_RECORDER_EVENTS & (TRACE_RECORDER_EVENTS - 1U)) != 0
+#error "TRACE_RECORDER_EVENTS must be a power of two"
+#endif
+
+/* Timestamp of an event: the DWT cycle counter on the target, the monotonic
+ * clock in nanoseconds (truncated to 32 bits) on a host build. */
+#if defined(__arm__)
+#define TRACE_RECORDER_TIMESTAMP() (DWT->CYCCNT)
+#define TRACE_RECORDER_HZ() (SystemCoreClock)
+#else
+#define TRACE_RECORDER_TIMESTAMP() trace_host_timestamp()
+#define TRACE_RECORDER_HZ() (1000000000UL)
+#endif
+
+#define TRACE_RECORDER_CALIBRATE_RUNS 8U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+struct trace_recorder trace_recorder = {
+    .magic = TRACE_RECORDER_MAGIC,
+    .version = TRACE_RECORDER_VERSION,
+    .event_size = sizeof(struct trace_event),
+    .events = TRACE_RECORDER_EVENTS,
+    .max_tasks = TRACE_RECORDER_MAX_TASKS,
+    .name_len = TRACE_RECORDER_NAME_LEN,
+    .overwrite = TRACE_RECORDER_OVERWRITE,
+};
+
+volatile uint8_t trace_current_task = TRACE_TASK_NONE;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+#if !defined(__arm__)
+static uint32_t trace_host_timestamp(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#endif
+
+static void trace_record_task(uint8_t type, uint8_t task, uint16_t obj)
+{
+    struct trace_event *ev;
+    uint32_t i;
+
+    /* Reserving the slot is the only shared write, an interrupt recording in
+     * between gets the next slot. */
+    i = __atomic_fetch_add(&trace_recorder.index, 1U, __ATOMIC_RELAXED);
+#if !TRACE_RECORDER_OVERWRITE
+    if (i >= TRACE_RECORDER_EVENTS)
+    {
+        /* index keeps counting, the dump tells how many events were lost. */
+        return;
+    }
+#endif
+    ev = &trace_recorder.ring[i & (TRACE_RECORDER_EVENTS - 1U)];
+    ev->ts = TRACE_RECORDER_TIMESTAMP();
+    ev->type = type;
+    ev->task = task;
+    ev->obj = obj;
+}
+
+void trace_record(uint8_t type, uint16_t obj)
+{
+    trace_record_task(type, trace_current_task, obj);
+}
+
+void trace_task_create(uint32_t task, const char *name)
+{
+    if (task < TRACE_RECORDER_MAX_TASKS)
+    {
+        strncpy(trace_recorder.names[task], name, TRACE_RECORDER_NAME_LEN);
+    }
+    trace_record_task(TRACE_EV_TASK_CREATE, (uint8_t)task, 0U);
+}
+
+void trace_task_switched_in(uint32_t task)
+{
+    trace_current_task = (uint8_t)task;
+    trace_record_task(TRACE_EV_TASK_SWITCHED_IN, (uint8_t)task, 0U);
+}
+
+uint16_t trace_object_create(uint8_t type, uint8_t obj_type)
+{
+    static uint16_t next_obj;
+    uint16_t obj;
+
+    obj = __atomic_add_fetch(&next_obj, 1U, __ATOMIC_RELAXED);
+    trace_record_task(type, obj_type, obj);
+    return obj;
+}
+
+void trace_recorder_clear(void)
+{
+    trace_recorder.index = 0U;
+    memset(trace_recorder.ring, 0, sizeof(trace_recorder.ring));
+}
+
+void trace_recorder_init(void)
+{
+    uint32_t best = UINT32_MAX;
+    uint32_t start;
+    uint32_t i;
+
+#if defined(__arm__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    trace_recorder.hz = TRACE_RECORDER_HZ();
+
+    /* The calibration events stay in the ring, the analyzer skips them. */
+    for (i = 0U; i < TRACE_RECORDER_CALIBRATE_RUNS; i++)
+    {
+        start = TRACE_RECORDER_TIMESTAMP();
+        trace_record(TRACE_EV_CALIBRATE, (uint16_t)i);
+        start = TRACE_RECORDER_TIMESTAMP() - start;
+        if (start < best)
+        {
+            best = start;
+        }
+    }
+    trace_recorder.cycles_per_event = (best > UINT16_MAX) ? UINT16_MAX : (uint16_t)best;
+}
+
+#endif /* configUSE_TRACE_RECORDER */
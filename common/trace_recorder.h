@@ -0,0 +1,196 @@
+/*
+ * Binary kernel trace recorder.
+ *
+ * Implements the FreeRTOS trace hooks (traceTASK_SWITCHED_IN, traceQUEUE_SEND,
+ * traceBLOCKING_ON_QUEUE_RECEIVE, ...) by appending fixed size, timestamped
+ * records to a RAM ring. Slots are reserved with a single atomic increment, so
+ * tasks and interrupts can record concurrently without a critical section.
+ *
+ * The whole recorder is the one global object 'trace_recorder': stop the
+ * target and dump it with the debugger, e.g. from gdb
+ *
+ *     dump binary value trace.bin trace_recorder
+ *
+ * and feed the file to trace_analyze.py at the top of the repository.
+ *
+ * Build with configUSE_TRACE_RECORDER=1 to record; otherwise the hooks and
+ * trace_recorder_init() expand to nothing. FreeRTOSConfig.h includes this
+ * header at its end, so it must not depend on any FreeRTOS type.
+ */
+
+#ifndef _TRACE_RECORDER_H_
+#define _TRACE_RECORDER_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#ifndef configUSE_TRACE_RECORDER
+#define configUSE_TRACE_RECORDER 0
+#endif
+
+/* Number of events in the ring, must be a power of two. */
+#ifndef TRACE_RECORDER_EVENTS
+#define TRACE_RECORDER_EVENTS 1024U
+#endif
+
+/* 1: the oldest events are overwritten when the ring is full (flight
+ * recorder), 0: recording stops when the ring is full (snapshot). */
+#ifndef TRACE_RECORDER_OVERWRITE
+#define TRACE_RECORDER_OVERWRITE 1
+#endif
+
+/* Number of task names kept, tasks are identified by their TCB number. */
+#ifndef TRACE_RECORDER_MAX_TASKS
+#define TRACE_RECORDER_MAX_TASKS 32U
+#endif
+
+#ifndef TRACE_RECORDER_NAME_LEN
+#if configMAX_TASK_NAME_LEN < 16
+#define TRACE_RECORDER_NAME_LEN configMAX_TASK_NAME_LEN
+#else
+#define TRACE_RECORDER_NAME_LEN 16
+#endif
+#endif
+
+#define TRACE_RECORDER_MAGIC 0x52545246UL /* "FRTR" in memory */
+#define TRACE_RECORDER_VERSION 1U
+
+/* Event types, keep in sync with trace_analyze.py. */
+enum trace_event_type
+{
+    TRACE_EV_NONE = 0,
+    TRACE_EV_TASK_CREATE,        /* task: new task */
+    TRACE_EV_TASK_DELETE,        /* obj: deleted task */
+    TRACE_EV_TASK_SWITCHED_IN,   /* task: task now running */
+    TRACE_EV_TASK_DELAY,
+    TRACE_EV_TASK_DELAY_UNTIL,
+    TRACE_EV_QUEUE_CREATE,       /* obj: queue, task: queue type */
+    TRACE_EV_QUEUE_SEND,
+    TRACE_EV_QUEUE_SEND_FAILED,
+    TRACE_EV_QUEUE_RECEIVE,
+    TRACE_EV_QUEUE_RECEIVE_FAILED,
+    TRACE_EV_QUEUE_PEEK,
+    TRACE_EV_QUEUE_SEND_FROM_ISR,
+    TRACE_EV_QUEUE_RECEIVE_FROM_ISR,
+    TRACE_EV_BLOCK_ON_QUEUE_SEND,
+    TRACE_EV_BLOCK_ON_QUEUE_RECEIVE,
+    TRACE_EV_BLOCK_ON_QUEUE_PEEK,
+    TRACE_EV_EVENT_GROUP_CREATE, /* obj: event group */
+    TRACE_EV_BLOCK_ON_EVENT_GROUP,
+    TRACE_EV_BLOCK_ON_NOTIFY,
+    TRACE_EV_CALIBRATE,
+    TRACE_EV_MAX
+};
+
+/* Object type of TRACE_EV_QUEUE_CREATE beyond the FreeRTOS queue types. */
+#define TRACE_OBJ_EVENT_GROUP 0x10U
+
+/* Task number recorded before the scheduler switched in the first task. */
+#define TRACE_TASK_NONE 0U
+
+/* One event, 8 bytes. The task of queue and block events is the running one. */
+struct trace_event
+{
+    uint32_t ts;
+    uint8_t type;
+    uint8_t task;
+    uint16_t obj;
+};
+
+struct trace_recorder
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t event_size;
+    uint32_t events;           /* capacity of ring[] */
+    uint32_t hz;               /* timestamp frequency */
+    volatile uint32_t index;   /* total events recorded, next slot is index % events */
+    uint16_t cycles_per_event; /* measured by trace_recorder_init() */
+    uint8_t max_tasks;
+    uint8_t name_len;
+    uint8_t overwrite;
+    uint8_t reserved[3];
+    char names[TRACE_RECORDER_MAX_TASKS][TRACE_RECORDER_NAME_LEN];
+    struct trace_event ring[TRACE_RECORDER_EVENTS];
+};
+
+#if configUSE_TRACE_RECORDER
+
+extern struct trace_recorder trace_recorder;
+extern volatile uint8_t trace_current_task;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Starts the timestamp counter and measures the cost of one event.
+ *
+ * Call once from main() after the clocks are set up. Objects created before
+ * are recorded with a zero timestamp.
+ */
+void trace_recorder_init(void);
+
+/*! @brief Clears the ring, e.g. before a measurement. */
+void trace_recorder_clear(void);
+
+void trace_record(uint8_t type, uint16_t obj);
+void trace_task_create(uint32_t task, const char *name);
+void trace_task_switched_in(uint32_t task);
+uint16_t trace_object_create(uint8_t type, uint8_t obj_type);
+
+#if defined(__cplusplus)
+}
+#endif
+
+/*******************************************************************************
+ * FreeRTOS trace hooks
+ ******************************************************************************/
+
+#define traceTASK_CREATE(pxNewTCB) trace_task_create((pxNewTCB)->uxTCBNumber, (pxNewTCB)->pcTaskName)
+#define traceTASK_DELETE(pxTaskToDelete) trace_record(TRACE_EV_TASK_DELETE, (uint16_t)(pxTaskToDelete)->uxTCBNumber)
+#define traceTASK_SWITCHED_IN() trace_task_switched_in(pxCurrentTCB->uxTCBNumber)
+#define traceTASK_DELAY() trace_record(TRACE_EV_TASK_DELAY, 0U)
+#define traceTASK_DELAY_UNTIL(xTimeToWake) trace_record(TRACE_EV_TASK_DELAY_UNTIL, 0U)
+#define traceTASK_NOTIFY_TAKE_BLOCK() trace_record(TRACE_EV_BLOCK_ON_NOTIFY, 0U)
+#define traceTASK_NOTIFY_WAIT_BLOCK() trace_record(TRACE_EV_BLOCK_ON_NOTIFY, 0U)
+
+#define traceQUEUE_CREATE(pxNewQueue) \
+    ((pxNewQueue)->uxQueueNumber = trace_object_create(TRACE_EV_QUEUE_CREATE, (pxNewQueue)->ucQueueType))
+#define traceQUEUE_SEND(pxQueue) trace_record(TRACE_EV_QUEUE_SEND, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FAILED(pxQueue) trace_record(TRACE_EV_QUEUE_SEND_FAILED, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE(pxQueue) trace_record(TRACE_EV_QUEUE_RECEIVE, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue) \
+    trace_record(TRACE_EV_QUEUE_RECEIVE_FAILED, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceQUEUE_PEEK(pxQueue) trace_record(TRACE_EV_QUEUE_PEEK, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) \
+    trace_record(TRACE_EV_QUEUE_SEND_FROM_ISR, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) \
+    trace_record(TRACE_EV_QUEUE_RECEIVE_FROM_ISR, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) \
+    trace_record(TRACE_EV_BLOCK_ON_QUEUE_SEND, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) \
+    trace_record(TRACE_EV_BLOCK_ON_QUEUE_RECEIVE, (uint16_t)(pxQueue)->uxQueueNumber)
+#define traceBLOCKING_ON_QUEUE_PEEK(pxQueue) \
+    trace_record(TRACE_EV_BLOCK_ON_QUEUE_PEEK, (uint16_t)(pxQueue)->uxQueueNumber)
+
+#define traceEVENT_GROUP_CREATE(pxEventBits) \
+    ((pxEventBits)->uxEventGroupNumber = trace_object_create(TRACE_EV_EVENT_GROUP_CREATE, TRACE_OBJ_EVENT_GROUP))
+#define traceEVENT_GROUP_WAIT_BITS_BLOCK(xEventGroup, uxBitsToWaitFor) \
+    trace_record(TRACE_EV_BLOCK_ON_EVENT_GROUP, (uint16_t)((EventGroup_t *)(xEventGroup))->uxEventGroupNumber)
+
+#else /* configUSE_TRACE_RECORDER */
+
+#define trace_recorder_init()
+#define trace_recorder_clear()
+
+#endif /* configUSE_TRACE_RECORDER */
+
+#endif /* _TRACE_RECORDER_H_ */
@@ -0,0 +1,252 @@
+# Analyzer for dumps of the binary kernel trace recorder (source/trace_recorder.c)
+#
+# Dump the recorder from the debugger, e.g. with gdb:
+#     dump binary value trace.bin trace_recorder
+# then:
+#     python trace_analyze.py trace.bin
+#     python trace_analyze.py --timeline 100 --events trace.bin
+import argparse
+import struct
+import sys
+
+MAGIC = 0x52545246
+VERSION = 1
+HEADER = struct.Struct('<IHHIIIHBBB3x')
+EVENT = struct.Struct('<IBBH')
+
+# enum trace_event_type in trace_recorder.h
+EV_NAMES = [
+    'none', 'task_create', 'task_delete', 'switched_in', 'delay', 'delay_until',
+    'queue_create', 'send', 'send_failed', 'receive', 'receive_failed', 'peek',
+    'send_from_isr', 'receive_from_isr', 'block_send', 'block_receive', 'block_peek',
+    'event_group_create', 'block_event_group', 'block_notify', 'calibrate',
+]
+EV = dict((name, i) for i, name in enumerate(EV_NAMES))
+BLOCK_EVENTS = (EV['block_send'], EV['block_receive'], EV['block_peek'],
+                EV['block_event_group'], EV['block_notify'])
+DELAY_EVENTS = (EV['delay'], EV['delay_until'])
+
+# ucQueueType of FreeRTOS plus TRACE_OBJ_EVENT_GROUP
+OBJ_TYPES = {0: 'queue', 1: 'mutex', 2: 'counting sem', 3: 'binary sem',
+             4: 'recursive mutex', 5: 'queue set', 0x10: 'event group'}
+
+
+class Trace(object):
+    def __init__(self, data):
+        if len(data) < HEADER.size:
+            raise ValueError('dump too short')
+        (magic, version, event_size, capacity, self.hz, self.index,
+         self.cycles_per_event, max_tasks, name_len, self.overwrite) = HEADER.unpack_from(data)
+        if magic != MAGIC:
+            raise ValueError('bad magic 0x%08x, not a trace_recorder dump' % magic)
+        if version != VERSION or event_size != EVENT.size:
+            raise ValueError('unsupported recorder version %d / event size %d' % (version, event_size))
+
+        off = HEADER.size
+        self.names = {}
+        for i in range(max_tasks):
+            raw = data[off + i * name_len:off + (i + 1) * name_len].split(b'\0')[0]
+            if raw:
+                self.names[i] = raw.decode('ascii', 'replace')
+        off += max_tasks * name_len
+        if len(data) < off + capacity * EVENT.size:
+            raise ValueError('dump truncated, expected %d bytes' % (off + capacity * EVENT.size))
+        ring = [EVENT.unpack_from(data, off + i * EVENT.size) for i in range(capacity)]
+
+        if self.index <= capacity:
+            raw_events = ring[:self.index]
+            self.lost = 0
+        elif self.overwrite:
+            start = self.index % capacity
+            raw_events = ring[start:] + ring[:start]
+            self.lost = self.index - capacity
+        else:
+            raw_events = ring
+            self.lost = self.index - capacity
+
+        # 32-bit timestamps are unwrapped; an event whose slot was reserved
+        # before an interrupt recorded its own can carry a slightly older
+        # timestamp, it is clamped to its predecessor.
+        self.events = []
+        t = 0
+        prev = None
+        for ts, typ, task, obj in raw_events:
+            if typ in (EV['none'], EV['calibrate']) or typ >= len(EV_NAMES):
+                continue
+            if prev is not None:
+                delta = (ts - prev) & 0xffffffff
+                if delta < 0x80000000:
+                    t += delta
+                    prev = ts
+            else:
+                prev = ts
+            self.events.append((t, typ, task, obj))
+
+    def task_name(self, task):
+        return self.names.get(task, 'task%d' % task)
+
+    def us(self, ticks):
+        return ticks * 1e6 / self.hz
+
+
+class ObjStats(object):
+    def __init__(self, kind):
+        self.kind = kind
+        self.ops = dict((k, 0) for k in ('send', 'receive', 'failed', 'isr'))
+        self.blocks = 0
+        self.block_total = 0
+        self.block_max = 0
+        self.waiters = {}
+
+
+def analyze(trace):
+    cpu = {}
+    switches_in = {}
+    objs = {}
+    pending = {}
+    slices = []
+    switches = 0
+    current = None
+    slice_start = None
+    first = None
+
+    def obj(o):
+        if o not in objs:
+            objs[o] = ObjStats('?')
+        return objs[o]
+
+    for t, typ, task, o in trace.events:
+        if typ == EV['queue_create'] or typ == EV['event_group_create']:
+            objs[o] = ObjStats(OBJ_TYPES.get(task, 'type%d' % task))
+        elif typ == EV['switched_in']:
+            if first is None:
+                first = t
+            if current is not None:
+                cpu[current] = cpu.get(current, 0) + t - slice_start
+                slices.append((current, slice_start, t))
+            if task != current:
+                switches += 1
+            switches_in[task] = switches_in.get(task, 0) + 1
+            current, slice_start = task, t
+            if task in pending:
+                o_blocked, since = pending.pop(task)
+                s = obj(o_blocked)
+                wait = t - since
+                s.blocks += 1
+                s.block_total += wait
+                s.block_max = max(s.block_max, wait)
+                s.waiters[task] = s.waiters.get(task, 0) + wait
+        elif typ in BLOCK_EVENTS:
+            # Notifications have no object, they are accounted as object 0.
+            pending[task] = (o if typ != EV['block_notify'] else 0, t)
+            if typ == EV['block_notify'] and 0 not in objs:
+                objs[0] = ObjStats('notification')
+        elif typ in DELAY_EVENTS:
+            pending.pop(task, None)
+        elif typ in (EV['send'], EV['receive'], EV['peek']):
+            obj(o).ops['send' if typ == EV['send'] else 'receive'] += 1
+        elif typ in (EV['send_failed'], EV['receive_failed']):
+            obj(o).ops['failed'] += 1
+        elif typ in (EV['send_from_isr'], EV['receive_from_isr']):
+            obj(o).ops['isr'] += 1
+
+    end = trace.events[-1][0] if trace.events else 0
+    if current is not None:
+        cpu[current] = cpu.get(current, 0) + end - slice_start
+        slices.append((current, slice_start, end))
+    span = end - first if first is not None else 0
+    return cpu, switches_in, switches, objs, slices, first or 0, span
+
+
+def print_report(trace, cpu, switches_in, switches, objs, span):
+    seconds = span / float(trace.hz) if span else 0.0
+    print('events %d (lost %d), %.0f Hz timestamps, %d ticks/event, span %.3f ms'
+          % (len(trace.events), trace.lost, trace.hz, trace.cycles_per_event, seconds * 1e3))
+    if seconds:
+        print('context switches %d, %.1f/s' % (switches, switches / seconds))
+        print('recorder overhead ~%.3f%% of the CPU'
+              % (100.0 * len(trace.events) * trace.cycles_per_event / float(span)))
+
+    print('')
+    print('%-16s %10s %7s %9s %9s' % ('task', 'cpu ms', 'cpu %', 'switches', 'per s'))
+    for task in sorted(cpu, key=lambda k: -cpu[k]):
+        print('%-16s %10.3f %7.2f %9d %9.1f'
+              % (trace.task_name(task), trace.us(cpu[task]) / 1e3,
+                 100.0 * cpu[task] / span if span else 0.0, switches_in.get(task, 0),
+                 switches_in.get(task, 0) / seconds if seconds else 0.0))
+
+    if not objs:
+        return
+    print('')
+    print('%-6s %-15s %7s %7s %6s %5s %7s %11s %11s %11s'
+          % ('obj', 'type', 'send', 'recv', 'fail', 'isr', 'blocks', 'block ms', 'avg us', 'max us'))
+    for o in sorted(objs):
+        s = objs[o]
+        print('%-6d %-15s %7d %7d %6d %5d %7d %11.3f %11.1f %11.1f'
+              % (o, s.kind, s.ops['send'], s.ops['receive'], s.ops['failed'], s.ops['isr'],
+                 s.blocks, trace.us(s.block_total) / 1e3,
+                 trace.us(s.block_total) / s.blocks if s.blocks else 0.0, trace.us(s.block_max)))
+        for task in sorted(s.waiters, key=lambda k: -s.waiters[k]):
+            print('%6s   blocked %-16s %.3f ms' % ('', trace.task_name(task), trace.us(s.waiters[task]) / 1e3))
+
+
+def print_timeline(trace, slices, first, span, columns):
+    # One row per task, one column per time bucket; the glyph tells which share
+    # of the bucket the task was running.
+    if not span or not slices:
+        return
+    bucket = span / float(columns)
+    rows = {}
+    for task, start, stop in slices:
+        row = rows.setdefault(task, [0.0] * columns)
+        start -= first
+        stop -= first
+        b = int(start / bucket)
+        while b < columns and start < stop:
+            edge = min(stop, (b + 1) * bucket)
+            row[b] += edge - start
+            start = edge
+            b += 1
+    print('')
+    print('timeline, %.1f us per column' % trace.us(bucket))
+    for task in sorted(rows):
+        glyphs = ''.join(' .:+#'[min(4, int(4 * busy / bucket + 0.999))] for busy in rows[task])
+        print('%-16s|%s|' % (trace.task_name(task), glyphs))
+
+
+def print_events(trace, first):
+    print('')
+    for t, typ, task, o in trace.events:
+        print('%12.1f us  %-16s %-18s %d' % (trace.us(t - first), trace.task_name(task), EV_NAMES[typ], o))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Summarize a trace_recorder dump.')
+    parser.add_argument('dump', help='binary dump of the trace_recorder object')
+    parser.add_argument('--hz', type=float, help='override the timestamp frequency of the dump')
+    parser.add_argument('--timeline', type=int, metavar='COLUMNS', nargs='?', const=72,
+                        help='print a per-task timeline (default 72 columns)')
+    parser.add_argument('--events', action='store_true', help='list every event')
+    args = parser.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        data = f.read()
+    try:
+        trace = Trace(data)
+    except ValueError as e:
+        sys.exit('%s: %s' % (args.dump, e))
+    if args.hz:
+        trace.hz = args.hz
+    if not trace.hz:
+        sys.exit('%s: timestamp frequency is 0, was trace_recorder_init() called? Use --hz' % args.dump)
+
+    cpu, switches_in, switches, objs, slices, first, span = analyze(trace)
+    print_report(trace, cpu, switches_in, switches, objs, span)
+    if args.timeline:
+        print_timeline(trace, slices, first, span, args.timeline)
+    if args.events:
+        print_events(trace, first)
+
+
+if __name__ == '__main__':
+    main()